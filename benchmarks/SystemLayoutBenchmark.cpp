@@ -0,0 +1,173 @@
+#include <QElapsedTimer>
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+
+#include <algorithm>
+#include <limits>
+
+#include "BodyGraph.h"
+#include "BodyRecords.h"
+#include "SystemLayoutEngine.h"
+
+// Замер SystemLayoutEngine на синтетических системах от 10 тыс. до 1 млн тел.
+// Запуск: SystemLayoutBenchmark [число тел ...]; без аргументов — 10000 100000 1000000.
+// Для каждой формы печатается первая раскладка (буферы создаются) и среднее по повторным
+// раскладкам с тем же Workspace, как при переключении между системами в виджете.
+
+namespace {
+
+constexpr int kRepeats = 5;
+
+struct SyntheticSystem {
+    BodyGraph graph;
+    QVector<BodyHot> hotBodies;
+};
+
+BodyHot makeBody(const int index, const int parentIndex, const BodyHot::Flag typeFlag, const double orbitAu) {
+    BodyHot body;
+    body.id = index;
+    body.parentId = parentIndex;
+    body.flags = typeFlag;
+    body.bodyClass = typeFlag == BodyHot::StarTypeFlag ? CelestialBody::BodyClass::Star
+                   : typeFlag == BodyHot::BarycenterTypeFlag ? CelestialBody::BodyClass::Barycenter
+                   : CelestialBody::BodyClass::Planet;
+    body.semiMajorAxisAu = orbitAu;
+    return body;
+}
+
+// CSR по массиву родителей: индексы тел совпадают с id, поэтому порядок по id сохраняется.
+void finishGraph(SyntheticSystem& system) {
+    BodyGraph& graph = system.graph;
+    const int bodyCount = system.hotBodies.size();
+    graph.bodyIds.resize(bodyCount);
+    graph.parentIndex.resize(bodyCount);
+    graph.childOffsets.fill(0, bodyCount + 1);
+    graph.indexById.reserve(bodyCount);
+    for (int index = 0; index < bodyCount; ++index) {
+        const int parentIndex = system.hotBodies.at(index).parentId;
+        graph.bodyIds[index] = index;
+        graph.indexById.insert(index, index);
+        graph.parentIndex[index] = parentIndex;
+        if (parentIndex >= 0) {
+            ++graph.childOffsets[parentIndex + 1];
+        } else {
+            graph.rootIndices.push_back(index);
+        }
+    }
+    for (int index = 0; index < bodyCount; ++index) {
+        graph.childOffsets[index + 1] += graph.childOffsets.at(index);
+    }
+
+    QVector<int> cursor(graph.childOffsets.constBegin(), graph.childOffsets.constEnd() - 1);
+    graph.childIndices.resize(graph.childOffsets.last());
+    for (int index = 0; index < bodyCount; ++index) {
+        const int parentIndex = graph.parentIndex.at(index);
+        if (parentIndex >= 0) {
+            graph.childIndices[cursor[parentIndex]++] = index;
+        }
+    }
+}
+
+// Широкая система: барицентр → двойные звёзды → планеты → спутники.
+SyntheticSystem makeWideSystem(const int bodyCount) {
+    SyntheticSystem system;
+    system.hotBodies.reserve(bodyCount + 2);
+    const auto addBody = [&system](const int parentIndex, const BodyHot::Flag typeFlag, const double orbitAu) {
+        const int index = system.hotBodies.size();
+        system.hotBodies.push_back(makeBody(index, parentIndex, typeFlag, orbitAu));
+        return index;
+    };
+
+    addBody(-1, BodyHot::BarycenterTypeFlag, 0.0);
+    int pairBarycenter = 0;
+    int planet = 0;
+    while (system.hotBodies.size() < bodyCount) {
+        const int index = system.hotBodies.size();
+        if (index % 64 == 1) {
+            pairBarycenter = addBody(0, BodyHot::BarycenterTypeFlag, 40.0 + index * 0.01);
+            addBody(pairBarycenter, BodyHot::StarTypeFlag, 0.2);
+            addBody(pairBarycenter, BodyHot::StarTypeFlag, 0.3);
+            planet = pairBarycenter;
+        } else if (index % 8 == 0) {
+            planet = addBody(pairBarycenter, BodyHot::PlanetTypeFlag, 1.0 + (index % 64) * 0.1);
+        } else {
+            // Часть спутников без полуоси — проверяется ветка с запасным расстоянием.
+            addBody(planet, BodyHot::MoonTypeFlag, index % 3 == 0 ? 0.0 : 0.001 * (index % 8));
+        }
+    }
+    // Звёзды последней пары могли выйти за размер; их родители лежат раньше, обрезка безопасна.
+    system.hotBodies.resize(bodyCount);
+    finishGraph(system);
+    return system;
+}
+
+// Вырожденная цепочка: каждое тело вращается вокруг предыдущего. Рекурсивный обход
+// переполнял бы стек уже на десятках тысяч уровней.
+SyntheticSystem makeChainSystem(const int bodyCount) {
+    SyntheticSystem system;
+    system.hotBodies.reserve(bodyCount);
+    for (int index = 0; index < bodyCount; ++index) {
+        system.hotBodies.push_back(makeBody(index, index - 1, index % 2 == 0 ? BodyHot::BarycenterTypeFlag : BodyHot::PlanetTypeFlag,
+                                            0.01));
+    }
+    finishGraph(system);
+    return system;
+}
+
+void runShape(QTextStream& out, const QString& shape, const SyntheticSystem& system) {
+    SystemLayoutEngine::Workspace workspace;
+    SystemLayout layout;
+
+    QElapsedTimer timer;
+    timer.start();
+    SystemLayoutEngine::buildLayout(system.graph, system.hotBodies, workspace, layout);
+    const qint64 firstNs = timer.nsecsElapsed();
+
+    qint64 bestNs = std::numeric_limits<qint64>::max();
+    qint64 totalNs = 0;
+    for (int repeat = 0; repeat < kRepeats; ++repeat) {
+        timer.restart();
+        SystemLayoutEngine::buildLayout(system.graph, system.hotBodies, workspace, layout);
+        const qint64 elapsedNs = timer.nsecsElapsed();
+        bestNs = std::min(bestNs, elapsedNs);
+        totalNs += elapsedNs;
+    }
+
+    const int placedCount = static_cast<int>(std::count_if(layout.bodies.cbegin(), layout.bodies.cend(), [](const BodyLayout& bodyLayout) {
+        return bodyLayout.placed;
+    }));
+    const double bodyCount = qMax(1, system.graph.size());
+    out << QStringLiteral("%1 %2 тел: первая %3 мс, повторная %4 мс (лучшая %5 мс, %6 нс/тело), размещено %7\n")
+               .arg(shape, -6)
+               .arg(system.graph.size(), 8)
+               .arg(firstNs / 1e6, 0, 'f', 2)
+               .arg(totalNs / 1e6 / kRepeats, 0, 'f', 2)
+               .arg(bestNs / 1e6, 0, 'f', 2)
+               .arg(bestNs / bodyCount, 0, 'f', 1)
+               .arg(placedCount);
+    out.flush();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QVector<int> sizes;
+    for (int i = 1; i < argc; ++i) {
+        const int size = QString::fromLocal8Bit(argv[i]).toInt();
+        if (size > 0) {
+            sizes.push_back(size);
+        }
+    }
+    if (sizes.isEmpty()) {
+        sizes = {10000, 100000, 1000000};
+    }
+
+    QTextStream out(stdout);
+    out.setCodec("UTF-8");
+    for (const int size : sizes) {
+        runShape(out, QStringLiteral("wide"), makeWideSystem(size));
+        runShape(out, QStringLiteral("chain"), makeChainSystem(size));
+    }
+    return 0;
+}
@@ -0,0 +1,269 @@
+#include "ArchitectureWindow.h"
+
+#include <QDoubleSpinBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSet>
+#include <QSpinBox>
+#include <QSplitter>
+#include <QTableWidget>
+#include <QTableWidgetItem>
+#include <QVBoxLayout>
+
+#include "ColumnKernels.h"
+#include "SystemCorpusDatabase.h"
+#include "SystemFingerprint.h"
+
+namespace {
+
+enum SystemsColumn {
+    SystemNameColumn,
+    SystemId64Column,
+    SystemBodiesColumn,
+    SystemsColumnCount
+};
+
+enum GroupsColumn {
+    GroupCountColumn,
+    GroupExampleColumn,
+    GroupArchitectureColumn,
+    GroupsColumnCount
+};
+
+enum SimilarColumn {
+    SimilarNameColumn,
+    SimilarDistanceColumn,
+    SimilarId64Column,
+    SimilarColumnCount
+};
+
+constexpr int kGroupLimit = 200;
+
+QTableWidget* createTable(const QStringList& headers, QWidget* parent) {
+    auto* table = new QTableWidget(0, headers.size(), parent);
+    table->setHorizontalHeaderLabels(headers);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSelectionMode(QAbstractItemView::SingleSelection);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setStretchLastSection(true);
+    return table;
+}
+
+QTableWidgetItem* numberItem(const QVariant& value) {
+    auto* item = new QTableWidgetItem;
+    item->setData(Qt::DisplayRole, value);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+QString fingerprintTooltip() {
+    QStringList features;
+    for (int feature = 0; feature < SystemFingerprint::kDimensions; ++feature) {
+        features.push_back(SystemFingerprint::featureName(static_cast<SystemFingerprint::Feature>(feature)));
+    }
+    return QStringLiteral("Евклидово расстояние по признакам: %1.").arg(features.join(QStringLiteral(", ")));
+}
+
+} // namespace
+
+ArchitectureWindow::ArchitectureWindow(SystemCorpusDatabase* corpus, QWidget* parent)
+    : QWidget(parent, Qt::Window),
+      m_corpus(corpus) {
+    setWindowTitle(QStringLiteral("Похожие системы"));
+    resize(820, 560);
+
+    m_architectureLabel = new QLabel(QStringLiteral("Система не выбрана."), this);
+    m_architectureLabel->setWordWrap(true);
+    m_architectureLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    m_architectureLabel->setToolTip(QStringLiteral("S — звезда, P — планета, M — спутник, B — барицентр, U — прочее;\n"
+                                                   "~ — тело обращается вокруг барицентра, в скобках — дети."));
+
+    auto* splitter = new QSplitter(Qt::Vertical, this);
+    m_systemsTable = createTable({QStringLiteral("Система"), QStringLiteral("id64"), QStringLiteral("Тел")}, splitter);
+    m_groupsTable = createTable({QStringLiteral("Систем"), QStringLiteral("Пример"), QStringLiteral("Структура")}, splitter);
+
+    auto* similarPanel = new QWidget(splitter);
+    m_similarCountSpin = new QSpinBox(similarPanel);
+    m_similarCountSpin->setRange(1, 1000);
+    m_similarCountSpin->setValue(50);
+    m_similarRadiusSpin = new QDoubleSpinBox(similarPanel);
+    m_similarRadiusSpin->setRange(0.0, 100000.0);
+    m_similarRadiusSpin->setDecimals(0);
+    m_similarRadiusSpin->setSingleStep(100.0);
+    m_similarRadiusSpin->setSuffix(QStringLiteral(" св. лет"));
+    m_similarRadiusSpin->setSpecialValueText(QStringLiteral("без ограничения"));
+    auto* similarButton = new QPushButton(QStringLiteral("Найти похожие по признакам"), similarPanel);
+    similarButton->setToolTip(fingerprintTooltip());
+    m_similarStatusLabel = new QLabel(similarPanel);
+    m_similarTable = createTable({QStringLiteral("Система"), QStringLiteral("Отличие"), QStringLiteral("id64")}, similarPanel);
+
+    auto* similarControls = new QHBoxLayout();
+    similarControls->addWidget(new QLabel(QStringLiteral("Показать:"), similarPanel));
+    similarControls->addWidget(m_similarCountSpin);
+    similarControls->addWidget(new QLabel(QStringLiteral("Радиус:"), similarPanel));
+    similarControls->addWidget(m_similarRadiusSpin);
+    similarControls->addWidget(similarButton);
+    similarControls->addWidget(m_similarStatusLabel, 1);
+    auto* similarLayout = new QVBoxLayout(similarPanel);
+    similarLayout->setContentsMargins(0, 0, 0, 0);
+    similarLayout->addLayout(similarControls);
+    similarLayout->addWidget(m_similarTable, 1);
+
+    splitter->addWidget(m_systemsTable);
+    splitter->addWidget(similarPanel);
+    splitter->addWidget(m_groupsTable);
+
+    auto* refreshButton = new QPushButton(QStringLiteral("Обновить частые структуры"), this);
+
+    auto* rootLayout = new QVBoxLayout(this);
+    rootLayout->addWidget(m_architectureLabel);
+    rootLayout->addWidget(splitter, 1);
+    rootLayout->addWidget(refreshButton, 0, Qt::AlignLeft);
+
+    connect(refreshButton, &QPushButton::clicked, this, [this]() {
+        reloadGroups();
+    });
+
+    connect(similarButton, &QPushButton::clicked, this, [this]() {
+        findSimilarSystems();
+    });
+
+    for (QTableWidget* table : {m_systemsTable, m_similarTable}) {
+        connect(table, &QTableWidget::cellDoubleClicked, this, [this, table](const int row, int) {
+            // Имя системы — первый столбец в обеих таблицах.
+            const QTableWidgetItem* nameItem = table->item(row, 0);
+            if (nameItem) {
+                emit systemActivated(nameItem->text());
+            }
+        });
+    }
+
+    // Двойной клик по группе показывает все её системы в верхней таблице.
+    connect(m_groupsTable, &QTableWidget::cellDoubleClicked, this, [this](const int row, int) {
+        const QTableWidgetItem* countItem = m_groupsTable->item(row, GroupCountColumn);
+        if (!countItem) {
+            return;
+        }
+        const int groupIndex = countItem->data(Qt::UserRole).toInt();
+        if (groupIndex >= 0 && groupIndex < m_groupArchitectures.size()) {
+            const SystemArchitectureSignature& architecture = m_groupArchitectures.at(groupIndex);
+            m_architectureLabel->setText(QStringLiteral("Структура: %1").arg(QString::fromLatin1(architecture.canonicalForm)));
+            showSystemsWithArchitecture(architecture);
+        }
+    });
+}
+
+void ArchitectureWindow::setSnapshot(const SystemSnapshot& snapshot) {
+    m_snapshot = snapshot;
+    m_similarTable->setRowCount(0);
+    m_similarStatusLabel->clear();
+    const SystemArchitectureSignature architecture =
+        SystemArchitecture::compute(snapshot.graph(), snapshot.hotBodies());
+    if (architecture.isEmpty()) {
+        m_architectureLabel->setText(QStringLiteral("Система не загружена."));
+        m_systemsTable->setRowCount(0);
+    } else {
+        m_architectureLabel->setText(QStringLiteral("«%1»: %2")
+                                         .arg(snapshot.systemName(), QString::fromLatin1(architecture.canonicalForm)));
+        showSystemsWithArchitecture(architecture);
+    }
+    reloadGroups();
+}
+
+void ArchitectureWindow::showSystemsWithArchitecture(const SystemArchitectureSignature& architecture) {
+    const QVector<CorpusSystemRecord> systems =
+        m_corpus ? m_corpus->systemsWithArchitecture(architecture) : QVector<CorpusSystemRecord>();
+
+    m_systemsTable->setSortingEnabled(false);
+    m_systemsTable->setRowCount(systems.size());
+    for (int row = 0; row < systems.size(); ++row) {
+        const CorpusSystemRecord& system = systems.at(row);
+        m_systemsTable->setItem(row, SystemNameColumn, new QTableWidgetItem(system.name));
+        m_systemsTable->setItem(row,
+                                SystemId64Column,
+                                new QTableWidgetItem(system.systemId64 != 0 ? QString::number(system.systemId64) : QString()));
+        m_systemsTable->setItem(row, SystemBodiesColumn, numberItem(system.bodyCount));
+    }
+    m_systemsTable->setSortingEnabled(true);
+    m_systemsTable->resizeColumnsToContents();
+}
+
+void ArchitectureWindow::reloadGroups() {
+    m_groupArchitectures.clear();
+    const QVector<CorpusArchitectureGroup> groups =
+        m_corpus ? m_corpus->architectureGroups(kGroupLimit) : QVector<CorpusArchitectureGroup>();
+
+    m_groupsTable->setSortingEnabled(false);
+    m_groupsTable->setRowCount(groups.size());
+    for (int row = 0; row < groups.size(); ++row) {
+        const CorpusArchitectureGroup& group = groups.at(row);
+        m_groupArchitectures.push_back(group.architecture);
+
+        QTableWidgetItem* countItem = numberItem(group.systemCount);
+        countItem->setData(Qt::UserRole, row);
+        m_groupsTable->setItem(row, GroupCountColumn, countItem);
+        m_groupsTable->setItem(row, GroupExampleColumn, new QTableWidgetItem(group.exampleSystem));
+        m_groupsTable->setItem(row,
+                               GroupArchitectureColumn,
+                               new QTableWidgetItem(QString::fromLatin1(group.architecture.canonicalForm)));
+    }
+    m_groupsTable->setSortingEnabled(true);
+    m_groupsTable->resizeColumnsToContents();
+}
+
+void ArchitectureWindow::findSimilarSystems() {
+    if (!m_corpus || !m_corpus->isOpen() || m_snapshot.isEmpty()) {
+        m_similarStatusLabel->setText(QStringLiteral("Нет открытой системы или корпуса."));
+        return;
+    }
+
+    const SystemFingerprintTable table = m_corpus->loadFingerprints();
+    QVector<quint8> rowMask(table.size(), 1);
+    const QString systemKey = m_snapshot.systemName().trimmed().toLower();
+    for (int row = 0; row < table.size(); ++row) {
+        if (table.names.at(row).trimmed().toLower() == systemKey) {
+            rowMask[row] = 0;
+        }
+    }
+
+    const double radiusLy = m_similarRadiusSpin->value();
+    if (radiusLy > 0.0) {
+        const auto origin = m_corpus->systemCoordinates(m_snapshot.systemName());
+        if (!origin) {
+            m_similarStatusLabel->setText(QStringLiteral("Координаты «%1» в корпусе неизвестны.").arg(m_snapshot.systemName()));
+            return;
+        }
+
+        QSet<quint64> nearbySystems;
+        for (const auto& neighbor : m_corpus->spatialIndex().withinRadius(*origin, radiusLy)) {
+            nearbySystems.insert(neighbor.point.systemId64);
+        }
+        for (int row = 0; row < table.size(); ++row) {
+            if (!nearbySystems.contains(table.systemId64.at(row))) {
+                rowMask[row] = 0;
+            }
+        }
+    }
+
+    const QVector<SystemFingerprintMatch> matches =
+        SystemFingerprintSearch::nearest(table, SystemFingerprint::compute(m_snapshot), m_similarCountSpin->value(), &rowMask);
+
+    m_similarTable->setSortingEnabled(false);
+    m_similarTable->setRowCount(matches.size());
+    for (int row = 0; row < matches.size(); ++row) {
+        const SystemFingerprintMatch& match = matches.at(row);
+        const quint64 id64 = table.systemId64.at(match.row);
+        m_similarTable->setItem(row, SimilarNameColumn, new QTableWidgetItem(table.names.at(match.row)));
+        m_similarTable->setItem(row, SimilarDistanceColumn, numberItem(QString::number(match.distance, 'f', 3).toDouble()));
+        m_similarTable->setItem(row, SimilarId64Column, new QTableWidgetItem(id64 != 0 ? QString::number(id64) : QString()));
+    }
+    m_similarTable->setSortingEnabled(true);
+    m_similarTable->sortByColumn(SimilarDistanceColumn, Qt::AscendingOrder);
+    m_similarTable->resizeColumnsToContents();
+
+    m_similarStatusLabel->setText(QStringLiteral("Просмотрено систем: %1.")
+                                      .arg(ColumnKernels::countSelected(rowMask.constData(), rowMask.size())));
+}
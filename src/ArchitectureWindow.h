@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QWidget>
+
+#include "SystemArchitecture.h"
+#include "SystemSnapshot.h"
+
+class QDoubleSpinBox;
+class QLabel;
+class QSpinBox;
+class QTableWidget;
+class SystemCorpusDatabase;
+
+// Поиск систем корпуса с такой же иерархией, как у открытой, и список самых частых
+// иерархий корпуса. Оба запроса идут по индексу architecture_hash, деревья не сравниваются.
+// Ниже — ближайшие по отпечатку SystemFingerprint системы, при желании в радиусе от открытой.
+class ArchitectureWindow : public QWidget {
+    Q_OBJECT
+public:
+    explicit ArchitectureWindow(SystemCorpusDatabase* corpus, QWidget* parent = nullptr);
+
+    // Форма считается по снимку, поэтому поиск работает и для системы, ещё не сохранённой в корпус.
+    void setSnapshot(const SystemSnapshot& snapshot);
+
+signals:
+    // Двойной клик по системе — открыть её в главном окне.
+    void systemActivated(const QString& systemName);
+
+private:
+    void showSystemsWithArchitecture(const SystemArchitectureSignature& architecture);
+    void reloadGroups();
+    void findSimilarSystems();
+
+    SystemCorpusDatabase* m_corpus = nullptr;
+    QLabel* m_architectureLabel = nullptr;
+    QTableWidget* m_systemsTable = nullptr;
+    QTableWidget* m_groupsTable = nullptr;
+    QSpinBox* m_similarCountSpin = nullptr;
+    QDoubleSpinBox* m_similarRadiusSpin = nullptr;
+    QLabel* m_similarStatusLabel = nullptr;
+    QTableWidget* m_similarTable = nullptr;
+    QVector<SystemArchitectureSignature> m_groupArchitectures;
+    SystemSnapshot m_snapshot;
+};
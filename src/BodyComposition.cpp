@@ -0,0 +1,105 @@
+#include "BodyComposition.h"
+
+#include <QHash>
+
+namespace {
+
+const std::array<QString, static_cast<size_t>(AtmosphereGas::Count)>& gasNames() {
+    static const std::array<QString, static_cast<size_t>(AtmosphereGas::Count)> names{
+        QStringLiteral("Ammonia"),
+        QStringLiteral("Argon"),
+        QStringLiteral("Carbon dioxide"),
+        QStringLiteral("Helium"),
+        QStringLiteral("Hydrogen"),
+        QStringLiteral("Iron"),
+        QStringLiteral("Methane"),
+        QStringLiteral("Neon"),
+        QStringLiteral("Nitrogen"),
+        QStringLiteral("Oxygen"),
+        QStringLiteral("Silicates"),
+        QStringLiteral("Sulphur dioxide"),
+        QStringLiteral("Water")};
+    return names;
+}
+
+const std::array<QString, static_cast<size_t>(RawMaterial::Count)>& materialNames() {
+    static const std::array<QString, static_cast<size_t>(RawMaterial::Count)> names{
+        QStringLiteral("Antimony"),
+        QStringLiteral("Arsenic"),
+        QStringLiteral("Cadmium"),
+        QStringLiteral("Carbon"),
+        QStringLiteral("Chromium"),
+        QStringLiteral("Germanium"),
+        QStringLiteral("Iron"),
+        QStringLiteral("Manganese"),
+        QStringLiteral("Mercury"),
+        QStringLiteral("Molybdenum"),
+        QStringLiteral("Nickel"),
+        QStringLiteral("Niobium"),
+        QStringLiteral("Phosphorus"),
+        QStringLiteral("Polonium"),
+        QStringLiteral("Ruthenium"),
+        QStringLiteral("Selenium"),
+        QStringLiteral("Sulphur"),
+        QStringLiteral("Technetium"),
+        QStringLiteral("Tellurium"),
+        QStringLiteral("Tin"),
+        QStringLiteral("Tungsten"),
+        QStringLiteral("Vanadium"),
+        QStringLiteral("Yttrium"),
+        QStringLiteral("Zinc"),
+        QStringLiteral("Zirconium")};
+    return names;
+}
+
+template <typename Slot, size_t Count>
+QHash<QString, Slot> buildSlotIndex(const std::array<QString, Count>& names) {
+    QHash<QString, Slot> index;
+    index.reserve(static_cast<int>(Count));
+    for (size_t slot = 0; slot < Count; ++slot) {
+        index.insert(BodyComposition::nameKey(names[slot]), static_cast<Slot>(slot));
+    }
+    return index;
+}
+
+template <typename Slot>
+std::optional<Slot> lookupSlot(const QHash<QString, Slot>& index, const QString& name) {
+    const auto it = index.constFind(BodyComposition::nameKey(name));
+    if (it == index.constEnd()) {
+        return std::nullopt;
+    }
+    return it.value();
+}
+
+} // namespace
+
+QString BodyComposition::displayName(const AtmosphereGas gas) {
+    return gas < AtmosphereGas::Count ? gasNames()[static_cast<size_t>(gas)] : QString();
+}
+
+QString BodyComposition::displayName(const RawMaterial material) {
+    return material < RawMaterial::Count ? materialNames()[static_cast<size_t>(material)] : QString();
+}
+
+QString BodyComposition::nameKey(const QString& name) {
+    QString key;
+    key.reserve(name.size());
+    for (const QChar ch : name) {
+        if (ch.isLetter()) {
+            key.push_back(ch.toLower());
+        }
+    }
+    return key.replace(QStringLiteral("sulfur"), QStringLiteral("sulphur"));
+}
+
+template <>
+std::optional<AtmosphereGas> BodyComposition::slotFromName<AtmosphereGas>(const QString& name) {
+    static const QHash<QString, AtmosphereGas> index = buildSlotIndex<AtmosphereGas>(gasNames());
+    return lookupSlot(index, name);
+}
+
+template <>
+std::optional<RawMaterial> BodyComposition::slotFromName<RawMaterial>(const QString& name) {
+    static const QHash<QString, RawMaterial> index = buildSlotIndex<RawMaterial>(materialNames());
+    return lookupSlot(index, name);
+}
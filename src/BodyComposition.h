@@ -0,0 +1,175 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+
+// Газы атмосфер — закрытый набор игры, поэтому состав хранится не списком строк,
+// а массивом долей по фиксированным слотам.
+enum class AtmosphereGas : quint8 {
+    Ammonia,
+    Argon,
+    CarbonDioxide,
+    Helium,
+    Hydrogen,
+    Iron,
+    Methane,
+    Neon,
+    Nitrogen,
+    Oxygen,
+    Silicates,
+    SulphurDioxide,
+    Water,
+    Count
+};
+
+// Сырьё в составе поверхности планет.
+enum class RawMaterial : quint8 {
+    Antimony,
+    Arsenic,
+    Cadmium,
+    Carbon,
+    Chromium,
+    Germanium,
+    Iron,
+    Manganese,
+    Mercury,
+    Molybdenum,
+    Nickel,
+    Niobium,
+    Phosphorus,
+    Polonium,
+    Ruthenium,
+    Selenium,
+    Sulphur,
+    Technetium,
+    Tellurium,
+    Tin,
+    Tungsten,
+    Vanadium,
+    Yttrium,
+    Zinc,
+    Zirconium,
+    Count
+};
+
+// Состав тела: доля в процентах по индексу слота, 0 — компонента нет.
+// Без строк и кучи: запись тривиально копируется и сравнивается.
+template <typename Slot>
+struct CompositionSlots {
+    static constexpr int kSlotCount = static_cast<int>(Slot::Count);
+
+    std::array<float, kSlotCount> percent{};
+
+    float value(const Slot slot) const {
+        return percent[static_cast<size_t>(slot)];
+    }
+
+    void setValue(const Slot slot, const float value) {
+        percent[static_cast<size_t>(slot)] = value;
+    }
+
+    int partCount() const {
+        return static_cast<int>(std::count_if(percent.cbegin(), percent.cend(), [](const float value) {
+            return value > 0.0f;
+        }));
+    }
+
+    bool isEmpty() const {
+        return partCount() == 0;
+    }
+
+    // Слоты с ненулевой долей по убыванию доли — порядок вывода и записи в корпус.
+    QVector<Slot> presentSlots() const {
+        QVector<Slot> present;
+        for (int index = 0; index < kSlotCount; ++index) {
+            if (percent[static_cast<size_t>(index)] > 0.0f) {
+                present.push_back(static_cast<Slot>(index));
+            }
+        }
+        std::stable_sort(present.begin(), present.end(), [this](const Slot lhs, const Slot rhs) {
+            return value(lhs) > value(rhs);
+        });
+        return present;
+    }
+
+    bool operator==(const CompositionSlots& other) const {
+        return percent == other.percent;
+    }
+
+    bool operator!=(const CompositionSlots& other) const {
+        return !(*this == other);
+    }
+};
+
+using AtmosphereComposition = CompositionSlots<AtmosphereGas>;
+using MaterialComposition = CompositionSlots<RawMaterial>;
+
+Q_DECLARE_TYPEINFO(AtmosphereComposition, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(MaterialComposition, Q_PRIMITIVE_TYPE);
+
+// Составы многих тел по столбцам: доля каждого слота — отдельный плотный массив float,
+// поэтому пороговый запрос "азот ≥ 70%" читает один столбец подряд (см. ColumnKernels).
+template <typename Slot>
+struct CompositionColumns {
+    std::array<QVector<float>, CompositionSlots<Slot>::kSlotCount> columns;
+
+    int size() const {
+        return columns.front().size();
+    }
+
+    void reserve(const int count) {
+        for (auto& column : columns) {
+            column.reserve(count);
+        }
+    }
+
+    // Новые строки заполняются нулями (компонент нет).
+    void resize(const int count) {
+        for (auto& column : columns) {
+            column.resize(count);
+        }
+    }
+
+    void append(const CompositionSlots<Slot>& composition) {
+        for (size_t index = 0; index < columns.size(); ++index) {
+            columns[index].push_back(composition.percent[index]);
+        }
+    }
+
+    void setValue(const int row, const Slot slot, const float value) {
+        columns[static_cast<size_t>(slot)][row] = value;
+    }
+
+    const float* column(const Slot slot) const {
+        return columns[static_cast<size_t>(slot)].constData();
+    }
+};
+
+using AtmosphereColumns = CompositionColumns<AtmosphereGas>;
+using MaterialColumns = CompositionColumns<RawMaterial>;
+
+class BodyComposition {
+public:
+    // Каноническое английское имя для вывода и корпуса: "Carbon dioxide", "Polonium".
+    static QString displayName(AtmosphereGas gas);
+    static QString displayName(RawMaterial material);
+
+    // Ключ сравнения имён: нижний регистр, только буквы, "sulfur" → "sulphur".
+    // Совпадает для "Carbon dioxide", "CarbonDioxide" и "carbon_dioxide".
+    static QString nameKey(const QString& name);
+
+    // Слот по имени из источника в любом из этих написаний; пусто для неизвестного имени.
+    template <typename Slot>
+    static std::optional<Slot> slotFromName(const QString& name);
+};
+
+template <>
+std::optional<AtmosphereGas> BodyComposition::slotFromName<AtmosphereGas>(const QString& name);
+
+template <>
+std::optional<RawMaterial> BodyComposition::slotFromName<RawMaterial>(const QString& name);
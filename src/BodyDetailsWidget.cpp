@@ -1,7 +1,5 @@
 #include "BodyDetailsWidget.h"
 
-#include "OrbitClassifier.h"
-
 #include <QFormLayout>
 #include <QLabel>
 #include <QStringList>
@@ -12,6 +10,17 @@ namespace {
 
 constexpr double kEarthGravityMs2 = 9.80665;
 
+// "Nitrogen 78.0%" по убыванию доли.
+template <typename Slot>
+QStringList compositionParts(const CompositionSlots<Slot>& composition) {
+    QStringList parts;
+    for (const Slot slot : composition.presentSlots()) {
+        parts.push_back(QStringLiteral("%1 %2%").arg(BodyComposition::displayName(slot),
+                                                    QString::number(composition.value(slot), 'f', 1)));
+    }
+    return parts;
+}
+
 QString yesNo(const bool value) {
     return value ? QStringLiteral("да") : QStringLiteral("нет");
 }
@@ -68,6 +77,8 @@ BodyDetailsWidget::BodyDetailsWidget(QWidget* parent)
         addField(form, QStringLiteral("parent"), QStringLiteral("Родительское тело:"));
         addField(form, QStringLiteral("relation"), QStringLiteral("Тип орбиты:"));
         addField(form, QStringLiteral("semiMajorAxis"), QStringLiteral("Большая полуось:"));
+        addField(form, QStringLiteral("eccentricity"), QStringLiteral("Эксцентриситет:"));
+        addField(form, QStringLiteral("orbitalPeriod"), QStringLiteral("Период обращения:"));
         addField(form, QStringLiteral("orbitsBarycenter"), QStringLiteral("Вокруг барицентра:"));
     }
 
@@ -95,7 +106,7 @@ BodyDetailsWidget::BodyDetailsWidget(QWidget* parent)
     setPlaceholderText(QStringLiteral("Кликните по телу, чтобы увидеть параметры."));
 }
 
-void BodyDetailsWidget::setBody(const CelestialBody& body, const QHash<int, CelestialBody>& bodyMap) {
+void BodyDetailsWidget::setBody(const CelestialBody& body, const SystemSnapshot& snapshot) {
     m_placeholderLabel->hide();
     m_toolBox->show();
 
@@ -105,16 +116,16 @@ void BodyDetailsWidget::setBody(const CelestialBody& body, const QHash<int, Cele
 
     QString parentName = QStringLiteral("нет данных");
     if (body.parentId >= 0) {
-        const auto parentIt = bodyMap.constFind(body.parentId);
-        if (parentIt == bodyMap.constEnd()) {
+        const auto parentBody = snapshot.body(body.parentId);
+        if (!parentBody) {
             parentName = QStringLiteral("ID %1").arg(body.parentId);
         } else {
-            const CelestialBody& parent = parentIt.value();
+            const CelestialBody& parent = *parentBody;
             parentName = parent.name.trimmed().isEmpty()
                 ? QStringLiteral("ID %1").arg(parent.id)
                 : QStringLiteral("%1 (ID %2)").arg(parent.name, QString::number(parent.id));
 
-            if (body.orbitsBarycenter && OrbitClassifier::isBarycenterType(parent.type)) {
+            if (body.orbitsBarycenter && parent.taxon.hasFlag(BodyTaxon::BarycenterTypeFlag)) {
                 parentName += QStringLiteral(" — барицентр пары");
             }
         }
@@ -123,6 +134,8 @@ void BodyDetailsWidget::setBody(const CelestialBody& body, const QHash<int, Cele
     setFieldValue(QStringLiteral("parent"), parentName);
     setFieldValue(QStringLiteral("relation"), formatText(body.parentRelationType));
     setFieldValue(QStringLiteral("semiMajorAxis"), formatSemiMajorAxis(body.semiMajorAxisAu));
+    setFieldValue(QStringLiteral("eccentricity"), fallbackText(formatDouble(body.orbit.eccentricity, 4)));
+    setFieldValue(QStringLiteral("orbitalPeriod"), formatOrbitalPeriod(body.orbit.orbitalPeriodDays));
     setFieldValue(QStringLiteral("orbitsBarycenter"), yesNo(body.orbitsBarycenter));
 
     setFieldValue(QStringLiteral("gravity"), formatGravity(body.surfaceGravityMs2));
@@ -132,8 +145,8 @@ void BodyDetailsWidget::setBody(const CelestialBody& body, const QHash<int, Cele
     setFieldValue(QStringLiteral("dayLength"), formatDayLength(body.rotationPeriodDays, body.isTidallyLocked));
     setFieldValue(QStringLiteral("axialTilt"), formatAxialTilt(body.axialTiltDeg));
 
-    setFieldValue(QStringLiteral("atmosphereComposition"), formatComposition(body.atmoComposition));
-    setFieldValue(QStringLiteral("materials"), formatComposition(body.materials));
+    setFieldValue(QStringLiteral("atmosphereComposition"), formatComposition(compositionParts(body.atmoComposition)));
+    setFieldValue(QStringLiteral("materials"), formatComposition(compositionParts(body.materials)));
     setFieldValue(QStringLiteral("pressure"), formatPressure(body.atmospherePressureAtm));
     setFieldValue(QStringLiteral("volcanism"), formatText(body.volcanism));
     setFieldValue(QStringLiteral("terraforming"), formatText(body.terraformingState));
@@ -169,6 +182,11 @@ QString BodyDetailsWidget::formatSemiMajorAxis(double value) const {
     return fallbackText(number.isEmpty() ? QString() : number + QStringLiteral(" а.е."));
 }
 
+QString BodyDetailsWidget::formatOrbitalPeriod(double valueDays) const {
+    const QString number = formatDouble(valueDays, 2);
+    return fallbackText(number.isEmpty() ? QString() : number + QStringLiteral(" сут"));
+}
+
 QString BodyDetailsWidget::formatRadiusKm(double value) const {
     const QString number = formatDouble(value, 2);
     return fallbackText(number.isEmpty() ? QString() : number + QStringLiteral(" км"));
@@ -219,22 +237,8 @@ QString BodyDetailsWidget::formatAxialTilt(double valueDeg) const {
     return fallbackText(number.isEmpty() ? QString() : number + QStringLiteral("°"));
 }
 
-QString BodyDetailsWidget::formatComposition(const QVector<CelestialBody::CompositionPart>& parts) const {
-    if (parts.isEmpty()) {
-        return QStringLiteral("нет данных");
-    }
-
-    QStringList chunks;
-    chunks.reserve(parts.size());
-    for (const CelestialBody::CompositionPart& part : parts) {
-        const QString name = part.name.trimmed();
-        if (name.isEmpty()) {
-            continue;
-        }
-        chunks.push_back(QStringLiteral("%1 %2%").arg(name, QString::number(part.percent, 'f', 1)));
-    }
-
-    return chunks.isEmpty() ? QStringLiteral("нет данных") : chunks.join(QStringLiteral(", "));
+QString BodyDetailsWidget::formatComposition(const QStringList& parts) const {
+    return parts.isEmpty() ? QStringLiteral("нет данных") : parts.join(QStringLiteral(", "));
 }
 
 QString BodyDetailsWidget::formatPressure(double valueAtm) const {
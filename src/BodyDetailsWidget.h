@@ -1,9 +1,11 @@
 #pragma once
 
 #include <QHash>
+#include <QStringList>
 #include <QWidget>
 
 #include "CelestialBody.h"
+#include "SystemSnapshot.h"
 
 class QLabel;
 class QToolBox;
@@ -13,7 +15,7 @@ class BodyDetailsWidget : public QWidget {
 public:
     explicit BodyDetailsWidget(QWidget* parent = nullptr);
 
-    void setBody(const CelestialBody& body, const QHash<int, CelestialBody>& bodyMap);
+    void setBody(const CelestialBody& body, const SystemSnapshot& snapshot);
     void setPlaceholderText(const QString& text);
 
 private:
@@ -22,13 +24,14 @@ private:
     QString formatText(const QString& value) const;
     QString formatDouble(const double value, const int precision) const;
     QString formatSemiMajorAxis(double value) const;
+    QString formatOrbitalPeriod(double valueDays) const;
     QString formatRadiusKm(double value) const;
     QString formatGravity(double valueMs2) const;
     QString formatTemperature(double valueK) const;
     QString formatMass(const CelestialBody& body) const;
     QString formatDayLength(double valueDays, bool tidallyLocked) const;
     QString formatAxialTilt(double valueDeg) const;
-    QString formatComposition(const QVector<CelestialBody::CompositionPart>& parts) const;
+    QString formatComposition(const QStringList& parts) const;
     QString formatPressure(double valueAtm) const;
     QString bodyClassText(CelestialBody::BodyClass bodyClass) const;
 
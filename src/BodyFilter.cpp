@@ -0,0 +1,935 @@
+#include "BodyFilter.h"
+
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "SystemSnapshot.h"
+
+namespace {
+
+constexpr float kMissingValue = std::numeric_limits<float>::quiet_NaN();
+constexpr double kEarthGravityMs2 = 9.80665;
+// Пакет строк на один проход байткода: маски стека (по байту на строку) остаются в L1.
+constexpr int kEvaluationBatchRows = 4096;
+
+constexpr int kAtmosphereOperandBase = BodyFilterColumns::kFieldCount;
+constexpr int kMaterialOperandBase = kAtmosphereOperandBase + AtmosphereComposition::kSlotCount;
+constexpr int kOperandCount = kMaterialOperandBase + MaterialComposition::kSlotCount;
+
+// 0 в исходных данных означает "нет данных" для величин, которые не бывают нулевыми.
+float knownOrMissing(const double value) {
+    return value != 0.0 ? static_cast<float>(value) : kMissingValue;
+}
+
+float flagValue(const bool value) {
+    return value ? 1.0f : 0.0f;
+}
+
+enum class ValueType {
+    Number,
+    Boolean
+};
+
+struct FieldName {
+    const char* name;
+    BodyFilterField field;
+};
+
+const FieldName kFieldNames[] = {
+    {"id", BodyFilterField::Id},
+    {"parent", BodyFilterField::ParentId},
+    {"distance", BodyFilterField::DistanceLs},
+    {"sma", BodyFilterField::SemiMajorAxisAu},
+    {"radius", BodyFilterField::RadiusKm},
+    {"gravity", BodyFilterField::GravityG},
+    {"temperature", BodyFilterField::TemperatureK},
+    {"pressure", BodyFilterField::PressureAtm},
+    {"mass", BodyFilterField::MassEarth},
+    {"rotation", BodyFilterField::RotationDays},
+    {"tilt", BodyFilterField::AxialTiltDeg},
+    {"terraformable", BodyFilterField::Terraformable},
+    {"locked", BodyFilterField::TidallyLocked},
+    {"star", BodyFilterField::Star},
+    {"planet", BodyFilterField::Planet},
+    {"moon", BodyFilterField::Moon},
+    {"barycenter", BodyFilterField::Barycenter},
+};
+
+struct GasFormula {
+    const char* formula;
+    AtmosphereGas gas;
+};
+
+// Химические формулы в дополнение к именам: "atmosphere contains CO2", "atmo.n2 >= 70".
+const GasFormula kGasFormulas[] = {
+    {"nh3", AtmosphereGas::Ammonia},
+    {"ar", AtmosphereGas::Argon},
+    {"co2", AtmosphereGas::CarbonDioxide},
+    {"he", AtmosphereGas::Helium},
+    {"h2", AtmosphereGas::Hydrogen},
+    {"fe", AtmosphereGas::Iron},
+    {"ch4", AtmosphereGas::Methane},
+    {"ne", AtmosphereGas::Neon},
+    {"n2", AtmosphereGas::Nitrogen},
+    {"o2", AtmosphereGas::Oxygen},
+    {"so2", AtmosphereGas::SulphurDioxide},
+    {"h2o", AtmosphereGas::Water},
+};
+
+// Единицы после чисел допускаются для читаемости и не пересчитываются.
+const char* const kUnitSuffixes[] = {"k", "g", "atm", "ls", "au", "km", "d", "deg"};
+
+std::optional<AtmosphereGas> gasFromToken(const QString& token) {
+    const QString lower = token.toLower();
+    for (const GasFormula& formula : kGasFormulas) {
+        if (lower == QLatin1String(formula.formula)) {
+            return formula.gas;
+        }
+    }
+    return BodyComposition::slotFromName<AtmosphereGas>(token);
+}
+
+bool isAtmosphereGroup(const QString& lower) {
+    return lower == QLatin1String("atmosphere") || lower == QLatin1String("atmo");
+}
+
+bool isMaterialGroup(const QString& lower) {
+    return lower == QLatin1String("materials") || lower == QLatin1String("mat");
+}
+
+ColumnComparison mirrored(const ColumnComparison comparison) {
+    switch (comparison) {
+    case ColumnComparison::Less:
+        return ColumnComparison::Greater;
+    case ColumnComparison::LessOrEqual:
+        return ColumnComparison::GreaterOrEqual;
+    case ColumnComparison::Greater:
+        return ColumnComparison::Less;
+    case ColumnComparison::GreaterOrEqual:
+        return ColumnComparison::LessOrEqual;
+    case ColumnComparison::Equal:
+    case ColumnComparison::NotEqual:
+        break;
+    }
+    return comparison;
+}
+
+struct Token {
+    enum Kind {
+        End,
+        Number,
+        Identifier,
+        Comparison,
+        LeftParen,
+        RightParen,
+        Minus,
+        And,
+        Or,
+        Not,
+        Between,
+        Contains
+    };
+
+    Kind kind = End;
+    int position = 0;
+    QString text;
+    float number = 0.0f;
+    ColumnComparison comparison = ColumnComparison::Equal;
+};
+
+struct CompileError {
+    QString message;
+    int position = -1;
+};
+
+bool isIdentifierStart(const QChar ch) {
+    return ch.isLetter() || ch == QLatin1Char('_');
+}
+
+bool isIdentifierPart(const QChar ch) {
+    return ch.isLetterOrNumber() || ch == QLatin1Char('_') || ch == QLatin1Char('.');
+}
+
+class Lexer {
+public:
+    explicit Lexer(const QString& source)
+        : m_source(source) {
+    }
+
+    bool tokenize(QVector<Token>* tokens, CompileError* error) {
+        while (true) {
+            skipSpaces();
+            if (m_position >= m_source.size()) {
+                Token end;
+                end.kind = Token::End;
+                end.position = m_position;
+                tokens->push_back(end);
+                return true;
+            }
+
+            Token token;
+            token.position = m_position;
+            const QChar ch = m_source.at(m_position);
+            if (ch.isDigit() || (ch == QLatin1Char('.') && peek(1).isDigit())) {
+                if (!readNumber(&token, error)) {
+                    return false;
+                }
+            } else if (isIdentifierStart(ch)) {
+                readIdentifier(&token);
+            } else if (!readPunctuation(&token)) {
+                error->message = QStringLiteral("Неожиданный символ «%1»").arg(ch);
+                error->position = m_position;
+                return false;
+            }
+            tokens->push_back(token);
+        }
+    }
+
+private:
+    QChar peek(const int offset) const {
+        const int index = m_position + offset;
+        return index < m_source.size() ? m_source.at(index) : QChar();
+    }
+
+    void skipSpaces() {
+        while (m_position < m_source.size() && m_source.at(m_position).isSpace()) {
+            ++m_position;
+        }
+    }
+
+    bool readNumber(Token* token, CompileError* error) {
+        const int start = m_position;
+        while (m_position < m_source.size() && (m_source.at(m_position).isDigit() || m_source.at(m_position) == QLatin1Char('.'))) {
+            ++m_position;
+        }
+        if (m_position < m_source.size() && (m_source.at(m_position) == QLatin1Char('e') || m_source.at(m_position) == QLatin1Char('E'))
+            && (peek(1).isDigit() || ((peek(1) == QLatin1Char('-') || peek(1) == QLatin1Char('+')) && peek(2).isDigit()))) {
+            m_position += 2;
+            while (m_position < m_source.size() && m_source.at(m_position).isDigit()) {
+                ++m_position;
+            }
+        }
+
+        bool ok = false;
+        token->kind = Token::Number;
+        token->text = m_source.mid(start, m_position - start);
+        token->number = token->text.toFloat(&ok);
+        if (!ok) {
+            error->message = QStringLiteral("Некорректное число «%1»").arg(token->text);
+            error->position = start;
+            return false;
+        }
+
+        skipUnitSuffix();
+        return true;
+    }
+
+    void skipUnitSuffix() {
+        const int afterNumber = m_position;
+        skipSpaces();
+        if (m_position < m_source.size() && m_source.at(m_position) == QLatin1Char('%')) {
+            ++m_position;
+            return;
+        }
+
+        int end = m_position;
+        while (end < m_source.size() && m_source.at(end).isLetter()) {
+            ++end;
+        }
+        const QString word = m_source.mid(m_position, end - m_position).toLower();
+        if (end < m_source.size() && isIdentifierPart(m_source.at(end))) {
+            m_position = afterNumber;
+            return;
+        }
+        for (const char* unit : kUnitSuffixes) {
+            if (word == QLatin1String(unit)) {
+                m_position = end;
+                return;
+            }
+        }
+        m_position = afterNumber;
+    }
+
+    void readIdentifier(Token* token) {
+        const int start = m_position;
+        while (m_position < m_source.size() && isIdentifierPart(m_source.at(m_position))) {
+            ++m_position;
+        }
+        token->text = m_source.mid(start, m_position - start);
+
+        const QString lower = token->text.toLower();
+        if (lower == QLatin1String("and")) {
+            token->kind = Token::And;
+        } else if (lower == QLatin1String("or")) {
+            token->kind = Token::Or;
+        } else if (lower == QLatin1String("not")) {
+            token->kind = Token::Not;
+        } else if (lower == QLatin1String("between")) {
+            token->kind = Token::Between;
+        } else if (lower == QLatin1String("contains")) {
+            token->kind = Token::Contains;
+        } else {
+            token->kind = Token::Identifier;
+        }
+    }
+
+    bool readPunctuation(Token* token) {
+        const QChar ch = m_source.at(m_position);
+        const QChar next = peek(1);
+        int length = 1;
+        token->kind = Token::Comparison;
+        if (ch == QLatin1Char('(')) {
+            token->kind = Token::LeftParen;
+        } else if (ch == QLatin1Char(')')) {
+            token->kind = Token::RightParen;
+        } else if (ch == QLatin1Char('-')) {
+            token->kind = Token::Minus;
+        } else if (ch == QLatin1Char('<') && next == QLatin1Char('=')) {
+            token->comparison = ColumnComparison::LessOrEqual;
+            length = 2;
+        } else if (ch == QLatin1Char('<') && next == QLatin1Char('>')) {
+            token->comparison = ColumnComparison::NotEqual;
+            length = 2;
+        } else if (ch == QLatin1Char('<')) {
+            token->comparison = ColumnComparison::Less;
+        } else if (ch == QLatin1Char('>') && next == QLatin1Char('=')) {
+            token->comparison = ColumnComparison::GreaterOrEqual;
+            length = 2;
+        } else if (ch == QLatin1Char('>')) {
+            token->comparison = ColumnComparison::Greater;
+        } else if (ch == QLatin1Char('=')) {
+            token->comparison = ColumnComparison::Equal;
+            length = next == QLatin1Char('=') ? 2 : 1;
+        } else if (ch == QLatin1Char('!') && next == QLatin1Char('=')) {
+            token->comparison = ColumnComparison::NotEqual;
+            length = 2;
+        } else if (ch == QChar(0x2264)) {
+            token->comparison = ColumnComparison::LessOrEqual;
+        } else if (ch == QChar(0x2265)) {
+            token->comparison = ColumnComparison::GreaterOrEqual;
+        } else if (ch == QChar(0x2260)) {
+            token->comparison = ColumnComparison::NotEqual;
+        } else if (ch == QLatin1Char('!')) {
+            token->kind = Token::Not;
+        } else if (ch == QLatin1Char('&') && next == QLatin1Char('&')) {
+            token->kind = Token::And;
+            length = 2;
+        } else if (ch == QLatin1Char('|') && next == QLatin1Char('|')) {
+            token->kind = Token::Or;
+            length = 2;
+        } else {
+            return false;
+        }
+
+        token->text = m_source.mid(m_position, length);
+        m_position += length;
+        return true;
+    }
+
+    const QString& m_source;
+    int m_position = 0;
+};
+
+struct Node {
+    enum Kind {
+        Constant,
+        Operand,
+        Compare,
+        Between,
+        And,
+        Or,
+        Not
+    };
+
+    Kind kind = Constant;
+    int position = 0;
+    float value = 0.0f;
+    int operand = -1;
+    ValueType operandType = ValueType::Number;
+    ColumnComparison comparison = ColumnComparison::Equal;
+    std::unique_ptr<Node> first;
+    std::unique_ptr<Node> second;
+    std::unique_ptr<Node> third;
+};
+
+std::unique_ptr<Node> makeNode(const Node::Kind kind, const int position) {
+    auto node = std::make_unique<Node>();
+    node->kind = kind;
+    node->position = position;
+    return node;
+}
+
+// Рекурсивный спуск:
+//   or        := and ("or" and)*
+//   and       := not ("and" not)*
+//   not       := "not" not | predicate
+//   predicate := "(" or ")" | group "contains" name
+//              | operand [comparison operand | "between" operand "and" operand]
+//   operand   := ["-"] number | field | atmo.<газ> | mat.<материал>
+class Parser {
+public:
+    Parser(const QVector<Token>& tokens, CompileError* error)
+        : m_tokens(tokens),
+          m_error(error) {
+    }
+
+    std::unique_ptr<Node> parseExpression() {
+        auto root = parseOr();
+        if (root && current().kind != Token::End) {
+            fail(QStringLiteral("Лишний текст после выражения: «%1»").arg(current().text), current().position);
+            return nullptr;
+        }
+        return root;
+    }
+
+private:
+    const Token& current() const {
+        return m_tokens.at(m_index);
+    }
+
+    const Token& lookahead(const int offset) const {
+        return m_tokens.at(qMin(m_index + offset, m_tokens.size() - 1));
+    }
+
+    const Token& advance() {
+        const Token& token = m_tokens.at(m_index);
+        if (m_index + 1 < m_tokens.size()) {
+            ++m_index;
+        }
+        return token;
+    }
+
+    std::nullptr_t fail(const QString& message, const int position) {
+        if (m_error->position < 0) {
+            m_error->message = message;
+            m_error->position = position;
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<Node> parseBinary(const Token::Kind operatorKind,
+                                      const Node::Kind nodeKind,
+                                      std::unique_ptr<Node> (Parser::*parseOperand)()) {
+        auto lhs = (this->*parseOperand)();
+        while (lhs && current().kind == operatorKind) {
+            auto node = makeNode(nodeKind, advance().position);
+            node->first = std::move(lhs);
+            node->second = (this->*parseOperand)();
+            if (!node->second) {
+                return nullptr;
+            }
+            lhs = std::move(node);
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<Node> parseOr() {
+        return parseBinary(Token::Or, Node::Or, &Parser::parseAnd);
+    }
+
+    std::unique_ptr<Node> parseAnd() {
+        return parseBinary(Token::And, Node::And, &Parser::parseNot);
+    }
+
+    std::unique_ptr<Node> parseNot() {
+        if (current().kind == Token::Not) {
+            auto node = makeNode(Node::Not, advance().position);
+            node->first = parseNot();
+            if (!node->first) {
+                return nullptr;
+            }
+            return node;
+        }
+        return parsePredicate();
+    }
+
+    std::unique_ptr<Node> parsePredicate() {
+        if (current().kind == Token::LeftParen) {
+            const int position = advance().position;
+            auto inner = parseOr();
+            if (!inner) {
+                return nullptr;
+            }
+            if (current().kind != Token::RightParen) {
+                return fail(QStringLiteral("Не закрыта скобка, открытая здесь"), position);
+            }
+            advance();
+            return inner;
+        }
+
+        if (current().kind == Token::Identifier && lookahead(1).kind == Token::Contains) {
+            return parseContains();
+        }
+
+        auto lhs = parseOperand();
+        if (!lhs) {
+            return nullptr;
+        }
+
+        if (current().kind == Token::Comparison) {
+            auto node = makeNode(Node::Compare, current().position);
+            node->comparison = advance().comparison;
+            node->first = std::move(lhs);
+            node->second = parseOperand();
+            if (!node->second) {
+                return nullptr;
+            }
+            return node;
+        }
+
+        if (current().kind == Token::Between) {
+            auto node = makeNode(Node::Between, advance().position);
+            node->first = std::move(lhs);
+            node->second = parseOperand();
+            if (!node->second) {
+                return nullptr;
+            }
+            if (current().kind != Token::And) {
+                return fail(QStringLiteral("Ожидалось «and» во фразе between … and …"), current().position);
+            }
+            advance();
+            node->third = parseOperand();
+            if (!node->third) {
+                return nullptr;
+            }
+            return node;
+        }
+
+        return lhs;
+    }
+
+    // "atmosphere contains CO2" ≡ atmo.co2 > 0, "materials contains polonium" ≡ mat.polonium > 0.
+    std::unique_ptr<Node> parseContains() {
+        const Token& group = advance();
+        const int position = advance().position;
+        if (current().kind != Token::Identifier) {
+            return fail(QStringLiteral("После contains ожидалось имя газа или материала"), current().position);
+        }
+        const Token& name = advance();
+
+        auto slot = makeNode(Node::Operand, name.position);
+        const QString groupName = group.text.toLower();
+        if (isAtmosphereGroup(groupName)) {
+            const auto gas = gasFromToken(name.text);
+            if (!gas) {
+                return fail(QStringLiteral("Неизвестный газ «%1»").arg(name.text), name.position);
+            }
+            slot->operand = kAtmosphereOperandBase + static_cast<int>(*gas);
+        } else if (isMaterialGroup(groupName)) {
+            const auto material = BodyComposition::slotFromName<RawMaterial>(name.text);
+            if (!material) {
+                return fail(QStringLiteral("Неизвестный материал «%1»").arg(name.text), name.position);
+            }
+            slot->operand = kMaterialOperandBase + static_cast<int>(*material);
+        } else {
+            return fail(QStringLiteral("contains применим только к atmosphere и materials, а не к «%1»").arg(group.text),
+                        group.position);
+        }
+
+        auto node = makeNode(Node::Compare, position);
+        node->comparison = ColumnComparison::Greater;
+        node->first = std::move(slot);
+        node->second = makeNode(Node::Constant, position);
+        return node;
+    }
+
+    std::unique_ptr<Node> parseOperand() {
+        const Token& token = current();
+        if (token.kind == Token::Minus && lookahead(1).kind == Token::Number) {
+            advance();
+            auto node = makeNode(Node::Constant, token.position);
+            node->value = -advance().number;
+            return node;
+        }
+        if (token.kind == Token::Number) {
+            auto node = makeNode(Node::Constant, token.position);
+            node->value = advance().number;
+            return node;
+        }
+        if (token.kind != Token::Identifier) {
+            return fail(token.kind == Token::End ? QStringLiteral("Выражение оборвано: ожидалось число или поле")
+                                                 : QStringLiteral("Ожидалось число или поле, а не «%1»").arg(token.text),
+                        token.position);
+        }
+
+        advance();
+        auto node = makeNode(Node::Operand, token.position);
+        if (!resolveField(token.text, node.get())) {
+            return fail(QStringLiteral("Неизвестное поле «%1»").arg(token.text), token.position);
+        }
+        return node;
+    }
+
+    static bool resolveField(const QString& name, Node* node) {
+        const QString lower = name.toLower();
+        const int dot = lower.indexOf(QLatin1Char('.'));
+        if (dot > 0) {
+            const QString group = lower.left(dot);
+            const QString slotName = name.mid(dot + 1);
+            if (isAtmosphereGroup(group)) {
+                const auto gas = gasFromToken(slotName);
+                node->operand = gas ? kAtmosphereOperandBase + static_cast<int>(*gas) : -1;
+            } else if (isMaterialGroup(group)) {
+                const auto material = BodyComposition::slotFromName<RawMaterial>(slotName);
+                node->operand = material ? kMaterialOperandBase + static_cast<int>(*material) : -1;
+            }
+            return node->operand >= 0;
+        }
+
+        for (const FieldName& field : kFieldNames) {
+            if (lower == QLatin1String(field.name)) {
+                node->operand = static_cast<int>(field.field);
+                node->operandType = field.field >= BodyFilterField::Terraformable ? ValueType::Boolean : ValueType::Number;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const QVector<Token>& m_tokens;
+    CompileError* m_error = nullptr;
+    int m_index = 0;
+};
+
+std::optional<ValueType> checkTypes(const Node& node, CompileError* error) {
+    const auto fail = [error](const QString& message, const int position) -> std::optional<ValueType> {
+        error->message = message;
+        error->position = position;
+        return std::nullopt;
+    };
+    const auto expect = [&fail, error](const Node& child, const ValueType expected, const QString& message) {
+        const auto type = checkTypes(child, error);
+        if (!type) {
+            return false;
+        }
+        if (*type != expected) {
+            fail(message, child.position);
+            return false;
+        }
+        return true;
+    };
+
+    switch (node.kind) {
+    case Node::Constant:
+        return ValueType::Number;
+    case Node::Operand:
+        return node.operandType;
+    case Node::Compare:
+    case Node::Between: {
+        const QString message = QStringLiteral("Сравнивать можно только числа и числовые поля");
+        if (!expect(*node.first, ValueType::Number, message) || !expect(*node.second, ValueType::Number, message)
+            || (node.third && !expect(*node.third, ValueType::Number, message))) {
+            return std::nullopt;
+        }
+        return ValueType::Boolean;
+    }
+    case Node::And:
+    case Node::Or:
+    case Node::Not: {
+        const QString message = QStringLiteral("Ожидалось условие (сравнение, contains или флаг), а не число");
+        if (!expect(*node.first, ValueType::Boolean, message)
+            || (node.second && !expect(*node.second, ValueType::Boolean, message))) {
+            return std::nullopt;
+        }
+        return ValueType::Boolean;
+    }
+    }
+    return std::nullopt;
+}
+
+class Compiler {
+public:
+    explicit Compiler(QVector<BodyFilterInstruction>* program)
+        : m_program(program) {
+    }
+
+    int maxDepth() const {
+        return m_maxDepth;
+    }
+
+    void emit(const Node& node) {
+        switch (node.kind) {
+        case Node::Operand:
+            // Флаг как условие: столбец 0/1 сравнивается с нулём.
+            emitComparison(node, ColumnComparison::NotEqual, nullptr, 0.0f);
+            break;
+        case Node::Compare:
+            emitComparison(*node.first, node.comparison, node.second.get(), 0.0f);
+            break;
+        case Node::Between:
+            emitComparison(*node.first, ColumnComparison::GreaterOrEqual, node.second.get(), 0.0f);
+            emitComparison(*node.first, ColumnComparison::LessOrEqual, node.third.get(), 0.0f);
+            emitLogical(BodyFilterInstruction::And);
+            break;
+        case Node::And:
+        case Node::Or:
+            emit(*node.first);
+            emit(*node.second);
+            emitLogical(node.kind == Node::And ? BodyFilterInstruction::And : BodyFilterInstruction::Or);
+            break;
+        case Node::Not: {
+            emit(*node.first);
+            BodyFilterInstruction instruction;
+            instruction.opcode = BodyFilterInstruction::Not;
+            m_program->push_back(instruction);
+            break;
+        }
+        case Node::Constant:
+            break;
+        }
+    }
+
+private:
+    // rhs == nullptr — сравнение с константой rhsConstant.
+    void emitComparison(const Node& lhs, const ColumnComparison comparison, const Node* rhs, const float rhsConstant) {
+        const bool lhsIsColumn = lhs.kind == Node::Operand;
+        const bool rhsIsColumn = rhs && rhs->kind == Node::Operand;
+        const float rhsValue = rhs ? rhs->value : rhsConstant;
+
+        BodyFilterInstruction instruction;
+        instruction.comparison = comparison;
+        if (lhsIsColumn && rhsIsColumn) {
+            instruction.opcode = BodyFilterInstruction::CompareColumns;
+            instruction.operand = lhs.operand;
+            instruction.otherOperand = rhs->operand;
+        } else if (lhsIsColumn) {
+            instruction.opcode = BodyFilterInstruction::CompareColumnConstant;
+            instruction.operand = lhs.operand;
+            instruction.constant = rhsValue;
+        } else if (rhsIsColumn) {
+            // "1.2 > gravity" → "gravity < 1.2": столбец всегда слева, скан один и тот же.
+            instruction.opcode = BodyFilterInstruction::CompareColumnConstant;
+            instruction.comparison = mirrored(comparison);
+            instruction.operand = rhs->operand;
+            instruction.constant = lhs.value;
+        } else {
+            instruction.opcode = BodyFilterInstruction::PushConstant;
+            instruction.constant = flagValue(ColumnKernels::compare(lhs.value, comparison, rhsValue));
+        }
+        m_program->push_back(instruction);
+        m_maxDepth = qMax(m_maxDepth, ++m_depth);
+    }
+
+    void emitLogical(const BodyFilterInstruction::Opcode opcode) {
+        BodyFilterInstruction instruction;
+        instruction.opcode = opcode;
+        m_program->push_back(instruction);
+        --m_depth;
+    }
+
+    QVector<BodyFilterInstruction>* m_program = nullptr;
+    int m_depth = 0;
+    int m_maxDepth = 0;
+};
+
+} // namespace
+
+void BodyFilterColumns::reserve(const int count) {
+    for (auto& column : fields) {
+        column.reserve(count);
+    }
+    atmosphere.reserve(count);
+    materials.reserve(count);
+}
+
+void BodyFilterColumns::appendBody(const BodyHot& hot, const BodyCold& cold) {
+    const auto set = [this](const BodyFilterField field, const float value) {
+        fields[static_cast<size_t>(field)].push_back(value);
+    };
+
+    set(BodyFilterField::Id, static_cast<float>(hot.id));
+    set(BodyFilterField::ParentId, static_cast<float>(hot.parentId));
+    set(BodyFilterField::DistanceLs, static_cast<float>(hot.distanceToArrivalLs));
+    set(BodyFilterField::SemiMajorAxisAu, knownOrMissing(hot.semiMajorAxisAu));
+    set(BodyFilterField::RadiusKm, knownOrMissing(hot.physicalRadiusKm));
+    set(BodyFilterField::GravityG, knownOrMissing(cold.surfaceGravityMs2 / kEarthGravityMs2));
+    set(BodyFilterField::TemperatureK, knownOrMissing(cold.surfaceTemperatureK));
+    set(BodyFilterField::PressureAtm, static_cast<float>(cold.atmospherePressureAtm));
+    set(BodyFilterField::MassEarth, knownOrMissing(cold.massEarth));
+    set(BodyFilterField::RotationDays, knownOrMissing(cold.rotationPeriodDays));
+    set(BodyFilterField::AxialTiltDeg, static_cast<float>(cold.axialTiltDeg));
+    set(BodyFilterField::Terraformable, flagValue(isTerraformableState(cold.terraformingState)));
+    set(BodyFilterField::TidallyLocked, flagValue(cold.isTidallyLocked));
+    set(BodyFilterField::Star, flagValue(hot.bodyClass == CelestialBody::BodyClass::Star));
+    set(BodyFilterField::Planet, flagValue(hot.bodyClass == CelestialBody::BodyClass::Planet));
+    set(BodyFilterField::Moon, flagValue(hot.bodyClass == CelestialBody::BodyClass::Moon));
+    set(BodyFilterField::Barycenter, flagValue(hot.bodyClass == CelestialBody::BodyClass::Barycenter));
+    atmosphere.append(cold.atmoComposition);
+    materials.append(cold.materials);
+}
+
+const float* BodyFilterColumns::operandColumn(const int operand) const {
+    if (operand < 0 || operand >= kOperandCount) {
+        return nullptr;
+    }
+    if (operand < kAtmosphereOperandBase) {
+        return fields[static_cast<size_t>(operand)].constData();
+    }
+    if (operand < kMaterialOperandBase) {
+        return atmosphere.column(static_cast<AtmosphereGas>(operand - kAtmosphereOperandBase));
+    }
+    return materials.column(static_cast<RawMaterial>(operand - kMaterialOperandBase));
+}
+
+BodyFilterColumns BodyFilterColumns::fromSnapshot(const SystemSnapshot& snapshot) {
+    BodyFilterColumns columns;
+    const QVector<BodyHot>& hotBodies = snapshot.hotBodies();
+    const QVector<BodyCold>& coldBodies = snapshot.coldBodies();
+    columns.reserve(hotBodies.size());
+    for (int index = 0; index < hotBodies.size(); ++index) {
+        columns.appendBody(hotBodies.at(index), coldBodies.at(index));
+    }
+    return columns;
+}
+
+BodyFilter BodyFilter::compile(const QString& expression) {
+    BodyFilter filter;
+    if (expression.trimmed().isEmpty()) {
+        return filter;
+    }
+
+    CompileError error;
+    QVector<Token> tokens;
+    Lexer lexer(expression);
+    if (!lexer.tokenize(&tokens, &error)) {
+        filter.m_errorMessage = error.message;
+        filter.m_errorPosition = error.position;
+        return filter;
+    }
+
+    Parser parser(tokens, &error);
+    const std::unique_ptr<Node> root = parser.parseExpression();
+    std::optional<ValueType> rootType;
+    if (root) {
+        rootType = checkTypes(*root, &error);
+        if (rootType && *rootType != ValueType::Boolean) {
+            error.message = QStringLiteral("Выражение должно быть условием, например gravity < 1.2");
+            error.position = root->position;
+            rootType.reset();
+        }
+    }
+    if (!rootType) {
+        filter.m_errorMessage = error.message;
+        filter.m_errorPosition = qMax(0, error.position);
+        return filter;
+    }
+
+    Compiler compiler(&filter.m_program);
+    compiler.emit(*root);
+    filter.m_maxStackDepth = compiler.maxDepth();
+    return filter;
+}
+
+bool BodyFilter::isValid() const {
+    return m_errorPosition < 0;
+}
+
+bool BodyFilter::matchesAll() const {
+    return isValid() && m_program.isEmpty();
+}
+
+const QString& BodyFilter::errorMessage() const {
+    return m_errorMessage;
+}
+
+int BodyFilter::errorPosition() const {
+    return m_errorPosition;
+}
+
+const QVector<BodyFilterInstruction>& BodyFilter::program() const {
+    return m_program;
+}
+
+QVector<quint8> BodyFilter::evaluate(const BodyFilterColumns& columns) const {
+    QVector<quint8> mask(columns.size());
+    evaluateRange(columns, 0, columns.size(), mask.data());
+    return mask;
+}
+
+void BodyFilter::evaluateRange(const BodyFilterColumns& columns, const int begin, const int end, quint8* out) const {
+    if (end <= begin) {
+        return;
+    }
+    if (!isValid() || m_program.isEmpty()) {
+        std::fill(out, out + (end - begin), quint8(isValid() ? 1 : 0));
+        return;
+    }
+
+    // Стек масок: по одному буферу на уровень, выделяются один раз на вызов.
+    const int batchCapacity = qMin(kEvaluationBatchRows, end - begin);
+    std::vector<std::vector<quint8>> stack(static_cast<size_t>(m_maxStackDepth), std::vector<quint8>(static_cast<size_t>(batchCapacity)));
+
+    for (int batchBegin = begin; batchBegin < end; batchBegin += kEvaluationBatchRows) {
+        const int rows = qMin(kEvaluationBatchRows, end - batchBegin);
+        size_t top = 0;
+        for (const BodyFilterInstruction& instruction : m_program) {
+            switch (instruction.opcode) {
+            case BodyFilterInstruction::CompareColumnConstant: {
+                quint8* mask = stack[top++].data();
+                std::fill(mask, mask + rows, quint8(1));
+                ColumnKernels::narrowMask(columns.operandColumn(instruction.operand) + batchBegin,
+                                          rows,
+                                          instruction.comparison,
+                                          instruction.constant,
+                                          mask);
+                break;
+            }
+            case BodyFilterInstruction::CompareColumns: {
+                quint8* mask = stack[top++].data();
+                const float* lhs = columns.operandColumn(instruction.operand) + batchBegin;
+                const float* rhs = columns.operandColumn(instruction.otherOperand) + batchBegin;
+                for (int row = 0; row < rows; ++row) {
+                    mask[row] = ColumnKernels::compare(lhs[row], instruction.comparison, rhs[row]) ? 1 : 0;
+                }
+                break;
+            }
+            case BodyFilterInstruction::PushConstant: {
+                quint8* mask = stack[top++].data();
+                std::fill(mask, mask + rows, quint8(instruction.constant != 0.0f ? 1 : 0));
+                break;
+            }
+            case BodyFilterInstruction::And:
+            case BodyFilterInstruction::Or: {
+                --top;
+                quint8* lhs = stack[top - 1].data();
+                const quint8* rhs = stack[top].data();
+                if (instruction.opcode == BodyFilterInstruction::And) {
+                    for (int row = 0; row < rows; ++row) {
+                        lhs[row] &= rhs[row];
+                    }
+                } else {
+                    for (int row = 0; row < rows; ++row) {
+                        lhs[row] |= rhs[row];
+                    }
+                }
+                break;
+            }
+            case BodyFilterInstruction::Not: {
+                quint8* mask = stack[top - 1].data();
+                for (int row = 0; row < rows; ++row) {
+                    mask[row] ^= 1;
+                }
+                break;
+            }
+            }
+        }
+        std::copy(stack.front().data(), stack.front().data() + rows, out + (batchBegin - begin));
+    }
+}
+
+QString BodyFilter::syntaxHelp() {
+    QStringList fields;
+    for (const FieldName& field : kFieldNames) {
+        fields.push_back(QLatin1String(field.name));
+    }
+    return QStringLiteral("Поля: %1, atmo.<газ>, mat.<материал> (доля в %).\n"
+                          "Операторы: < <= > >= = != between … and …, contains, and, or, not, скобки.\n"
+                          "Пример: gravity < 1.2 and temperature between 200 and 320 K and atmosphere contains CO2")
+        .arg(fields.join(QStringLiteral(", ")));
+}
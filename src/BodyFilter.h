@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <array>
+
+#include "BodyComposition.h"
+#include "BodyRecords.h"
+#include "ColumnKernels.h"
+
+class SystemSnapshot;
+
+// Скалярные поля тела, доступные в выражениях фильтра. Отсутствующие физические
+// значения хранятся как NaN и не проходят ни одно сравнение, кроме "!=".
+enum class BodyFilterField : quint8 {
+    Id,
+    ParentId,
+    DistanceLs,
+    SemiMajorAxisAu,
+    RadiusKm,
+    GravityG,
+    TemperatureK,
+    PressureAtm,
+    MassEarth,
+    RotationDays,
+    AxialTiltDeg,
+    // Флаги 0/1.
+    Terraformable,
+    TidallyLocked,
+    Star,
+    Planet,
+    Moon,
+    Barycenter,
+    Count
+};
+
+// Тела по столбцам для пакетной оценки фильтра: снимок системы или выборка корпуса.
+struct BodyFilterColumns {
+    static constexpr int kFieldCount = static_cast<int>(BodyFilterField::Count);
+
+    std::array<QVector<float>, kFieldCount> fields;
+    AtmosphereColumns atmosphere;
+    MaterialColumns materials;
+    // Для корпуса — rowid тел (в порядке строк), для снимка — пусто.
+    QVector<qint64> rowIds;
+
+    int size() const {
+        return fields.front().size();
+    }
+
+    void reserve(int count);
+    void appendBody(const BodyHot& hot, const BodyCold& cold);
+
+    const float* field(const BodyFilterField field) const {
+        return fields[static_cast<size_t>(field)].constData();
+    }
+
+    // Операнд байткода: сначала скалярные поля, затем слоты атмосферы, затем материалы.
+    const float* operandColumn(int operand) const;
+
+    // Строки — индексы graph снимка, включая виртуальный корень барицентров.
+    static BodyFilterColumns fromSnapshot(const SystemSnapshot& snapshot);
+};
+
+// Одна инструкция стековой машины. Каждая инструкция обрабатывает сразу пакет строк:
+// сравнение столбца с константой — SIMD-скан ColumnKernels, логика — побайтовые циклы по маскам.
+struct BodyFilterInstruction {
+    enum Opcode : quint8 {
+        CompareColumnConstant,
+        CompareColumns,
+        PushConstant,
+        And,
+        Or,
+        Not
+    };
+
+    Opcode opcode = PushConstant;
+    ColumnComparison comparison = ColumnComparison::Equal;
+    int operand = -1;
+    int otherOperand = -1;
+    float constant = 0.0f;
+};
+
+// Пользовательский фильтр тел, например:
+//   gravity < 1.2 and temperature between 200 and 320 K and atmosphere contains CO2
+//   terraformable and (mat.polonium > 1 or atmo.nitrogen >= 70)
+// Выражение разбирается, проверяется по типам и компилируется в байткод один раз,
+// затем вычисляется по столбцам пакетами, а не интерпретируется для каждого тела.
+class BodyFilter {
+public:
+    // Пустое выражение даёт допустимый фильтр, пропускающий все тела.
+    static BodyFilter compile(const QString& expression);
+
+    bool isValid() const;
+    bool matchesAll() const;
+    const QString& errorMessage() const;
+    // Позиция ошибки в исходной строке (0-based), -1 — ошибки нет.
+    int errorPosition() const;
+    const QVector<BodyFilterInstruction>& program() const;
+
+    // Маска 0/1 по строкам columns. Для недопустимого фильтра — все нули.
+    QVector<quint8> evaluate(const BodyFilterColumns& columns) const;
+    // Строки [begin, end) в out[0 .. end - begin).
+    void evaluateRange(const BodyFilterColumns& columns, int begin, int end, quint8* out) const;
+
+    // Имена полей для подсказки в интерфейсе.
+    static QString syntaxHelp();
+
+private:
+    QVector<BodyFilterInstruction> m_program;
+    int m_maxStackDepth = 0;
+    QString m_errorMessage;
+    int m_errorPosition = -1;
+};
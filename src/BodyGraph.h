@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QHash>
+#include <QVector>
+
+// Плотное представление иерархии: тела пронумерованы 0..n-1 (по возрастанию id),
+// дети каждого тела лежат подряд в childIndices (compressed sparse row).
+// Обходы раскладки и классификации работают по индексам без поиска в QHash.
+struct BodyGraph {
+    QVector<int> bodyIds;
+    QHash<int, int> indexById;
+    QVector<int> parentIndex;
+    // childOffsets[i]..childOffsets[i + 1] — диапазон детей тела i в childIndices.
+    QVector<int> childOffsets;
+    QVector<int> childIndices;
+    QVector<int> rootIndices;
+
+    int size() const {
+        return bodyIds.size();
+    }
+
+    int indexOf(const int bodyId) const {
+        return indexById.value(bodyId, -1);
+    }
+
+    int idAt(const int index) const {
+        return bodyIds.at(index);
+    }
+
+    int childCount(const int index) const {
+        return childOffsets.at(index + 1) - childOffsets.at(index);
+    }
+
+    const int* childrenBegin(const int index) const {
+        return childIndices.constData() + childOffsets.at(index);
+    }
+
+    const int* childrenEnd(const int index) const {
+        return childIndices.constData() + childOffsets.at(index + 1);
+    }
+};
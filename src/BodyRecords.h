@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <type_traits>
+
+#include "CelestialBody.h"
+
+// Горячая часть тела: поля, которые читают раскладка, классификация, отрисовка и
+// hit-test на каждом проходе. Запись компактная и тривиально копируемая, поэтому
+// плотный массив таких записей обходится без промахов кэша по строкам и составам.
+struct BodyHot {
+    // Младшие биты совпадают с BodyTaxon::TypeFlag и копируются из таксономии тела.
+    enum Flag : quint8 {
+        StarTypeFlag = BodyTaxon::StarTypeFlag,
+        PlanetTypeFlag = BodyTaxon::PlanetTypeFlag,
+        MoonTypeFlag = BodyTaxon::MoonTypeFlag,
+        BarycenterTypeFlag = BodyTaxon::BarycenterTypeFlag,
+        WorldTypeFlag = BodyTaxon::WorldTypeFlag,
+        VirtualRootFlag = 1 << 5,
+        OrbitsBarycenterFlag = 1 << 6
+    };
+    static constexpr quint8 kTypeFlagMask = 0x1F;
+
+    int id = -1;
+    int parentId = -1;
+    CelestialBody::BodyClass bodyClass = CelestialBody::BodyClass::Unknown;
+    quint8 flags = 0;
+    StarClass starClass = StarClass::Unknown;
+    StarLuminosity luminosity = StarLuminosity::MainSequence;
+    PlanetSubtype planetSubtype = PlanetSubtype::Unknown;
+    double distanceToArrivalLs = 0.0;
+    double semiMajorAxisAu = 0.0;
+    double physicalRadiusKm = 0.0;
+
+    bool hasFlag(const Flag flag) const {
+        return (flags & flag) != 0;
+    }
+};
+
+static_assert(std::is_trivially_copyable<BodyHot>::value, "BodyHot must stay trivially copyable");
+static_assert(sizeof(BodyHot) <= 64, "BodyHot must fit into one cache line");
+
+// Q_MOVABLE_TYPE, а не Q_PRIMITIVE_TYPE: QVector не должен обнулять id/parentId через memset.
+Q_DECLARE_TYPEINFO(BodyHot, Q_MOVABLE_TYPE);
+
+// Холодная часть тела: строки, составы и редкие физические параметры.
+// Нужна только панелям деталей и подписям, лежит по тем же плотным индексам, что и BodyHot.
+struct BodyCold {
+    QString parentRelationType;
+    QString name;
+    QString type;
+    // Элементы орбиты нужны эфемеридам один раз при построении снимка, поэтому лежат здесь.
+    OrbitalElements orbit;
+    double surfaceGravityMs2 = 0.0;
+    double surfaceTemperatureK = 0.0;
+    double rotationPeriodDays = 0.0;
+    bool isTidallyLocked = false;
+    QString atmosphereSummary;
+    double atmospherePressureAtm = 0.0;
+    double massEarth = 0.0;
+    double massSolar = 0.0;
+    double axialTiltDeg = 0.0;
+    QString volcanism;
+    QString terraformingState;
+    AtmosphereComposition atmoComposition;
+    MaterialComposition materials;
+};
+
+Q_DECLARE_TYPEINFO(BodyCold, Q_MOVABLE_TYPE);
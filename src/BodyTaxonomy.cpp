@@ -0,0 +1,262 @@
+#include "BodyTaxonomy.h"
+
+#include <QLatin1String>
+
+namespace {
+
+enum class TokenMatch : quint8 {
+    Prefix,
+    Contains
+};
+
+struct StarToken {
+    const char* token;
+    TokenMatch match;
+    StarClass starClass;
+};
+
+struct PlanetToken {
+    const char* token;
+    PlanetSubtype subtype;
+};
+
+struct TypeFlagToken {
+    const char* token;
+    quint8 flag;
+};
+
+// Таблицы просматриваются сверху вниз, побеждает первое совпадение, поэтому
+// более специфичные формулировки стоят раньше общих ("supermassive black hole" до "black hole",
+// "water giant" до "water world", "class ii" до "class i").
+constexpr StarToken kStarTokens[] = {
+    {"supermassive black hole", TokenMatch::Contains, StarClass::SupermassiveBlackHole},
+    {"black hole", TokenMatch::Contains, StarClass::BlackHole},
+    {"neutron", TokenMatch::Contains, StarClass::Neutron},
+    {"white dwarf", TokenMatch::Contains, StarClass::WhiteDwarf},
+    {"wolf-rayet", TokenMatch::Contains, StarClass::WolfRayet},
+    {"t tauri", TokenMatch::Contains, StarClass::TTauri},
+    {"herbig", TokenMatch::Contains, StarClass::HerbigAeBe},
+    {"ms-type", TokenMatch::Contains, StarClass::MSType},
+    {"s-type", TokenMatch::Contains, StarClass::SType},
+    {"o (", TokenMatch::Prefix, StarClass::O},
+    {"b (", TokenMatch::Prefix, StarClass::B},
+    {"a (", TokenMatch::Prefix, StarClass::A},
+    {"f (", TokenMatch::Prefix, StarClass::F},
+    {"g (", TokenMatch::Prefix, StarClass::G},
+    {"k (", TokenMatch::Prefix, StarClass::K},
+    {"m (", TokenMatch::Prefix, StarClass::M},
+    {"l (", TokenMatch::Prefix, StarClass::L},
+    {"t (", TokenMatch::Prefix, StarClass::T},
+    {"y (", TokenMatch::Prefix, StarClass::Y},
+    {"c star", TokenMatch::Prefix, StarClass::Carbon},
+    {"cn star", TokenMatch::Prefix, StarClass::Carbon},
+    {"cj star", TokenMatch::Prefix, StarClass::Carbon},
+    {"ch star", TokenMatch::Prefix, StarClass::Carbon},
+    {"chd star", TokenMatch::Prefix, StarClass::Carbon},
+    {"cs star", TokenMatch::Prefix, StarClass::Carbon},
+};
+
+constexpr PlanetToken kPlanetTokens[] = {
+    {"earth-like", PlanetSubtype::EarthLike},
+    {"earthlike", PlanetSubtype::EarthLike},
+    {"water giant", PlanetSubtype::WaterGiant},
+    {"water world", PlanetSubtype::WaterWorld},
+    {"ammonia world", PlanetSubtype::AmmoniaWorld},
+    {"metal-rich", PlanetSubtype::MetalRich},
+    {"metal rich", PlanetSubtype::MetalRich},
+    {"high metal", PlanetSubtype::HighMetalContent},
+    {"rocky ice", PlanetSubtype::RockyIce},
+    {"rocky", PlanetSubtype::Rocky},
+    {"icy", PlanetSubtype::Icy},
+    {"ice world", PlanetSubtype::Icy},
+    {"ice giant", PlanetSubtype::IceGiant},
+    {"water-based life", PlanetSubtype::GasGiantWaterLife},
+    {"water based life", PlanetSubtype::GasGiantWaterLife},
+    {"ammonia-based life", PlanetSubtype::GasGiantAmmoniaLife},
+    {"ammonia based life", PlanetSubtype::GasGiantAmmoniaLife},
+    {"class v gas giant", PlanetSubtype::GasGiantClassV},
+    {"class iv gas giant", PlanetSubtype::GasGiantClassIV},
+    {"class iii gas giant", PlanetSubtype::GasGiantClassIII},
+    {"class ii gas giant", PlanetSubtype::GasGiantClassII},
+    {"class i gas giant", PlanetSubtype::GasGiantClassI},
+    {"helium rich", PlanetSubtype::HeliumRichGasGiant},
+    {"helium-rich", PlanetSubtype::HeliumRichGasGiant},
+    {"helium gas giant", PlanetSubtype::HeliumGasGiant},
+    {"gas giant", PlanetSubtype::GasGiant},
+};
+
+constexpr TypeFlagToken kTypeFlagTokens[] = {
+    {"star", BodyTaxon::StarTypeFlag},
+    {"planet", BodyTaxon::PlanetTypeFlag},
+    {"moon", BodyTaxon::MoonTypeFlag},
+    {"barycentre", BodyTaxon::BarycenterTypeFlag},
+    {"barycenter", BodyTaxon::BarycenterTypeFlag},
+    {"world", BodyTaxon::WorldTypeFlag},
+    {"giant", BodyTaxon::WorldTypeFlag},
+};
+
+bool matchesToken(const QString& lowerText, const char* token, const TokenMatch match) {
+    const QLatin1String latinToken(token);
+    return match == TokenMatch::Prefix ? lowerText.startsWith(latinToken) : lowerText.contains(latinToken);
+}
+
+} // namespace
+
+BodyTaxon BodyTaxonomy::resolve(const QString& type, const QString& subType) {
+    BodyTaxon taxon;
+    taxon.resolved = true;
+
+    const QString lowerType = type.trimmed().toLower();
+    for (const TypeFlagToken& entry : kTypeFlagTokens) {
+        if (lowerType.contains(QLatin1String(entry.token))) {
+            taxon.typeFlags |= entry.flag;
+        }
+    }
+
+    const QString trimmedSubType = subType.trimmed();
+    const QString lowerDetail = trimmedSubType.isEmpty() ? lowerType : trimmedSubType.toLower();
+    if (lowerDetail.isEmpty()) {
+        return taxon;
+    }
+
+    const bool looksLikeStar = lowerDetail.contains(QLatin1String("star"))
+                               || lowerDetail.contains(QLatin1String("black hole"));
+    if (looksLikeStar) {
+        for (const StarToken& entry : kStarTokens) {
+            if (matchesToken(lowerDetail, entry.token, entry.match)) {
+                taxon.starClass = entry.starClass;
+                break;
+            }
+        }
+
+        if (lowerDetail.contains(QLatin1String("super giant")) || lowerDetail.contains(QLatin1String("supergiant"))) {
+            taxon.luminosity = StarLuminosity::SuperGiant;
+        } else if (lowerDetail.contains(QLatin1String("giant"))) {
+            taxon.luminosity = StarLuminosity::Giant;
+        }
+        return taxon;
+    }
+
+    for (const PlanetToken& entry : kPlanetTokens) {
+        if (lowerDetail.contains(QLatin1String(entry.token))) {
+            taxon.planetSubtype = entry.subtype;
+            break;
+        }
+    }
+
+    return taxon;
+}
+
+bool BodyTaxonomy::isGasGiant(const PlanetSubtype subtype) {
+    switch (subtype) {
+    case PlanetSubtype::GasGiantClassI:
+    case PlanetSubtype::GasGiantClassII:
+    case PlanetSubtype::GasGiantClassIII:
+    case PlanetSubtype::GasGiantClassIV:
+    case PlanetSubtype::GasGiantClassV:
+    case PlanetSubtype::GasGiantWaterLife:
+    case PlanetSubtype::GasGiantAmmoniaLife:
+    case PlanetSubtype::HeliumRichGasGiant:
+    case PlanetSubtype::HeliumGasGiant:
+    case PlanetSubtype::GasGiant:
+        return true;
+    default:
+        return false;
+    }
+}
+
+QString BodyTaxonomy::starClassName(const StarClass starClass) {
+    switch (starClass) {
+    case StarClass::Unknown:
+        break;
+    case StarClass::O:
+        return QStringLiteral("O");
+    case StarClass::B:
+        return QStringLiteral("B");
+    case StarClass::A:
+        return QStringLiteral("A");
+    case StarClass::F:
+        return QStringLiteral("F");
+    case StarClass::G:
+        return QStringLiteral("G");
+    case StarClass::K:
+        return QStringLiteral("K");
+    case StarClass::M:
+        return QStringLiteral("M");
+    case StarClass::L:
+        return QStringLiteral("L");
+    case StarClass::T:
+        return QStringLiteral("T");
+    case StarClass::Y:
+        return QStringLiteral("Y");
+    case StarClass::TTauri:
+        return QStringLiteral("T Tauri");
+    case StarClass::HerbigAeBe:
+        return QStringLiteral("Herbig Ae/Be");
+    case StarClass::WolfRayet:
+        return QStringLiteral("Wolf-Rayet");
+    case StarClass::Carbon:
+        return QStringLiteral("Carbon");
+    case StarClass::SType:
+        return QStringLiteral("S");
+    case StarClass::MSType:
+        return QStringLiteral("MS");
+    case StarClass::WhiteDwarf:
+        return QStringLiteral("White dwarf");
+    case StarClass::Neutron:
+        return QStringLiteral("Neutron star");
+    case StarClass::BlackHole:
+        return QStringLiteral("Black hole");
+    case StarClass::SupermassiveBlackHole:
+        return QStringLiteral("Supermassive black hole");
+    }
+    return QStringLiteral("Unknown");
+}
+
+QString BodyTaxonomy::planetSubtypeName(const PlanetSubtype subtype) {
+    switch (subtype) {
+    case PlanetSubtype::Unknown:
+        break;
+    case PlanetSubtype::MetalRich:
+        return QStringLiteral("Metal-rich body");
+    case PlanetSubtype::HighMetalContent:
+        return QStringLiteral("High metal content world");
+    case PlanetSubtype::Rocky:
+        return QStringLiteral("Rocky body");
+    case PlanetSubtype::RockyIce:
+        return QStringLiteral("Rocky ice world");
+    case PlanetSubtype::Icy:
+        return QStringLiteral("Icy body");
+    case PlanetSubtype::EarthLike:
+        return QStringLiteral("Earth-like world");
+    case PlanetSubtype::WaterWorld:
+        return QStringLiteral("Water world");
+    case PlanetSubtype::AmmoniaWorld:
+        return QStringLiteral("Ammonia world");
+    case PlanetSubtype::WaterGiant:
+        return QStringLiteral("Water giant");
+    case PlanetSubtype::IceGiant:
+        return QStringLiteral("Ice giant");
+    case PlanetSubtype::GasGiantClassI:
+        return QStringLiteral("Class I gas giant");
+    case PlanetSubtype::GasGiantClassII:
+        return QStringLiteral("Class II gas giant");
+    case PlanetSubtype::GasGiantClassIII:
+        return QStringLiteral("Class III gas giant");
+    case PlanetSubtype::GasGiantClassIV:
+        return QStringLiteral("Class IV gas giant");
+    case PlanetSubtype::GasGiantClassV:
+        return QStringLiteral("Class V gas giant");
+    case PlanetSubtype::GasGiantWaterLife:
+        return QStringLiteral("Gas giant with water-based life");
+    case PlanetSubtype::GasGiantAmmoniaLife:
+        return QStringLiteral("Gas giant with ammonia-based life");
+    case PlanetSubtype::HeliumRichGasGiant:
+        return QStringLiteral("Helium-rich gas giant");
+    case PlanetSubtype::HeliumGasGiant:
+        return QStringLiteral("Helium gas giant");
+    case PlanetSubtype::GasGiant:
+        return QStringLiteral("Gas giant");
+    }
+    return QStringLiteral("Unknown");
+}
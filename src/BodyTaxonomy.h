@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+enum class StarClass : quint8 {
+    Unknown,
+    O,
+    B,
+    A,
+    F,
+    G,
+    K,
+    M,
+    L,
+    T,
+    Y,
+    TTauri,
+    HerbigAeBe,
+    WolfRayet,
+    Carbon,
+    SType,
+    MSType,
+    WhiteDwarf,
+    Neutron,
+    BlackHole,
+    SupermassiveBlackHole
+};
+
+enum class StarLuminosity : quint8 {
+    MainSequence,
+    Giant,
+    SuperGiant
+};
+
+enum class PlanetSubtype : quint8 {
+    Unknown,
+    MetalRich,
+    HighMetalContent,
+    Rocky,
+    RockyIce,
+    Icy,
+    EarthLike,
+    WaterWorld,
+    AmmoniaWorld,
+    WaterGiant,
+    IceGiant,
+    GasGiantClassI,
+    GasGiantClassII,
+    GasGiantClassIII,
+    GasGiantClassIV,
+    GasGiantClassV,
+    GasGiantWaterLife,
+    GasGiantAmmoniaLife,
+    HeliumRichGasGiant,
+    HeliumGasGiant,
+    GasGiant
+};
+
+// Типизированная классификация тела. Строковый тип разбирается один раз в парсере,
+// дальше раскладка, классификатор орбит и отрисовка работают только с этими полями.
+struct BodyTaxon {
+    // Какие ключевые слова встречаются в исходной строке типа (без учёта регистра).
+    enum TypeFlag : quint8 {
+        StarTypeFlag = 1 << 0,
+        PlanetTypeFlag = 1 << 1,
+        MoonTypeFlag = 1 << 2,
+        BarycenterTypeFlag = 1 << 3,
+        // "world" или "giant": подтип планеты назван без слова "Planet".
+        WorldTypeFlag = 1 << 4
+    };
+
+    StarClass starClass = StarClass::Unknown;
+    StarLuminosity luminosity = StarLuminosity::MainSequence;
+    PlanetSubtype planetSubtype = PlanetSubtype::Unknown;
+    quint8 typeFlags = 0;
+    bool resolved = false;
+
+    bool hasFlag(const TypeFlag flag) const {
+        return (typeFlags & flag) != 0;
+    }
+};
+
+class BodyTaxonomy {
+public:
+    // type — основное поле типа (по нему ставятся TypeFlag), subType — уточнённый подтип,
+    // если источник хранит его отдельно (EDSM/Spansh). Без subType спектральный класс
+    // и подтип планеты берутся из type.
+    static BodyTaxon resolve(const QString& type, const QString& subType = QString());
+
+    static bool isGasGiant(PlanetSubtype subtype);
+
+    // Короткие названия в терминах игры — для сводок и экспорта.
+    static QString starClassName(StarClass starClass);
+    static QString planetSubtypeName(PlanetSubtype subtype);
+};
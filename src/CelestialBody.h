@@ -1,18 +1,16 @@
 #pragma once
 
 #include <QString>
-#include <QVector>
+
+#include "BodyComposition.h"
+#include "BodyTaxonomy.h"
+#include "OrbitalElements.h"
 
 inline constexpr int kExternalVirtualBarycenterMarkerId = 0;
 inline constexpr int kVirtualBarycenterRootId = 0;
 inline const QString kVirtualBarycenterRootType = QStringLiteral("Null");
 
 struct CelestialBody {
-    struct CompositionPart {
-        QString name;
-        double percent = 0.0;
-    };
-
     enum class BodyClass {
         Unknown,
         Star,
@@ -28,6 +26,7 @@ struct CelestialBody {
     QString type;
     double distanceToArrivalLs = 0.0;
     double semiMajorAxisAu = 0.0;
+    OrbitalElements orbit;
     double physicalRadiusKm = 0.0;
     double surfaceGravityMs2 = 0.0;
     double surfaceTemperatureK = 0.0;
@@ -40,14 +39,22 @@ struct CelestialBody {
     double axialTiltDeg = 0.0;
     QString volcanism;
     QString terraformingState;
-    QVector<CompositionPart> atmoComposition;
-    QVector<CompositionPart> materials;
+    AtmosphereComposition atmoComposition;
+    MaterialComposition materials;
     bool orbitsBarycenter = false;
     BodyClass bodyClass = BodyClass::Unknown;
-    QVector<int> children;
+    // Заполняется парсером вместе с type; без него SystemModelBuilder разбирает type сам.
+    BodyTaxon taxon;
 };
 
 inline bool isVirtualBarycenterRoot(const CelestialBody& body) {
     return body.id == kVirtualBarycenterRootId
            && body.type.compare(kVirtualBarycenterRootType, Qt::CaseInsensitive) == 0;
 }
+
+// "Candidate for terraforming", "Terraformable", "Terraforming", "Terraformed" — да;
+// пусто и "Not terraformable" — нет.
+inline bool isTerraformableState(const QString& terraformingState) {
+    const QString lower = terraformingState.trimmed().toLower();
+    return lower.contains(QLatin1String("terraform")) && !lower.startsWith(QLatin1String("not"));
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QVector>
+#include <QtConcurrent>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <vector>
+
+// Параллельный отбор k лучших строк по плотным столбцам (TerraformingScorer, SystemFingerprintSearch).
+// Строки режутся на блоки по chunkRows; каждая задача пула считает значения своего блока
+// в буфер, пропускает строки с нулём в маске и держит кучу из k лучших. Затем кучи блоков
+// сливаются и частично сортируются. Candidate — агрегат {int row; float value}, better задаёт
+// строгий порядок выдачи; при равенстве значений он должен сравнивать строки, тогда ответ не
+// зависит от разбиения на блоки.
+class ChunkedTopK {
+public:
+    // Куча с худшим из кандидатов на вершине.
+    template <typename Candidate, typename Better>
+    static void offer(std::vector<Candidate>& heap, const int k, const Candidate& candidate, Better better) {
+        if (static_cast<int>(heap.size()) < k) {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end(), better);
+            return;
+        }
+
+        if (better(candidate, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+
+    // evaluate(begin, end, out) пишет значения строк [begin, end) в out[0 .. end - begin).
+    // mask — по байту на строку или nullptr.
+    template <typename Candidate, typename Evaluate, typename Better>
+    static QVector<Candidate> select(const int rowCount,
+                                     const int chunkRows,
+                                     const int k,
+                                     const quint8* mask,
+                                     Evaluate evaluate,
+                                     Better better) {
+        if (k <= 0 || rowCount <= 0) {
+            return {};
+        }
+
+        struct Chunk {
+            int begin = 0;
+            int end = 0;
+            std::vector<Candidate> best;
+        };
+
+        QVector<Chunk> chunks;
+        chunks.reserve((rowCount + chunkRows - 1) / chunkRows);
+        for (int begin = 0; begin < rowCount; begin += chunkRows) {
+            Chunk chunk;
+            chunk.begin = begin;
+            chunk.end = qMin(rowCount, begin + chunkRows);
+            chunks.push_back(chunk);
+        }
+
+        QtConcurrent::blockingMap(chunks, [&evaluate, &better, k, mask](Chunk& chunk) {
+            std::vector<float> values(static_cast<size_t>(chunk.end - chunk.begin));
+            evaluate(chunk.begin, chunk.end, values.data());
+
+            chunk.best.reserve(static_cast<size_t>(qMin(k, chunk.end - chunk.begin)));
+            for (int row = chunk.begin; row < chunk.end; ++row) {
+                if (mask && mask[row] == 0) {
+                    continue;
+                }
+                offer(chunk.best, k, Candidate{row, values[static_cast<size_t>(row - chunk.begin)]}, better);
+            }
+        });
+
+        std::vector<Candidate> merged;
+        for (const Chunk& chunk : chunks) {
+            merged.insert(merged.end(), chunk.best.cbegin(), chunk.best.cend());
+        }
+
+        const int resultSize = qMin(k, static_cast<int>(merged.size()));
+        std::partial_sort(merged.begin(), merged.begin() + resultSize, merged.end(), better);
+
+        QVector<Candidate> ranked;
+        ranked.reserve(resultSize);
+        for (int index = 0; index < resultSize; ++index) {
+            ranked.push_back(merged[static_cast<size_t>(index)]);
+        }
+        return ranked;
+    }
+};
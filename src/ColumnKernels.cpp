@@ -0,0 +1,198 @@
+#include "ColumnKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMPLE_EDT_COLUMN_SSE2 1
+#else
+#define SIMPLE_EDT_COLUMN_SSE2 0
+#endif
+
+namespace {
+
+struct LessThan {
+    static bool scalar(const float value, const float threshold) {
+        return value < threshold;
+    }
+#if SIMPLE_EDT_COLUMN_SSE2
+    static __m128 vector(const __m128 values, const __m128 threshold) {
+        return _mm_cmplt_ps(values, threshold);
+    }
+#endif
+};
+
+struct LessOrEqual {
+    static bool scalar(const float value, const float threshold) {
+        return value <= threshold;
+    }
+#if SIMPLE_EDT_COLUMN_SSE2
+    static __m128 vector(const __m128 values, const __m128 threshold) {
+        return _mm_cmple_ps(values, threshold);
+    }
+#endif
+};
+
+struct GreaterThan {
+    static bool scalar(const float value, const float threshold) {
+        return value > threshold;
+    }
+#if SIMPLE_EDT_COLUMN_SSE2
+    static __m128 vector(const __m128 values, const __m128 threshold) {
+        return _mm_cmpgt_ps(values, threshold);
+    }
+#endif
+};
+
+struct GreaterOrEqual {
+    static bool scalar(const float value, const float threshold) {
+        return value >= threshold;
+    }
+#if SIMPLE_EDT_COLUMN_SSE2
+    static __m128 vector(const __m128 values, const __m128 threshold) {
+        return _mm_cmpge_ps(values, threshold);
+    }
+#endif
+};
+
+struct EqualTo {
+    static bool scalar(const float value, const float threshold) {
+        return value == threshold;
+    }
+#if SIMPLE_EDT_COLUMN_SSE2
+    static __m128 vector(const __m128 values, const __m128 threshold) {
+        return _mm_cmpeq_ps(values, threshold);
+    }
+#endif
+};
+
+struct NotEqualTo {
+    static bool scalar(const float value, const float threshold) {
+        return value != threshold;
+    }
+#if SIMPLE_EDT_COLUMN_SSE2
+    static __m128 vector(const __m128 values, const __m128 threshold) {
+        return _mm_cmpneq_ps(values, threshold);
+    }
+#endif
+};
+
+template <typename Comparison>
+void narrowMaskWith(const float* values, const int count, const float threshold, quint8* mask) {
+    int row = 0;
+#if SIMPLE_EDT_COLUMN_SSE2
+    // 16 строк за итерацию: четыре сравнения по 4 float дают маски 0/-1 в int32,
+    // два насыщающих сжатия превращают их в 16 байт 0x00/0xFF для AND с маской.
+    const __m128 limit = _mm_set1_ps(threshold);
+    for (; row + 16 <= count; row += 16) {
+        const __m128i lanes0 = _mm_castps_si128(Comparison::vector(_mm_loadu_ps(values + row), limit));
+        const __m128i lanes1 = _mm_castps_si128(Comparison::vector(_mm_loadu_ps(values + row + 4), limit));
+        const __m128i lanes2 = _mm_castps_si128(Comparison::vector(_mm_loadu_ps(values + row + 8), limit));
+        const __m128i lanes3 = _mm_castps_si128(Comparison::vector(_mm_loadu_ps(values + row + 12), limit));
+        const __m128i passed = _mm_packs_epi16(_mm_packs_epi32(lanes0, lanes1), _mm_packs_epi32(lanes2, lanes3));
+
+        auto* maskBlock = reinterpret_cast<__m128i*>(mask + row);
+        _mm_storeu_si128(maskBlock, _mm_and_si128(_mm_loadu_si128(maskBlock), passed));
+    }
+#endif
+    for (; row < count; ++row) {
+        if (!Comparison::scalar(values[row], threshold)) {
+            mask[row] = 0;
+        }
+    }
+}
+
+} // namespace
+
+void ColumnKernels::narrowMask(const float* values,
+                               const int count,
+                               const ColumnComparison comparison,
+                               const float threshold,
+                               quint8* mask) {
+    if (!values || !mask || count <= 0) {
+        return;
+    }
+
+    switch (comparison) {
+    case ColumnComparison::Less:
+        narrowMaskWith<LessThan>(values, count, threshold, mask);
+        break;
+    case ColumnComparison::LessOrEqual:
+        narrowMaskWith<LessOrEqual>(values, count, threshold, mask);
+        break;
+    case ColumnComparison::Greater:
+        narrowMaskWith<GreaterThan>(values, count, threshold, mask);
+        break;
+    case ColumnComparison::GreaterOrEqual:
+        narrowMaskWith<GreaterOrEqual>(values, count, threshold, mask);
+        break;
+    case ColumnComparison::Equal:
+        narrowMaskWith<EqualTo>(values, count, threshold, mask);
+        break;
+    case ColumnComparison::NotEqual:
+        narrowMaskWith<NotEqualTo>(values, count, threshold, mask);
+        break;
+    }
+}
+
+int ColumnKernels::countSelected(const quint8* mask, const int count) {
+    if (!mask || count <= 0) {
+        return 0;
+    }
+
+    int row = 0;
+    qint64 selected = 0;
+#if SIMPLE_EDT_COLUMN_SSE2
+    // Ненулевые байты → 1, затем _mm_sad_epu8 суммирует по 8 байт в две 64-битные половины.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i sums = _mm_setzero_si128();
+    for (; row + 16 <= count; row += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + row));
+        const __m128i ones = _mm_andnot_si128(_mm_cmpeq_epi8(bytes, zero), one);
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(ones, zero));
+    }
+    alignas(16) qint64 halves[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(halves), sums);
+    selected = halves[0] + halves[1];
+#endif
+    for (; row < count; ++row) {
+        selected += mask[row] != 0 ? 1 : 0;
+    }
+    return static_cast<int>(selected);
+}
+
+void ColumnKernels::squaredDistances(const float* rows,
+                                     const int rowCount,
+                                     const int dimensions,
+                                     const float* query,
+                                     float* out) {
+    if (!rows || !query || !out || rowCount <= 0 || dimensions <= 0) {
+        return;
+    }
+
+#if SIMPLE_EDT_COLUMN_SSE2
+    if (dimensions % 4 == 0) {
+        for (int row = 0; row < rowCount; ++row) {
+            const float* values = rows + static_cast<qsizetype>(row) * dimensions;
+            __m128 sums = _mm_setzero_ps();
+            for (int dimension = 0; dimension < dimensions; dimension += 4) {
+                const __m128 delta = _mm_sub_ps(_mm_loadu_ps(values + dimension), _mm_loadu_ps(query + dimension));
+                sums = _mm_add_ps(sums, _mm_mul_ps(delta, delta));
+            }
+            // Горизонтальная сумма четырёх частичных сумм.
+            sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+            sums = _mm_add_ss(sums, _mm_shuffle_ps(sums, sums, 0x55));
+            out[row] = _mm_cvtss_f32(sums);
+        }
+        return;
+    }
+#endif
+    for (int row = 0; row < rowCount; ++row) {
+        const float* values = rows + static_cast<qsizetype>(row) * dimensions;
+        float sum = 0.0f;
+        for (int dimension = 0; dimension < dimensions; ++dimension) {
+            const float delta = values[dimension] - query[dimension];
+            sum += delta * delta;
+        }
+        out[row] = sum;
+    }
+}
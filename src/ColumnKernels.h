@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QtGlobal>
+
+enum class ColumnComparison : quint8 {
+    Less,
+    LessOrEqual,
+    Greater,
+    GreaterOrEqual,
+    Equal,
+    NotEqual
+};
+
+// Пороговые сканы по плотным столбцам float (составы, физические поля корпуса).
+// Маска — по байту на строку, 0 или 1; условия накладываются последовательно через AND,
+// поэтому "азот ≥ 70 и полоний > 1" — два прохода по двум столбцам без промежуточных списков.
+// На x86-64 сравнение идёт по 16 строк за итерацию (SSE2), остаток и прочие платформы — скалярно.
+// Здесь же перебор расстояний до строк признаков (поиск похожих систем).
+class ColumnKernels {
+public:
+    // mask[i] &= values[i] <comparison> threshold. NaN проходит только NotEqual.
+    static void narrowMask(const float* values, int count, ColumnComparison comparison, float threshold, quint8* mask);
+
+    // То же сравнение для одной пары значений.
+    static bool compare(const float lhs, const ColumnComparison comparison, const float rhs) {
+        switch (comparison) {
+        case ColumnComparison::Less:
+            return lhs < rhs;
+        case ColumnComparison::LessOrEqual:
+            return lhs <= rhs;
+        case ColumnComparison::Greater:
+            return lhs > rhs;
+        case ColumnComparison::GreaterOrEqual:
+            return lhs >= rhs;
+        case ColumnComparison::Equal:
+            return lhs == rhs;
+        case ColumnComparison::NotEqual:
+            return lhs != rhs;
+        }
+        return false;
+    }
+
+    static int countSelected(const quint8* mask, int count);
+
+    // out[i] = |rows[i] - query|² для rowCount строк по dimensions float подряд.
+    // При dimensions, кратном 4, строка читается векторами SSE2.
+    static void squaredDistances(const float* rows, int rowCount, int dimensions, const float* query, float* out);
+};
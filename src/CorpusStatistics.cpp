@@ -0,0 +1,148 @@
+#include "CorpusStatistics.h"
+
+#include <QHash>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+
+#include "BodyTaxonomy.h"
+#include "OrbitClassifier.h"
+#include "SystemId64.h"
+
+namespace {
+
+// Секторов id64 по X и по Z — 7 бит на ось.
+constexpr int kSectorsPerAxis = 128;
+
+int sectorIndex(const double coordinate, const double origin) {
+    const int sector = static_cast<int>(std::floor((coordinate - origin) / DecodedSystemId64::kSectorSizeLy));
+    return qBound(0, sector, kSectorsPerAxis - 1);
+}
+
+// Ключи по убыванию суммы, при равенстве — по возрастанию ключа.
+QVector<int> keysByTotal(const QHash<int, qint64>& totals) {
+    QVector<int> keys;
+    keys.reserve(totals.size());
+    for (auto it = totals.constBegin(); it != totals.constEnd(); ++it) {
+        keys.push_back(it.key());
+    }
+    std::sort(keys.begin(), keys.end(), [&totals](const int lhs, const int rhs) {
+        const qint64 lhsCount = totals.value(lhs);
+        const qint64 rhsCount = totals.value(rhs);
+        return lhsCount > rhsCount || (lhsCount == rhsCount && lhs < rhs);
+    });
+    return keys;
+}
+
+} // namespace
+
+qint64 CorpusStatistics::count(const Kind kind, const int key, const int region) const {
+    qint64 total = 0;
+    for (const Entry& entry : entries) {
+        if (entry.kind == kind && entry.key == key && (region == kAllRegions || entry.region == region)) {
+            total += entry.count;
+        }
+    }
+    return total;
+}
+
+QVector<int> CorpusStatistics::keys(const Kind kind) const {
+    QHash<int, qint64> totals;
+    for (const Entry& entry : entries) {
+        if (entry.kind == kind) {
+            totals[entry.key] += entry.count;
+        }
+    }
+    return keysByTotal(totals);
+}
+
+QVector<int> CorpusStatistics::regions() const {
+    QHash<int, qint64> totals;
+    for (const Entry& entry : entries) {
+        if (entry.kind == Systems) {
+            totals[entry.region] += entry.count;
+        }
+    }
+    return keysByTotal(totals);
+}
+
+int CorpusStatistics::regionOf(const GalacticCoordinates& position) {
+    return sectorIndex(position.x, DecodedSystemId64::kGalaxyOriginX) * kSectorsPerAxis
+         + sectorIndex(position.z, DecodedSystemId64::kGalaxyOriginZ);
+}
+
+QString CorpusStatistics::regionName(const int region) {
+    if (region == kAllRegions) {
+        return QStringLiteral("весь корпус");
+    }
+    if (region < 0) {
+        return QStringLiteral("координаты неизвестны");
+    }
+
+    // Границы столбца в координатах с началом в Sol, с округлением до светового года.
+    const int sectorX = region / kSectorsPerAxis;
+    const int sectorZ = region % kSectorsPerAxis;
+    const double minX = DecodedSystemId64::kGalaxyOriginX + sectorX * DecodedSystemId64::kSectorSizeLy;
+    const double minZ = DecodedSystemId64::kGalaxyOriginZ + sectorZ * DecodedSystemId64::kSectorSizeLy;
+    return QStringLiteral("сектор %1:%2 (x %3…%4, z %5…%6)")
+        .arg(sectorX)
+        .arg(sectorZ)
+        .arg(minX, 0, 'f', 0)
+        .arg(minX + DecodedSystemId64::kSectorSizeLy, 0, 'f', 0)
+        .arg(minZ, 0, 'f', 0)
+        .arg(minZ + DecodedSystemId64::kSectorSizeLy, 0, 'f', 0);
+}
+
+QString CorpusStatistics::kindName(const Kind kind) {
+    switch (kind) {
+    case Systems:
+        return QStringLiteral("системы");
+    case SystemOrbitTypes:
+        return QStringLiteral("типы систем");
+    case BodyOrbitTypes:
+        return QStringLiteral("типы тел");
+    case PlanetSubtypes:
+        return QStringLiteral("подтипы планет");
+    case TerraformableByStarClass:
+        return QStringLiteral("терраформируемые по классу звезды");
+    case KindCount:
+        break;
+    }
+    return QString();
+}
+
+QString CorpusStatistics::keyName(const Kind kind, const int key) {
+    switch (kind) {
+    case Systems:
+        return QStringLiteral("все");
+    case SystemOrbitTypes:
+        return OrbitClassifier::systemTypeToLabel(static_cast<SystemOrbitType>(key));
+    case BodyOrbitTypes:
+        return OrbitClassifier::bodyTypeToLabel(static_cast<BodyOrbitType>(key));
+    case PlanetSubtypes:
+        return BodyTaxonomy::planetSubtypeName(static_cast<PlanetSubtype>(key));
+    case TerraformableByStarClass:
+        return BodyTaxonomy::starClassName(static_cast<StarClass>(key));
+    case KindCount:
+        break;
+    }
+    return QString::number(key);
+}
+
+QString CorpusStatistics::csvField(const QString& value) {
+    if (!value.contains(QLatin1Char(',')) && !value.contains(QLatin1Char('"')) && !value.contains(QLatin1Char('\n'))) {
+        return value;
+    }
+    QString escaped = value;
+    escaped.replace(QLatin1Char('"'), QStringLiteral("\"\""));
+    return QLatin1Char('"') + escaped + QLatin1Char('"');
+}
+
+void CorpusStatistics::writeCsv(QTextStream& stream) const {
+    stream << "kind,region,key,count\n";
+    for (const Entry& entry : entries) {
+        stream << csvField(kindName(entry.kind)) << ',' << csvField(regionName(entry.region)) << ','
+               << csvField(keyName(entry.kind, entry.key)) << ',' << entry.count << '\n';
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include "GalacticCoordinates.h"
+
+class QTextStream;
+
+// Сводные счётчики корпуса по регионам: системы, типы систем и тел OrbitClassifier, подтипы
+// планет и терраформируемые тела по классу звезды-хозяина. SystemCorpusDatabase обновляет их
+// в транзакции записи системы (вычитает вклад прежней версии и прибавляет новый), поэтому
+// сводка читается одним SELECT по маленькой таблице, без обхода тел.
+struct CorpusStatistics {
+    enum Kind : quint8 {
+        Systems,
+        SystemOrbitTypes,
+        BodyOrbitTypes,
+        PlanetSubtypes,
+        TerraformableByStarClass,
+        KindCount
+    };
+
+    // Регион — столбец секторов id64: 1280 × 1280 св. лет в плоскости галактики на всю высоту.
+    static constexpr int kUnknownRegion = -1;
+    static constexpr int kAllRegions = -2;
+
+    struct Entry {
+        Kind kind = Systems;
+        int region = kUnknownRegion;
+        // Бит SystemOrbitType/BodyOrbitType, PlanetSubtype или StarClass; у Systems — 0.
+        int key = 0;
+        qint64 count = 0;
+    };
+
+    QVector<Entry> entries;
+
+    qint64 count(Kind kind, int key, int region = kAllRegions) const;
+    // Ключи вида, встречающиеся в сводке, по убыванию суммы по всем регионам.
+    QVector<int> keys(Kind kind) const;
+    // Регионы с хотя бы одной системой, по убыванию числа систем.
+    QVector<int> regions() const;
+
+    static int regionOf(const GalacticCoordinates& position);
+    static QString regionName(int region);
+    static QString kindName(Kind kind);
+    static QString keyName(Kind kind, int key);
+
+    // kind,region,key,count — строка на запись, с названиями вместо кодов.
+    void writeCsv(QTextStream& stream) const;
+    // Значение для поля CSV: с запятой, кавычкой или переводом строки — в кавычках (RFC 4180).
+    static QString csvField(const QString& value);
+};
+
+Q_DECLARE_TYPEINFO(CorpusStatistics::Entry, Q_PRIMITIVE_TYPE);
@@ -0,0 +1,184 @@
+#include "CorpusStatisticsWindow.h"
+
+#include <QComboBox>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QTableWidgetItem>
+#include <QTextStream>
+#include <QVBoxLayout>
+
+#include "SystemCorpusDatabase.h"
+
+namespace {
+
+enum StatisticsColumn {
+    NameColumn,
+    CountColumn,
+    ShareColumn,
+    StatisticsColumnCount
+};
+
+// Виды сводки с собственной таблицей, в порядке вкладок.
+constexpr CorpusStatistics::Kind kTableKinds[] = {
+    CorpusStatistics::SystemOrbitTypes,
+    CorpusStatistics::BodyOrbitTypes,
+    CorpusStatistics::PlanetSubtypes,
+    CorpusStatistics::TerraformableByStarClass,
+};
+
+QTableWidget* createTable(QWidget* parent) {
+    auto* table = new QTableWidget(0, StatisticsColumnCount, parent);
+    table->setHorizontalHeaderLabels({QStringLiteral("Название"), QStringLiteral("Количество"), QStringLiteral("Доля, %")});
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setStretchLastSection(true);
+    return table;
+}
+
+QTableWidgetItem* numberItem(const QVariant& value) {
+    auto* item = new QTableWidgetItem;
+    // Число в DisplayRole, чтобы сортировка по столбцу была числовой.
+    item->setData(Qt::DisplayRole, value);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+} // namespace
+
+CorpusStatisticsWindow::CorpusStatisticsWindow(SystemCorpusDatabase* corpus, QWidget* parent)
+    : QWidget(parent, Qt::Window),
+      m_corpus(corpus) {
+    setWindowTitle(QStringLiteral("Сводка по корпусу"));
+    resize(720, 520);
+
+    m_regionCombo = new QComboBox(this);
+    m_regionCombo->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    auto* refreshButton = new QPushButton(QStringLiteral("Обновить"), this);
+    auto* exportButton = new QPushButton(QStringLiteral("Экспорт CSV…"), this);
+    exportButton->setToolTip(QStringLiteral("Вся сводка по всем регионам: вид, регион, ключ, количество"));
+    m_statusLabel = new QLabel(this);
+
+    auto* tabs = new QTabWidget(this);
+    for (const CorpusStatistics::Kind kind : kTableKinds) {
+        QTableWidget* table = createTable(tabs);
+        m_tables.push_back(table);
+        QString title = CorpusStatistics::kindName(kind);
+        title[0] = title.at(0).toUpper();
+        tabs->addTab(table, title);
+    }
+
+    auto* controls = new QHBoxLayout();
+    controls->addWidget(new QLabel(QStringLiteral("Регион:"), this));
+    controls->addWidget(m_regionCombo, 1);
+    controls->addWidget(refreshButton);
+    controls->addWidget(exportButton);
+
+    auto* rootLayout = new QVBoxLayout(this);
+    rootLayout->addLayout(controls);
+    rootLayout->addWidget(tabs, 1);
+    rootLayout->addWidget(m_statusLabel);
+
+    connect(refreshButton, &QPushButton::clicked, this, [this]() {
+        reload();
+    });
+    connect(exportButton, &QPushButton::clicked, this, [this]() {
+        exportCsv();
+    });
+    connect(m_regionCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int) {
+        showRegion();
+    });
+}
+
+void CorpusStatisticsWindow::reload() {
+    QElapsedTimer timer;
+    timer.start();
+    m_statistics = m_corpus ? m_corpus->statistics() : CorpusStatistics();
+
+    const int previousRegion = m_regionCombo->currentData().isValid() ? m_regionCombo->currentData().toInt()
+                                                                       : CorpusStatistics::kAllRegions;
+    {
+        // Перезаполнение списка не должно перерисовывать таблицы на каждый пункт.
+        const QSignalBlocker blocker(m_regionCombo);
+        m_regionCombo->clear();
+        m_regionCombo->addItem(CorpusStatistics::regionName(CorpusStatistics::kAllRegions), CorpusStatistics::kAllRegions);
+        for (const int region : m_statistics.regions()) {
+            m_regionCombo->addItem(QStringLiteral("%1 — %2 сист.")
+                                       .arg(CorpusStatistics::regionName(region))
+                                       .arg(m_statistics.count(CorpusStatistics::Systems, 0, region)),
+                                   region);
+        }
+        const int previousIndex = m_regionCombo->findData(previousRegion);
+        m_regionCombo->setCurrentIndex(previousIndex >= 0 ? previousIndex : 0);
+    }
+    showRegion();
+
+    m_statusLabel->setText(QStringLiteral("Систем: %1, регионов: %2, записей сводки: %3 (%4 мс)")
+                               .arg(m_statistics.count(CorpusStatistics::Systems, 0))
+                               .arg(m_regionCombo->count() - 1)
+                               .arg(m_statistics.entries.size())
+                               .arg(timer.elapsed()));
+}
+
+void CorpusStatisticsWindow::showRegion() {
+    const int region = m_regionCombo->currentData().isValid() ? m_regionCombo->currentData().toInt()
+                                                               : CorpusStatistics::kAllRegions;
+    const qint64 systemCount = m_statistics.count(CorpusStatistics::Systems, 0, region);
+
+    for (int tableIndex = 0; tableIndex < m_tables.size(); ++tableIndex) {
+        const CorpusStatistics::Kind kind = kTableKinds[tableIndex];
+        QVector<QPair<int, qint64>> rows;
+        qint64 kindTotal = 0;
+        for (const int key : m_statistics.keys(kind)) {
+            const qint64 count = m_statistics.count(kind, key, region);
+            if (count > 0) {
+                rows.push_back({key, count});
+                kindTotal += count;
+            }
+        }
+        // Типы систем — доля от числа систем региона, остальное — доля внутри вида.
+        const qint64 shareBase = kind == CorpusStatistics::SystemOrbitTypes ? systemCount : kindTotal;
+
+        QTableWidget* table = m_tables.at(tableIndex);
+        table->setSortingEnabled(false);
+        table->setRowCount(rows.size());
+        for (int row = 0; row < rows.size(); ++row) {
+            const double share = shareBase > 0 ? 100.0 * static_cast<double>(rows.at(row).second) / static_cast<double>(shareBase)
+                                               : 0.0;
+            table->setItem(row, NameColumn, new QTableWidgetItem(CorpusStatistics::keyName(kind, rows.at(row).first)));
+            table->setItem(row, CountColumn, numberItem(rows.at(row).second));
+            table->setItem(row, ShareColumn, numberItem(qRound(share * 10.0) / 10.0));
+        }
+        table->setSortingEnabled(true);
+        table->sortItems(CountColumn, Qt::DescendingOrder);
+        table->resizeColumnsToContents();
+    }
+}
+
+void CorpusStatisticsWindow::exportCsv() {
+    const QString path = QFileDialog::getSaveFileName(this,
+                                                      QStringLiteral("Экспорт сводки корпуса"),
+                                                      QStringLiteral("corpus-statistics.csv"),
+                                                      QStringLiteral("CSV (*.csv)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        m_statusLabel->setText(QStringLiteral("Не удалось записать %1: %2").arg(path, file.errorString()));
+        return;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    m_statistics.writeCsv(stream);
+    m_statusLabel->setText(QStringLiteral("Экспортировано записей сводки: %1 → %2").arg(m_statistics.entries.size()).arg(path));
+}
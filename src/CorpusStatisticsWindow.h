@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QVector>
+#include <QWidget>
+
+#include "CorpusStatistics.h"
+
+class QComboBox;
+class QLabel;
+class QTableWidget;
+class SystemCorpusDatabase;
+
+// Сводка по корпусу: типы систем и тел OrbitClassifier, подтипы планет и терраформируемые
+// тела по классу звезды — по всему корпусу или по одному региону. Данные берутся из
+// поддерживаемой корпусом таблицы сводки, поэтому окно открывается мгновенно; сводку
+// целиком можно выгрузить в CSV для отчётов.
+class CorpusStatisticsWindow : public QWidget {
+    Q_OBJECT
+public:
+    explicit CorpusStatisticsWindow(SystemCorpusDatabase* corpus, QWidget* parent = nullptr);
+
+    void reload();
+
+private:
+    void showRegion();
+    void exportCsv();
+
+    SystemCorpusDatabase* m_corpus = nullptr;
+    QComboBox* m_regionCombo = nullptr;
+    QLabel* m_statusLabel = nullptr;
+    // По таблице на вид сводки, кроме Systems (он идёт в строку состояния).
+    QVector<QTableWidget*> m_tables;
+    CorpusStatistics m_statistics;
+};
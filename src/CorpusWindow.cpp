@@ -0,0 +1,465 @@
+#include "CorpusWindow.h"
+
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QHash>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSet>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTableWidgetItem>
+#include <QTextStream>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+#include "BodyFilter.h"
+#include "ColumnKernels.h"
+#include "CorpusStatistics.h"
+#include "SystemCorpusDatabase.h"
+
+namespace {
+
+enum ResultColumn {
+    RankColumn,
+    ScoreColumn,
+    SystemColumn,
+    BodyColumn,
+    TypeColumn,
+    GravityColumn,
+    TemperatureColumn,
+    PressureColumn,
+    TerraformingColumn,
+    DistanceColumn,
+    ResultColumnCount
+};
+
+// Данные пункта фильтра состава: -1 — без фильтра, газы — индекс слота,
+// материалы — kMaterialSlotBase + индекс слота.
+constexpr int kNoCompositionFilter = -1;
+constexpr int kMaterialSlotBase = 100;
+
+QDoubleSpinBox* createWeightSpin(const double value, QWidget* parent) {
+    auto* spin = new QDoubleSpinBox(parent);
+    spin->setRange(0.0, 10.0);
+    spin->setSingleStep(0.5);
+    spin->setDecimals(1);
+    spin->setValue(value);
+    return spin;
+}
+
+QTableWidgetItem* numberItem(const double value, const int decimals) {
+    auto* item = new QTableWidgetItem;
+    // Число в DisplayRole, чтобы сортировка по столбцу была числовой.
+    item->setData(Qt::DisplayRole, QString::number(value, 'f', decimals).toDouble());
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+// Переносит маску фильтра (строки loadFilterColumns) на строки оценки: обе выборки
+// упорядочены по rowid, поэтому хватает одного линейного прохода.
+void intersectByRowId(const QVector<qint64>& filterRowIds,
+                      const QVector<quint8>& filterMask,
+                      const QVector<qint64>& scoringRowIds,
+                      QVector<quint8>* scoringMask) {
+    int filterRow = 0;
+    for (int row = 0; row < scoringRowIds.size(); ++row) {
+        const qint64 rowId = scoringRowIds.at(row);
+        while (filterRow < filterRowIds.size() && filterRowIds.at(filterRow) < rowId) {
+            ++filterRow;
+        }
+        const bool passed = filterRow < filterRowIds.size() && filterRowIds.at(filterRow) == rowId
+                            && filterMask.at(filterRow) != 0;
+        if (!passed) {
+            (*scoringMask)[row] = 0;
+        }
+    }
+}
+
+} // namespace
+
+CorpusWindow::CorpusWindow(SystemCorpusDatabase* corpus, QWidget* parent)
+    : QWidget(parent, Qt::Window),
+      m_corpus(corpus) {
+    setWindowTitle(QStringLiteral("Кандидаты на терраформирование"));
+    resize(980, 620);
+
+    const TerraformingWeights defaults;
+    auto* weightsGroup = new QGroupBox(QStringLiteral("Веса критериев"), this);
+    auto* weightsLayout = new QGridLayout(weightsGroup);
+    m_terraformingWeightSpin = createWeightSpin(defaults.terraformingState, weightsGroup);
+    m_gravityWeightSpin = createWeightSpin(defaults.gravity, weightsGroup);
+    m_temperatureWeightSpin = createWeightSpin(defaults.temperature, weightsGroup);
+    m_pressureWeightSpin = createWeightSpin(defaults.pressure, weightsGroup);
+    m_atmosphereWeightSpin = createWeightSpin(defaults.atmosphere, weightsGroup);
+    m_massWeightSpin = createWeightSpin(defaults.mass, weightsGroup);
+    m_distanceWeightSpin = createWeightSpin(defaults.distance, weightsGroup);
+
+    const QVector<QPair<QString, QDoubleSpinBox*>> weightRows{
+        {QStringLiteral("Терраформирование:"), m_terraformingWeightSpin},
+        {QStringLiteral("Гравитация (1 g):"), m_gravityWeightSpin},
+        {QStringLiteral("Температура (288 K):"), m_temperatureWeightSpin},
+        {QStringLiteral("Давление (1 атм):"), m_pressureWeightSpin},
+        {QStringLiteral("Атмосфера N₂ + O₂:"), m_atmosphereWeightSpin},
+        {QStringLiteral("Масса (1 M⊕):"), m_massWeightSpin},
+        {QStringLiteral("Близость к точке входа:"), m_distanceWeightSpin},
+    };
+    for (int index = 0; index < weightRows.size(); ++index) {
+        const int row = index / 4;
+        const int column = (index % 4) * 2;
+        weightsLayout->addWidget(new QLabel(weightRows.at(index).first, weightsGroup), row, column);
+        weightsLayout->addWidget(weightRows.at(index).second, row, column + 1);
+    }
+
+    auto* searchGroup = new QGroupBox(QStringLiteral("Поиск"), this);
+    auto* searchLayout = new QFormLayout(searchGroup);
+    m_topKSpin = new QSpinBox(searchGroup);
+    m_topKSpin->setRange(1, 10000);
+    m_topKSpin->setValue(100);
+    m_originSystemEdit = new QLineEdit(searchGroup);
+    m_originSystemEdit->setPlaceholderText(QStringLiteral("Необязательно, например: Col 285 Sector XW-G b25-1"));
+    m_radiusSpin = new QDoubleSpinBox(searchGroup);
+    m_radiusSpin->setRange(0.0, 100000.0);
+    m_radiusSpin->setDecimals(0);
+    m_radiusSpin->setSingleStep(50.0);
+    m_radiusSpin->setSuffix(QStringLiteral(" св. лет"));
+    m_radiusSpin->setSpecialValueText(QStringLiteral("без ограничения"));
+    searchLayout->addRow(QStringLiteral("Показать лучших:"), m_topKSpin);
+    searchLayout->addRow(QStringLiteral("Рядом с системой:"), m_originSystemEdit);
+    searchLayout->addRow(QStringLiteral("Радиус:"), m_radiusSpin);
+
+    m_compositionCombo = new QComboBox(searchGroup);
+    m_compositionCombo->addItem(QStringLiteral("без фильтра"), kNoCompositionFilter);
+    for (int slot = 0; slot < AtmosphereComposition::kSlotCount; ++slot) {
+        m_compositionCombo->addItem(QStringLiteral("Атмосфера: %1").arg(BodyComposition::displayName(static_cast<AtmosphereGas>(slot))),
+                                    slot);
+    }
+    for (int slot = 0; slot < MaterialComposition::kSlotCount; ++slot) {
+        m_compositionCombo->addItem(QStringLiteral("Материал: %1").arg(BodyComposition::displayName(static_cast<RawMaterial>(slot))),
+                                    kMaterialSlotBase + slot);
+    }
+    m_compositionComparisonCombo = new QComboBox(searchGroup);
+    m_compositionComparisonCombo->addItem(QStringLiteral("≥"), static_cast<int>(ColumnComparison::GreaterOrEqual));
+    m_compositionComparisonCombo->addItem(QStringLiteral(">"), static_cast<int>(ColumnComparison::Greater));
+    m_compositionComparisonCombo->addItem(QStringLiteral("≤"), static_cast<int>(ColumnComparison::LessOrEqual));
+    m_compositionComparisonCombo->addItem(QStringLiteral("<"), static_cast<int>(ColumnComparison::Less));
+    m_compositionPercentSpin = new QDoubleSpinBox(searchGroup);
+    m_compositionPercentSpin->setRange(0.0, 100.0);
+    m_compositionPercentSpin->setDecimals(1);
+    m_compositionPercentSpin->setSuffix(QStringLiteral(" %"));
+    auto* compositionRow = new QHBoxLayout();
+    compositionRow->addWidget(m_compositionCombo, 1);
+    compositionRow->addWidget(m_compositionComparisonCombo);
+    compositionRow->addWidget(m_compositionPercentSpin);
+    searchLayout->addRow(QStringLiteral("Состав:"), compositionRow);
+
+    m_filterEdit = new QLineEdit(searchGroup);
+    m_filterEdit->setPlaceholderText(QStringLiteral("Например: gravity < 1.2 and temperature between 200 and 320 K"));
+    m_filterEdit->setToolTip(BodyFilter::syntaxHelp());
+    searchLayout->addRow(QStringLiteral("Выражение:"), m_filterEdit);
+
+    m_scoreButton = new QPushButton(QStringLiteral("Оценить корпус"), this);
+    m_exportButton = new QPushButton(QStringLiteral("Экспорт CSV…"), this);
+    m_exportButton->setToolTip(QStringLiteral("Все тела корпуса, прошедшие выражение фильтра"));
+    m_statusLabel = new QLabel(QStringLiteral("Корпус не оценивался."), this);
+
+    m_resultsTable = new QTableWidget(0, ResultColumnCount, this);
+    m_resultsTable->setHorizontalHeaderLabels({QStringLiteral("№"),
+                                               QStringLiteral("Оценка"),
+                                               QStringLiteral("Система"),
+                                               QStringLiteral("Тело"),
+                                               QStringLiteral("Тип"),
+                                               QStringLiteral("g"),
+                                               QStringLiteral("T, K"),
+                                               QStringLiteral("Давление, атм"),
+                                               QStringLiteral("Терраформирование"),
+                                               QStringLiteral("До точки входа, ls")});
+    m_resultsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_resultsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_resultsTable->verticalHeader()->setVisible(false);
+    m_resultsTable->horizontalHeader()->setStretchLastSection(true);
+    m_resultsTable->horizontalHeader()->setSortIndicator(RankColumn, Qt::AscendingOrder);
+
+    auto* actionsRow = new QHBoxLayout();
+    actionsRow->addWidget(m_scoreButton);
+    actionsRow->addWidget(m_exportButton);
+    actionsRow->addWidget(m_statusLabel, 1);
+
+    auto* rootLayout = new QVBoxLayout(this);
+    rootLayout->addWidget(weightsGroup);
+    rootLayout->addWidget(searchGroup);
+    rootLayout->addLayout(actionsRow);
+    rootLayout->addWidget(m_resultsTable, 1);
+
+    connect(m_scoreButton, &QPushButton::clicked, this, [this]() {
+        startScoring();
+    });
+
+    connect(m_exportButton, &QPushButton::clicked, this, [this]() {
+        exportFilteredBodies();
+    });
+
+    connect(&m_scoringWatcher, &QFutureWatcher<ScoringRun>::finished, this, [this]() {
+        showResults(m_scoringWatcher.result());
+    });
+
+    connect(m_resultsTable, &QTableWidget::cellDoubleClicked, this, [this](const int row, int) {
+        const QTableWidgetItem* systemItem = m_resultsTable->item(row, SystemColumn);
+        if (systemItem) {
+            emit systemActivated(systemItem->text());
+        }
+    });
+}
+
+CorpusWindow::~CorpusWindow() {
+    // Задача оценки держит своё соединение с базой корпуса — дожидаемся её закрытия.
+    m_scoringWatcher.waitForFinished();
+}
+
+TerraformingWeights CorpusWindow::currentWeights() const {
+    TerraformingWeights weights;
+    weights.terraformingState = m_terraformingWeightSpin->value();
+    weights.gravity = m_gravityWeightSpin->value();
+    weights.temperature = m_temperatureWeightSpin->value();
+    weights.pressure = m_pressureWeightSpin->value();
+    weights.atmosphere = m_atmosphereWeightSpin->value();
+    weights.mass = m_massWeightSpin->value();
+    weights.distance = m_distanceWeightSpin->value();
+    return weights;
+}
+
+void CorpusWindow::startScoring() {
+    if (m_scoringWatcher.isRunning() || !m_corpus || !m_corpus->isOpen()) {
+        return;
+    }
+
+    ScoringRequest request;
+    request.weights = currentWeights();
+    request.k = m_topKSpin->value();
+
+    const QString originSystem = m_originSystemEdit->text().trimmed();
+    const double radiusLy = m_radiusSpin->value();
+    if (!originSystem.isEmpty() && radiusLy > 0.0) {
+        const auto origin = m_corpus->systemCoordinates(originSystem);
+        if (!origin) {
+            m_statusLabel->setText(QStringLiteral("Координаты системы «%1» в корпусе неизвестны.").arg(originSystem));
+            return;
+        }
+
+        request.nearbyOnly = true;
+        for (const auto& neighbor : m_corpus->spatialIndex().withinRadius(*origin, radiusLy)) {
+            request.nearbySystems.insert(neighbor.point.systemId64);
+        }
+    }
+
+    request.filter = BodyFilter::compile(m_filterEdit->text());
+    if (!request.filter.isValid()) {
+        m_statusLabel->setText(QStringLiteral("Ошибка в выражении (позиция %1): %2")
+                                   .arg(request.filter.errorPosition() + 1)
+                                   .arg(request.filter.errorMessage()));
+        return;
+    }
+
+    request.compositionSlot = m_compositionCombo->currentData().toInt();
+    request.compositionComparison = static_cast<ColumnComparison>(m_compositionComparisonCombo->currentData().toInt());
+    request.compositionPercent = static_cast<float>(m_compositionPercentSpin->value());
+
+    m_statusLabel->setText(QStringLiteral("Чтение и оценка тел корпуса..."));
+    m_scoringTimer.start();
+    if (m_corpus->isInMemory()) {
+        // Временную базу в памяти видит только соединение m_corpus: столбцы читаются здесь же.
+        showResults(score(*m_corpus, request));
+        return;
+    }
+
+    m_scoreButton->setEnabled(false);
+    const QString corpusPath = m_corpus->path();
+    m_scoringWatcher.setFuture(QtConcurrent::run([corpusPath, request]() {
+        // Соединение QtSql живёт в одном потоке: у задачи пула — своё, с той же базой.
+        SystemCorpusDatabase corpus;
+        if (!corpus.openForReading(corpusPath)) {
+            ScoringRun failed;
+            failed.error = corpus.lastError();
+            return failed;
+        }
+        return score(corpus, request);
+    }));
+}
+
+CorpusWindow::ScoringRun CorpusWindow::score(const SystemCorpusDatabase& corpus, const ScoringRequest& request) {
+    // Столбцы, фильтр и записи выдачи читаются на один момент: storeSystem из главного окна
+    // во время оценки перезаписывает тела под новыми rowid и не должен попасть между ними.
+    const bool readStarted = corpus.beginRead();
+    ScoringRun run;
+    run.columns = corpus.loadScoringColumns();
+    const int rowCount = run.columns.size();
+    if (rowCount == 0) {
+        if (readStarted) {
+            corpus.endRead();
+        }
+        return run;
+    }
+
+    if (request.nearbyOnly) {
+        run.rowMask.resize(rowCount);
+        for (int row = 0; row < rowCount; ++row) {
+            run.rowMask[row] = request.nearbySystems.contains(run.columns.systemId64.at(row)) ? 1 : 0;
+        }
+    }
+
+    if (!request.filter.matchesAll()) {
+        const BodyFilterColumns filterColumns = corpus.loadFilterColumns();
+        if (run.rowMask.isEmpty()) {
+            run.rowMask.fill(1, rowCount);
+        }
+        intersectByRowId(filterColumns.rowIds,
+                         request.filter.evaluate(filterColumns),
+                         run.columns.rowIds,
+                         &run.rowMask);
+    }
+
+    if (request.compositionSlot != kNoCompositionFilter) {
+        if (run.rowMask.isEmpty()) {
+            run.rowMask.fill(1, rowCount);
+        }
+        const float* values = request.compositionSlot < kMaterialSlotBase
+            ? run.columns.atmosphere.column(static_cast<AtmosphereGas>(request.compositionSlot))
+            : run.columns.materials.column(static_cast<RawMaterial>(request.compositionSlot - kMaterialSlotBase));
+        ColumnKernels::narrowMask(values,
+                                  rowCount,
+                                  request.compositionComparison,
+                                  request.compositionPercent,
+                                  run.rowMask.data());
+    }
+
+    const QVector<TerraformingCandidate> ranked = TerraformingScorer::topK(run.columns,
+                                                                          request.weights,
+                                                                          request.k,
+                                                                          run.rowMask.isEmpty() ? nullptr : &run.rowMask);
+    QVector<qint64> rowIds;
+    rowIds.reserve(ranked.size());
+    for (const auto& candidate : ranked) {
+        rowIds.push_back(run.columns.rowIds.at(candidate.row));
+    }
+    const QVector<CorpusBodyRecord> records = corpus.bodiesByRowIds(rowIds);
+    if (readStarted) {
+        corpus.endRead();
+    }
+
+    // Пары строятся по rowid: тело, которого уже нет в базе, выпадает вместе со своей оценкой.
+    QHash<qint64, int> recordByRowId;
+    recordByRowId.reserve(records.size());
+    for (int index = 0; index < records.size(); ++index) {
+        recordByRowId.insert(records.at(index).rowId, index);
+    }
+    run.ranked.reserve(ranked.size());
+    run.records.reserve(ranked.size());
+    for (int rank = 0; rank < ranked.size(); ++rank) {
+        const auto it = recordByRowId.constFind(rowIds.at(rank));
+        if (it != recordByRowId.constEnd()) {
+            run.ranked.push_back(ranked.at(rank));
+            run.records.push_back(records.at(*it));
+        }
+    }
+    return run;
+}
+
+void CorpusWindow::showResults(ScoringRun run) {
+    m_scoreButton->setEnabled(true);
+    const qint64 elapsedMs = m_scoringTimer.elapsed();
+    if (!run.error.isEmpty()) {
+        m_statusLabel->setText(run.error);
+        return;
+    }
+    if (run.columns.size() == 0) {
+        m_statusLabel->setText(QStringLiteral("В корпусе нет планет. Загрузите или импортируйте системы."));
+        return;
+    }
+
+    m_resultsTable->setSortingEnabled(false);
+    m_resultsTable->setRowCount(0);
+    m_resultsTable->setRowCount(run.records.size());
+    for (int row = 0; row < run.records.size(); ++row) {
+        const CorpusBodyRecord& record = run.records.at(row);
+        m_resultsTable->setItem(row, RankColumn, numberItem(row + 1, 0));
+        m_resultsTable->setItem(row, ScoreColumn, numberItem(run.ranked.at(row).score, 3));
+        m_resultsTable->setItem(row, SystemColumn, new QTableWidgetItem(record.systemName));
+        m_resultsTable->setItem(row, BodyColumn, new QTableWidgetItem(record.name));
+        m_resultsTable->setItem(row, TypeColumn, new QTableWidgetItem(record.type));
+        m_resultsTable->setItem(row, GravityColumn, numberItem(record.gravityG, 2));
+        m_resultsTable->setItem(row, TemperatureColumn, numberItem(record.surfaceTemperatureK, 0));
+        m_resultsTable->setItem(row, PressureColumn, numberItem(record.atmospherePressureAtm, 3));
+        m_resultsTable->setItem(row, TerraformingColumn, new QTableWidgetItem(record.terraformingState));
+        m_resultsTable->setItem(row, DistanceColumn, numberItem(record.distanceToArrivalLs, 0));
+    }
+    m_resultsTable->setSortingEnabled(true);
+    m_resultsTable->resizeColumnsToContents();
+
+    const int consideredRows = run.rowMask.isEmpty()
+        ? run.columns.size()
+        : ColumnKernels::countSelected(run.rowMask.constData(), run.rowMask.size());
+    m_statusLabel->setText(QStringLiteral("Оценено тел: %1 за %2 мс, показано лучших: %3.")
+                               .arg(consideredRows)
+                               .arg(elapsedMs)
+                               .arg(m_resultsTable->rowCount()));
+}
+
+void CorpusWindow::exportFilteredBodies() {
+    if (!m_corpus || !m_corpus->isOpen()) {
+        return;
+    }
+
+    const BodyFilter filter = BodyFilter::compile(m_filterEdit->text());
+    if (!filter.isValid()) {
+        m_statusLabel->setText(QStringLiteral("Ошибка в выражении (позиция %1): %2")
+                                   .arg(filter.errorPosition() + 1)
+                                   .arg(filter.errorMessage()));
+        return;
+    }
+
+    const QString path = QFileDialog::getSaveFileName(this,
+                                                      QStringLiteral("Экспорт тел корпуса"),
+                                                      QStringLiteral("bodies.csv"),
+                                                      QStringLiteral("CSV (*.csv)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    const BodyFilterColumns columns = m_corpus->loadFilterColumns();
+    const QVector<quint8> mask = filter.evaluate(columns);
+    QVector<qint64> rowIds;
+    rowIds.reserve(ColumnKernels::countSelected(mask.constData(), mask.size()));
+    for (int row = 0; row < mask.size(); ++row) {
+        if (mask.at(row) != 0) {
+            rowIds.push_back(columns.rowIds.at(row));
+        }
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        m_statusLabel->setText(QStringLiteral("Не удалось записать %1: %2").arg(path, file.errorString()));
+        return;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << "system,id64,body_id,name,type,distance_ls,gravity_g,temperature_k,pressure_atm,mass_earth,terraforming\n";
+    const QVector<CorpusBodyRecord> records = m_corpus->bodiesByRowIds(rowIds);
+    for (const CorpusBodyRecord& record : records) {
+        stream << CorpusStatistics::csvField(record.systemName) << ',' << record.systemId64 << ',' << record.bodyId
+               << ',' << CorpusStatistics::csvField(record.name) << ',' << CorpusStatistics::csvField(record.type) << ','
+               << record.distanceToArrivalLs << ',' << record.gravityG << ',' << record.surfaceTemperatureK << ','
+               << record.atmospherePressureAtm << ',' << record.massEarth << ','
+               << CorpusStatistics::csvField(record.terraformingState) << '\n';
+    }
+
+    m_statusLabel->setText(QStringLiteral("Экспортировано тел: %1 из %2 → %3").arg(records.size()).arg(columns.size()).arg(path));
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <QWidget>
+
+#include "BodyFilter.h"
+#include "ColumnKernels.h"
+#include "SystemCorpusDatabase.h"
+#include "TerraformingScorer.h"
+
+class QComboBox;
+class QDoubleSpinBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSpinBox;
+class QTableWidget;
+
+// Окно поиска кандидатов на терраформирование по всему локальному корпусу:
+// настраиваемые веса, top-K, необязательное ограничение по расстоянию до системы,
+// пороговый фильтр по доле газа или материала и выражение BodyFilter. Тела, прошедшие
+// выражение, можно выгрузить в CSV.
+class CorpusWindow : public QWidget {
+    Q_OBJECT
+public:
+    explicit CorpusWindow(SystemCorpusDatabase* corpus, QWidget* parent = nullptr);
+    ~CorpusWindow() override;
+
+signals:
+    // Двойной клик по строке результата — открыть систему в главном окне.
+    void systemActivated(const QString& systemName);
+
+private:
+    // Параметры оценки, снятые с формы в потоке GUI.
+    struct ScoringRequest {
+        TerraformingWeights weights;
+        int k = 0;
+        // Ограничение по расстоянию: только тела этих систем.
+        bool nearbyOnly = false;
+        QSet<quint64> nearbySystems;
+        BodyFilter filter;
+        int compositionSlot = -1;
+        ColumnComparison compositionComparison = ColumnComparison::GreaterOrEqual;
+        float compositionPercent = 0.0f;
+    };
+
+    struct ScoringRun {
+        TerraformingColumns columns;
+        // Пусто — оценивались все строки.
+        QVector<quint8> rowMask;
+        // Лучшие строки и их записи, попарно: записи читаются в той же задаче и на тот же момент.
+        QVector<TerraformingCandidate> ranked;
+        QVector<CorpusBodyRecord> records;
+        QString error;
+    };
+
+    TerraformingWeights currentWeights() const;
+    void startScoring();
+    // Чтение столбцов, маска и top-K на соединении corpus; в фоне — на собственном соединении задачи.
+    static ScoringRun score(const SystemCorpusDatabase& corpus, const ScoringRequest& request);
+    void showResults(ScoringRun run);
+    void exportFilteredBodies();
+
+    SystemCorpusDatabase* m_corpus = nullptr;
+    QDoubleSpinBox* m_terraformingWeightSpin = nullptr;
+    QDoubleSpinBox* m_gravityWeightSpin = nullptr;
+    QDoubleSpinBox* m_temperatureWeightSpin = nullptr;
+    QDoubleSpinBox* m_pressureWeightSpin = nullptr;
+    QDoubleSpinBox* m_atmosphereWeightSpin = nullptr;
+    QDoubleSpinBox* m_massWeightSpin = nullptr;
+    QDoubleSpinBox* m_distanceWeightSpin = nullptr;
+    QSpinBox* m_topKSpin = nullptr;
+    QLineEdit* m_originSystemEdit = nullptr;
+    QDoubleSpinBox* m_radiusSpin = nullptr;
+    QComboBox* m_compositionCombo = nullptr;
+    QComboBox* m_compositionComparisonCombo = nullptr;
+    QDoubleSpinBox* m_compositionPercentSpin = nullptr;
+    QLineEdit* m_filterEdit = nullptr;
+    QPushButton* m_scoreButton = nullptr;
+    QPushButton* m_exportButton = nullptr;
+    QLabel* m_statusLabel = nullptr;
+    QTableWidget* m_resultsTable = nullptr;
+
+    QFutureWatcher<ScoringRun> m_scoringWatcher;
+    QElapsedTimer m_scoringTimer;
+};
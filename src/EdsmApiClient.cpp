@@ -1,7 +1,11 @@
 #include "EdsmApiClient.h"
 
+#include "BodyTaxonomy.h"
 #include "OrbitClassifier.h"
+#include "SystemId64.h"
 
+#include <algorithm>
+#include <QDateTime>
 #include <QHash>
 #include <functional>
 #include <QJsonArray>
@@ -17,6 +21,7 @@
 #include <QTimer>
 #include <QUrl>
 #include <QUrlQuery>
+#include <QVarLengthArray>
 
 namespace {
 
@@ -89,19 +94,17 @@ void reportLsToAuSanityWarnings(const QVector<CelestialBody>& bodies,
 
 
 
-CelestialBody::BodyClass classifyBodyClassFromType(const QString& bodyType) {
-    if (OrbitClassifier::isBarycenterType(bodyType)) {
+CelestialBody::BodyClass classifyBodyClassFromTaxon(const BodyTaxon& taxon) {
+    if (taxon.hasFlag(BodyTaxon::BarycenterTypeFlag)) {
         return CelestialBody::BodyClass::Barycenter;
     }
-    if (bodyType.contains(QStringLiteral("Star"), Qt::CaseInsensitive)) {
+    if (taxon.hasFlag(BodyTaxon::StarTypeFlag)) {
         return CelestialBody::BodyClass::Star;
     }
-    if (bodyType.contains(QStringLiteral("Moon"), Qt::CaseInsensitive)) {
+    if (taxon.hasFlag(BodyTaxon::MoonTypeFlag)) {
         return CelestialBody::BodyClass::Moon;
     }
-    if (bodyType.contains(QStringLiteral("Planet"), Qt::CaseInsensitive)
-        || bodyType.contains(QStringLiteral("world"), Qt::CaseInsensitive)
-        || bodyType.contains(QStringLiteral("giant"), Qt::CaseInsensitive)) {
+    if (taxon.hasFlag(BodyTaxon::PlanetTypeFlag) || taxon.hasFlag(BodyTaxon::WorldTypeFlag)) {
         return CelestialBody::BodyClass::Planet;
     }
     return CelestialBody::BodyClass::Unknown;
@@ -132,14 +135,148 @@ ParentRef normalizeParentRef(const ParentRef& ref) {
     return normalized;
 }
 
-QString parentRefKey(const ParentRef& ref) {
-    return QStringLiteral("%1:%2").arg(ref.type.toLower(), QString::number(ref.bodyId));
-}
-
 QString parentRefToString(const ParentRef& ref) {
     return QStringLiteral("%1:%2").arg(ref.type, QString::number(ref.bodyId));
 }
 
+enum class ParentRelation {
+    Null,
+    Barycentre,
+    Star,
+    Planet,
+    Other
+};
+
+ParentRelation parentRelationFromType(const QString& type) {
+    if (type.contains(QStringLiteral("Null"), Qt::CaseInsensitive)) {
+        return ParentRelation::Null;
+    }
+    if (type.contains(QStringLiteral("Bary"), Qt::CaseInsensitive)) {
+        return ParentRelation::Barycentre;
+    }
+    if (type.contains(QStringLiteral("Star"), Qt::CaseInsensitive)) {
+        return ParentRelation::Star;
+    }
+    if (type.contains(QStringLiteral("Planet"), Qt::CaseInsensitive)) {
+        return ParentRelation::Planet;
+    }
+    return ParentRelation::Other;
+}
+
+constexpr int kEmptyParentChain = -1;
+
+struct ParentChainNode {
+    ParentRef ref;
+    ParentRelation relation = ParentRelation::Other;
+    // Интернированный ключ ссылки: тип без учёта регистра + id. Равные ключи — равные ссылки.
+    int refKey = -1;
+    // Следующий (более внешний) узел цепочки; kEmptyParentChain для верхнего предка.
+    int next = kEmptyParentChain;
+};
+
+// Префиксное дерево цепочек родителей: цепочка тела хранится как индекс узла его
+// непосредственного родителя, а общий хвост (например, у спутников одной планеты)
+// разделяется всеми телами. Узел всегда создаётся после своего next, поэтому
+// порядок индексов — топологический (next < node).
+class ParentChainStore {
+public:
+    int intern(const QVector<ParentRef>& chain) {
+        int head = kEmptyParentChain;
+        for (int i = chain.size() - 1; i >= 0; --i) {
+            head = append(head, chain.at(i));
+        }
+        return head;
+    }
+
+    int append(const int next, const ParentRef& rawRef) {
+        const ParentRef ref = normalizeParentRef(rawRef);
+        const int key = refKey(ref);
+        const auto existing = m_nodeByKeyAndNext.constFind(qMakePair(key, next));
+        if (existing != m_nodeByKeyAndNext.constEnd()) {
+            return existing.value();
+        }
+
+        ParentChainNode node;
+        node.ref = ref;
+        node.relation = parentRelationFromType(ref.type);
+        node.refKey = key;
+        node.next = next;
+        m_nodes.push_back(node);
+
+        const int index = m_nodes.size() - 1;
+        m_nodeByKeyAndNext.insert(qMakePair(key, next), index);
+        return index;
+    }
+
+    int refKey(const ParentRef& ref) {
+        const int typeId = typeKey(ref.type);
+        const auto existing = m_refKeyByTypeAndId.constFind(qMakePair(typeId, ref.bodyId));
+        if (existing != m_refKeyByTypeAndId.constEnd()) {
+            return existing.value();
+        }
+
+        const int key = m_refKeyByTypeAndId.size();
+        m_refKeyByTypeAndId.insert(qMakePair(typeId, ref.bodyId), key);
+        return key;
+    }
+
+    int virtualRootKey() {
+        return refKey(ParentRef{kVirtualBarycenterRootType, kVirtualBarycenterRootId});
+    }
+
+    int nodeCount() const {
+        return m_nodes.size();
+    }
+
+    const ParentChainNode& node(const int index) const {
+        return m_nodes.at(index);
+    }
+
+    QString toString(const int head) const {
+        if (head == kEmptyParentChain) {
+            return QStringLiteral("<empty>");
+        }
+
+        // Строки строятся лениво и переиспользуются всеми цепочками с общим хвостом.
+        if (m_renderedChains.size() < m_nodes.size()) {
+            m_renderedChains.resize(m_nodes.size());
+        }
+        QString& rendered = m_renderedChains[head];
+        if (rendered.isNull()) {
+            const ParentChainNode& chainNode = m_nodes.at(head);
+            rendered = chainNode.next == kEmptyParentChain
+                ? parentRefToString(chainNode.ref)
+                : QStringLiteral("%1;%2").arg(parentRefToString(chainNode.ref), toString(chainNode.next));
+        }
+        return rendered;
+    }
+
+private:
+    int typeKey(const QString& type) {
+        // Каждое написание типа приводится к нижнему регистру один раз.
+        const auto spelling = m_typeKeyBySpelling.constFind(type);
+        if (spelling != m_typeKeyBySpelling.constEnd()) {
+            return spelling.value();
+        }
+
+        const QString lowered = type.toLower();
+        int key = m_typeKeyByLowered.value(lowered, -1);
+        if (key < 0) {
+            key = m_typeKeyByLowered.size();
+            m_typeKeyByLowered.insert(lowered, key);
+        }
+        m_typeKeyBySpelling.insert(type, key);
+        return key;
+    }
+
+    QVector<ParentChainNode> m_nodes;
+    QHash<QPair<int, int>, int> m_nodeByKeyAndNext;
+    QHash<QPair<int, int>, int> m_refKeyByTypeAndId;
+    QHash<QString, int> m_typeKeyBySpelling;
+    QHash<QString, int> m_typeKeyByLowered;
+    mutable QVector<QString> m_renderedChains;
+};
+
 int readInt(const QJsonObject& object, const QStringList& keys, int defaultValue);
 QString readString(const QJsonObject& object, const QStringList& keys);
 
@@ -358,24 +495,48 @@ QString parentChainToString(const QVector<ParentRef>& chain) {
     return parts.join(QStringLiteral(";"));
 }
 
+bool isTrackedForCycles(const ParentRelation relation) {
+    return relation == ParentRelation::Null
+           || relation == ParentRelation::Star
+           || relation == ParentRelation::Planet;
+}
+
+bool chainHasRepeatedRef(const ParentChainStore& parentChains, const int head) {
+    QVarLengthArray<int, 16> seen;
+    for (int index = head; index != kEmptyParentChain; index = parentChains.node(index).next) {
+        const ParentChainNode& chainNode = parentChains.node(index);
+        if (!isTrackedForCycles(chainNode.relation)) {
+            continue;
+        }
+
+        if (std::find(seen.cbegin(), seen.cend(), chainNode.refKey) != seen.cend()) {
+            return true;
+        }
+        seen.push_back(chainNode.refKey);
+    }
+    return false;
+}
+
 void validateEdastroParentChains(const QVector<CelestialBody>& bodies,
-                                 const QHash<int, QVector<ParentRef>>& parentsByBodyId,
+                                 ParentChainStore* parentChains,
+                                 const QHash<int, int>& chainByBodyId,
                                  const QSet<int>& barycenterIds,
                                  const QString& systemName,
                                  const std::function<void(const QString&)>& onDebugInfo) {
-    QHash<int, QVector<ParentRef>> finalChainByBodyId;
-    QHash<int, CelestialBody> bodyById;
-    for (const auto& body : bodies) {
+    QHash<int, int> finalChainByBodyId;
+    QHash<int, int> bodyIndexById;
+    for (int bodyIndex = 0; bodyIndex < bodies.size(); ++bodyIndex) {
+        const CelestialBody& body = bodies.at(bodyIndex);
         if (body.id < 0) {
             continue;
         }
 
-        QVector<ParentRef> chain = parentsByBodyId.value(body.id);
-        if (chain.isEmpty() && body.parentId >= 0) {
-            chain.push_back(normalizeParentRef({body.parentRelationType, body.parentId}));
+        int chain = chainByBodyId.value(body.id, kEmptyParentChain);
+        if (chain == kEmptyParentChain && body.parentId >= 0) {
+            chain = parentChains->append(kEmptyParentChain, {body.parentRelationType, body.parentId});
         }
         finalChainByBodyId.insert(body.id, chain);
-        bodyById.insert(body.id, body);
+        bodyIndexById.insert(body.id, bodyIndex);
 
         if (body.parentId == body.id) {
             reportHierarchyDiagnostic(systemName,
@@ -383,80 +544,84 @@ void validateEdastroParentChains(const QVector<CelestialBody>& bodies,
                                                           body.id,
                                                           body.name,
                                                           body.parentId,
-                                                          parentChainToString(chain),
+                                                          parentChains->toString(chain),
                                                           QStringLiteral("self-parent (repair required)")},
                                       onDebugInfo);
         }
     }
 
+    auto reportForBody = [&](const QString& level, const int bodyId, const int chain, const QString& reason) {
+        const int bodyIndex = bodyIndexById.value(bodyId, -1);
+        const CelestialBody* body = bodyIndex >= 0 ? &bodies.at(bodyIndex) : nullptr;
+        reportHierarchyDiagnostic(systemName,
+                                  HierarchyDiagnostic{level,
+                                                      bodyId,
+                                                      body ? body->name : QString(),
+                                                      body ? body->parentId : -1,
+                                                      parentChains->toString(chain),
+                                                      reason},
+                                  onDebugInfo);
+    };
+
+    // Свойства цепочки зависят только от её узла, поэтому считаем их один раз на узел:
+    // индексы узлов топологически упорядочены (next < node), хватает одного прохода.
+    const int nodeCount = parentChains->nodeCount();
+    QVector<bool> hasMissingBarycenter(nodeCount, false);
+    for (int index = 0; index < nodeCount; ++index) {
+        const ParentChainNode& chainNode = parentChains->node(index);
+        const bool missingHere = chainNode.relation == ParentRelation::Null
+                                 && !isVirtualRootRef(chainNode.ref)
+                                 && !barycenterIds.contains(chainNode.ref.bodyId);
+        hasMissingBarycenter[index] = missingHere
+                                      || (chainNode.next != kEmptyParentChain && hasMissingBarycenter.at(chainNode.next));
+    }
+
     // 1) Проверяем циклы Null/Star/Planet в цепочке родителей.
+    QHash<int, bool> hasCycleByChain;
     for (auto it = finalChainByBodyId.constBegin(); it != finalChainByBodyId.constEnd(); ++it) {
-        QSet<QString> seen;
-        for (const auto& ref : it.value()) {
-            const bool trackType = ref.type.contains(QStringLiteral("Null"), Qt::CaseInsensitive)
-                                   || ref.type.contains(QStringLiteral("Star"), Qt::CaseInsensitive)
-                                   || ref.type.contains(QStringLiteral("Planet"), Qt::CaseInsensitive);
-            if (!trackType) {
-                continue;
-            }
-
-            const QString key = parentRefKey(normalizeParentRef(ref));
-            if (seen.contains(key)) {
-                reportHierarchyDiagnostic(systemName,
-                                          HierarchyDiagnostic{QStringLiteral("ERROR"),
-                                                              it.key(),
-                                                              bodyById.value(it.key()).name,
-                                                              bodyById.value(it.key()).parentId,
-                                                              parentChainToString(it.value()),
-                                                              QStringLiteral("cycle")},
-                                          onDebugInfo);
-                break;
-            }
-            seen.insert(key);
+        bool hasCycle = false;
+        const auto cached = hasCycleByChain.constFind(it.value());
+        if (cached != hasCycleByChain.constEnd()) {
+            hasCycle = cached.value();
+        } else {
+            hasCycle = chainHasRepeatedRef(*parentChains, it.value());
+            hasCycleByChain.insert(it.value(), hasCycle);
+        }
+        if (hasCycle) {
+            reportForBody(QStringLiteral("ERROR"), it.key(), it.value(), QStringLiteral("cycle"));
         }
     }
 
     // 2) Каждый Null:B у тел должен существовать в barycenters, кроме Null:0.
     for (auto it = finalChainByBodyId.constBegin(); it != finalChainByBodyId.constEnd(); ++it) {
-        for (const auto& ref : it.value()) {
-            const ParentRef normalized = normalizeParentRef(ref);
-            if (!normalized.type.contains(QStringLiteral("Null"), Qt::CaseInsensitive)) {
-                continue;
-            }
-            if (isVirtualRootRef(normalized)) {
-                continue;
-            }
-            if (barycenterIds.contains(normalized.bodyId)) {
-                continue;
-            }
-
-            reportHierarchyDiagnostic(systemName,
-                                      HierarchyDiagnostic{QStringLiteral("ERROR"),
-                                                          it.key(),
-                                                          bodyById.value(it.key()).name,
-                                                          bodyById.value(it.key()).parentId,
-                                                          parentChainToString(it.value()),
-                                                          QStringLiteral("missing barycenter")},
-                                      onDebugInfo);
-            break;
+        if (it.value() != kEmptyParentChain && hasMissingBarycenter.at(it.value())) {
+            reportForBody(QStringLiteral("ERROR"), it.key(), it.value(), QStringLiteral("missing barycenter"));
         }
     }
 
-    // 3) У барицентра не более одного итогового родителя.
-    QHash<int, QSet<QString>> parentVariants;
+    // 3) У барицентра не более одного итогового родителя. Общие хвосты цепочек
+    // обходим один раз; первая цепочка, дошедшая до узла, служит примером в диагностике.
+    const int virtualRootKey = parentChains->virtualRootKey();
+    QVector<bool> visited(nodeCount, false);
+    QHash<int, QSet<int>> parentVariants;
+    QHash<int, int> sourceChainByBarycenterId;
     for (auto it = finalChainByBodyId.constBegin(); it != finalChainByBodyId.constEnd(); ++it) {
-        const auto& chain = it.value();
-        for (int i = 0; i < chain.size(); ++i) {
-            const ParentRef node = normalizeParentRef(chain[i]);
-            if (!node.type.contains(QStringLiteral("Null"), Qt::CaseInsensitive) || isVirtualRootRef(node)) {
+        for (int index = it.value(); index != kEmptyParentChain && !visited.at(index);
+             index = parentChains->node(index).next) {
+            visited[index] = true;
+
+            const ParentChainNode& chainNode = parentChains->node(index);
+            if (chainNode.relation != ParentRelation::Null || isVirtualRootRef(chainNode.ref)) {
                 continue;
             }
 
-            ParentRef candidate = ParentRef{kVirtualBarycenterRootType, kVirtualBarycenterRootId};
-            if (i + 1 < chain.size()) {
-                candidate = normalizeParentRef(chain[i + 1]);
+            const int candidateKey = chainNode.next != kEmptyParentChain
+                ? parentChains->node(chainNode.next).refKey
+                : virtualRootKey;
+            parentVariants[chainNode.ref.bodyId].insert(candidateKey);
+            if (!sourceChainByBarycenterId.contains(chainNode.ref.bodyId)) {
+                sourceChainByBarycenterId.insert(chainNode.ref.bodyId, it.value());
             }
-            parentVariants[node.bodyId].insert(parentRefKey(candidate));
         }
     }
 
@@ -465,38 +630,23 @@ void validateEdastroParentChains(const QVector<CelestialBody>& bodies,
             continue;
         }
 
-        QVector<ParentRef> sourceChain;
-        for (auto bodyIt = finalChainByBodyId.constBegin(); bodyIt != finalChainByBodyId.constEnd(); ++bodyIt) {
-            for (const auto& ref : bodyIt.value()) {
-                const ParentRef normalized = normalizeParentRef(ref);
-                if (normalized.type.contains(QStringLiteral("Null"), Qt::CaseInsensitive)
-                    && !isVirtualRootRef(normalized)
-                    && normalized.bodyId == it.key()) {
-                    sourceChain = bodyIt.value();
-                    break;
-                }
-            }
-            if (!sourceChain.isEmpty()) {
-                break;
-            }
-        }
-
-        reportHierarchyDiagnostic(systemName,
-                                  HierarchyDiagnostic{QStringLiteral("WARNING"),
-                                                      it.key(),
-                                                      bodyById.value(it.key()).name,
-                                                      bodyById.value(it.key()).parentId,
-                                                      parentChainToString(sourceChain),
-                                                      QStringLiteral("multiple parents")},
-                                  onDebugInfo);
+        reportForBody(QStringLiteral("WARNING"),
+                      it.key(),
+                      sourceChainByBarycenterId.value(it.key(), kEmptyParentChain),
+                      QStringLiteral("multiple parents"));
     }
 }
 
 void buildBarycenterHierarchy(QVector<CelestialBody>* bodies,
-                              const QHash<int, QVector<ParentRef>>& parentsByBodyId,
+                              ParentChainStore* parentChains,
+                              const QHash<int, int>& chainByBodyId,
                               const QString& systemName,
                               const std::function<void(const QString&)>& onDebugInfo) {
-    QHash<int, QHash<QString, ParentRef>> barycenterCandidates;
+    const ParentRef virtualRootRef{kVirtualBarycenterRootType, kVirtualBarycenterRootId};
+    const int virtualRootKey = parentChains->virtualRootKey();
+
+    QHash<int, QHash<int, ParentRef>> barycenterCandidates;
+    QVector<bool> visited(parentChains->nodeCount(), false);
 
     for (const auto& body : *bodies) {
         if (body.bodyClass != CelestialBody::BodyClass::Star
@@ -505,26 +655,28 @@ void buildBarycenterHierarchy(QVector<CelestialBody>* bodies,
             continue;
         }
 
-        const auto chain = parentsByBodyId.value(body.id);
-        for (int i = 0; i < chain.size(); ++i) {
-            const ParentRef parent = normalizeParentRef(chain[i]);
-            if (!parent.type.contains(QStringLiteral("Null"), Qt::CaseInsensitive)) {
+        // Дошли до уже обработанного узла — весь остаток цепочки уже учтён другим телом.
+        for (int index = chainByBodyId.value(body.id, kEmptyParentChain);
+             index != kEmptyParentChain && !visited.at(index);
+             index = parentChains->node(index).next) {
+            visited[index] = true;
+
+            const ParentChainNode& chainNode = parentChains->node(index);
+            if (chainNode.relation != ParentRelation::Null) {
                 continue;
             }
 
             // Если в цепочке верхний предок Null:0 (после нормализации — технический id), подвешиваем ветку на виртуальный корень.
-            if (isVirtualRootRef(parent)) {
+            if (isVirtualRootRef(chainNode.ref)) {
                 continue;
             }
 
-            ParentRef candidate;
-            if (i + 1 < chain.size()) {
-                candidate = normalizeParentRef(chain[i + 1]);
+            if (chainNode.next != kEmptyParentChain) {
+                const ParentChainNode& candidate = parentChains->node(chainNode.next);
+                barycenterCandidates[chainNode.ref.bodyId].insert(candidate.refKey, candidate.ref);
             } else {
-                candidate = ParentRef{kVirtualBarycenterRootType, kVirtualBarycenterRootId};
+                barycenterCandidates[chainNode.ref.bodyId].insert(virtualRootKey, virtualRootRef);
             }
-
-            barycenterCandidates[parent.bodyId].insert(parentRefKey(candidate), candidate);
         }
     }
 
@@ -566,7 +718,7 @@ void buildBarycenterHierarchy(QVector<CelestialBody>* bodies,
 }
 
 void synthesizeMissingBarycenters(QVector<CelestialBody>* bodies,
-                                  const QHash<int, QVector<ParentRef>>& parentsByBodyId) {
+                                  const ParentChainStore& parentChains) {
     QSet<int> existingBodyIds;
     for (const auto& body : *bodies) {
         if (body.id >= 0) {
@@ -574,20 +726,19 @@ void synthesizeMissingBarycenters(QVector<CelestialBody>* bodies,
         }
     }
 
+    // Каждая ссылка хранится в дереве один раз на уникальный хвост цепочки,
+    // поэтому достаточно пройти по узлам, а не по цепочкам всех тел.
     QSet<int> missingBarycenterIds;
-    for (auto it = parentsByBodyId.constBegin(); it != parentsByBodyId.constEnd(); ++it) {
-        const auto& parentChain = it.value();
-        for (const auto& relation : parentChain) {
-            const ParentRef normalizedParent = normalizeParentRef(relation);
-            if (!normalizedParent.type.contains(QStringLiteral("Null"), Qt::CaseInsensitive)
-                || normalizedParent.bodyId == kVirtualBarycenterRootId
-                || normalizedParent.bodyId < 0
-                || existingBodyIds.contains(normalizedParent.bodyId)) {
-                continue;
-            }
-
-            missingBarycenterIds.insert(normalizedParent.bodyId);
+    for (int index = 0; index < parentChains.nodeCount(); ++index) {
+        const ParentRef& parent = parentChains.node(index).ref;
+        if (parentChains.node(index).relation != ParentRelation::Null
+            || parent.bodyId == kVirtualBarycenterRootId
+            || parent.bodyId < 0
+            || existingBodyIds.contains(parent.bodyId)) {
+            continue;
         }
+
+        missingBarycenterIds.insert(parent.bodyId);
     }
 
     for (const int barycenterId : missingBarycenterIds) {
@@ -595,6 +746,7 @@ void synthesizeMissingBarycenters(QVector<CelestialBody>* bodies,
         syntheticBarycenter.id = barycenterId;
         syntheticBarycenter.name = QStringLiteral("Barycenter %1").arg(barycenterId);
         syntheticBarycenter.type = QStringLiteral("Barycenter");
+        syntheticBarycenter.taxon = BodyTaxonomy::resolve(syntheticBarycenter.type);
         syntheticBarycenter.bodyClass = CelestialBody::BodyClass::Barycenter;
         syntheticBarycenter.parentId = -1;
         syntheticBarycenter.parentRelationType = QStringLiteral("Unknown");
@@ -615,6 +767,7 @@ void ensureCentralRootBody(QVector<CelestialBody>* bodies) {
     root.id = kExternalVirtualBarycenterMarkerId;
     root.name = QStringLiteral("System Center");
     root.type = QStringLiteral("Null");
+    root.taxon = BodyTaxonomy::resolve(root.type);
     root.bodyClass = CelestialBody::BodyClass::Unknown;
     root.parentId = -1;
     root.parentRelationType.clear();
@@ -844,7 +997,8 @@ bool parseParentFromArray(const QJsonValue& parentsValue,
 }
 
 double readPhysicalRadiusKm(const QJsonObject& object);
-QVector<CelestialBody::CompositionPart> readCompositionParts(const QJsonObject& object, const QStringList& keys);
+template <typename Slot>
+CompositionSlots<Slot> readCompositionParts(const QJsonObject& object, const QStringList& keys);
 void fillPhysicalFieldsFromJson(const QJsonObject& bodyObj, CelestialBody* body, bool isSpanshSource);
 
 QVector<CelestialBody> parseEdsmBodies(const QJsonObject& rootObject) {
@@ -858,7 +1012,8 @@ QVector<CelestialBody> parseEdsmBodies(const QJsonObject& rootObject) {
         body.id = bodyObj.value(QStringLiteral("bodyId")).toInt(-1);
         body.name = bodyObj.value(QStringLiteral("name")).toString();
         body.type = bodyObj.value(QStringLiteral("type")).toString();
-        body.bodyClass = classifyBodyClassFromType(body.type);
+        body.taxon = BodyTaxonomy::resolve(body.type, bodyObj.value(QStringLiteral("subType")).toString());
+        body.bodyClass = classifyBodyClassFromTaxon(body.taxon);
         body.distanceToArrivalLs = bodyObj.value(QStringLiteral("distanceToArrival")).toDouble(0.0);
         body.semiMajorAxisAu = bodyObj.value(QStringLiteral("semiMajorAxis")).toDouble(0.0);
         body.physicalRadiusKm = readPhysicalRadiusKm(bodyObj);
@@ -1000,37 +1155,43 @@ double readPhysicalRadiusKm(const QJsonObject& object) {
     return 0.0;
 }
 
-QVector<CelestialBody::CompositionPart> readCompositionParts(const QJsonObject& object,
-                                                       const QStringList& keys) {
-    QVector<CelestialBody::CompositionPart> result;
-    const QJsonArray partsArray = readArray(object, keys);
-    if (!partsArray.isEmpty()) {
-        result.reserve(partsArray.size());
-        for (const auto& partValue : partsArray) {
-            if (partValue.isObject()) {
-                const auto partObj = partValue.toObject();
-                const QString name = readString(partObj,
-                                                {QStringLiteral("name"),
-                                                 QStringLiteral("material"),
-                                                 QStringLiteral("component"),
-                                                 QStringLiteral("symbol")});
-                const double percent = readDouble(partObj,
-                                                  {QStringLiteral("percent"),
-                                                   QStringLiteral("percentage"),
-                                                   QStringLiteral("share")});
-                if (!name.isEmpty() || percent > 0.0) {
-                    result.push_back({name, percent});
-                }
-                continue;
-            }
+// Части состава раскладываются по слотам сразу при разборе; имена вне закрытого
+// набора игры и части без доли отбрасываются.
+template <typename Slot>
+bool addCompositionPart(CompositionSlots<Slot>* composition, const QString& name, const double percent) {
+    const auto slot = BodyComposition::slotFromName<Slot>(name);
+    if (!slot || !(percent > 0.0)) {
+        return false;
+    }
+    composition->setValue(*slot, composition->value(*slot) + static_cast<float>(percent));
+    return true;
+}
 
-            if (partValue.isString()) {
-                result.push_back({partValue.toString(), 0.0});
-            }
+template <typename Slot>
+CompositionSlots<Slot> readCompositionParts(const QJsonObject& object,
+                                            const QStringList& keys) {
+    CompositionSlots<Slot> result;
+    bool hasParts = false;
+    const QJsonArray partsArray = readArray(object, keys);
+    for (const auto& partValue : partsArray) {
+        if (!partValue.isObject()) {
+            continue;
         }
+
+        const auto partObj = partValue.toObject();
+        const QString name = readString(partObj,
+                                        {QStringLiteral("name"),
+                                         QStringLiteral("material"),
+                                         QStringLiteral("component"),
+                                         QStringLiteral("symbol")});
+        const double percent = readDouble(partObj,
+                                          {QStringLiteral("percent"),
+                                           QStringLiteral("percentage"),
+                                           QStringLiteral("share")});
+        hasParts = addCompositionPart(&result, name, percent) || hasParts;
     }
 
-    if (!result.isEmpty()) {
+    if (hasParts) {
         return result;
     }
 
@@ -1041,7 +1202,6 @@ QVector<CelestialBody::CompositionPart> readCompositionParts(const QJsonObject&
         }
 
         const auto obj = value.toObject();
-        result.reserve(obj.size());
         for (auto it = obj.constBegin(); it != obj.constEnd(); ++it) {
             double percent = 0.0;
             if (it.value().isDouble()) {
@@ -1053,9 +1213,9 @@ QVector<CelestialBody::CompositionPart> readCompositionParts(const QJsonObject&
                     percent = 0.0;
                 }
             }
-            result.push_back({it.key(), percent});
+            hasParts = addCompositionPart(&result, it.key(), percent) || hasParts;
         }
-        if (!result.isEmpty()) {
+        if (hasParts) {
             return result;
         }
     }
@@ -1063,6 +1223,56 @@ QVector<CelestialBody::CompositionPart> readCompositionParts(const QJsonObject&
     return result;
 }
 
+qint64 readUtcTimestampMs(const QJsonObject& object, const QStringList& keys) {
+    QString text = readString(object, keys).trimmed();
+    if (text.isEmpty()) {
+        return 0;
+    }
+
+    // EDAstro пишет "2026-02-15T05:38:20" без зоны, встречается и вариант через пробел; время — UTC.
+    text.replace(QLatin1Char(' '), QLatin1Char('T'));
+    QDateTime timestamp = QDateTime::fromString(text, Qt::ISODate);
+    if (!timestamp.isValid()) {
+        return 0;
+    }
+    if (timestamp.timeSpec() == Qt::LocalTime) {
+        timestamp.setTimeSpec(Qt::UTC);
+    }
+    return timestamp.toMSecsSinceEpoch();
+}
+
+OrbitalElements readOrbitalElements(const QJsonObject& bodyObj) {
+    OrbitalElements orbit;
+    orbit.eccentricity = qBound(0.0,
+                                readDouble(bodyObj,
+                                           {QStringLiteral("orbitalEccentricity"),
+                                            QStringLiteral("eccentricity"),
+                                            QStringLiteral("orbital_eccentricity")}),
+                                0.999999);
+    orbit.inclinationDeg = readDouble(bodyObj,
+                                      {QStringLiteral("orbitalInclination"),
+                                       QStringLiteral("inclination"),
+                                       QStringLiteral("orbital_inclination")});
+    orbit.argOfPeriapsisDeg = readDouble(bodyObj,
+                                         {QStringLiteral("argOfPeriapsis"),
+                                          QStringLiteral("argumentOfPeriapsis"),
+                                          QStringLiteral("arg_of_periapsis")});
+    orbit.ascendingNodeDeg = readDouble(bodyObj,
+                                        {QStringLiteral("ascendingNode"),
+                                         QStringLiteral("ascending_node")});
+    orbit.meanAnomalyDeg = readDouble(bodyObj,
+                                      {QStringLiteral("meanAnomaly"),
+                                       QStringLiteral("mean_anomaly")});
+    orbit.meanAnomalyEpochMs = readUtcTimestampMs(bodyObj,
+                                                  {QStringLiteral("meanAnomalyDate"),
+                                                   QStringLiteral("mean_anomaly_date")});
+    // Период во всех источниках в сутках; знак для положения на орбите не нужен.
+    orbit.orbitalPeriodDays = qAbs(readDouble(bodyObj,
+                                              {QStringLiteral("orbitalPeriod"),
+                                               QStringLiteral("orbital_period")}));
+    return orbit;
+}
+
 void fillPhysicalFieldsFromJson(const QJsonObject& bodyObj, CelestialBody* body, const bool isSpanshSource) {
     body->surfaceGravityMs2 = readDouble(bodyObj,
                                          {QStringLiteral("surfaceGravity"),
@@ -1140,13 +1350,15 @@ void fillPhysicalFieldsFromJson(const QJsonObject& bodyObj, CelestialBody* body,
                                           QStringLiteral("terraforming"),
                                           QStringLiteral("terraforming_state")});
 
-    body->atmoComposition = readCompositionParts(bodyObj,
-                                                 {QStringLiteral("atmosphereComposition"),
-                                                  QStringLiteral("atmoComposition"),
-                                                  QStringLiteral("atmosphere_composition")});
-    body->materials = readCompositionParts(bodyObj,
-                                           {QStringLiteral("materials"),
-                                            QStringLiteral("materialComposition")});
+    body->orbit = readOrbitalElements(bodyObj);
+
+    body->atmoComposition = readCompositionParts<AtmosphereGas>(bodyObj,
+                                                                {QStringLiteral("atmosphereComposition"),
+                                                                 QStringLiteral("atmoComposition"),
+                                                                 QStringLiteral("atmosphere_composition")});
+    body->materials = readCompositionParts<RawMaterial>(bodyObj,
+                                                        {QStringLiteral("materials"),
+                                                         QStringLiteral("materialComposition")});
 }
 
 QString readMessageField(const QJsonObject& object) {
@@ -1329,7 +1541,9 @@ QVector<CelestialBody> parseSpanshBodies(const QJsonObject& rootObject) {
                                 QStringLiteral("subType"),
                                 QStringLiteral("sub_type"),
                                 QStringLiteral("bodyType")});
-        body.bodyClass = classifyBodyClassFromType(body.type);
+        body.taxon = BodyTaxonomy::resolve(body.type,
+                                           readString(bodyObj, {QStringLiteral("subType"), QStringLiteral("sub_type")}));
+        body.bodyClass = classifyBodyClassFromTaxon(body.taxon);
         body.distanceToArrivalLs = readDouble(bodyObj,
                                               {QStringLiteral("distanceToArrival"),
                                                QStringLiteral("distance_to_arrival")});
@@ -1393,7 +1607,7 @@ QVector<CelestialBody> parseSpanshBodies(const QJsonObject& rootObject) {
 
 CelestialBody::BodyClass classifyEdastroBodyClass(const QString& collectionKey,
                                                  const QJsonObject& bodyObj,
-                                                 const QString& bodyType) {
+                                                 const BodyTaxon& taxon) {
     const auto key = collectionKey.toLower();
     if (key.contains(QStringLiteral("star"))) {
         return CelestialBody::BodyClass::Star;
@@ -1408,19 +1622,9 @@ CelestialBody::BodyClass classifyEdastroBodyClass(const QString& collectionKey,
         return CelestialBody::BodyClass::Barycenter;
     }
 
-    if (OrbitClassifier::isBarycenterType(bodyType)) {
-        return CelestialBody::BodyClass::Barycenter;
-    }
-    if (bodyType.contains(QStringLiteral("Star"), Qt::CaseInsensitive)) {
-        return CelestialBody::BodyClass::Star;
-    }
-    if (bodyType.contains(QStringLiteral("Moon"), Qt::CaseInsensitive)) {
-        return CelestialBody::BodyClass::Moon;
-    }
-    if (bodyType.contains(QStringLiteral("Planet"), Qt::CaseInsensitive)
-        || bodyType.contains(QStringLiteral("world"), Qt::CaseInsensitive)
-        || bodyType.contains(QStringLiteral("giant"), Qt::CaseInsensitive)) {
-        return CelestialBody::BodyClass::Planet;
+    const CelestialBody::BodyClass classFromType = classifyBodyClassFromTaxon(taxon);
+    if (classFromType != CelestialBody::BodyClass::Unknown) {
+        return classFromType;
     }
 
     const int parentPlanetId = readInt(bodyObj,
@@ -1476,7 +1680,8 @@ QVector<CelestialBody> parseEdastroBodiesFromObject(const QJsonObject& rootObjec
 
     QVector<CelestialBody> bodies;
     bodies.reserve(rawBodies.size());
-    QHash<int, QVector<ParentRef>> parentsByBodyId;
+    ParentChainStore parentChains;
+    QHash<int, int> chainByBodyId;
     QSet<int> existingBodyIds;
     QSet<int> barycenterBodyIds;
 
@@ -1491,7 +1696,8 @@ QVector<CelestialBody> parseEdastroBodiesFromObject(const QJsonObject& rootObjec
                                                  QStringLiteral("sub_type"),
                                                  QStringLiteral("bodyType"),
                                                  QStringLiteral("body_type")});
-            if (classifyEdastroBodyClass(collectionKey, bodyObj, bodyType) == CelestialBody::BodyClass::Barycenter) {
+            if (classifyEdastroBodyClass(collectionKey, bodyObj, BodyTaxonomy::resolve(bodyType))
+                == CelestialBody::BodyClass::Barycenter) {
                 barycenterBodyIds.insert(bodyId);
             }
         }
@@ -1527,7 +1733,9 @@ QVector<CelestialBody> parseEdastroBodiesFromObject(const QJsonObject& rootObjec
         body.physicalRadiusKm = readPhysicalRadiusKm(bodyObj);
         fillPhysicalFieldsFromJson(bodyObj, &body, false);
 
-        body.bodyClass = classifyEdastroBodyClass(collectionKey, bodyObj, body.type);
+        body.taxon = BodyTaxonomy::resolve(body.type,
+                                           readString(bodyObj, {QStringLiteral("subType"), QStringLiteral("sub_type")}));
+        body.bodyClass = classifyEdastroBodyClass(collectionKey, bodyObj, body.taxon);
         body.orbitsBarycenter = (body.bodyClass == CelestialBody::BodyClass::Barycenter);
 
         QVector<ParentRef> parentChain = parseParentChainFromString(readString(bodyObj, {QStringLiteral("parents")}));
@@ -1581,14 +1789,14 @@ QVector<CelestialBody> parseEdastroBodiesFromObject(const QJsonObject& rootObjec
         }
 
         if (body.id >= 0) {
-            parentsByBodyId.insert(body.id, parentChain);
+            chainByBodyId.insert(body.id, parentChains.intern(parentChain));
         }
 
         bodies.push_back(body);
     }
 
-    synthesizeMissingBarycenters(&bodies, parentsByBodyId);
-    buildBarycenterHierarchy(&bodies, parentsByBodyId, systemName, onDebugInfo);
+    synthesizeMissingBarycenters(&bodies, parentChains);
+    buildBarycenterHierarchy(&bodies, &parentChains, chainByBodyId, systemName, onDebugInfo);
 
     QSet<int> barycenterIds;
     for (const auto& body : bodies) {
@@ -1596,7 +1804,7 @@ QVector<CelestialBody> parseEdastroBodiesFromObject(const QJsonObject& rootObjec
             barycenterIds.insert(body.id);
         }
     }
-    validateEdastroParentChains(bodies, parentsByBodyId, barycenterIds, systemName, onDebugInfo);
+    validateEdastroParentChains(bodies, &parentChains, chainByBodyId, barycenterIds, systemName, onDebugInfo);
     prepareBodiesForGraph(&bodies, onDebugInfo, QStringLiteral("EDASTRO"));
 
     return bodies;
@@ -1666,6 +1874,82 @@ QVector<CelestialBody> parseEdastroBodies(const QJsonDocument& document,
                                         onDebugInfo);
 }
 
+bool looksLikeEdastroSystemObject(const QJsonObject& object) {
+    for (const auto& key : {QStringLiteral("id64"),
+                            QStringLiteral("coord_x"),
+                            QStringLiteral("bodies"),
+                            QStringLiteral("stars"),
+                            QStringLiteral("planets"),
+                            QStringLiteral("barycenters"),
+                            QStringLiteral("barycentres")}) {
+        if (object.contains(key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Объект самой системы: корень ответа либо первый элемент массива систем.
+QJsonObject findEdastroSystemObject(const QJsonDocument& document) {
+    if (document.isArray()) {
+        const auto systemsArray = document.array();
+        return systemsArray.isEmpty() ? QJsonObject() : systemsArray.first().toObject();
+    }
+
+    const auto rootObject = document.object();
+    if (rootObject.contains(QStringLiteral("name")) || looksLikeEdastroSystemObject(rootObject)) {
+        return rootObject;
+    }
+
+    for (auto it = rootObject.constBegin(); it != rootObject.constEnd(); ++it) {
+        const auto systemsArray = it.value().toArray();
+        if (!systemsArray.isEmpty() && looksLikeEdastroSystemObject(systemsArray.first().toObject())) {
+            return systemsArray.first().toObject();
+        }
+    }
+
+    return rootObject;
+}
+
+std::optional<GalacticCoordinates> readEdastroSystemCoordinates(const QJsonObject& systemObject) {
+    const QStringList axisKeys{QStringLiteral("coord_x"), QStringLiteral("coord_y"), QStringLiteral("coord_z")};
+    for (const auto& key : axisKeys) {
+        if (!systemObject.value(key).isDouble()) {
+            return std::nullopt;
+        }
+    }
+
+    GalacticCoordinates coordinates;
+    coordinates.x = systemObject.value(axisKeys.at(0)).toDouble();
+    coordinates.y = systemObject.value(axisKeys.at(1)).toDouble();
+    coordinates.z = systemObject.value(axisKeys.at(2)).toDouble();
+    return coordinates;
+}
+
+quint64 parseEdastroSystemId64(const QByteArray& payload) {
+    // Как и для индекса EDSM, id64 читаем из исходного токена: через double
+    // значения больше 2^53 округляются. Ключ "id64" есть только у системы; если его нет,
+    // id64 системы восстанавливается из младших 55 бит bodyId64 любого тела.
+    static const QRegularExpression kSystemId64Regex(QStringLiteral("\"id64\"\\s*:\\s*\"?([0-9]+)"));
+    static const QRegularExpression kBodyId64Regex(QStringLiteral("\"bodyId64\"\\s*:\\s*\"?([0-9]+)"));
+
+    const auto payloadText = QString::fromUtf8(payload);
+    const auto systemMatch = kSystemId64Regex.match(payloadText);
+    if (systemMatch.hasMatch()) {
+        return systemMatch.captured(1).toULongLong();
+    }
+
+    const auto bodyMatch = kBodyId64Regex.match(payloadText);
+    return bodyMatch.hasMatch() ? SystemId64::systemOfBody(bodyMatch.captured(1).toULongLong()) : 0;
+}
+
+// Поля уровня системы (id64, координаты) — без разбора тел.
+void readEdastroSystemHeader(const QJsonDocument& document, const QByteArray& payload, SystemBodiesResult* result) {
+    const auto systemObject = findEdastroSystemObject(document);
+    result->systemId64 = parseEdastroSystemId64(payload);
+    result->coordinates = readEdastroSystemCoordinates(systemObject);
+}
+
 QVector<CelestialBody> mergeBodies(const QVector<CelestialBody>& edsmBodies,
                                    const QVector<CelestialBody>& spanshBodies,
                                    bool* outHadConflict) {
@@ -1706,6 +1990,7 @@ QVector<CelestialBody> mergeBodies(const QVector<CelestialBody>& edsmBodies,
             syntheticParent.id = body.parentId;
             syntheticParent.name = QStringLiteral("Body %1").arg(body.parentId);
             syntheticParent.type = QStringLiteral("Unknown");
+            syntheticParent.taxon = BodyTaxonomy::resolve(syntheticParent.type);
             mergedById.insert(syntheticParent.id, syntheticParent);
         }
     }
@@ -1727,6 +2012,28 @@ QVector<CelestialBody> parseEdastroBodiesForTests(const QJsonDocument& document,
     return parseEdastroBodies(document, defaultSystemName, onDebugInfo);
 }
 
+SystemBodiesResult parseEdastroSystemPayload(const QByteArray& payload,
+                                             const QString& defaultSystemName,
+                                             const std::function<void(const QString&)>& onDebugInfo) {
+    SystemBodiesResult result;
+    result.selectedSource = SystemDataSource::Edastro;
+
+    const auto document = QJsonDocument::fromJson(payload);
+    if (!document.isObject() && !document.isArray()) {
+        return result;
+    }
+
+    const auto parsedSystemName = readString(findEdastroSystemObject(document), {QStringLiteral("name")});
+    result.systemName = parsedSystemName.isEmpty() ? defaultSystemName.trimmed() : parsedSystemName;
+    readEdastroSystemHeader(document, payload, &result);
+    result.bodies = parseEdastroBodies(document, result.systemName, onDebugInfo);
+    if (!prepareBodiesForGraph(&result.bodies, onDebugInfo, QStringLiteral("EDASTRO"))) {
+        result.bodies.clear();
+    }
+    result.hasEdastroData = !result.bodies.isEmpty();
+    return result;
+}
+
 EdsmApiClient::EdsmApiClient(QObject* parent)
     : QObject(parent)
     , m_networkManager(new QNetworkAccessManager(this)) {
@@ -1912,8 +2219,8 @@ void EdsmApiClient::requestSpanshSystemBodies(const QString& systemName) {
                                          this,
                                          trimmedSystemName,
                                          systemIndex,
-                                         [this, trimmedSystemName](const QVector<CelestialBody>& spanshBodies,
-                                                                   const QString& spanshError) {
+                                         [this, trimmedSystemName, systemIndex](const QVector<CelestialBody>& spanshBodies,
+                                                                                const QString& spanshError) {
                                              if (!spanshError.isEmpty()) {
                                                  emit requestFailed(spanshError);
                                                  return;
@@ -1921,6 +2228,7 @@ void EdsmApiClient::requestSpanshSystemBodies(const QString& systemName) {
 
                                              SystemBodiesResult result;
                                              result.systemName = trimmedSystemName;
+                                             result.systemId64 = systemIndex.toULongLong();
                                              result.bodies = spanshBodies;
                                              result.selectedSource = SystemDataSource::Spansh;
                                              result.hasSpanshData = !result.bodies.isEmpty();
@@ -2014,6 +2322,7 @@ void EdsmApiClient::requestEdastroSystemBodies(const QString& systemName) {
 
         SystemBodiesResult result;
         result.systemName = trimmedSystemName;
+        readEdastroSystemHeader(document, payload, &result);
         result.bodies = bodies;
         result.selectedSource = SystemDataSource::Edastro;
         result.hasEdastroData = true;
@@ -2049,6 +2358,7 @@ void EdsmApiClient::requestSystemBodies(const QString& systemName, const SystemR
         QString spanshError;
         QVector<CelestialBody> edsmBodies;
         QVector<CelestialBody> spanshBodies;
+        quint64 systemId64 = 0;
     };
 
     const bool autoMergeMode = (mode == SystemRequestMode::AutoMerge);
@@ -2062,6 +2372,7 @@ void EdsmApiClient::requestSystemBodies(const QString& systemName, const SystemR
 
         SystemBodiesResult result;
         result.systemName = trimmedSystemName;
+        result.systemId64 = state->systemId64;
         result.hasEdsmData = !state->edsmBodies.isEmpty();
         result.hasSpanshData = !state->spanshBodies.isEmpty();
 
@@ -2284,6 +2595,7 @@ void EdsmApiClient::requestSystemBodies(const QString& systemName, const SystemR
             finalizeRequest();
             return;
         }
+        state->systemId64 = systemIndex.toULongLong();
 
         requestSpanshBodiesBySystemIndex(m_networkManager,
                                          this,
@@ -2,10 +2,13 @@
 
 #include <QObject>
 #include <functional>
+#include <optional>
 #include <QVector>
 
 #include "CelestialBody.h"
+#include "GalacticCoordinates.h"
 
+class QByteArray;
 class QNetworkAccessManager;
 class QJsonDocument;
 
@@ -25,6 +28,11 @@ enum class SystemRequestMode {
 
 struct SystemBodiesResult {
     QString systemName;
+    // 0 — источник не сообщил id64 системы.
+    quint64 systemId64 = 0;
+    // Галактические координаты (EDAstro coord_x/y/z), если источник их прислал.
+    // sol_dist не храним: это расстояние от начала координат, оно выводится из них.
+    std::optional<GalacticCoordinates> coordinates;
     QVector<CelestialBody> bodies;
     SystemDataSource selectedSource = SystemDataSource::Edastro;
     bool hasEdsmData = false;
@@ -59,3 +67,9 @@ Q_DECLARE_METATYPE(SystemBodiesResult);
 QVector<CelestialBody> parseEdastroBodiesForTests(const QJsonDocument& document,
                                                   const QString& defaultSystemName,
                                                   const std::function<void(const QString&)>& onDebugInfo);
+
+// Разбор сохранённого ответа EDAstro (импорт локального JSON-файла). Тела проходят ту же
+// подготовку иерархии, что и при сетевом запросе; пустой список тел означает ошибку формата.
+SystemBodiesResult parseEdastroSystemPayload(const QByteArray& payload,
+                                             const QString& defaultSystemName,
+                                             const std::function<void(const QString&)>& onDebugInfo);
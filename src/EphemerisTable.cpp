@@ -0,0 +1,164 @@
+#include "EphemerisTable.h"
+
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Сегментов на оборот у круговой орбиты. У вытянутой скорость у перицентра растёт как
+// 1/(1 − e), и сегменты мельчают пропорционально, но не больше kMaxSegmentsPerRevolution.
+constexpr int kBaseSegmentsPerRevolution = 8;
+constexpr int kMaxSegmentsPerRevolution = 512;
+constexpr int kAxisCount = 3;
+
+int segmentsPerRevolution(const double eccentricity) {
+    const double segments = std::ceil(kBaseSegmentsPerRevolution / qMax(1e-6, 1.0 - eccentricity));
+    return static_cast<int>(qBound(static_cast<double>(kBaseSegmentsPerRevolution),
+                                   segments,
+                                   static_cast<double>(kMaxSegmentsPerRevolution)));
+}
+
+} // namespace
+
+void EphemerisTable::reset(const int bodyCount) {
+    m_tableByIndex.fill(-1, bodyCount);
+    m_tables.clear();
+    m_coefficients.clear();
+}
+
+int EphemerisTable::bodyCount() const {
+    return m_tableByIndex.size();
+}
+
+bool EphemerisTable::contains(const int index) const {
+    return index >= 0 && index < m_tableByIndex.size() && m_tableByIndex.at(index) >= 0;
+}
+
+int EphemerisTable::tableCount() const {
+    return m_tables.size();
+}
+
+qint64 EphemerisTable::estimatedMemoryBytes() const {
+    return static_cast<qint64>(sizeof(EphemerisTable))
+         + static_cast<qint64>(m_tableByIndex.capacity()) * static_cast<qint64>(sizeof(int))
+         + static_cast<qint64>(m_tables.capacity()) * static_cast<qint64>(sizeof(BodyTable))
+         + static_cast<qint64>(m_coefficients.capacity()) * static_cast<qint64>(sizeof(double));
+}
+
+EphemerisTable EphemerisTable::build(const KeplerEphemeris& ephemeris, const QVector<int>& indices) {
+    EphemerisTable table;
+    table.reset(ephemeris.size());
+
+    // Узлы Чебышёва первого рода на [−1, 1] и косинусы для прямого преобразования.
+    double nodes[kCoefficientCount];
+    double basis[kCoefficientCount][kCoefficientCount];
+    for (int node = 0; node < kCoefficientCount; ++node) {
+        const double angle = M_PI * (node + 0.5) / kCoefficientCount;
+        nodes[node] = std::cos(angle);
+        for (int degree = 0; degree < kCoefficientCount; ++degree) {
+            basis[degree][node] = std::cos(degree * angle);
+        }
+    }
+
+    QVector<double> revolutions;
+    QVector<double> samples[kAxisCount];
+    for (const int index : indices) {
+        if (index < 0 || index >= ephemeris.size() || !ephemeris.hasPhase(index) || table.contains(index)) {
+            continue;
+        }
+
+        const int segmentCount = segmentsPerRevolution(ephemeris.eccentricity(index));
+        const int sampleCount = segmentCount * kCoefficientCount;
+        revolutions.resize(sampleCount);
+        for (int segment = 0; segment < segmentCount; ++segment) {
+            for (int node = 0; node < kCoefficientCount; ++node) {
+                revolutions[segment * kCoefficientCount + node] = (segment + 0.5 * (nodes[node] + 1.0)) / segmentCount;
+            }
+        }
+        for (QVector<double>& axisSamples : samples) {
+            axisSamples.resize(sampleCount);
+        }
+        // Все узлы оборота решаются одним пакетом.
+        ephemeris.sampleRelative(index, revolutions.constData(), sampleCount,
+                                 samples[0].data(), samples[1].data(), samples[2].data());
+
+        BodyTable bodyTable;
+        bodyTable.segmentCount = segmentCount;
+        bodyTable.coefficientOffset = table.m_coefficients.size();
+        table.m_coefficients.resize(bodyTable.coefficientOffset + segmentCount * kAxisCount * kCoefficientCount);
+        double* coefficients = table.m_coefficients.data() + bodyTable.coefficientOffset;
+        for (int segment = 0; segment < segmentCount; ++segment) {
+            for (int axis = 0; axis < kAxisCount; ++axis) {
+                const double* values = samples[axis].constData() + segment * kCoefficientCount;
+                for (int degree = 0; degree < kCoefficientCount; ++degree) {
+                    double sum = 0.0;
+                    for (int node = 0; node < kCoefficientCount; ++node) {
+                        sum += values[node] * basis[degree][node];
+                    }
+                    *coefficients++ = (degree == 0 ? 1.0 : 2.0) * sum / kCoefficientCount;
+                }
+            }
+        }
+
+        table.m_tableByIndex[index] = table.m_tables.size();
+        table.m_tables.push_back(bodyTable);
+    }
+    return table;
+}
+
+void EphemerisTable::merge(const EphemerisTable& other) {
+    if (other.bodyCount() != bodyCount()) {
+        return;
+    }
+
+    for (int index = 0; index < other.m_tableByIndex.size(); ++index) {
+        const int otherSlot = other.m_tableByIndex.at(index);
+        if (otherSlot < 0 || contains(index)) {
+            continue;
+        }
+
+        BodyTable bodyTable = other.m_tables.at(otherSlot);
+        const int length = bodyTable.segmentCount * kAxisCount * kCoefficientCount;
+        const int sourceOffset = bodyTable.coefficientOffset;
+        bodyTable.coefficientOffset = m_coefficients.size();
+        m_coefficients.resize(bodyTable.coefficientOffset + length);
+        std::copy(other.m_coefficients.constBegin() + sourceOffset,
+                  other.m_coefficients.constBegin() + sourceOffset + length,
+                  m_coefficients.begin() + bodyTable.coefficientOffset);
+        m_tableByIndex[index] = m_tables.size();
+        m_tables.push_back(bodyTable);
+    }
+}
+
+bool EphemerisTable::evaluate(const int index, const double revolutions, double& x, double& y, double& z) const {
+    if (!contains(index)) {
+        return false;
+    }
+
+    const BodyTable& bodyTable = m_tables.at(m_tableByIndex.at(index));
+    const double position = (revolutions - std::floor(revolutions)) * bodyTable.segmentCount;
+    const int segment = qBound(0, static_cast<int>(position), bodyTable.segmentCount - 1);
+    const double local = 2.0 * (position - segment) - 1.0;
+    const double* coefficients = m_coefficients.constData() + bodyTable.coefficientOffset
+                               + segment * kAxisCount * kCoefficientCount;
+
+    // Схема Кленшоу: сумма ряда Чебышёва без вычисления самих многочленов.
+    double values[kAxisCount];
+    for (int axis = 0; axis < kAxisCount; ++axis) {
+        const double* axisCoefficients = coefficients + axis * kCoefficientCount;
+        double next = 0.0;
+        double afterNext = 0.0;
+        for (int degree = kChebyshevDegree; degree >= 1; --degree) {
+            const double current = 2.0 * local * next - afterNext + axisCoefficients[degree];
+            afterNext = next;
+            next = current;
+        }
+        values[axis] = local * next - afterNext + axisCoefficients[0];
+    }
+    x = values[0];
+    y = values[1];
+    z = values[2];
+    return true;
+}
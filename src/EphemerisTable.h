@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QVector>
+#include <QtGlobal>
+
+#include "KeplerEphemeris.h"
+
+// Заранее посчитанные эфемериды для прокрутки времени: смещение тела от родителя на одном
+// обороте приближено кусочными многочленами Чебышёва. Кеплерово движение периодично, поэтому
+// таблица одного оборота годится на любой момент и не зависит от зума, а её вычисление
+// в момент кадра — это выбор сегмента и схема Кленшоу без решения уравнения Кеплера.
+//
+// Таблицы строятся лениво и только для запрошенных тел (видимых на сцене): build() считает
+// набор тел, merge() добавляет его к уже накопленным.
+class EphemerisTable {
+public:
+    // Степень многочлена на сегменте: 9 коэффициентов на координату.
+    static constexpr int kChebyshevDegree = 8;
+
+    // Таблица на bodyCount тел без построенных сегментов.
+    void reset(int bodyCount);
+    int bodyCount() const;
+    bool contains(int index) const;
+    int tableCount() const;
+    qint64 estimatedMemoryBytes() const;
+
+    // Таблицы тел indices с известной фазой; остальные индексы пропускаются.
+    static EphemerisTable build(const KeplerEphemeris& ephemeris, const QVector<int>& indices);
+    // Переносит таблицы other, которых здесь ещё нет; число тел должно совпадать.
+    void merge(const EphemerisTable& other);
+
+    // Смещение тела от родителя, а.е., через revolutions оборотов от момента его средней
+    // аномалии (KeplerEphemeris::revolutionsSinceEpoch); false — таблицы тела нет.
+    bool evaluate(int index, double revolutions, double& x, double& y, double& z) const;
+
+private:
+    static constexpr int kCoefficientCount = kChebyshevDegree + 1;
+
+    struct BodyTable {
+        int segmentCount = 0;
+        // Начало коэффициентов тела в m_coefficients: сегменты подряд, в сегменте x, y, z.
+        int coefficientOffset = 0;
+    };
+
+    // Индекс тела → номер в m_tables, −1 — таблицы нет.
+    QVector<int> m_tableByIndex;
+    QVector<BodyTable> m_tables;
+    QVector<double> m_coefficients;
+};
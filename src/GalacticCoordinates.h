@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <cmath>
+
+// Галактические координаты системы в световых годах, Sol — начало координат
+// (оси как в журнале игры и в полях coord_x/coord_y/coord_z EDAstro).
+struct GalacticCoordinates {
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+
+    double squaredDistanceTo(const GalacticCoordinates& other) const {
+        const double dx = x - other.x;
+        const double dy = y - other.y;
+        const double dz = z - other.z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    double distanceTo(const GalacticCoordinates& other) const {
+        return std::sqrt(squaredDistanceTo(other));
+    }
+
+    double distanceToSol() const {
+        return std::sqrt(x * x + y * y + z * z);
+    }
+
+    // Компонента по оси 0/1/2 — для k-d дерева.
+    double axis(const int axisIndex) const {
+        return axisIndex == 0 ? x : (axisIndex == 1 ? y : z);
+    }
+};
+
+Q_DECLARE_TYPEINFO(GalacticCoordinates, Q_PRIMITIVE_TYPE);
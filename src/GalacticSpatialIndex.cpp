@@ -0,0 +1,260 @@
+#include "GalacticSpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr int kAxisCount = 3;
+// Буфер добавленных точек перебирается каждым запросом; при таком размере он вливается в дерево.
+constexpr int kMaxPendingPoints = 256;
+
+struct NearestSearch {
+    GalacticCoordinates origin;
+    int k = 0;
+    const GalacticSpatialIndex::PointFilter* accept = nullptr;
+    const QHash<quint64, int>* shadowed = nullptr;
+    // Max-heap по квадрату расстояния: на вершине худший из текущих k кандидатов.
+    std::vector<std::pair<double, int>> heap;
+};
+
+struct RadiusSearch {
+    GalacticCoordinates origin;
+    double radiusSquared = 0.0;
+    const GalacticSpatialIndex::PointFilter* accept = nullptr;
+    const QHash<quint64, int>* shadowed = nullptr;
+    std::vector<std::pair<double, int>> hits;
+};
+
+bool accepts(const GalacticSpatialIndex::PointFilter* accept, const GalacticPoint& point) {
+    return !*accept || (*accept)(point);
+}
+
+// Точка дерева, перенесённая insert() в буфер, отвечает оттуда.
+template <typename Search>
+bool acceptsTreePoint(const Search& search, const GalacticPoint& point) {
+    return !search.shadowed->contains(point.systemId64) && accepts(search.accept, point);
+}
+
+void searchNearest(const GalacticPoint* points, const int begin, const int end, const int depth, NearestSearch& search) {
+    if (begin >= end) {
+        return;
+    }
+
+    const int mid = begin + (end - begin) / 2;
+    const GalacticPoint& node = points[mid];
+    const int axis = depth % kAxisCount;
+    const double delta = search.origin.axis(axis) - node.position.axis(axis);
+
+    if (acceptsTreePoint(search, node)) {
+        const double distanceSquared = search.origin.squaredDistanceTo(node.position);
+        if (static_cast<int>(search.heap.size()) < search.k) {
+            search.heap.emplace_back(distanceSquared, mid);
+            std::push_heap(search.heap.begin(), search.heap.end());
+        } else if (distanceSquared < search.heap.front().first) {
+            std::pop_heap(search.heap.begin(), search.heap.end());
+            search.heap.back() = {distanceSquared, mid};
+            std::push_heap(search.heap.begin(), search.heap.end());
+        }
+    }
+
+    const bool originOnLowSide = delta < 0.0;
+    if (originOnLowSide) {
+        searchNearest(points, begin, mid, depth + 1, search);
+    } else {
+        searchNearest(points, mid + 1, end, depth + 1, search);
+    }
+
+    // Дальнюю половину смотрим, только если плоскость разбиения ближе худшего кандидата.
+    const bool heapFull = static_cast<int>(search.heap.size()) >= search.k;
+    if (heapFull && delta * delta >= search.heap.front().first) {
+        return;
+    }
+
+    if (originOnLowSide) {
+        searchNearest(points, mid + 1, end, depth + 1, search);
+    } else {
+        searchNearest(points, begin, mid, depth + 1, search);
+    }
+}
+
+void searchRadius(const GalacticPoint* points, const int begin, const int end, const int depth, RadiusSearch& search) {
+    if (begin >= end) {
+        return;
+    }
+
+    const int mid = begin + (end - begin) / 2;
+    const GalacticPoint& node = points[mid];
+    const int axis = depth % kAxisCount;
+    const double delta = search.origin.axis(axis) - node.position.axis(axis);
+
+    const double distanceSquared = search.origin.squaredDistanceTo(node.position);
+    if (distanceSquared <= search.radiusSquared && acceptsTreePoint(search, node)) {
+        search.hits.emplace_back(distanceSquared, mid);
+    }
+
+    const bool crossesPlane = delta * delta <= search.radiusSquared;
+    if (delta < 0.0 || crossesPlane) {
+        searchRadius(points, begin, mid, depth + 1, search);
+    }
+    if (delta >= 0.0 || crossesPlane) {
+        searchRadius(points, mid + 1, end, depth + 1, search);
+    }
+}
+
+QVector<GalacticSpatialIndex::Neighbor> toNeighbors(const QVector<GalacticPoint>& points,
+                                                    std::vector<std::pair<double, int>>& candidates) {
+    std::sort(candidates.begin(), candidates.end());
+
+    QVector<GalacticSpatialIndex::Neighbor> neighbors;
+    neighbors.reserve(static_cast<int>(candidates.size()));
+    for (const auto& candidate : candidates) {
+        neighbors.push_back({points.at(candidate.second), std::sqrt(candidate.first)});
+    }
+    return neighbors;
+}
+
+// Дописывает подходящие точки буфера к ответу дерева и восстанавливает порядок по расстоянию.
+void appendPending(const QVector<GalacticPoint>& pending,
+                   const GalacticCoordinates& origin,
+                   const double radiusSquared,
+                   const GalacticSpatialIndex::PointFilter& accept,
+                   QVector<GalacticSpatialIndex::Neighbor>& neighbors) {
+    const int treeCount = neighbors.size();
+    for (const GalacticPoint& point : pending) {
+        const double distanceSquared = origin.squaredDistanceTo(point.position);
+        if (distanceSquared <= radiusSquared && accepts(&accept, point)) {
+            neighbors.push_back({point, std::sqrt(distanceSquared)});
+        }
+    }
+    if (neighbors.size() == treeCount) {
+        return;
+    }
+    std::stable_sort(neighbors.begin(), neighbors.end(),
+                     [](const GalacticSpatialIndex::Neighbor& lhs, const GalacticSpatialIndex::Neighbor& rhs) {
+                         return lhs.distanceLy < rhs.distanceLy;
+                     });
+}
+
+} // namespace
+
+void GalacticSpatialIndex::build(QVector<GalacticPoint> points) {
+    m_points = std::move(points);
+    m_pending.clear();
+    m_pendingById.clear();
+    m_shadowedCount = 0;
+    buildRange(0, m_points.size(), 0);
+}
+
+void GalacticSpatialIndex::insert(const GalacticPoint& point) {
+    const auto pendingIt = m_pendingById.constFind(point.systemId64);
+    if (pendingIt != m_pendingById.constEnd()) {
+        m_pending[*pendingIt].position = point.position;
+        return;
+    }
+
+    // Повторное сохранение системы обычно не двигает её: такая точка остаётся в дереве.
+    const auto treeIt = std::find_if(m_points.cbegin(), m_points.cend(), [&point](const GalacticPoint& existing) {
+        return existing.systemId64 == point.systemId64;
+    });
+    if (treeIt != m_points.cend()) {
+        if (treeIt->position.x == point.position.x && treeIt->position.y == point.position.y
+            && treeIt->position.z == point.position.z) {
+            return;
+        }
+        ++m_shadowedCount;
+    }
+
+    m_pendingById.insert(point.systemId64, m_pending.size());
+    m_pending.push_back(point);
+    if (m_pending.size() >= kMaxPendingPoints) {
+        mergePending();
+    }
+}
+
+void GalacticSpatialIndex::clear() {
+    m_points.clear();
+    m_pending.clear();
+    m_pendingById.clear();
+    m_shadowedCount = 0;
+}
+
+int GalacticSpatialIndex::size() const {
+    return m_points.size() - m_shadowedCount + m_pending.size();
+}
+
+bool GalacticSpatialIndex::isEmpty() const {
+    return size() == 0;
+}
+
+void GalacticSpatialIndex::mergePending() {
+    QVector<GalacticPoint> points;
+    points.reserve(size());
+    for (const GalacticPoint& point : qAsConst(m_points)) {
+        if (!m_pendingById.contains(point.systemId64)) {
+            points.push_back(point);
+        }
+    }
+    points.append(m_pending);
+    build(std::move(points));
+}
+
+void GalacticSpatialIndex::buildRange(const int begin, const int end, const int depth) {
+    if (end - begin <= 1) {
+        return;
+    }
+
+    // Медиана по текущей оси становится узлом, меньшие координаты уходят влево.
+    const int mid = begin + (end - begin) / 2;
+    const int axis = depth % kAxisCount;
+    GalacticPoint* data = m_points.data();
+    std::nth_element(data + begin, data + mid, data + end, [axis](const GalacticPoint& lhs, const GalacticPoint& rhs) {
+        return lhs.position.axis(axis) < rhs.position.axis(axis);
+    });
+
+    buildRange(begin, mid, depth + 1);
+    buildRange(mid + 1, end, depth + 1);
+}
+
+QVector<GalacticSpatialIndex::Neighbor> GalacticSpatialIndex::kNearest(const GalacticCoordinates& origin,
+                                                                       const int k,
+                                                                       const PointFilter& accept) const {
+    if (k <= 0 || isEmpty()) {
+        return {};
+    }
+
+    NearestSearch search;
+    search.origin = origin;
+    search.k = k;
+    search.accept = &accept;
+    search.shadowed = &m_pendingById;
+    search.heap.reserve(static_cast<size_t>(qMin(k, m_points.size())));
+    searchNearest(m_points.constData(), 0, m_points.size(), 0, search);
+    QVector<Neighbor> neighbors = toNeighbors(m_points, search.heap);
+    appendPending(m_pending, origin, std::numeric_limits<double>::infinity(), accept, neighbors);
+    if (neighbors.size() > k) {
+        neighbors.resize(k);
+    }
+    return neighbors;
+}
+
+QVector<GalacticSpatialIndex::Neighbor> GalacticSpatialIndex::withinRadius(const GalacticCoordinates& origin,
+                                                                           const double radiusLy,
+                                                                           const PointFilter& accept) const {
+    if (radiusLy < 0.0 || isEmpty()) {
+        return {};
+    }
+
+    RadiusSearch search;
+    search.origin = origin;
+    search.radiusSquared = radiusLy * radiusLy;
+    search.accept = &accept;
+    search.shadowed = &m_pendingById;
+    searchRadius(m_points.constData(), 0, m_points.size(), 0, search);
+    QVector<Neighbor> neighbors = toNeighbors(m_points, search.hits);
+    appendPending(m_pending, origin, search.radiusSquared, accept, neighbors);
+    return neighbors;
+}
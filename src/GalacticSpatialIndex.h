@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QHash>
+#include <QVector>
+#include <QtGlobal>
+
+#include <functional>
+
+#include "GalacticCoordinates.h"
+
+struct GalacticPoint {
+    quint64 systemId64 = 0;
+    GalacticCoordinates position;
+};
+
+Q_DECLARE_TYPEINFO(GalacticPoint, Q_PRIMITIVE_TYPE);
+
+// Статическое k-d дерево по координатам систем. Строится пакетно за O(n log n)
+// (импорт корпуса, загрузка дампа) и хранится неявно: узел — середина своего диапазона
+// в плотном массиве точек, ось разбиения чередуется x → y → z по глубине.
+// Запросы k ближайших и по радиусу обходят только ветви, пересекающие текущую сферу поиска.
+// Единичные системы (сохранение загруженной системы в корпус) добавляются через insert()
+// в небольшой несортированный буфер, который перебирается линейно и вливается в дерево
+// пересборкой, когда разрастается.
+class GalacticSpatialIndex {
+public:
+    struct Neighbor {
+        GalacticPoint point;
+        double distanceLy = 0.0;
+    };
+
+    // Фильтр точек (например, «в системе есть терраформируемая планета»).
+    // Отклонённые точки не занимают место среди k ближайших.
+    using PointFilter = std::function<bool(const GalacticPoint&)>;
+
+    void build(QVector<GalacticPoint> points);
+    // Добавляет точку или переносит уже известную по systemId64 на новые координаты.
+    void insert(const GalacticPoint& point);
+    void clear();
+
+    int size() const;
+    bool isEmpty() const;
+
+    // До k ближайших точек, по возрастанию расстояния.
+    QVector<Neighbor> kNearest(const GalacticCoordinates& origin, int k, const PointFilter& accept = PointFilter()) const;
+    // Все точки не дальше radiusLy, по возрастанию расстояния.
+    QVector<Neighbor> withinRadius(const GalacticCoordinates& origin,
+                                   double radiusLy,
+                                   const PointFilter& accept = PointFilter()) const;
+
+private:
+    void buildRange(int begin, int end, int depth);
+    void mergePending();
+
+    QVector<GalacticPoint> m_points;
+    // Добавленные после build() точки и их позиции в буфере по id64. Точка дерева с тем же
+    // id64 устарела и в запросах пропускается.
+    QVector<GalacticPoint> m_pending;
+    QHash<quint64, int> m_pendingById;
+    int m_shadowedCount = 0;
+};
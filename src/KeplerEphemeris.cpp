@@ -0,0 +1,295 @@
+#include "KeplerEphemeris.h"
+
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kMsPerDay = 86400000.0;
+constexpr int kMaxNewtonIterations = 16;
+// Поправка Ньютона меньше этой (рад) — дальше точность double уже не растёт.
+constexpr double kEccentricAnomalyTolerance = 1e-12;
+
+template <typename... Vectors>
+void resizeAll(const int size, Vectors&... vectors) {
+    (vectors.resize(size), ...);
+}
+
+} // namespace
+
+KeplerEphemeris KeplerEphemeris::build(const BodyGraph& graph,
+                                       const QVector<BodyHot>& hotBodies,
+                                       const QVector<BodyCold>& coldBodies) {
+    KeplerEphemeris ephemeris;
+    const int bodyCount = graph.size();
+    resizeAll(bodyCount,
+              ephemeris.m_semiMajorAxisAu,
+              ephemeris.m_eccentricity,
+              ephemeris.m_semiMinorFactor,
+              ephemeris.m_meanAnomalyAtEpoch,
+              ephemeris.m_revolutionsPerDay,
+              ephemeris.m_pX,
+              ephemeris.m_pY,
+              ephemeris.m_pZ,
+              ephemeris.m_qX,
+              ephemeris.m_qY,
+              ephemeris.m_qZ);
+    ephemeris.m_epochMs.resize(bodyCount);
+    ephemeris.m_flags.resize(bodyCount);
+    ephemeris.m_parentIndex = graph.parentIndex;
+
+    for (int index = 0; index < bodyCount; ++index) {
+        ephemeris.setElements(index, hotBodies.at(index), coldBodies.at(index).orbit);
+    }
+
+    // Порядок «родитель раньше детей» по CSR-графу от корней. Тела, не достижимые
+    // из корней, считаются относительно начала координат.
+    ephemeris.m_parentFirstOrder.reserve(bodyCount);
+    QVector<bool> reached(bodyCount, false);
+    for (int index = 0; index < bodyCount; ++index) {
+        if (graph.parentIndex.at(index) >= 0) {
+            continue;
+        }
+        reached[index] = true;
+        ephemeris.m_parentFirstOrder.push_back(index);
+    }
+    for (int cursor = 0; cursor < ephemeris.m_parentFirstOrder.size(); ++cursor) {
+        const int parentIndex = ephemeris.m_parentFirstOrder.at(cursor);
+        for (const int* child = graph.childrenBegin(parentIndex); child != graph.childrenEnd(parentIndex); ++child) {
+            if (!reached.at(*child)) {
+                reached[*child] = true;
+                ephemeris.m_parentFirstOrder.push_back(*child);
+            }
+        }
+    }
+    for (int index = 0; index < bodyCount; ++index) {
+        if (!reached.at(index)) {
+            ephemeris.m_parentIndex[index] = -1;
+            ephemeris.m_parentFirstOrder.push_back(index);
+        }
+    }
+
+    return ephemeris;
+}
+
+void KeplerEphemeris::updateBody(const int index, const BodyHot& hot, const BodyCold& cold) {
+    setElements(index, hot, cold.orbit);
+}
+
+void KeplerEphemeris::setElements(const int index, const BodyHot& hot, const OrbitalElements& orbit) {
+    const double semiMajorAxisAu = qMax(0.0, hot.semiMajorAxisAu);
+    const double eccentricity = qBound(0.0, orbit.eccentricity, 0.999999);
+
+    m_semiMajorAxisAu[index] = semiMajorAxisAu;
+    m_eccentricity[index] = eccentricity;
+    m_semiMinorFactor[index] = std::sqrt(1.0 - eccentricity * eccentricity);
+    m_meanAnomalyAtEpoch[index] = qDegreesToRadians(orbit.meanAnomalyDeg);
+    m_epochMs[index] = orbit.meanAnomalyEpochMs;
+    m_revolutionsPerDay[index] = orbit.orbitalPeriodDays > 0.0 ? 1.0 / orbit.orbitalPeriodDays : 0.0;
+
+    // Перифокальный базис, повёрнутый на Ω, i, ω (Rz(Ω)·Rx(i)·Rz(ω)).
+    const double node = qDegreesToRadians(orbit.ascendingNodeDeg);
+    const double inclination = qDegreesToRadians(orbit.inclinationDeg);
+    const double periapsis = qDegreesToRadians(orbit.argOfPeriapsisDeg);
+    const double cosNode = std::cos(node);
+    const double sinNode = std::sin(node);
+    const double cosInclination = std::cos(inclination);
+    const double sinInclination = std::sin(inclination);
+    const double cosPeriapsis = std::cos(periapsis);
+    const double sinPeriapsis = std::sin(periapsis);
+    m_pX[index] = cosNode * cosPeriapsis - sinNode * sinPeriapsis * cosInclination;
+    m_pY[index] = sinNode * cosPeriapsis + cosNode * sinPeriapsis * cosInclination;
+    m_pZ[index] = sinPeriapsis * sinInclination;
+    m_qX[index] = -cosNode * sinPeriapsis - sinNode * cosPeriapsis * cosInclination;
+    m_qY[index] = -sinNode * sinPeriapsis + cosNode * cosPeriapsis * cosInclination;
+    m_qZ[index] = cosPeriapsis * sinInclination;
+
+    // Счётчик фаз учитывает прежние флаги тела: при обновлении оно могло фазу потерять.
+    if ((m_flags.at(index) & HasPhaseFlag) != 0) {
+        --m_phasedCount;
+    }
+    quint8 flags = 0;
+    if (semiMajorAxisAu > 0.0) {
+        flags |= HasOrbitFlag;
+        if (orbit.hasPhase()) {
+            flags |= HasPhaseFlag;
+            ++m_phasedCount;
+        }
+    }
+    m_flags[index] = flags;
+}
+
+int KeplerEphemeris::size() const {
+    return m_flags.size();
+}
+
+bool KeplerEphemeris::isEmpty() const {
+    return m_flags.isEmpty();
+}
+
+bool KeplerEphemeris::hasOrbit(const int index) const {
+    return (m_flags.at(index) & HasOrbitFlag) != 0;
+}
+
+bool KeplerEphemeris::hasPhase(const int index) const {
+    return (m_flags.at(index) & HasPhaseFlag) != 0;
+}
+
+double KeplerEphemeris::semiMajorAxisAu(const int index) const {
+    return m_semiMajorAxisAu.at(index);
+}
+
+double KeplerEphemeris::eccentricity(const int index) const {
+    return m_eccentricity.at(index);
+}
+
+OrbitEllipse KeplerEphemeris::orbitEllipse(const int index) const {
+    OrbitEllipse ellipse;
+    ellipse.majorX = m_pX.at(index);
+    ellipse.majorY = m_pY.at(index);
+    ellipse.majorZ = m_pZ.at(index);
+    ellipse.minorX = m_qX.at(index) * m_semiMinorFactor.at(index);
+    ellipse.minorY = m_qY.at(index) * m_semiMinorFactor.at(index);
+    ellipse.minorZ = m_qZ.at(index) * m_semiMinorFactor.at(index);
+    ellipse.eccentricity = m_eccentricity.at(index);
+    return ellipse;
+}
+
+int KeplerEphemeris::phasedCount() const {
+    return m_phasedCount;
+}
+
+const QVector<int>& KeplerEphemeris::parentFirstOrder() const {
+    return m_parentFirstOrder;
+}
+
+qint64 KeplerEphemeris::estimatedMemoryBytes() const {
+    const qint64 doubleArrays = 11;
+    return static_cast<qint64>(sizeof(KeplerEphemeris))
+         + static_cast<qint64>(m_flags.capacity())
+               * (doubleArrays * static_cast<qint64>(sizeof(double)) + static_cast<qint64>(sizeof(qint64))
+                  + static_cast<qint64>(sizeof(quint8)) + 2 * static_cast<qint64>(sizeof(int)));
+}
+
+void KeplerEphemeris::solve(const qint64 epochMs, EphemerisState& state) const {
+    const int bodyCount = size();
+    state.epochMs = epochMs;
+    resizeAll(bodyCount,
+              state.relativeX,
+              state.relativeY,
+              state.relativeZ,
+              state.x,
+              state.y,
+              state.z,
+              state.meanAnomaly,
+              state.eccentricAnomaly);
+
+    // Средняя аномалия через дробную часть числа оборотов: на коротких периодах
+    // и больших интервалах M не набирает тысячи радиан и не теряет точность.
+    const double* const meanAnomalyAtEpoch = m_meanAnomalyAtEpoch.constData();
+    const double* const revolutionsPerDay = m_revolutionsPerDay.constData();
+    const qint64* const bodyEpochMs = m_epochMs.constData();
+    double* const meanAnomaly = state.meanAnomaly.data();
+    for (int index = 0; index < bodyCount; ++index) {
+        const double revolutions = static_cast<double>(epochMs - bodyEpochMs[index]) / kMsPerDay * revolutionsPerDay[index];
+        const double anomaly = meanAnomalyAtEpoch[index] + 2.0 * M_PI * (revolutions - std::floor(revolutions));
+        meanAnomaly[index] = std::remainder(anomaly, 2.0 * M_PI);
+    }
+
+    solveEccentricAnomalies(meanAnomaly, m_eccentricity.constData(), state.eccentricAnomaly.data(), bodyCount);
+
+    // Положение в плоскости орбиты (a(cos E − e), b·sin E), повёрнутое базисом P, Q.
+    const double* const eccentricAnomaly = state.eccentricAnomaly.constData();
+    const double* const semiMajorAxisAu = m_semiMajorAxisAu.constData();
+    const double* const eccentricity = m_eccentricity.constData();
+    const double* const semiMinorFactor = m_semiMinorFactor.constData();
+    double* const relativeX = state.relativeX.data();
+    double* const relativeY = state.relativeY.data();
+    double* const relativeZ = state.relativeZ.data();
+    const double* const pX = m_pX.constData();
+    const double* const pY = m_pY.constData();
+    const double* const pZ = m_pZ.constData();
+    const double* const qX = m_qX.constData();
+    const double* const qY = m_qY.constData();
+    const double* const qZ = m_qZ.constData();
+    for (int index = 0; index < bodyCount; ++index) {
+        const double alongPeriapsis = semiMajorAxisAu[index] * (std::cos(eccentricAnomaly[index]) - eccentricity[index]);
+        const double alongMotion = semiMajorAxisAu[index] * semiMinorFactor[index] * std::sin(eccentricAnomaly[index]);
+        relativeX[index] = pX[index] * alongPeriapsis + qX[index] * alongMotion;
+        relativeY[index] = pY[index] * alongPeriapsis + qY[index] * alongMotion;
+        relativeZ[index] = pZ[index] * alongPeriapsis + qZ[index] * alongMotion;
+    }
+
+    for (const int index : m_parentFirstOrder) {
+        const int parentIndex = m_parentIndex.at(index);
+        const double parentX = parentIndex >= 0 ? state.x.at(parentIndex) : 0.0;
+        const double parentY = parentIndex >= 0 ? state.y.at(parentIndex) : 0.0;
+        const double parentZ = parentIndex >= 0 ? state.z.at(parentIndex) : 0.0;
+        state.x[index] = parentX + relativeX[index];
+        state.y[index] = parentY + relativeY[index];
+        state.z[index] = parentZ + relativeZ[index];
+    }
+}
+
+double KeplerEphemeris::revolutionsSinceEpoch(const int index, const qint64 epochMs) const {
+    return static_cast<double>(epochMs - m_epochMs.at(index)) / kMsPerDay * m_revolutionsPerDay.at(index);
+}
+
+void KeplerEphemeris::sampleRelative(const int index,
+                                     const double* const revolutions,
+                                     const int count,
+                                     double* const x,
+                                     double* const y,
+                                     double* const z) const {
+    QVector<double> meanAnomalies(count);
+    QVector<double> eccentricAnomalies(count);
+    const QVector<double> eccentricities(count, m_eccentricity.at(index));
+    const double meanAnomalyAtEpoch = m_meanAnomalyAtEpoch.at(index);
+    for (int sample = 0; sample < count; ++sample) {
+        const double fraction = revolutions[sample] - std::floor(revolutions[sample]);
+        meanAnomalies[sample] = std::remainder(meanAnomalyAtEpoch + 2.0 * M_PI * fraction, 2.0 * M_PI);
+    }
+
+    solveEccentricAnomalies(meanAnomalies.constData(), eccentricities.constData(), eccentricAnomalies.data(), count);
+
+    const double semiMajorAxisAu = m_semiMajorAxisAu.at(index);
+    const double eccentricity = m_eccentricity.at(index);
+    const double semiMinorAu = semiMajorAxisAu * m_semiMinorFactor.at(index);
+    for (int sample = 0; sample < count; ++sample) {
+        const double alongPeriapsis = semiMajorAxisAu * (std::cos(eccentricAnomalies.at(sample)) - eccentricity);
+        const double alongMotion = semiMinorAu * std::sin(eccentricAnomalies.at(sample));
+        x[sample] = m_pX.at(index) * alongPeriapsis + m_qX.at(index) * alongMotion;
+        y[sample] = m_pY.at(index) * alongPeriapsis + m_qY.at(index) * alongMotion;
+        z[sample] = m_pZ.at(index) * alongPeriapsis + m_qZ.at(index) * alongMotion;
+    }
+}
+
+void KeplerEphemeris::solveEccentricAnomalies(const double* const meanAnomalies,
+                                              const double* const eccentricities,
+                                              double* const eccentricAnomalies,
+                                              const int count) {
+    // Начальное приближение Данби E₀ = M + 0.85·e·sign(M): с ним Ньютон сходится при любом e < 1.
+    for (int index = 0; index < count; ++index) {
+        const double sign = meanAnomalies[index] < 0.0 ? -1.0 : 1.0;
+        eccentricAnomalies[index] = meanAnomalies[index] + 0.85 * eccentricities[index] * sign;
+    }
+
+    // Каждый проход — одна итерация для всех тел: внутренний цикл без ветвлений векторизуется,
+    // а проверка сходимости одна на проход. Почти круговые орбиты сходятся за 3–4 прохода.
+    for (int iteration = 0; iteration < kMaxNewtonIterations; ++iteration) {
+        double maxCorrection = 0.0;
+        for (int index = 0; index < count; ++index) {
+            const double anomaly = eccentricAnomalies[index];
+            const double eccentricity = eccentricities[index];
+            const double residual = anomaly - eccentricity * std::sin(anomaly) - meanAnomalies[index];
+            const double correction = residual / (1.0 - eccentricity * std::cos(anomaly));
+            eccentricAnomalies[index] = anomaly - correction;
+            maxCorrection = std::max(maxCorrection, std::abs(correction));
+        }
+        if (maxCorrection < kEccentricAnomalyTolerance) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QVector>
+#include <QtGlobal>
+
+#include "BodyGraph.h"
+#include "BodyRecords.h"
+
+// Положения тел системы на один момент по индексам BodyGraph, в а.е. Плоскость XY —
+// опорная плоскость орбит (наклонение отсчитывается от неё), Z — высота над ней.
+struct EphemerisState {
+    qint64 epochMs = 0;
+    // Смещение от родителя.
+    QVector<double> relativeX;
+    QVector<double> relativeY;
+    QVector<double> relativeZ;
+    // Положение относительно корня своей иерархии.
+    QVector<double> x;
+    QVector<double> y;
+    QVector<double> z;
+    // Рабочие массивы решателя: средняя и эксцентрическая аномалии, рад.
+    QVector<double> meanAnomaly;
+    QVector<double> eccentricAnomaly;
+};
+
+// Эллипс орбиты в опорных осях, в долях большой полуоси: точка с эксцентрической аномалией E
+// смещена от родителя (он в фокусе) на major·(cos E − eccentricity) + minor·sin E. Плоская
+// схема берёт только X и Y — проекцию на опорную плоскость.
+struct OrbitEllipse {
+    double majorX = 1.0;
+    double majorY = 0.0;
+    double majorZ = 0.0;
+    double minorX = 0.0;
+    double minorY = 1.0;
+    double minorZ = 0.0;
+    double eccentricity = 0.0;
+};
+
+// Эфемериды системы по кеплеровым элементам. Константы орбит при построении раскладываются
+// в плотные массивы (structure of arrays): полуось, эксцентриситет, обратный период, базис
+// плоскости орбиты. solve() затем проходит по ним короткими циклами без ветвлений и вызовов
+// через границу тела — компилятор векторизует их, и пересчёт всех тел крупной системы
+// укладывается в кадр.
+class KeplerEphemeris {
+public:
+    static KeplerEphemeris build(const BodyGraph& graph,
+                                 const QVector<BodyHot>& hotBodies,
+                                 const QVector<BodyCold>& coldBodies);
+
+    // Пересчитывает элементы орбиты тела index на месте; родитель тела прежний.
+    void updateBody(int index, const BodyHot& hot, const BodyCold& cold);
+
+    int size() const;
+    bool isEmpty() const;
+    // Известна полуось: тело смещено от родителя.
+    bool hasOrbit(int index) const;
+    // Известны период и момент средней аномалии: фаза на орбите настоящая, а не условная.
+    bool hasPhase(int index) const;
+    double semiMajorAxisAu(int index) const;
+    double eccentricity(int index) const;
+    OrbitEllipse orbitEllipse(int index) const;
+    int phasedCount() const;
+    qint64 estimatedMemoryBytes() const;
+    // Индексы тел так, что родитель всегда раньше детей.
+    const QVector<int>& parentFirstOrder() const;
+
+    // Положения всех тел на момент epochMs (мс от эпохи Unix, UTC). Массивы state
+    // переиспользуются: повторный вызов для той же системы память не выделяет.
+    void solve(qint64 epochMs, EphemerisState& state) const;
+
+    // Оборотов тела index от момента его средней аномалии до epochMs; 0, если период неизвестен.
+    double revolutionsSinceEpoch(int index, qint64 epochMs) const;
+    // Смещения тела index от родителя в count точках орбиты, заданных числом оборотов от
+    // момента средней аномалии. Движение по кеплеровой орбите периодично, поэтому точек
+    // одного оборота хватает на любой момент.
+    void sampleRelative(int index, const double* revolutions, int count, double* x, double* y, double* z) const;
+
+    // E − e·sin E = M для count тел: Ньютон от начального приближения Данби, проходы по всему
+    // массиву до сходимости самого медленного тела. meanAnomalies — в [−π, π].
+    static void solveEccentricAnomalies(const double* meanAnomalies,
+                                        const double* eccentricities,
+                                        double* eccentricAnomalies,
+                                        int count);
+
+private:
+    enum OrbitFlag : quint8 {
+        HasOrbitFlag = 1 << 0,
+        HasPhaseFlag = 1 << 1
+    };
+
+    void setElements(int index, const BodyHot& hot, const OrbitalElements& orbit);
+
+    QVector<double> m_semiMajorAxisAu;
+    QVector<double> m_eccentricity;
+    // sqrt(1 − e²): малая полуось в долях большой.
+    QVector<double> m_semiMinorFactor;
+    // Средняя аномалия в момент m_epochMs, рад.
+    QVector<double> m_meanAnomalyAtEpoch;
+    QVector<qint64> m_epochMs;
+    // Оборотов в сутки; 0 — период неизвестен, тело неподвижно на орбите.
+    QVector<double> m_revolutionsPerDay;
+    // Базис плоскости орбиты в опорных осях: P — к перицентру, Q — на 90° по движению.
+    QVector<double> m_pX;
+    QVector<double> m_pY;
+    QVector<double> m_pZ;
+    QVector<double> m_qX;
+    QVector<double> m_qY;
+    QVector<double> m_qZ;
+    QVector<quint8> m_flags;
+    QVector<int> m_parentIndex;
+    // Родители раньше детей: в этом порядке складываются абсолютные положения.
+    QVector<int> m_parentFirstOrder;
+    int m_phasedCount = 0;
+};
@@ -0,0 +1,134 @@
+#include "LabelPlacement.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Места подписи вокруг значка: справа сверху (основное), справа под ним, слева сверху, слева под ним.
+constexpr int kCandidateCount = 4;
+// Отступы подписи от края значка, пикселей.
+constexpr double kGapXPx = 8.0;
+constexpr double kGapYPx = 6.0;
+
+QRectF candidateRect(const LabelPlacement::Request& request, const int candidate) {
+    const double clearance = request.clearancePx;
+    const bool right = candidate == 0 || candidate == 1;
+    const bool top = candidate == 0 || candidate == 2;
+    const double left = right ? request.anchor.x() + clearance + kGapXPx
+                              : request.anchor.x() - clearance - kGapXPx - request.size.width();
+    const double y = request.anchor.y() - clearance - kGapYPx + (top ? 0.0 : request.size.height());
+    return QRectF(QPointF(left, y), request.size);
+}
+
+} // namespace
+
+LabelPlacement::LabelPlacement(const double cellSizePx)
+    : m_cellSizePx(cellSizePx > 0.0 ? cellSizePx : 64.0) {
+}
+
+void LabelPlacement::place(const QVector<Request>& requests, const QRectF& viewport, QVector<QRectF>& placedRects) {
+    const int count = requests.size();
+    placedRects.fill(QRectF(), count);
+    m_rects.clear();
+    m_placedCount = 0;
+    m_droppedCount = 0;
+    resetBuckets(count);
+
+    m_order.resize(count);
+    for (int index = 0; index < count; ++index) {
+        m_order[index] = index;
+    }
+    std::stable_sort(m_order.begin(), m_order.end(), [&requests](const int left, const int right) {
+        return requests.at(left).priority > requests.at(right).priority;
+    });
+
+    for (const int index : m_order) {
+        const Request& request = requests.at(index);
+        if (request.size.isEmpty()) {
+            continue;
+        }
+        bool visible = false;
+        for (int candidate = 0; candidate < kCandidateCount; ++candidate) {
+            const QRectF rect = candidateRect(request, candidate);
+            if (!rect.intersects(viewport)) {
+                continue;
+            }
+            visible = true;
+            if (!collides(rect)) {
+                placedRects[index] = rect;
+                insert(rect);
+                ++m_placedCount;
+                break;
+            }
+        }
+        // Подпись, которой нет в окне ни на одном месте, не считается выброшенной.
+        if (visible && placedRects.at(index).isNull()) {
+            ++m_droppedCount;
+        }
+    }
+}
+
+int LabelPlacement::placedCount() const {
+    return m_placedCount;
+}
+
+int LabelPlacement::droppedCount() const {
+    return m_droppedCount;
+}
+
+void LabelPlacement::resetBuckets(const int expectedRects) {
+    // Степень двойки не меньше удвоенного числа подписей: цепочки остаются короткими.
+    int bucketCount = 64;
+    while (bucketCount < 2 * expectedRects) {
+        bucketCount *= 2;
+    }
+    m_bucketHeads.fill(-1, bucketCount);
+    m_entryRect.clear();
+    m_entryNext.clear();
+}
+
+int LabelPlacement::cellCoordinate(const double value) const {
+    return static_cast<int>(std::floor(value / m_cellSizePx));
+}
+
+int LabelPlacement::bucketFor(const int cellX, const int cellY) const {
+    const quint32 hash = static_cast<quint32>(cellX) * 73856093u ^ static_cast<quint32>(cellY) * 19349663u;
+    return static_cast<int>(hash & static_cast<quint32>(m_bucketHeads.size() - 1));
+}
+
+bool LabelPlacement::collides(const QRectF& rect) const {
+    const int firstX = cellCoordinate(rect.left());
+    const int firstY = cellCoordinate(rect.top());
+    const int lastX = cellCoordinate(rect.right());
+    const int lastY = cellCoordinate(rect.bottom());
+    for (int cellY = firstY; cellY <= lastY; ++cellY) {
+        for (int cellX = firstX; cellX <= lastX; ++cellX) {
+            for (int entry = m_bucketHeads.at(bucketFor(cellX, cellY)); entry >= 0; entry = m_entryNext.at(entry)) {
+                if (m_rects.at(m_entryRect.at(entry)).intersects(rect)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void LabelPlacement::insert(const QRectF& rect) {
+    const int rectIndex = m_rects.size();
+    m_rects.push_back(rect);
+    const int firstX = cellCoordinate(rect.left());
+    const int firstY = cellCoordinate(rect.top());
+    const int lastX = cellCoordinate(rect.right());
+    const int lastY = cellCoordinate(rect.bottom());
+    for (int cellY = firstY; cellY <= lastY; ++cellY) {
+        for (int cellX = firstX; cellX <= lastX; ++cellX) {
+            const int bucket = bucketFor(cellX, cellY);
+            m_entryRect.push_back(rectIndex);
+            m_entryNext.push_back(m_bucketHeads.at(bucket));
+            m_bucketHeads[bucket] = m_entryRect.size() - 1;
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+#include <QVector>
+
+// Расстановка подписей тел без наложений. Подписи ставятся по убыванию приоритета; каждая
+// пробует несколько мест вокруг своего тела и занимает первое свободное, а не поместившаяся
+// нигде не рисуется. Занятые прямоугольники лежат в пространственном хэше по ячейкам сетки,
+// так что проверка подписи смотрит только на соседей по ячейкам, а не на все подписи кадра.
+// Буферы переиспользуются между кадрами.
+class LabelPlacement {
+public:
+    struct Request {
+        // Центр значка тела и его радиус в пикселях окна.
+        QPointF anchor;
+        double clearancePx = 0.0;
+        QSizeF size;
+        // Больший приоритет ставится раньше; при равном — в порядке запросов.
+        int priority = 0;
+    };
+
+    explicit LabelPlacement(double cellSizePx = 64.0);
+
+    // placedRects[i] — прямоугольник подписи i в пикселях окна; пустой, если подпись
+    // ни на одном месте не помещается или лежит вне viewport.
+    void place(const QVector<Request>& requests, const QRectF& viewport, QVector<QRectF>& placedRects);
+
+    int placedCount() const;
+    int droppedCount() const;
+
+private:
+    void resetBuckets(int expectedRects);
+    bool collides(const QRectF& rect) const;
+    void insert(const QRectF& rect);
+    int bucketFor(int cellX, int cellY) const;
+    int cellCoordinate(double value) const;
+
+    double m_cellSizePx = 64.0;
+    // Хэш ячеек: голова цепочки на корзину и записи «прямоугольник — следующая запись».
+    QVector<int> m_bucketHeads;
+    QVector<int> m_entryRect;
+    QVector<int> m_entryNext;
+    QVector<QRectF> m_rects;
+    QVector<int> m_order;
+    int m_placedCount = 0;
+    int m_droppedCount = 0;
+};
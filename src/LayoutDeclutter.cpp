@@ -0,0 +1,312 @@
+#include "LayoutDeclutter.h"
+
+#include <QElapsedTimer>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Зазор, который держится между кругами элементов, пикселей.
+constexpr double kPaddingPx = 2.0;
+// Доля перекрытия пары, на которую элемент отодвигается за итерацию, и жёсткость пружины
+// к якорю: у двух одинаковых элементов на одном якоре перекрытие остаётся в пределах зазора.
+constexpr double kRepulsion = 0.35;
+constexpr double kAnchorStiffness = 0.05;
+// Шаг элемента за итерацию ограничен, иначе плотный сгусток разлетается за один шаг.
+constexpr double kMaxStepPx = 4.0;
+// Узел дерева действует как один элемент, когда его сторона меньше kTheta расстояния до него.
+constexpr double kTheta = 0.5;
+// Раскладка сошлась, когда за итерацию никто не сдвинулся на заметную долю пикселя.
+constexpr double kConvergedStepPx = 0.2;
+// Совпадающие элементы дерево не различит на любой глубине: на предельной они копятся в листе.
+constexpr int kMaxTreeDepth = 20;
+// Раскладка, которая так и не успокоилась (элементы зажаты между соседями и пружиной),
+// после стольких итераций с одними якорями считается готовой.
+constexpr int kMaxIterations = 400;
+// Направление расталкивания совпадающих элементов — по ключу через золотой угол, чтобы
+// сгусток раскрывался веером, а не в одну сторону.
+constexpr double kGoldenAngleRad = 2.39996322972865332;
+
+} // namespace
+
+void LayoutDeclutter::setItems(const QVector<Item>& items) {
+    const int count = items.size();
+    bool unchanged = count == m_keys.size();
+    m_keys.resize(count);
+    m_anchorX.resize(count);
+    m_anchorY.resize(count);
+    m_x.resize(count);
+    m_y.resize(count);
+    m_radius.resize(count);
+    m_maxOffset.resize(count);
+    for (int index = 0; index < count; ++index) {
+        const Item& item = items.at(index);
+        unchanged = unchanged && m_keys.at(index) == item.key && m_anchorX.at(index) == item.anchor.x()
+            && m_anchorY.at(index) == item.anchor.y() && m_radius.at(index) == item.radius
+            && m_maxOffset.at(index) == item.maxOffset;
+        if (unchanged) {
+            continue;
+        }
+        const QPointF previousOffset = m_offsetsByKey.value(item.key);
+        m_keys[index] = item.key;
+        m_anchorX[index] = item.anchor.x();
+        m_anchorY[index] = item.anchor.y();
+        m_x[index] = item.anchor.x() + previousOffset.x();
+        m_y[index] = item.anchor.y() + previousOffset.y();
+        m_radius[index] = item.radius;
+        m_maxOffset[index] = item.maxOffset;
+    }
+    if (!unchanged) {
+        m_converged = false;
+        m_totalIterations = 0;
+    }
+}
+
+bool LayoutDeclutter::relax(const qint64 budgetNs) {
+    if (m_converged) {
+        m_lastIterationCount = 0;
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int iterations = 0;
+    do {
+        iterate();
+        ++iterations;
+        if (m_lastMaxStep < kConvergedStepPx) {
+            m_converged = true;
+        }
+    } while (!m_converged && timer.nsecsElapsed() < budgetNs);
+
+    // Общий счётчик копится по кадрам с одними якорями и обнуляется в setItems() при их смене.
+    m_lastIterationCount = iterations;
+    m_totalIterations += iterations;
+    if (m_totalIterations >= kMaxIterations) {
+        m_converged = true;
+    }
+
+    m_offsetsByKey.clear();
+    m_offsetsByKey.reserve(m_keys.size());
+    for (int index = 0; index < m_keys.size(); ++index) {
+        m_offsetsByKey.insert(m_keys.at(index), offset(index));
+    }
+    return m_converged;
+}
+
+void LayoutDeclutter::buildTree() {
+    m_nodes.clear();
+    const int count = m_x.size();
+    double minX = m_x.at(0);
+    double maxX = minX;
+    double minY = m_y.at(0);
+    double maxY = minY;
+    for (int index = 1; index < count; ++index) {
+        minX = qMin(minX, m_x.at(index));
+        maxX = qMax(maxX, m_x.at(index));
+        minY = qMin(minY, m_y.at(index));
+        maxY = qMax(maxY, m_y.at(index));
+    }
+
+    Node root;
+    root.centerX = 0.5 * (minX + maxX);
+    root.centerY = 0.5 * (minY + maxY);
+    root.halfSize = 0.5 * qMax(qMax(maxX - minX, maxY - minY), 1.0);
+    m_nodes.push_back(root);
+    for (int index = 0; index < count; ++index) {
+        insert(index);
+    }
+}
+
+void LayoutDeclutter::insert(const int item) {
+    const double x = m_x.at(item);
+    const double y = m_y.at(item);
+    int nodeIndex = 0;
+    for (int depth = 0;; ++depth) {
+        Node& node = m_nodes[nodeIndex];
+        ++node.count;
+        node.sumX += x;
+        node.sumY += y;
+        node.maxRadius = qMax(node.maxRadius, m_radius.at(item));
+        if (node.firstChild < 0) {
+            if (node.count == 1) {
+                node.item = item;
+                return;
+            }
+            if (depth >= kMaxTreeDepth) {
+                return;
+            }
+
+            // Лист делится: прежний элемент уходит в своего потомка, новый спускается дальше.
+            const int existing = node.item;
+            const double childHalf = 0.5 * node.halfSize;
+            const double centerX = node.centerX;
+            const double centerY = node.centerY;
+            node.item = -1;
+            node.firstChild = m_nodes.size();
+            for (int quadrant = 0; quadrant < 4; ++quadrant) {
+                Node child;
+                child.halfSize = childHalf;
+                child.centerX = centerX + ((quadrant & 1) ? childHalf : -childHalf);
+                child.centerY = centerY + ((quadrant & 2) ? childHalf : -childHalf);
+                m_nodes.push_back(child);
+            }
+            const int firstChild = m_nodes.at(nodeIndex).firstChild;
+            Node& existingChild = m_nodes[firstChild + (m_x.at(existing) >= centerX ? 1 : 0)
+                                          + (m_y.at(existing) >= centerY ? 2 : 0)];
+            existingChild.count = 1;
+            existingChild.sumX = m_x.at(existing);
+            existingChild.sumY = m_y.at(existing);
+            existingChild.maxRadius = m_radius.at(existing);
+            existingChild.item = existing;
+        }
+
+        const Node& parent = m_nodes.at(nodeIndex);
+        nodeIndex = parent.firstChild + (x >= parent.centerX ? 1 : 0) + (y >= parent.centerY ? 2 : 0);
+    }
+}
+
+void LayoutDeclutter::iterate() {
+    const int count = m_x.size();
+    m_forceX.fill(0.0, count);
+    m_forceY.fill(0.0, count);
+    if (count > 1) {
+        buildTree();
+    }
+
+    for (int index = 0; count > 1 && index < count; ++index) {
+        const double x = m_x.at(index);
+        const double y = m_y.at(index);
+        const double radius = m_radius.at(index);
+        double forceX = 0.0;
+        double forceY = 0.0;
+        int overlapCount = 0;
+        m_stack.clear();
+        m_stack.push_back(0);
+        while (!m_stack.isEmpty()) {
+            const Node& node = m_nodes.at(m_stack.takeLast());
+            if (node.count == 0 || (node.count == 1 && node.item == index)) {
+                continue;
+            }
+            // Узел, весь лежащий дальше радиуса взаимодействия, пропускается целиком.
+            const double range = radius + node.maxRadius + kPaddingPx;
+            const double outsideX = qMax(0.0, std::abs(x - node.centerX) - node.halfSize);
+            const double outsideY = qMax(0.0, std::abs(y - node.centerY) - node.halfSize);
+            if (outsideX * outsideX + outsideY * outsideY >= range * range) {
+                continue;
+            }
+
+            int nodeCount = node.count;
+            double sumX = node.sumX;
+            double sumY = node.sumY;
+            if (node.firstChild < 0) {
+                // Лист на предельной глубине может содержать сам элемент.
+                if (outsideX == 0.0 && outsideY == 0.0 && nodeCount > 1) {
+                    --nodeCount;
+                    sumX -= x;
+                    sumY -= y;
+                }
+            } else {
+                const double comX = x - sumX / nodeCount;
+                const double comY = y - sumY / nodeCount;
+                if (4.0 * node.halfSize * node.halfSize >= kTheta * kTheta * (comX * comX + comY * comY)) {
+                    for (int quadrant = 0; quadrant < 4; ++quadrant) {
+                        m_stack.push_back(node.firstChild + quadrant);
+                    }
+                    continue;
+                }
+            }
+
+            const double dx = x - sumX / nodeCount;
+            const double dy = y - sumY / nodeCount;
+            const double distanceSquared = dx * dx + dy * dy;
+            if (distanceSquared >= range * range) {
+                continue;
+            }
+            const double distance = std::sqrt(distanceSquared);
+            const double push = kRepulsion * nodeCount * (range - distance);
+            overlapCount += nodeCount;
+            if (distance > 1e-6) {
+                forceX += push * dx / distance;
+                forceY += push * dy / distance;
+            } else {
+                const double angle = kGoldenAngleRad * m_keys.at(index);
+                forceX += push * std::cos(angle);
+                forceY += push * std::sin(angle);
+            }
+        }
+        // Толчки соседей ослабляются корнем из их числа: простая сумма раскачивает плотную кучу
+        // с каждой итерацией сильнее.
+        const double damping = overlapCount > 1 ? 1.0 / std::sqrt(static_cast<double>(overlapCount)) : 1.0;
+        m_forceX[index] = forceX * damping;
+        m_forceY[index] = forceY * damping;
+    }
+
+    m_lastMaxStep = 0.0;
+    for (int index = 0; index < count; ++index) {
+        double stepX = m_forceX.at(index) - kAnchorStiffness * (m_x.at(index) - m_anchorX.at(index));
+        double stepY = m_forceY.at(index) - kAnchorStiffness * (m_y.at(index) - m_anchorY.at(index));
+        const double step = std::hypot(stepX, stepY);
+        if (step > kMaxStepPx) {
+            stepX *= kMaxStepPx / step;
+            stepY *= kMaxStepPx / step;
+        }
+
+        double offsetX = m_x.at(index) + stepX - m_anchorX.at(index);
+        double offsetY = m_y.at(index) + stepY - m_anchorY.at(index);
+        const double offsetLength = std::hypot(offsetX, offsetY);
+        const double maxOffset = m_maxOffset.at(index);
+        if (offsetLength > maxOffset) {
+            const double factor = maxOffset > 0.0 ? maxOffset / offsetLength : 0.0;
+            offsetX *= factor;
+            offsetY *= factor;
+        }
+
+        const double newX = m_anchorX.at(index) + offsetX;
+        const double newY = m_anchorY.at(index) + offsetY;
+        m_lastMaxStep = qMax(m_lastMaxStep, std::hypot(newX - m_x.at(index), newY - m_y.at(index)));
+        m_x[index] = newX;
+        m_y[index] = newY;
+    }
+}
+
+int LayoutDeclutter::itemCount() const {
+    return m_keys.size();
+}
+
+QPointF LayoutDeclutter::position(const int item) const {
+    return QPointF(m_x.at(item), m_y.at(item));
+}
+
+QPointF LayoutDeclutter::offset(const int item) const {
+    return QPointF(m_x.at(item) - m_anchorX.at(item), m_y.at(item) - m_anchorY.at(item));
+}
+
+QPointF LayoutDeclutter::offsetForKey(const int key) const {
+    return m_offsetsByKey.value(key);
+}
+
+bool LayoutDeclutter::isConverged() const {
+    return m_converged;
+}
+
+int LayoutDeclutter::lastIterationCount() const {
+    return m_lastIterationCount;
+}
+
+void LayoutDeclutter::clear() {
+    m_keys.clear();
+    m_anchorX.clear();
+    m_anchorY.clear();
+    m_x.clear();
+    m_y.clear();
+    m_radius.clear();
+    m_maxOffset.clear();
+    m_nodes.clear();
+    m_offsetsByKey.clear();
+    m_converged = true;
+    m_lastIterationCount = 0;
+    m_totalIterations = 0;
+}
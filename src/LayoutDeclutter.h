@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QHash>
+#include <QPointF>
+#include <QVector>
+
+// Необязательное разведение перекрытий на схеме: значки тел и подписи, налезающие друг на
+// друга, расталкиваются силовой моделью, а пружина держит каждый элемент у его якоря —
+// места, где он стоит по орбите. Отталкивание считается по квадродереву Барнса — Хата:
+// далёкий сгусток элементов действует как один, поэтому итерация стоит O(n log n).
+// Решатель работает в экранных пикселях и инкрементально: смещения переживают кадр по
+// ключам элементов, а relax() останавливается по бюджету времени и продолжает в следующем
+// кадре, так что кадр он не задерживает.
+class LayoutDeclutter {
+public:
+    struct Item {
+        // Ключ элемента между кадрами: по нему восстанавливается смещение прошлого кадра.
+        int key = -1;
+        QPointF anchor;
+        // Радиус круга, которым элемент представлен в расталкивании, пикселей.
+        double radius = 0.0;
+        // Дальше этого элемент от якоря не уводится.
+        double maxOffset = 0.0;
+    };
+
+    // Элементы нового кадра. Элементы с ключами прошлого кадра начинают со своих прежних
+    // смещений от якоря, новые — с якоря.
+    void setItems(const QVector<Item>& items);
+    // Итерации до сходимости или пока не истечёт budgetNs наносекунд. true — раскладка
+    // сошлась и следующие кадры с теми же якорями ничего не считают.
+    bool relax(qint64 budgetNs);
+
+    int itemCount() const;
+    // Положение элемента item в порядке последнего setItems().
+    QPointF position(int item) const;
+    QPointF offset(int item) const;
+    // Смещение элемента по ключу на конец последнего relax(); для отсутствующих — нулевое.
+    QPointF offsetForKey(int key) const;
+    bool isConverged() const;
+    // Итерации, сделанные последним relax().
+    int lastIterationCount() const;
+    void clear();
+
+private:
+    struct Node {
+        double centerX = 0.0;
+        double centerY = 0.0;
+        double halfSize = 0.0;
+        // Сумма по элементам узла: число, центр масс и наибольший радиус.
+        int count = 0;
+        double sumX = 0.0;
+        double sumY = 0.0;
+        double maxRadius = 0.0;
+        // Первый из четырёх потомков подряд в m_nodes; -1 — лист.
+        int firstChild = -1;
+        // Элемент листа; в листе на предельной глубине элементов может быть несколько.
+        int item = -1;
+    };
+
+    void buildTree();
+    void insert(int item);
+    void iterate();
+
+    QVector<int> m_keys;
+    QVector<double> m_anchorX;
+    QVector<double> m_anchorY;
+    QVector<double> m_x;
+    QVector<double> m_y;
+    QVector<double> m_radius;
+    QVector<double> m_maxOffset;
+    QVector<double> m_forceX;
+    QVector<double> m_forceY;
+    QVector<Node> m_nodes;
+    QVector<int> m_stack;
+    QHash<int, QPointF> m_offsetsByKey;
+    double m_lastMaxStep = 0.0;
+    bool m_converged = true;
+    int m_lastIterationCount = 0;
+    int m_totalIterations = 0;
+};
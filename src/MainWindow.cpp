@@ -1,8 +1,12 @@
 #include "MainWindow.h"
 
+#include <QCheckBox>
 #include <QCloseEvent>
 #include <QComboBox>
 #include <QDebug>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QHBoxLayout>
@@ -12,13 +16,17 @@
 #include <QPushButton>
 #include <QSizePolicy>
 #include <QSettings>
+#include <QSpinBox>
 #include <QSplitter>
 #include <QVBoxLayout>
 #include <QWidget>
 
+#include "ArchitectureWindow.h"
 #include "BodyDetailsWidget.h"
-#include "SystemModelBuilder.h"
+#include "CorpusStatisticsWindow.h"
+#include "CorpusWindow.h"
 #include "SystemIdsWindow.h"
+#include "SystemOrbit3DWidget.h"
 #include "SystemSceneWidget.h"
 
 namespace {
@@ -26,6 +34,9 @@ namespace {
 constexpr auto kSettingsGroupUi = "MainWindow";
 constexpr auto kSettingsSplitterState = "contentSplitterState";
 constexpr auto kSettingsDetailsVisible = "detailsVisible";
+constexpr auto kSettingsCacheBudgetMb = "systemCacheBudgetMb";
+constexpr auto kSettingsOrbit3DVisible = "orbit3DVisible";
+constexpr int kDefaultCacheBudgetMb = static_cast<int>(SystemSnapshotStore::kDefaultMemoryBudgetBytes / (1024 * 1024));
 
 QString dataSourceTitle(const SystemDataSource source) {
     switch (source) {
@@ -42,12 +53,24 @@ QString dataSourceTitle(const SystemDataSource source) {
     return QStringLiteral("Unknown");
 }
 
+void logCacheEviction(const int evictedCount, const SystemSnapshotStore& store) {
+    if (evictedCount > 0) {
+        qDebug().noquote() << QStringLiteral("[CACHE] Вытеснено систем: %1, занято %2 из %3 КиБ.")
+                                  .arg(evictedCount)
+                                  .arg(store.memoryUsageBytes() / 1024)
+                                  .arg(store.memoryBudgetBytes() / 1024);
+    }
+}
+
 } // namespace
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent) {
     setupUi();
     m_systemIdsWindow = new SystemIdsWindow(this);
+    m_corpusWindow = new CorpusWindow(&m_corpusDatabase, this);
+    m_architectureWindow = new ArchitectureWindow(&m_corpusDatabase, this);
+    m_statisticsWindow = new CorpusStatisticsWindow(&m_corpusDatabase, this);
 
     connect(m_bodySizeModeCombo, qOverload<int>(&QComboBox::currentIndexChanged), this, [this](const int index) {
         const auto mode = index == 1
@@ -64,29 +87,71 @@ MainWindow::MainWindow(QWidget* parent)
     });
 
     connect(&m_apiClient, &EdsmApiClient::systemBodiesReady, this, [this](const SystemBodiesResult& result) {
-        m_currentBodies = SystemModelBuilder::buildBodyMap(result.bodies);
-        const auto roots = SystemModelBuilder::findRootBodies(m_currentBodies);
+        // Снимок собирается один раз и дальше раздаётся всем виджетам без копирования тел.
+        const SystemSnapshot snapshot = SystemSnapshot::build(result.systemName, result.bodies);
+        storeInCorpus(snapshot, result);
+        logCacheEviction(m_snapshotStore.insert(snapshot), m_snapshotStore);
+        m_snapshotStore.visit(snapshot.systemName());
+
+        showSnapshot(snapshot,
+                     QStringLiteral("Источник: %1. Загружено тел: %2")
+                         .arg(dataSourceTitle(result.selectedSource))
+                         .arg(snapshot.realBodyCount()));
+        updateNavigationButtons();
+    });
 
-        m_sceneWidget->setSystemData(result.systemName, m_currentBodies, roots);
+    connect(m_backButton, &QPushButton::clicked, this, [this]() {
+        navigateToHistoryEntry(m_snapshotStore.goBack());
+    });
 
-        int realBodiesCount = 0;
-        for (auto it = m_currentBodies.constBegin(); it != m_currentBodies.constEnd(); ++it) {
-            if (!isVirtualBarycenterRoot(it.value())) {
-                ++realBodiesCount;
-            }
-        }
+    connect(m_forwardButton, &QPushButton::clicked, this, [this]() {
+        navigateToHistoryEntry(m_snapshotStore.goForward());
+    });
 
-        QString status = QStringLiteral("Источник: %1. Загружено тел: %2")
-                             .arg(dataSourceTitle(result.selectedSource))
-                             .arg(realBodiesCount);
+    connect(m_importButton, &QPushButton::clicked, this, [this]() {
+        importSystemFiles();
+    });
 
+    connect(m_corpusButton, &QPushButton::clicked, this, [this]() {
+        m_corpusWindow->show();
+        m_corpusWindow->raise();
+        m_corpusWindow->activateWindow();
+    });
 
-        m_statusLabel->setText(status);
-        m_systemIdsWindow->setBodies(m_currentBodies);
+    connect(m_architectureButton, &QPushButton::clicked, this, [this]() {
+        m_architectureWindow->setSnapshot(m_currentSnapshot);
+        m_architectureWindow->show();
+        m_architectureWindow->raise();
+        m_architectureWindow->activateWindow();
+    });
+
+    connect(m_statisticsButton, &QPushButton::clicked, this, [this]() {
+        m_statisticsWindow->reload();
+        m_statisticsWindow->show();
+        m_statisticsWindow->raise();
+        m_statisticsWindow->activateWindow();
+    });
+
+    const auto openSystem = [this](const QString& systemName) {
+        m_systemNameEdit->setText(systemName);
+        m_statusLabel->setText(QStringLiteral("Загрузка данных только из EDAstro..."));
+        m_apiClient.requestSystemBodies(systemName, SystemRequestMode::EdastroOnly);
+    };
+    connect(m_corpusWindow, &CorpusWindow::systemActivated, this, openSystem);
+    connect(m_architectureWindow, &ArchitectureWindow::systemActivated, this, openSystem);
+
+    connect(m_cacheBudgetSpin, qOverload<int>(&QSpinBox::valueChanged), this, [this](const int budgetMb) {
+        logCacheEviction(m_snapshotStore.setMemoryBudgetBytes(static_cast<qint64>(budgetMb) * 1024 * 1024),
+                         m_snapshotStore);
+
+        QSettings settings;
+        settings.beginGroup(QLatin1String(kSettingsGroupUi));
+        settings.setValue(QLatin1String(kSettingsCacheBudgetMb), budgetMb);
+        settings.endGroup();
     });
 
     connect(m_showIdsButton, &QPushButton::clicked, this, [this]() {
-        m_systemIdsWindow->setBodies(m_currentBodies);
+        m_systemIdsWindow->setSnapshot(m_currentSnapshot);
         m_systemIdsWindow->show();
         m_systemIdsWindow->raise();
         m_systemIdsWindow->activateWindow();
@@ -100,8 +165,9 @@ MainWindow::MainWindow(QWidget* parent)
         m_statusLabel->setText(state);
     });
 
-    connect(m_sceneWidget, &SystemSceneWidget::bodyClicked, this, [this](const int bodyId) {
-        if (!m_currentBodies.contains(bodyId)) {
+    const auto showBodyDetails = [this](const int bodyId) {
+        const auto body = m_currentSnapshot.body(bodyId);
+        if (!body) {
             setBodyDetailsPlaceholder(QStringLiteral("Тело не найдено в текущих данных."));
             return;
         }
@@ -110,7 +176,21 @@ MainWindow::MainWindow(QWidget* parent)
             setDetailsPanelVisible(true);
         }
 
-        m_bodyDetailsPanel->setBody(m_currentBodies.value(bodyId), m_currentBodies);
+        m_bodyDetailsPanel->setBody(*body, m_currentSnapshot);
+    };
+    connect(m_sceneWidget, &SystemSceneWidget::bodyClicked, this, showBodyDetails);
+    connect(m_orbit3DWidget, &SystemOrbit3DWidget::bodyClicked, this, showBodyDetails);
+    connect(m_sceneWidget, &SystemSceneWidget::sceneEpochChanged, m_orbit3DWidget, &SystemOrbit3DWidget::setSceneEpoch);
+
+    connect(m_declutterCheck, &QCheckBox::toggled, m_sceneWidget, &SystemSceneWidget::setDeclutterEnabled);
+
+    connect(m_orbit3DCheck, &QCheckBox::toggled, this, [this](const bool visible) {
+        m_orbit3DWidget->setVisible(visible);
+
+        QSettings settings;
+        settings.beginGroup(QLatin1String(kSettingsGroupUi));
+        settings.setValue(QLatin1String(kSettingsOrbit3DVisible), visible);
+        settings.endGroup();
     });
 
     connect(m_sceneWidget, &SystemSceneWidget::emptyAreaClicked, this, [this]() {
@@ -127,7 +207,12 @@ MainWindow::MainWindow(QWidget* parent)
         QMessageBox::warning(this, QStringLiteral("System API"), reason);
     });
 
+    if (!m_corpusDatabase.open()) {
+        qDebug().noquote() << QStringLiteral("[CORPUS] %1").arg(m_corpusDatabase.lastError());
+    }
+
     restoreUiState();
+    updateNavigationButtons();
 }
 
 void MainWindow::setupUi() {
@@ -153,6 +238,24 @@ void MainWindow::setupUi() {
     m_loadButton->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
     m_toggleDetailsButton = new QPushButton(central);
     m_toggleDetailsButton->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
+    m_backButton = new QPushButton(QStringLiteral("← Назад"), central);
+    m_backButton->setToolTip(QStringLiteral("Предыдущая открытая система"));
+    m_backButton->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
+    m_forwardButton = new QPushButton(QStringLiteral("Вперёд →"), central);
+    m_forwardButton->setToolTip(QStringLiteral("Следующая открытая система"));
+    m_forwardButton->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
+    m_importButton = new QPushButton(QStringLiteral("Импорт JSON…"), central);
+    m_importButton->setToolTip(QStringLiteral("Загрузить сохранённые ответы EDAstro в локальный корпус систем"));
+    m_importButton->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
+    m_corpusButton = new QPushButton(QStringLiteral("Кандидаты…"), central);
+    m_corpusButton->setToolTip(QStringLiteral("Оценка всех тел локального корпуса для терраформирования"));
+    m_corpusButton->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
+    m_architectureButton = new QPushButton(QStringLiteral("Похожие…"), central);
+    m_architectureButton->setToolTip(QStringLiteral("Системы корпуса с такой же иерархией тел, как у текущей"));
+    m_architectureButton->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
+    m_statisticsButton = new QPushButton(QStringLiteral("Сводка…"), central);
+    m_statisticsButton->setToolTip(QStringLiteral("Типы систем и тел, подтипы планет и терраформируемые тела по всему корпусу"));
+    m_statisticsButton->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
     m_statusLabel = new QLabel(QStringLiteral("Ожидание запроса"), central);
 
     m_showIdsButton = new QPushButton(QStringLiteral("Все ID тел текущей системы"), central);
@@ -168,8 +271,29 @@ void MainWindow::setupUi() {
     m_bodySizeModeCombo->setToolTip(QStringLiteral("VisualClamped ограничивает максимальный экранный размер, Physical показывает физический масштаб."));
 
 
+    m_orbit3DCheck = new QCheckBox(QStringLiteral("3D-вид орбит"), secondarySettingsGroup);
+    m_orbit3DCheck->setToolTip(QStringLiteral("Орбиты в настоящем масштабе с наклонением и восходящим узлом рядом с плоской схемой."));
+
+    m_declutterCheck = new QCheckBox(QStringLiteral("Разводить перекрытия"), secondarySettingsGroup);
+    m_declutterCheck->setToolTip(QStringLiteral("Слегка расталкивает налезающие друг на друга тела и подписи, удерживая их возле мест на орбитах."));
+
+    auto* cacheBudgetTitle = new QLabel(QStringLiteral("Кэш систем:"), secondarySettingsGroup);
+    m_cacheBudgetSpin = new QSpinBox(secondarySettingsGroup);
+    m_cacheBudgetSpin->setRange(16, 4096);
+    m_cacheBudgetSpin->setSingleStep(16);
+    m_cacheBudgetSpin->setSuffix(QStringLiteral(" МБ"));
+    m_cacheBudgetSpin->setValue(kDefaultCacheBudgetMb);
+    m_cacheBudgetSpin->setToolTip(QStringLiteral("Бюджет памяти для недавно открытых систем. При превышении дольше всего не открывавшиеся системы вытесняются."));
+
     secondaryRow->addWidget(bodySizeModeTitle);
     secondaryRow->addWidget(m_bodySizeModeCombo);
+    secondaryRow->addSpacing(16);
+    secondaryRow->addWidget(m_orbit3DCheck);
+    secondaryRow->addSpacing(16);
+    secondaryRow->addWidget(m_declutterCheck);
+    secondaryRow->addSpacing(16);
+    secondaryRow->addWidget(cacheBudgetTitle);
+    secondaryRow->addWidget(m_cacheBudgetSpin);
     secondaryRow->addStretch(1);
 
     topControlsLayout->addWidget(systemNameTitle, 0, 0);
@@ -178,11 +302,28 @@ void MainWindow::setupUi() {
     topControlsLayout->addWidget(m_showIdsButton, 0, 3);
     topControlsLayout->addWidget(sourceTitle, 1, 0);
     topControlsLayout->addWidget(m_sourceCombo, 1, 1, Qt::AlignLeft);
-    topControlsLayout->addWidget(m_toggleDetailsButton, 1, 2, 1, 2, Qt::AlignLeft);
+    auto* navigationRow = new QHBoxLayout();
+    navigationRow->addWidget(m_backButton);
+    navigationRow->addWidget(m_forwardButton);
+    navigationRow->addStretch(1);
+    navigationRow->addWidget(m_importButton);
+    navigationRow->addWidget(m_corpusButton);
+    navigationRow->addWidget(m_architectureButton);
+    navigationRow->addWidget(m_statisticsButton);
+
+    topControlsLayout->addWidget(m_toggleDetailsButton, 1, 2, Qt::AlignLeft);
+    topControlsLayout->addLayout(navigationRow, 1, 3);
     topControlsLayout->addWidget(secondarySettingsGroup, 2, 0, 1, 4);
     topControlsLayout->setColumnStretch(1, 1);
 
-    m_sceneWidget = new SystemSceneWidget(central);
+    m_sceneSplitter = new QSplitter(Qt::Horizontal, central);
+    m_sceneWidget = new SystemSceneWidget(m_sceneSplitter);
+    m_orbit3DWidget = new SystemOrbit3DWidget(m_sceneSplitter);
+    m_orbit3DWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    m_orbit3DWidget->hide();
+    m_sceneSplitter->addWidget(m_sceneWidget);
+    m_sceneSplitter->addWidget(m_orbit3DWidget);
+    m_sceneSplitter->setChildrenCollapsible(false);
 
     m_bodyDetailsPanel = new BodyDetailsWidget(central);
     m_bodyDetailsPanel->setMinimumWidth(260);
@@ -193,7 +334,7 @@ void MainWindow::setupUi() {
 
     m_contentSplitter = new QSplitter(Qt::Horizontal, central);
     m_contentSplitter->addWidget(m_bodyDetailsPanel);
-    m_contentSplitter->addWidget(m_sceneWidget);
+    m_contentSplitter->addWidget(m_sceneSplitter);
     m_contentSplitter->setChildrenCollapsible(false);
     m_contentSplitter->setCollapsible(0, false);
     m_contentSplitter->setCollapsible(1, false);
@@ -268,6 +409,8 @@ void MainWindow::restoreUiState() {
 
     const auto splitterState = settings.value(QLatin1String(kSettingsSplitterState)).toByteArray();
     const bool detailsVisible = settings.value(QLatin1String(kSettingsDetailsVisible), true).toBool();
+    const int cacheBudgetMb = settings.value(QLatin1String(kSettingsCacheBudgetMb), kDefaultCacheBudgetMb).toInt();
+    const bool orbit3DVisible = settings.value(QLatin1String(kSettingsOrbit3DVisible), false).toBool();
 
     bool splitterRestored = false;
     if (!splitterState.isEmpty()) {
@@ -281,6 +424,15 @@ void MainWindow::restoreUiState() {
 
     settings.endGroup();
 
+    if (m_cacheBudgetSpin) {
+        m_cacheBudgetSpin->setValue(cacheBudgetMb);
+        m_snapshotStore.setMemoryBudgetBytes(static_cast<qint64>(m_cacheBudgetSpin->value()) * 1024 * 1024);
+    }
+
+    if (m_orbit3DCheck) {
+        m_orbit3DCheck->setChecked(orbit3DVisible);
+    }
+
     setDetailsPanelVisible(detailsVisible);
     if (detailsVisible) {
         m_lastVisibleSplitterSizes = m_contentSplitter->sizes();
@@ -327,6 +479,112 @@ void MainWindow::updateDetailsToggleText() {
             : QStringLiteral("Показать детали"));
 }
 
+void MainWindow::showSnapshot(const SystemSnapshot& snapshot, const QString& status) {
+    m_currentSnapshot = snapshot;
+    // 3D-вид получает снимок первым: установка снимка в схеме сразу сообщает момент шкалы времени.
+    m_orbit3DWidget->setSnapshot(m_currentSnapshot);
+    m_sceneWidget->setSnapshot(m_currentSnapshot);
+    m_systemIdsWindow->setSnapshot(m_currentSnapshot);
+    m_statusLabel->setText(status);
+    setBodyDetailsPlaceholder(QStringLiteral("Кликните по телу на карте, чтобы увидеть параметры."));
+}
+
+void MainWindow::navigateToHistoryEntry(const QString& systemName) {
+    if (systemName.isEmpty()) {
+        updateNavigationButtons();
+        return;
+    }
+
+    m_systemNameEdit->setText(systemName);
+    const auto cached = m_snapshotStore.find(systemName);
+    if (cached) {
+        showSnapshot(*cached,
+                     QStringLiteral("Из памяти: %1. Тел: %2")
+                         .arg(systemName)
+                         .arg(cached->realBodyCount()));
+    } else {
+        // Система уже вытеснена из кэша — загружаем заново, история при этом не меняется.
+        m_statusLabel->setText(QStringLiteral("Система вытеснена из кэша, повторная загрузка из EDAstro..."));
+        m_apiClient.requestSystemBodies(systemName, SystemRequestMode::EdastroOnly);
+    }
+
+    updateNavigationButtons();
+}
+
+void MainWindow::updateNavigationButtons() {
+    if (!m_backButton || !m_forwardButton) {
+        return;
+    }
+
+    m_backButton->setEnabled(m_snapshotStore.canGoBack());
+    m_forwardButton->setEnabled(m_snapshotStore.canGoForward());
+}
+
+void MainWindow::storeInCorpus(const SystemSnapshot& snapshot, const SystemBodiesResult& result) {
+    if (!m_corpusDatabase.isOpen()) {
+        return;
+    }
+
+    if (!m_corpusDatabase.storeSystem(snapshot, result.systemId64, result.coordinates)) {
+        qDebug().noquote() << QStringLiteral("[CORPUS] %1").arg(m_corpusDatabase.lastError());
+        return;
+    }
+
+    // Сводка читается из готовой таблицы — открытое окно можно обновлять после каждой записи.
+    if (m_statisticsWindow->isVisible()) {
+        m_statisticsWindow->reload();
+    }
+}
+
+void MainWindow::importSystemFiles() {
+    const QStringList paths = QFileDialog::getOpenFileNames(this,
+                                                            QStringLiteral("Импорт систем EDAstro"),
+                                                            QString(),
+                                                            QStringLiteral("JSON (*.json);;Все файлы (*)"));
+    if (paths.isEmpty()) {
+        return;
+    }
+
+    int importedCount = 0;
+    SystemSnapshot lastSnapshot;
+    for (const QString& path : paths) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qDebug().noquote() << QStringLiteral("[IMPORT] Не удалось открыть %1: %2").arg(path, file.errorString());
+            continue;
+        }
+
+        const SystemBodiesResult result = parseEdastroSystemPayload(file.readAll(),
+                                                                    QFileInfo(path).completeBaseName(),
+                                                                    [](const QString& message) {
+                                                                        qDebug().noquote() << message;
+                                                                    });
+        if (result.bodies.isEmpty()) {
+            qDebug().noquote() << QStringLiteral("[IMPORT] В файле %1 не найдено тел системы.").arg(path);
+            continue;
+        }
+
+        lastSnapshot = SystemSnapshot::build(result.systemName, result.bodies);
+        storeInCorpus(lastSnapshot, result);
+        ++importedCount;
+    }
+
+    if (lastSnapshot.isEmpty()) {
+        QMessageBox::warning(this, QStringLiteral("Импорт"), QStringLiteral("Ни один файл не удалось разобрать как систему EDAstro."));
+        return;
+    }
+
+    logCacheEviction(m_snapshotStore.insert(lastSnapshot), m_snapshotStore);
+    m_snapshotStore.visit(lastSnapshot.systemName());
+    m_systemNameEdit->setText(lastSnapshot.systemName());
+    showSnapshot(lastSnapshot,
+                 QStringLiteral("Импортировано систем: %1 из %2. В корпусе: %3")
+                     .arg(importedCount)
+                     .arg(paths.size())
+                     .arg(m_corpusDatabase.systemCount()));
+    updateNavigationButtons();
+}
+
 void MainWindow::closeEvent(QCloseEvent* event) {
     saveUiState();
     QMainWindow::closeEvent(event);
@@ -3,14 +3,23 @@
 #include <QMainWindow>
 
 #include "EdsmApiClient.h"
+#include "SystemCorpusDatabase.h"
+#include "SystemSnapshot.h"
+#include "SystemSnapshotStore.h"
 
 class QLabel;
 class QLineEdit;
 class QPushButton;
+class QCheckBox;
 class QComboBox;
+class QSpinBox;
 class QSplitter;
 class QCloseEvent;
+class ArchitectureWindow;
 class BodyDetailsWidget;
+class CorpusStatisticsWindow;
+class CorpusWindow;
+class SystemOrbit3DWidget;
 class SystemSceneWidget;
 class SystemIdsWindow;
 
@@ -26,6 +35,11 @@ private:
     void saveUiState() const;
     void restoreUiState();
     void updateDetailsToggleText();
+    void showSnapshot(const SystemSnapshot& snapshot, const QString& status);
+    void navigateToHistoryEntry(const QString& systemName);
+    void updateNavigationButtons();
+    void storeInCorpus(const SystemSnapshot& snapshot, const SystemBodiesResult& result);
+    void importSystemFiles();
     QList<int> defaultSplitterSizesForWidth(int totalWidth) const;
     bool isValidSplitterSizes(const QList<int>& sizes, int totalWidth) const;
 
@@ -37,13 +51,30 @@ protected:
     QPushButton* m_loadButton = nullptr;
     QPushButton* m_showIdsButton = nullptr;
     QPushButton* m_toggleDetailsButton = nullptr;
+    QPushButton* m_backButton = nullptr;
+    QPushButton* m_forwardButton = nullptr;
+    QPushButton* m_importButton = nullptr;
+    QPushButton* m_corpusButton = nullptr;
+    QPushButton* m_architectureButton = nullptr;
+    QPushButton* m_statisticsButton = nullptr;
     QComboBox* m_sourceCombo = nullptr;
     QComboBox* m_bodySizeModeCombo = nullptr;
+    QCheckBox* m_orbit3DCheck = nullptr;
+    QCheckBox* m_declutterCheck = nullptr;
+    QSpinBox* m_cacheBudgetSpin = nullptr;
     QLabel* m_statusLabel = nullptr;
     QSplitter* m_contentSplitter = nullptr;
+    // Плоская схема и необязательный 3D-вид орбит рядом с ней.
+    QSplitter* m_sceneSplitter = nullptr;
     BodyDetailsWidget* m_bodyDetailsPanel = nullptr;
     SystemSceneWidget* m_sceneWidget = nullptr;
+    SystemOrbit3DWidget* m_orbit3DWidget = nullptr;
     SystemIdsWindow* m_systemIdsWindow = nullptr;
-    QHash<int, CelestialBody> m_currentBodies;
+    CorpusWindow* m_corpusWindow = nullptr;
+    ArchitectureWindow* m_architectureWindow = nullptr;
+    CorpusStatisticsWindow* m_statisticsWindow = nullptr;
+    SystemSnapshot m_currentSnapshot;
+    SystemSnapshotStore m_snapshotStore;
+    SystemCorpusDatabase m_corpusDatabase;
     QList<int> m_lastVisibleSplitterSizes;
 };
@@ -8,23 +8,19 @@ bool containsInsensitive(const QString& value, const QString& token) {
     return value.contains(token, Qt::CaseInsensitive);
 }
 
-bool isStar(const CelestialBody& body) {
+bool isStar(const BodyHot& body) {
     return body.bodyClass == CelestialBody::BodyClass::Star
-        || containsInsensitive(body.type, QStringLiteral("Star"));
+        || body.hasFlag(BodyHot::StarTypeFlag);
 }
 
-bool isPlanet(const CelestialBody& body) {
+bool isPlanet(const BodyHot& body) {
     return body.bodyClass == CelestialBody::BodyClass::Planet
-        || containsInsensitive(body.type, QStringLiteral("Planet"));
+        || body.hasFlag(BodyHot::PlanetTypeFlag);
 }
 
-bool isBarycenter(const CelestialBody& body) {
+bool isBarycenter(const BodyHot& body) {
     return body.bodyClass == CelestialBody::BodyClass::Barycenter
-        || OrbitClassifier::isBarycenterType(body.type);
-}
-
-bool isNonStarBody(const CelestialBody& body) {
-    return !isStar(body) && !isBarycenter(body);
+        || body.hasFlag(BodyHot::BarycenterTypeFlag);
 }
 
 } // namespace
@@ -34,108 +30,136 @@ bool OrbitClassifier::isBarycenterType(const QString& type) {
         || containsInsensitive(type, QStringLiteral("Barycenter"));
 }
 
-OrbitClassificationResult OrbitClassifier::classify(const QHash<int, CelestialBody>& bodyMap) {
+OrbitClassificationResult OrbitClassifier::classify(const BodyGraph& graph, const QVector<BodyHot>& hotBodies) {
     OrbitClassificationResult result;
+    const int bodyCount = graph.size();
+    result.bodyTypes.fill(BodyOrbitTypes(), bodyCount);
+    if (bodyCount == 0 || hotBodies.size() != bodyCount) {
+        return result;
+    }
 
-    for (auto it = bodyMap.constBegin(); it != bodyMap.constEnd(); ++it) {
-        if (!isBarycenter(it.value())) {
-            continue;
+    // Порядок «дети раньше родителя»: обратный прямому обходу от корней. Тела вне деревьев
+    // корней (после ремонта иерархии таких нет) дообходятся отдельно, каждое не больше раза.
+    QVector<int> order;
+    order.reserve(bodyCount);
+    QVector<bool> visited(bodyCount, false);
+    QVector<int> stack;
+    const auto visitFrom = [&](const int startIndex) {
+        if (visited.at(startIndex)) {
+            return;
         }
+        visited[startIndex] = true;
+        stack.push_back(startIndex);
+        while (!stack.isEmpty()) {
+            const int index = stack.takeLast();
+            order.push_back(index);
+            for (const int* child = graph.childrenBegin(index); child != graph.childrenEnd(index); ++child) {
+                if (!visited.at(*child)) {
+                    visited[*child] = true;
+                    stack.push_back(*child);
+                }
+            }
+        }
+    };
+    for (const int rootIndex : graph.rootIndices) {
+        visitFrom(rootIndex);
+    }
+    for (int index = 0; index < bodyCount; ++index) {
+        visitFrom(index);
+    }
 
-        QVector<int> starChildren;
-        QVector<int> planetChildren;
-        QVector<int> nonStarChildren;
-        QVector<int> nonStarNonPlanetChildren;
+    for (int position = order.size() - 1; position >= 0; --position) {
+        const int index = order.at(position);
+        if (!isBarycenter(hotBodies.at(index))) {
+            continue;
+        }
 
-        for (const int childId : it->children) {
-            const auto childIt = bodyMap.constFind(childId);
-            if (childIt == bodyMap.constEnd()) {
-                continue;
+        // Дети уже размечены, поэтому все мотивы барицентра — по одному проходу по детям.
+        int starChildren = 0;
+        int planetChildren = 0;
+        int nonStarChildren = 0;
+        int nonStarNonPlanetChildren = 0;
+        int binaryPairChildren = 0;
+        for (const int* child = graph.childrenBegin(index); child != graph.childrenEnd(index); ++child) {
+            const BodyHot& childBody = hotBodies.at(*child);
+            if (result.bodyTypes.at(*child).testFlag(BodyOrbitType::BinaryStarBarycenter)) {
+                ++binaryPairChildren;
             }
-
-            const CelestialBody& childBody = childIt.value();
             if (isStar(childBody)) {
-                starChildren.push_back(childId);
+                ++starChildren;
                 continue;
             }
 
-            if (isPlanet(childBody)) {
-                planetChildren.push_back(childId);
+            const bool planet = isPlanet(childBody);
+            if (planet) {
+                ++planetChildren;
             }
-
-            if (isNonStarBody(childBody)) {
-                nonStarChildren.push_back(childId);
-                if (!isPlanet(childBody)) {
-                    nonStarNonPlanetChildren.push_back(childId);
+            if (!isBarycenter(childBody)) {
+                ++nonStarChildren;
+                if (!planet) {
+                    ++nonStarNonPlanetChildren;
                 }
             }
         }
 
-        if (starChildren.size() == 2) {
-            result.bodyTypes[it.key()].insert(BodyOrbitType::BinaryStarBarycenter);
-            result.systemTypes.insert(SystemOrbitType::BinaryStar);
+        BodyOrbitTypes& types = result.bodyTypes[index];
+        // Метки, которые барицентр раздаёт детям определённого класса.
+        BodyOrbitTypes starChildTypes;
+        BodyOrbitTypes planetChildTypes;
+        BodyOrbitTypes pairChildTypes;
 
-            for (const int childId : starChildren) {
-                result.bodyTypes[childId].insert(BodyOrbitType::BinaryStarComponent);
-            }
+        if (starChildren == 2) {
+            types |= BodyOrbitType::BinaryStarBarycenter;
+            result.systemTypes |= SystemOrbitType::BinaryStar;
+            starChildTypes |= BodyOrbitType::BinaryStarComponent;
         }
 
-        if (nonStarChildren.size() == 2) {
+        if (nonStarChildren == 2) {
             // Для не-звёздных барицентров выделяем как общий класс "не-звёздная пара",
             // так и более узкие подтипы (2 планеты или планета + другое не-звёздное тело).
-            result.bodyTypes[it.key()].insert(BodyOrbitType::BinaryNonStarBarycenter);
-            result.systemTypes.insert(SystemOrbitType::BinaryNonStarPair);
-
-            if (planetChildren.size() == 2) {
-                result.bodyTypes[it.key()].insert(BodyOrbitType::BinaryPlanetPairBarycenter);
-                result.systemTypes.insert(SystemOrbitType::BinaryPlanetPair);
+            types |= BodyOrbitType::BinaryNonStarBarycenter;
+            result.systemTypes |= SystemOrbitType::BinaryNonStarPair;
 
-                for (const int childId : planetChildren) {
-                    result.bodyTypes[childId].insert(BodyOrbitType::BinaryPlanetComponent);
-                }
+            if (planetChildren == 2) {
+                types |= BodyOrbitType::BinaryPlanetPairBarycenter;
+                result.systemTypes |= SystemOrbitType::BinaryPlanetPair;
+                planetChildTypes |= BodyOrbitType::BinaryPlanetComponent;
             }
 
-            if (planetChildren.size() == 1 && nonStarNonPlanetChildren.size() == 1) {
-                result.bodyTypes[it.key()].insert(BodyOrbitType::BinaryPlanetNonStarBarycenter);
-                result.systemTypes.insert(SystemOrbitType::BinaryPlanetNonStarPair);
-
-                result.bodyTypes[planetChildren.front()].insert(BodyOrbitType::BinaryPlanetComponent);
+            if (planetChildren == 1 && nonStarNonPlanetChildren == 1) {
+                types |= BodyOrbitType::BinaryPlanetNonStarBarycenter;
+                result.systemTypes |= SystemOrbitType::BinaryPlanetNonStarPair;
+                planetChildTypes |= BodyOrbitType::BinaryPlanetComponent;
             }
         }
-    }
-
-    // Ищем иерархическую "пару пар": верхний барицентр, у которого минимум два дочерних
-    // барицентра уже классифицированы как барицентры бинарных звёздных пар.
-    for (auto it = bodyMap.constBegin(); it != bodyMap.constEnd(); ++it) {
-        if (!isBarycenter(it.value())) {
-            continue;
-        }
 
-        QVector<int> binaryPairChildren;
-        for (const int childId : it->children) {
-            if (result.bodyTypes.value(childId).contains(BodyOrbitType::BinaryStarBarycenter)) {
-                binaryPairChildren.push_back(childId);
-            }
+        // Иерархическая "пара пар": минимум два дочерних барицентра бинарных звёздных пар.
+        if (binaryPairChildren >= 2) {
+            types |= BodyOrbitType::HierarchicalPairOfPairsBarycenter;
+            result.systemTypes |= SystemOrbitType::HierarchicalPairOfPairs;
+            pairChildTypes |= BodyOrbitType::HierarchicalPairMemberBarycenter;
         }
 
-        if (binaryPairChildren.size() >= 2) {
-            result.bodyTypes[it.key()].insert(BodyOrbitType::HierarchicalPairOfPairsBarycenter);
-            result.systemTypes.insert(SystemOrbitType::HierarchicalPairOfPairs);
-
-            for (const int childId : binaryPairChildren) {
-                result.bodyTypes[childId].insert(BodyOrbitType::HierarchicalPairMemberBarycenter);
-            }
+        // Планеты вокруг барицентра бинарной звезды — циркумбинарные.
+        if (types.testFlag(BodyOrbitType::BinaryStarBarycenter) && planetChildren > 0) {
+            planetChildTypes |= BodyOrbitType::CircumbinaryPlanet;
+            result.systemTypes |= SystemOrbitType::CircumbinaryPlanetarySystem;
         }
-    }
 
-    for (auto it = bodyMap.constBegin(); it != bodyMap.constEnd(); ++it) {
-        if (!isPlanet(it.value()) || it->parentId < 0) {
+        if (!starChildTypes && !planetChildTypes && !pairChildTypes) {
             continue;
         }
-
-        if (result.bodyTypes.value(it->parentId).contains(BodyOrbitType::BinaryStarBarycenter)) {
-            result.bodyTypes[it.key()].insert(BodyOrbitType::CircumbinaryPlanet);
-            result.systemTypes.insert(SystemOrbitType::CircumbinaryPlanetarySystem);
+        for (const int* child = graph.childrenBegin(index); child != graph.childrenEnd(index); ++child) {
+            const BodyHot& childBody = hotBodies.at(*child);
+            BodyOrbitTypes& childTypes = result.bodyTypes[*child];
+            if (isStar(childBody)) {
+                childTypes |= starChildTypes;
+            } else if (isPlanet(childBody)) {
+                childTypes |= planetChildTypes;
+            }
+            if (childTypes.testFlag(BodyOrbitType::BinaryStarBarycenter)) {
+                childTypes |= pairChildTypes;
+            }
         }
     }
 
@@ -186,21 +210,25 @@ QString OrbitClassifier::systemTypeToLabel(const SystemOrbitType type) {
     return QString();
 }
 
-QStringList OrbitClassifier::bodyTypeLabels(const QSet<BodyOrbitType>& types) {
+QStringList OrbitClassifier::bodyTypeLabels(const BodyOrbitTypes types) {
     QStringList labels;
-    labels.reserve(types.size());
-    for (const auto type : types) {
-        labels.push_back(bodyTypeToLabel(type));
+    for (int bit = 0; bit < 16; ++bit) {
+        const auto type = static_cast<BodyOrbitType>(1 << bit);
+        if (types.testFlag(type)) {
+            labels.push_back(bodyTypeToLabel(type));
+        }
     }
     std::sort(labels.begin(), labels.end());
     return labels;
 }
 
-QStringList OrbitClassifier::systemTypeLabels(const QSet<SystemOrbitType>& types) {
+QStringList OrbitClassifier::systemTypeLabels(const SystemOrbitTypes types) {
     QStringList labels;
-    labels.reserve(types.size());
-    for (const auto type : types) {
-        labels.push_back(systemTypeToLabel(type));
+    for (int bit = 0; bit < 8; ++bit) {
+        const auto type = static_cast<SystemOrbitType>(1 << bit);
+        if (types.testFlag(type)) {
+            labels.push_back(systemTypeToLabel(type));
+        }
     }
     std::sort(labels.begin(), labels.end());
     return labels;
@@ -1,55 +1,61 @@
 #pragma once
 
-#include <QHash>
-#include <QSet>
+#include <QFlags>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
-#include <type_traits>
-
+#include "BodyGraph.h"
+#include "BodyRecords.h"
 #include "CelestialBody.h"
 
-enum class BodyOrbitType {
-    BinaryStarComponent,
-    BinaryStarBarycenter,
-    BinaryNonStarBarycenter,
-    BinaryPlanetPairBarycenter,
-    BinaryPlanetNonStarBarycenter,
-    BinaryPlanetComponent,
-    HierarchicalPairMemberBarycenter,
-    HierarchicalPairOfPairsBarycenter,
-    CircumbinaryPlanet,
+// Метки — отдельные биты: набор меток тела или системы хранится одним словом (QFlags),
+// без QSet и кучи.
+enum class BodyOrbitType : quint16 {
+    BinaryStarComponent = 1 << 0,
+    BinaryStarBarycenter = 1 << 1,
+    BinaryNonStarBarycenter = 1 << 2,
+    BinaryPlanetPairBarycenter = 1 << 3,
+    BinaryPlanetNonStarBarycenter = 1 << 4,
+    BinaryPlanetComponent = 1 << 5,
+    HierarchicalPairMemberBarycenter = 1 << 6,
+    HierarchicalPairOfPairsBarycenter = 1 << 7,
+    CircumbinaryPlanet = 1 << 8,
 };
 
-enum class SystemOrbitType {
-    BinaryStar,
-    BinaryNonStarPair,
-    BinaryPlanetPair,
-    BinaryPlanetNonStarPair,
-    HierarchicalPairOfPairs,
-    CircumbinaryPlanetarySystem,
+enum class SystemOrbitType : quint8 {
+    BinaryStar = 1 << 0,
+    BinaryNonStarPair = 1 << 1,
+    BinaryPlanetPair = 1 << 2,
+    BinaryPlanetNonStarPair = 1 << 3,
+    HierarchicalPairOfPairs = 1 << 4,
+    CircumbinaryPlanetarySystem = 1 << 5,
 };
 
-inline uint qHash(const BodyOrbitType key, const uint seed = 0) noexcept {
-    return ::qHash(static_cast<std::underlying_type_t<BodyOrbitType>>(key), seed);
-}
-
-inline uint qHash(const SystemOrbitType key, const uint seed = 0) noexcept {
-    return ::qHash(static_cast<std::underlying_type_t<SystemOrbitType>>(key), seed);
-}
+Q_DECLARE_FLAGS(BodyOrbitTypes, BodyOrbitType)
+Q_DECLARE_OPERATORS_FOR_FLAGS(BodyOrbitTypes)
+Q_DECLARE_FLAGS(SystemOrbitTypes, SystemOrbitType)
+Q_DECLARE_OPERATORS_FOR_FLAGS(SystemOrbitTypes)
 
 struct OrbitClassificationResult {
-    QHash<int, QSet<BodyOrbitType>> bodyTypes;
-    QSet<SystemOrbitType> systemTypes;
+    // Метки тел по индексам BodyGraph.
+    QVector<BodyOrbitTypes> bodyTypes;
+    SystemOrbitTypes systemTypes;
+
+    BodyOrbitTypes typesAt(const int index) const {
+        return index >= 0 && index < bodyTypes.size() ? bodyTypes.at(index) : BodyOrbitTypes();
+    }
 };
 
 class OrbitClassifier {
 public:
-    static OrbitClassificationResult classify(const QHash<int, CelestialBody>& bodyMap);
+    // Один проход снизу вверх: каждый барицентр считает своих детей по классам и меткам,
+    // уже выставленным детям. Стоимость O(n), поэтому классификация дешева и для всего корпуса.
+    static OrbitClassificationResult classify(const BodyGraph& graph, const QVector<BodyHot>& hotBodies);
     static bool isBarycenterType(const QString& type);
 
     static QString bodyTypeToLabel(BodyOrbitType type);
     static QString systemTypeToLabel(SystemOrbitType type);
-    static QStringList bodyTypeLabels(const QSet<BodyOrbitType>& types);
-    static QStringList systemTypeLabels(const QSet<SystemOrbitType>& types);
+    static QStringList bodyTypeLabels(BodyOrbitTypes types);
+    static QStringList systemTypeLabels(SystemOrbitTypes types);
 };
@@ -0,0 +1,145 @@
+#include "OrbitPathCache.h"
+
+#include <QtMath>
+
+#include <cmath>
+
+namespace {
+
+// Допустимое отклонение хорды от эллипса, экранных пикселей.
+constexpr double kChordTolerancePx = 0.25;
+constexpr int kMinSegments = 24;
+constexpr int kMaxSegments = 1 << 16;
+// Корзины идут через полоктавы экранного радиуса: 2^(bucket / 2) пикселей.
+constexpr int kMaxBucket = 80;
+constexpr int kChunkSegments = 32;
+// Выше этого числа точек кэш сбрасывается целиком: зум туда-обратно по всем корзинам
+// не должен копить память без предела.
+constexpr qint64 kMaxCachedPoints = 2000000;
+
+} // namespace
+
+void OrbitPathCache::clear() {
+    m_paths.clear();
+    m_pointCount = 0;
+}
+
+int OrbitPathCache::cachedPathCount() const {
+    return m_paths.size();
+}
+
+qint64 OrbitPathCache::cachedPointCount() const {
+    return m_pointCount;
+}
+
+int OrbitPathCache::bucketForRadius(const double radiusPx) {
+    if (radiusPx <= 1.0) {
+        return 0;
+    }
+    return qBound(0, static_cast<int>(std::ceil(2.0 * std::log2(radiusPx))), kMaxBucket);
+}
+
+int OrbitPathCache::segmentCountForRadius(const double radiusPx) {
+    return segmentCountForBucket(bucketForRadius(radiusPx));
+}
+
+int OrbitPathCache::segmentCountForBucket(const int bucket) {
+    // Вторая производная точки эллипса по E не длиннее большой полуоси R, поэтому шаг h даёт
+    // прогиб хорды не больше h²·R/8; R берётся по верхней границе корзины.
+    const double bucketRadiusPx = std::pow(2.0, bucket / 2.0);
+    const double step = std::sqrt(8.0 * kChordTolerancePx / bucketRadiusPx);
+    const double segments = std::ceil(2.0 * M_PI / step);
+    return static_cast<int>(qBound(static_cast<double>(kMinSegments), segments, static_cast<double>(kMaxSegments)));
+}
+
+const OrbitPathCache::Path& OrbitPathCache::pathFor(const int index, const int bucket, const OrbitEllipse& ellipse) {
+    const quint64 key = (static_cast<quint64>(static_cast<quint32>(index)) << 8) | static_cast<quint64>(bucket);
+    const auto found = m_paths.constFind(key);
+    if (found != m_paths.constEnd()) {
+        return found.value();
+    }
+
+    const int segmentCount = segmentCountForBucket(bucket);
+    if (m_pointCount + segmentCount + 1 > kMaxCachedPoints) {
+        clear();
+    }
+
+    Path path;
+    path.points.resize(segmentCount + 1);
+    for (int segment = 0; segment <= segmentCount; ++segment) {
+        // Последняя точка совпадает с первой точно, без ошибки округления 2π.
+        const double anomaly = segment == segmentCount ? 0.0 : (2.0 * M_PI * segment) / segmentCount;
+        const double alongMajor = std::cos(anomaly) - ellipse.eccentricity;
+        const double alongMinor = std::sin(anomaly);
+        path.points[segment] = QPointF(ellipse.majorX * alongMajor + ellipse.minorX * alongMinor,
+                                       ellipse.majorY * alongMajor + ellipse.minorY * alongMinor);
+    }
+
+    path.chunks.reserve((segmentCount + kChunkSegments - 1) / kChunkSegments);
+    for (int first = 0; first < segmentCount; first += kChunkSegments) {
+        Chunk chunk;
+        chunk.first = first;
+        chunk.last = qMin(first + kChunkSegments, segmentCount);
+        chunk.minX = chunk.maxX = path.points.at(first).x();
+        chunk.minY = chunk.maxY = path.points.at(first).y();
+        for (int point = first + 1; point <= chunk.last; ++point) {
+            chunk.minX = qMin(chunk.minX, path.points.at(point).x());
+            chunk.maxX = qMax(chunk.maxX, path.points.at(point).x());
+            chunk.minY = qMin(chunk.minY, path.points.at(point).y());
+            chunk.maxY = qMax(chunk.maxY, path.points.at(point).y());
+        }
+        path.chunks.push_back(chunk);
+    }
+
+    m_pointCount += path.points.size();
+    return m_paths.insert(key, path).value();
+}
+
+void OrbitPathCache::appendVisibleRuns(const int index,
+                                       const OrbitEllipse& ellipse,
+                                       const double orbitRadiusAu,
+                                       const QPointF& parentAu,
+                                       const double widgetPxPerAu,
+                                       const QRectF& viewAu,
+                                       OrbitPathRuns& runs) {
+    if (orbitRadiusAu <= 0.0 || widgetPxPerAu <= 0.0) {
+        return;
+    }
+
+    // Весь эллипс лежит в квадрате 2·(1 + e) вокруг родителя: дальше орбита не проверяется.
+    const double reachAu = orbitRadiusAu * (1.0 + ellipse.eccentricity);
+    if (parentAu.x() + reachAu < viewAu.left() || parentAu.x() - reachAu > viewAu.right()
+        || parentAu.y() + reachAu < viewAu.top() || parentAu.y() - reachAu > viewAu.bottom()) {
+        return;
+    }
+
+    const Path& path = pathFor(index, bucketForRadius(orbitRadiusAu * widgetPxPerAu), ellipse);
+    // Окно в координатах пути: доли большой полуоси относительно родителя.
+    const double viewLeft = (viewAu.left() - parentAu.x()) / orbitRadiusAu;
+    const double viewRight = (viewAu.right() - parentAu.x()) / orbitRadiusAu;
+    const double viewTop = (viewAu.top() - parentAu.y()) / orbitRadiusAu;
+    const double viewBottom = (viewAu.bottom() - parentAu.y()) / orbitRadiusAu;
+
+    bool continuesRun = false;
+    for (const Chunk& chunk : path.chunks) {
+        // Сравнение с равенством: у орбиты, видной с ребра, кусок может быть отрезком нулевой ширины.
+        const bool visible = chunk.maxX >= viewLeft && chunk.minX <= viewRight
+                          && chunk.maxY >= viewTop && chunk.minY <= viewBottom;
+        if (!visible) {
+            continuesRun = false;
+            continue;
+        }
+
+        int first = chunk.first;
+        if (continuesRun) {
+            // Первая точка куска — последняя точка предыдущего, уже добавленная.
+            ++first;
+        } else {
+            runs.runStarts.push_back(runs.points.size());
+        }
+        for (int point = first; point <= chunk.last; ++point) {
+            runs.points.push_back(parentAu + path.points.at(point) * orbitRadiusAu);
+        }
+        continuesRun = true;
+    }
+}
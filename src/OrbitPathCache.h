@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QHash>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include <QtGlobal>
+
+#include "KeplerEphemeris.h"
+
+// Видимые куски орбит одного кадра в а.е.: ломаные лежат подряд в points, runStarts —
+// начало каждой. Буферы переиспользуются между кадрами.
+struct OrbitPathRuns {
+    QVector<QPointF> points;
+    QVector<int> runStarts;
+
+    void clear() {
+        points.clear();
+        runStarts.clear();
+    }
+
+    int runCount() const {
+        return runStarts.size();
+    }
+
+    int runLength(const int run) const {
+        const int end = run + 1 < runStarts.size() ? runStarts.at(run + 1) : points.size();
+        return end - runStarts.at(run);
+    }
+};
+
+// Кэш разбиения эллипсов орбит на ломаные. Шаг по эксцентрической аномалии подбирается по
+// экранному размеру орбиты так, чтобы хорда отходила от эллипса не дальше чем на четверть
+// пикселя. Размер округляется вверх до корзины в полоктавы, и разбиение корзины служит всем
+// зумам внутри неё. Ломаная хранится кусками с габаритами: в кадр попадают только куски,
+// задевающие окно, поэтому орбита при глубоком зуме стоит столько же, сколько её видимая дуга.
+class OrbitPathCache {
+public:
+    void clear();
+    int cachedPathCount() const;
+    qint64 cachedPointCount() const;
+
+    // Добавляет в runs куски орбиты тела index, задевающие viewAu: эллипс ellipse с большой
+    // полуосью orbitRadiusAu и родителем в фокусе parentAu. widgetPxPerAu — экранных пикселей
+    // на а.е. при текущем зуме.
+    void appendVisibleRuns(int index,
+                           const OrbitEllipse& ellipse,
+                           double orbitRadiusAu,
+                           const QPointF& parentAu,
+                           double widgetPxPerAu,
+                           const QRectF& viewAu,
+                           OrbitPathRuns& runs);
+
+    // Отрезков на полный оборот для орбиты экранного радиуса radiusPx (с округлением до корзины).
+    static int segmentCountForRadius(double radiusPx);
+
+private:
+    struct Chunk {
+        int first = 0;
+        int last = 0;
+        // Габариты куска в долях большой полуоси относительно родителя.
+        double minX = 0.0;
+        double minY = 0.0;
+        double maxX = 0.0;
+        double maxY = 0.0;
+    };
+
+    struct Path {
+        // Точки в долях большой полуоси относительно родителя; первая и последняя совпадают.
+        QVector<QPointF> points;
+        QVector<Chunk> chunks;
+    };
+
+    static int bucketForRadius(double radiusPx);
+    static int segmentCountForBucket(int bucket);
+    const Path& pathFor(int index, int bucket, const OrbitEllipse& ellipse);
+
+    QHash<quint64, Path> m_paths;
+    qint64 m_pointCount = 0;
+};
@@ -0,0 +1,168 @@
+#include "OrbitScene3D.h"
+
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+template <typename... Vectors>
+void resizeAll(const int size, Vectors&... vectors) {
+    (vectors.resize(size), ...);
+}
+
+} // namespace
+
+void ViewProjection3D::project(const double* const x,
+                               const double* const y,
+                               const double* const z,
+                               const int count,
+                               double* const screenX,
+                               double* const screenY,
+                               double* const depth) const {
+    const double cosYaw = std::cos(yawRad);
+    const double sinYaw = std::sin(yawRad);
+    const double cosPitch = std::cos(pitchRad);
+    const double sinPitch = std::sin(pitchRad);
+    // Строки матрицы Rx(pitch)·Rz(yaw), первые две уже умножены на масштаб экрана.
+    const double row0X = cosYaw * pxPerAu;
+    const double row0Y = -sinYaw * pxPerAu;
+    const double row1X = sinYaw * cosPitch * pxPerAu;
+    const double row1Y = cosYaw * cosPitch * pxPerAu;
+    const double row1Z = -sinPitch * pxPerAu;
+    const double row2X = sinYaw * sinPitch;
+    const double row2Y = cosYaw * sinPitch;
+    const double row2Z = cosPitch;
+    for (int point = 0; point < count; ++point) {
+        screenX[point] = originX + row0X * x[point] + row0Y * y[point];
+        screenY[point] = originY + row1X * x[point] + row1Y * y[point] + row1Z * z[point];
+        depth[point] = row2X * x[point] + row2Y * y[point] + row2Z * z[point];
+    }
+}
+
+void OrbitScene3D::build(const KeplerEphemeris& ephemeris) {
+    m_orbitBodyIndex.clear();
+    for (int index = 0; index < ephemeris.size(); ++index) {
+        if (ephemeris.hasOrbit(index)) {
+            m_orbitBodyIndex.push_back(index);
+        }
+    }
+
+    const int pointCount = m_orbitBodyIndex.size() * kPointsPerOrbit;
+    resizeAll(pointCount, m_relativeX, m_relativeY, m_relativeZ, m_x, m_y, m_z, m_screenX, m_screenY, m_depth);
+
+    // Косинусы и синусы шага общие для всех орбит.
+    double cosAnomaly[kPointsPerOrbit];
+    double sinAnomaly[kPointsPerOrbit];
+    for (int point = 0; point < kPointsPerOrbit; ++point) {
+        // Последняя точка совпадает с первой точно, без ошибки округления 2π.
+        const double anomaly = point == kSegmentsPerOrbit ? 0.0 : (2.0 * M_PI * point) / kSegmentsPerOrbit;
+        cosAnomaly[point] = std::cos(anomaly);
+        sinAnomaly[point] = std::sin(anomaly);
+    }
+
+    for (int orbit = 0; orbit < m_orbitBodyIndex.size(); ++orbit) {
+        const int index = m_orbitBodyIndex.at(orbit);
+        const OrbitEllipse ellipse = ephemeris.orbitEllipse(index);
+        const double semiMajorAxisAu = ephemeris.semiMajorAxisAu(index);
+        double* const relativeX = m_relativeX.data() + orbit * kPointsPerOrbit;
+        double* const relativeY = m_relativeY.data() + orbit * kPointsPerOrbit;
+        double* const relativeZ = m_relativeZ.data() + orbit * kPointsPerOrbit;
+        for (int point = 0; point < kPointsPerOrbit; ++point) {
+            const double alongMajor = semiMajorAxisAu * (cosAnomaly[point] - ellipse.eccentricity);
+            const double alongMinor = semiMajorAxisAu * sinAnomaly[point];
+            relativeX[point] = ellipse.majorX * alongMajor + ellipse.minorX * alongMinor;
+            relativeY[point] = ellipse.majorY * alongMajor + ellipse.minorY * alongMinor;
+            relativeZ[point] = ellipse.majorZ * alongMajor + ellipse.minorZ * alongMinor;
+        }
+    }
+
+    m_extentAu = 0.0;
+}
+
+void OrbitScene3D::place(const EphemerisState& state) {
+    double extentSquared = 0.0;
+    for (int orbit = 0; orbit < m_orbitBodyIndex.size(); ++orbit) {
+        const int index = m_orbitBodyIndex.at(orbit);
+        // Родитель стоит там, откуда тело смещено на relative.
+        const double parentX = state.x.at(index) - state.relativeX.at(index);
+        const double parentY = state.y.at(index) - state.relativeY.at(index);
+        const double parentZ = state.z.at(index) - state.relativeZ.at(index);
+        const int first = orbit * kPointsPerOrbit;
+        const double* const relativeX = m_relativeX.constData() + first;
+        const double* const relativeY = m_relativeY.constData() + first;
+        const double* const relativeZ = m_relativeZ.constData() + first;
+        double* const x = m_x.data() + first;
+        double* const y = m_y.data() + first;
+        double* const z = m_z.data() + first;
+        for (int point = 0; point < kPointsPerOrbit; ++point) {
+            x[point] = parentX + relativeX[point];
+            y[point] = parentY + relativeY[point];
+            z[point] = parentZ + relativeZ[point];
+            extentSquared = std::max(extentSquared, x[point] * x[point] + y[point] * y[point] + z[point] * z[point]);
+        }
+    }
+
+    for (int index = 0; index < state.x.size(); ++index) {
+        extentSquared = std::max(extentSquared,
+                                 state.x.at(index) * state.x.at(index) + state.y.at(index) * state.y.at(index)
+                                     + state.z.at(index) * state.z.at(index));
+    }
+    m_extentAu = std::sqrt(extentSquared);
+}
+
+void OrbitScene3D::project(const ViewProjection3D& view, const EphemerisState& state) {
+    view.project(m_x.constData(), m_y.constData(), m_z.constData(), m_x.size(),
+                 m_screenX.data(), m_screenY.data(), m_depth.data());
+
+    const int bodyCount = state.x.size();
+    resizeAll(bodyCount, m_bodyScreenX, m_bodyScreenY, m_bodyDepth);
+    view.project(state.x.constData(), state.y.constData(), state.z.constData(), bodyCount,
+                 m_bodyScreenX.data(), m_bodyScreenY.data(), m_bodyDepth.data());
+
+    m_bodyDepthOrder.resize(bodyCount);
+    for (int index = 0; index < bodyCount; ++index) {
+        m_bodyDepthOrder[index] = index;
+    }
+    const double* const depth = m_bodyDepth.constData();
+    std::sort(m_bodyDepthOrder.begin(), m_bodyDepthOrder.end(), [depth](const int left, const int right) {
+        return depth[left] < depth[right];
+    });
+}
+
+int OrbitScene3D::orbitCount() const {
+    return m_orbitBodyIndex.size();
+}
+
+int OrbitScene3D::orbitBodyIndex(const int orbit) const {
+    return m_orbitBodyIndex.at(orbit);
+}
+
+const double* OrbitScene3D::orbitScreenX(const int orbit) const {
+    return m_screenX.constData() + orbit * kPointsPerOrbit;
+}
+
+const double* OrbitScene3D::orbitScreenY(const int orbit) const {
+    return m_screenY.constData() + orbit * kPointsPerOrbit;
+}
+
+const QVector<double>& OrbitScene3D::bodyScreenX() const {
+    return m_bodyScreenX;
+}
+
+const QVector<double>& OrbitScene3D::bodyScreenY() const {
+    return m_bodyScreenY;
+}
+
+const QVector<double>& OrbitScene3D::bodyDepth() const {
+    return m_bodyDepth;
+}
+
+const QVector<int>& OrbitScene3D::bodyDepthOrder() const {
+    return m_bodyDepthOrder;
+}
+
+double OrbitScene3D::extentAu() const {
+    return m_extentAu;
+}
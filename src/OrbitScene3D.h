@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QVector>
+
+#include "KeplerEphemeris.h"
+
+// Ортографическая проекция опорных осей на экран: поворот вокруг нормали опорной плоскости
+// на yawRad, затем наклон плоскости от зрителя на pitchRad (0 — вид сверху, как на плоской
+// схеме; π/2 — с ребра, высота над плоскостью идёт вверх экрана). Третья ось после поворота —
+// глубина: чем больше, тем ближе к зрителю.
+struct ViewProjection3D {
+    double yawRad = 0.0;
+    double pitchRad = 0.0;
+    double pxPerAu = 1.0;
+    double originX = 0.0;
+    double originY = 0.0;
+
+    // count точек одним проходом без ветвлений: матрица поворота считается один раз на вызов.
+    void project(const double* x,
+                 const double* y,
+                 const double* z,
+                 int count,
+                 double* screenX,
+                 double* screenY,
+                 double* depth) const;
+};
+
+// Трёхмерная сцена системы в а.е.: ломаные орбит всех тел с известной полуосью и положения
+// тел, в плотных массивах. Форма орбит от момента не зависит и строится один раз на систему;
+// на новый момент ломаные только переносятся к родителям, на поворот вида — только
+// проецируются. Оба прохода — плоские циклы по всем точкам сцены сразу.
+class OrbitScene3D {
+public:
+    // Отрезков на оборот, равномерно по эксцентрической аномалии: у вытянутых орбит точки
+    // сами сгущаются к перицентру, где кривизна больше.
+    static constexpr int kSegmentsPerOrbit = 128;
+    static constexpr int kPointsPerOrbit = kSegmentsPerOrbit + 1;
+
+    void build(const KeplerEphemeris& ephemeris);
+    // Переносит ломаные к положениям родителей на момент state.
+    void place(const EphemerisState& state);
+    // Проецирует орбиты и тела state на экран.
+    void project(const ViewProjection3D& view, const EphemerisState& state);
+
+    int orbitCount() const;
+    int orbitBodyIndex(int orbit) const;
+    // Экранные точки орбиты после project(): kPointsPerOrbit штук, последняя совпадает с первой.
+    const double* orbitScreenX(int orbit) const;
+    const double* orbitScreenY(int orbit) const;
+    // Экранные положения и глубина тел по индексам BodyGraph после project().
+    const QVector<double>& bodyScreenX() const;
+    const QVector<double>& bodyScreenY() const;
+    const QVector<double>& bodyDepth() const;
+    // Индексы тел от дальних к ближним: в этом порядке тела рисуются поверх друг друга.
+    const QVector<int>& bodyDepthOrder() const;
+    // Наибольшее удаление точки орбиты или тела от начала координат после place(), а.е.
+    double extentAu() const;
+
+private:
+    QVector<int> m_orbitBodyIndex;
+    // Точки орбит подряд по kPointsPerOrbit: смещения от родителя и положения на момент place().
+    QVector<double> m_relativeX;
+    QVector<double> m_relativeY;
+    QVector<double> m_relativeZ;
+    QVector<double> m_x;
+    QVector<double> m_y;
+    QVector<double> m_z;
+    QVector<double> m_screenX;
+    QVector<double> m_screenY;
+    QVector<double> m_depth;
+    QVector<double> m_bodyScreenX;
+    QVector<double> m_bodyScreenY;
+    QVector<double> m_bodyDepth;
+    QVector<int> m_bodyDepthOrder;
+    double m_extentAu = 0.0;
+};
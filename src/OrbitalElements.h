@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QtGlobal>
+
+// Кеплеровы элементы орбиты тела относительно родителя в том виде, в каком их отдают
+// EDSM/Spansh/EDAstro (orbitalEccentricity, orbitalInclination, argOfPeriapsis, ascendingNode,
+// meanAnomaly, meanAnomalyDate, orbitalPeriod). Большая полуось хранится отдельно —
+// CelestialBody::semiMajorAxisAu, её читают и схема, и классификация.
+struct OrbitalElements {
+    double eccentricity = 0.0;
+    double inclinationDeg = 0.0;
+    double argOfPeriapsisDeg = 0.0;
+    double ascendingNodeDeg = 0.0;
+    double meanAnomalyDeg = 0.0;
+    // Момент, к которому относится meanAnomalyDeg: мс от эпохи Unix, UTC; 0 — неизвестен.
+    qint64 meanAnomalyEpochMs = 0;
+    // Сидерический период в земных сутках; 0 — неизвестен.
+    double orbitalPeriodDays = 0.0;
+
+    // Фаза известна: положение на орбите можно посчитать на любой момент.
+    bool hasPhase() const {
+        return orbitalPeriodDays > 0.0 && meanAnomalyEpochMs != 0;
+    }
+};
+
+Q_DECLARE_TYPEINFO(OrbitalElements, Q_PRIMITIVE_TYPE);
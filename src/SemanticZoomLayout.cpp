@@ -0,0 +1,171 @@
+#include "SemanticZoomLayout.h"
+
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Радиус, до которого раздвигается подсистема на экране, пикселей.
+constexpr double kTargetRadiusPx = 80.0;
+// Пока окружение подсистемы на экране меньше этого, спутники остаются слитыми с планетой
+// и масштаб для неё не считается вовсе.
+constexpr double kMinRoomPx = 24.0;
+// Корзины зума через восьмую долю октавы: на границе корзины подсистема меняет размер
+// не больше чем на 9%.
+constexpr double kBucketsPerOctave = 8.0;
+constexpr int kMaxCachedBuckets = 256;
+
+bool isSubsystemHost(const BodyGraph& graph, const QVector<BodyHot>& hotBodies, const int index) {
+    const BodyHot& body = hotBodies.at(index);
+    return (body.bodyClass == CelestialBody::BodyClass::Planet || body.hasFlag(BodyHot::PlanetTypeFlag))
+        && graph.childCount(index) > 0;
+}
+
+} // namespace
+
+void SemanticZoomLayout::reset(const BodyGraph& graph, const QVector<BodyHot>& hotBodies, const SystemLayout& baseLayout) {
+    m_subsystems.clear();
+    m_members.clear();
+    m_scalesByBucket.clear();
+    m_displayScale.fill(1.0, graph.size());
+    m_bodyCount = graph.size();
+    if (baseLayout.size() != graph.size()) {
+        return;
+    }
+
+    QVector<double> reachAu(graph.size(), 0.0);
+    QVector<int> stack;
+    for (int hostIndex = 0; hostIndex < graph.size(); ++hostIndex) {
+        if (!isSubsystemHost(graph, hotBodies, hostIndex) || !baseLayout.at(hostIndex).placed) {
+            continue;
+        }
+        // Планета внутри подсистемы другой планеты раздвигается вместе с ней.
+        bool nested = false;
+        for (int ancestor = graph.parentIndex.at(hostIndex); ancestor >= 0 && !nested;
+             ancestor = graph.parentIndex.at(ancestor)) {
+            nested = isSubsystemHost(graph, hotBodies, ancestor);
+        }
+        if (nested) {
+            continue;
+        }
+
+        Subsystem subsystem;
+        subsystem.hostIndex = hostIndex;
+        subsystem.firstMember = m_members.size();
+        reachAu[hostIndex] = 0.0;
+        stack.clear();
+        stack.push_back(hostIndex);
+        while (!stack.isEmpty()) {
+            const int parentIndex = stack.takeLast();
+            for (const int* child = graph.childrenBegin(parentIndex); child != graph.childrenEnd(parentIndex); ++child) {
+                if (!baseLayout.at(*child).placed) {
+                    continue;
+                }
+                reachAu[*child] = reachAu.at(parentIndex) + baseLayout.at(*child).orbitRadius;
+                subsystem.extentAu = qMax(subsystem.extentAu, reachAu.at(*child));
+                m_members.push_back(*child);
+                stack.push_back(*child);
+            }
+        }
+        subsystem.endMember = m_members.size();
+
+        // Зазор: до родителя и до ближайших по радиусу орбит соседей. Соседи на той же орбите
+        // (компонент двойной планеты) стоят напротив и зазор не сужают.
+        const double hostOrbitAu = baseLayout.at(hostIndex).orbitRadius;
+        const int parentIndex = graph.parentIndex.at(hostIndex);
+        subsystem.roomAu = hostOrbitAu > 0.0 ? 0.5 * hostOrbitAu : 0.25 * baseLayout.extentAu;
+        if (parentIndex >= 0 && hostOrbitAu > 0.0) {
+            for (const int* sibling = graph.childrenBegin(parentIndex); sibling != graph.childrenEnd(parentIndex); ++sibling) {
+                const double gapAu = std::abs(baseLayout.at(*sibling).orbitRadius - hostOrbitAu);
+                if (*sibling != hostIndex && baseLayout.at(*sibling).placed && gapAu > 1e-9 * hostOrbitAu) {
+                    subsystem.roomAu = qMin(subsystem.roomAu, 0.5 * gapAu);
+                }
+            }
+        }
+
+        // Подсистема, которая и так занимает весь зазор, в раздвигании не нуждается.
+        if (subsystem.extentAu > 0.0 && subsystem.roomAu > subsystem.extentAu) {
+            m_subsystems.push_back(subsystem);
+        } else {
+            m_members.resize(subsystem.firstMember);
+        }
+    }
+}
+
+int SemanticZoomLayout::bucketForPxPerAu(const double widgetPxPerAu) {
+    return static_cast<int>(std::floor(kBucketsPerOctave * std::log2(widgetPxPerAu)));
+}
+
+int SemanticZoomLayout::apply(const SystemLayout& layout,
+                              const double widgetPxPerAu,
+                              const QRectF& viewAu,
+                              SystemLayout& displayLayout) {
+    const int bodyCount = layout.size();
+    displayLayout.extentAu = layout.extentAu;
+    // Копия в существующий буфер: кадр не выделяет память.
+    displayLayout.bodies.resize(bodyCount);
+    std::copy(layout.bodies.constBegin(), layout.bodies.constEnd(), displayLayout.bodies.begin());
+    m_displayScale.fill(1.0, bodyCount);
+    if (m_subsystems.isEmpty() || widgetPxPerAu <= 0.0 || bodyCount != m_bodyCount) {
+        return 0;
+    }
+
+    const int bucket = bucketForPxPerAu(widgetPxPerAu);
+    if (!m_scalesByBucket.contains(bucket) && m_scalesByBucket.size() >= kMaxCachedBuckets) {
+        m_scalesByBucket.clear();
+    }
+    QVector<double>& scales = m_scalesByBucket[bucket];
+    if (scales.isEmpty()) {
+        scales.fill(-1.0, m_subsystems.size());
+    }
+    // Масштаб считается по нижней границе корзины: внутри неё подсистема на экране не меньше цели.
+    const double bucketPxPerAu = std::exp2(bucket / kBucketsPerOctave);
+
+    int computedCount = 0;
+    for (int ordinal = 0; ordinal < m_subsystems.size(); ++ordinal) {
+        const Subsystem& subsystem = m_subsystems.at(ordinal);
+        if (subsystem.roomAu * widgetPxPerAu < kMinRoomPx) {
+            continue;
+        }
+        const QPointF hostPosition = layout.at(subsystem.hostIndex).position;
+        if (hostPosition.x() + subsystem.roomAu < viewAu.left() || hostPosition.x() - subsystem.roomAu > viewAu.right()
+            || hostPosition.y() + subsystem.roomAu < viewAu.top() || hostPosition.y() - subsystem.roomAu > viewAu.bottom()) {
+            continue;
+        }
+
+        double scale = scales.at(ordinal);
+        if (scale < 0.0) {
+            scale = qBound(1.0, kTargetRadiusPx / (subsystem.extentAu * bucketPxPerAu), subsystem.roomAu / subsystem.extentAu);
+            scales[ordinal] = scale;
+            ++computedCount;
+        }
+        if (scale <= 1.0) {
+            continue;
+        }
+
+        // Смещения от хозяина растут в scale раз вместе с орбитами: спутники остаются на своих
+        // эллипсах, а сама планета — на месте.
+        for (int member = subsystem.firstMember; member < subsystem.endMember; ++member) {
+            const int index = m_members.at(member);
+            BodyLayout& bodyLayout = displayLayout.bodies[index];
+            bodyLayout.position = hostPosition + (layout.at(index).position - hostPosition) * scale;
+            bodyLayout.orbitRadius *= scale;
+            m_displayScale[index] = scale;
+        }
+    }
+    return computedCount;
+}
+
+double SemanticZoomLayout::displayScale(const int index) const {
+    return index >= 0 && index < m_displayScale.size() ? m_displayScale.at(index) : 1.0;
+}
+
+int SemanticZoomLayout::subsystemCount() const {
+    return m_subsystems.size();
+}
+
+int SemanticZoomLayout::cachedBucketCount() const {
+    return m_scalesByBucket.size();
+}
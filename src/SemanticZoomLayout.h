@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QHash>
+#include <QRectF>
+#include <QVector>
+
+#include "BodyGraph.h"
+#include "BodyRecords.h"
+#include "SystemLayoutEngine.h"
+
+// Семантический зум схемы: подсистема спутников каждой планеты получает свой локальный масштаб.
+// В настоящем масштабе луны сливаются с планетой, пока зум не вырастет в сотни раз, а тогда
+// остальная система уже за краем окна. Здесь подсистема, чьё окружение на экране стало
+// заметным, раздвигается до kTargetRadiusPx, но не дальше половины зазора до соседних орбит.
+// Масштаб считается лениво — только для подсистем в окне и только когда их окружение крупнее
+// порога — и кэшируется по корзинам зума; остальные тела копируются как есть.
+class SemanticZoomLayout {
+public:
+    // Подсистемы и их зазоры по раскладке на момент загрузки; вызывается при смене системы.
+    void reset(const BodyGraph& graph, const QVector<BodyHot>& hotBodies, const SystemLayout& baseLayout);
+
+    // displayLayout — копия layout, где видимые подсистемы раздвинуты под зум widgetPxPerAu
+    // (экранных пикселей на а.е.); viewAu — окно в а.е. Возвращает число подсистем, чей
+    // масштаб посчитан впервые для этой корзины зума.
+    int apply(const SystemLayout& layout, double widgetPxPerAu, const QRectF& viewAu, SystemLayout& displayLayout);
+
+    // Во сколько раз смещение тела index от хозяина подсистемы увеличено в последнем
+    // displayLayout; 1 — тело в настоящем масштабе.
+    double displayScale(int index) const;
+    int subsystemCount() const;
+    int cachedBucketCount() const;
+
+private:
+    struct Subsystem {
+        int hostIndex = -1;
+        // Члены подсистемы — срез m_members [firstMember, endMember).
+        int firstMember = 0;
+        int endMember = 0;
+        // Наибольшее удаление спутника от хозяина: сумма радиусов орбит по цепочке родителей.
+        double extentAu = 0.0;
+        // Половина зазора до орбит соседей и до родителя: дальше подсистема не раздвигается.
+        double roomAu = 0.0;
+    };
+
+    static int bucketForPxPerAu(double widgetPxPerAu);
+
+    int m_bodyCount = 0;
+    QVector<Subsystem> m_subsystems;
+    QVector<int> m_members;
+    QVector<double> m_displayScale;
+    // Масштаб подсистем по корзинам зума, по порядку m_subsystems; < 0 — ещё не считался.
+    QHash<int, QVector<double>> m_scalesByBucket;
+};
@@ -0,0 +1,120 @@
+#include "SystemArchitecture.h"
+
+#include <algorithm>
+
+namespace {
+
+// Метка тела: класс (S звезда, P планета, M спутник, B барицентр, U прочее) с префиксом "~",
+// если тело обращается вокруг барицентра. Виртуальный корень — "*".
+QByteArray nodeLabel(const BodyHot& body) {
+    if (body.hasFlag(BodyHot::VirtualRootFlag)) {
+        return QByteArrayLiteral("*");
+    }
+
+    // Класс из парсера главнее флагов таксономии; флаги — только для тел неизвестного класса.
+    char bodyClass = 'U';
+    switch (body.bodyClass) {
+    case CelestialBody::BodyClass::Star:
+        bodyClass = 'S';
+        break;
+    case CelestialBody::BodyClass::Planet:
+        bodyClass = 'P';
+        break;
+    case CelestialBody::BodyClass::Moon:
+        bodyClass = 'M';
+        break;
+    case CelestialBody::BodyClass::Barycenter:
+        bodyClass = 'B';
+        break;
+    case CelestialBody::BodyClass::Unknown:
+        if (body.hasFlag(BodyHot::BarycenterTypeFlag)) {
+            bodyClass = 'B';
+        } else if (body.hasFlag(BodyHot::StarTypeFlag)) {
+            bodyClass = 'S';
+        } else if (body.hasFlag(BodyHot::MoonTypeFlag)) {
+            bodyClass = 'M';
+        } else if (body.hasFlag(BodyHot::PlanetTypeFlag)) {
+            bodyClass = 'P';
+        }
+        break;
+    }
+
+    QByteArray label;
+    if (body.hasFlag(BodyHot::OrbitsBarycenterFlag)) {
+        label.append('~');
+    }
+    label.append(bodyClass);
+    return label;
+}
+
+QByteArray joinSorted(QVector<QByteArray>* codes) {
+    std::sort(codes->begin(), codes->end());
+    QByteArray joined;
+    for (const QByteArray& code : *codes) {
+        if (!joined.isEmpty()) {
+            joined.append(',');
+        }
+        joined.append(code);
+    }
+    return joined;
+}
+
+} // namespace
+
+SystemArchitectureSignature SystemArchitecture::compute(const BodyGraph& graph, const QVector<BodyHot>& hotBodies) {
+    SystemArchitectureSignature signature;
+    const int bodyCount = graph.size();
+    if (bodyCount == 0 || hotBodies.size() != bodyCount) {
+        return signature;
+    }
+
+    // Прямой обход от корней даёт порядок, в котором родитель стоит раньше детей;
+    // обратный проход по нему — снизу вверх. Тела вне деревьев корней (после ремонта
+    // иерархии таких нет) в форму не попадают.
+    QVector<int> order;
+    order.reserve(bodyCount);
+    QVector<int> stack(graph.rootIndices);
+    while (!stack.isEmpty()) {
+        const int index = stack.takeLast();
+        order.push_back(index);
+        for (const int* child = graph.childrenBegin(index); child != graph.childrenEnd(index); ++child) {
+            stack.push_back(*child);
+        }
+    }
+
+    QVector<QByteArray> codes(bodyCount);
+    QVector<QByteArray> childCodes;
+    for (int position = order.size() - 1; position >= 0; --position) {
+        const int index = order.at(position);
+        QByteArray code = nodeLabel(hotBodies.at(index));
+        if (graph.childCount(index) > 0) {
+            childCodes.clear();
+            for (const int* child = graph.childrenBegin(index); child != graph.childrenEnd(index); ++child) {
+                // Код ребёнка больше не нужен — забираем без копирования.
+                childCodes.push_back(std::move(codes[*child]));
+            }
+            code.append('(');
+            code.append(joinSorted(&childCodes));
+            code.append(')');
+        }
+        codes[index] = std::move(code);
+    }
+
+    QVector<QByteArray> rootCodes;
+    rootCodes.reserve(graph.rootIndices.size());
+    for (const int rootIndex : graph.rootIndices) {
+        rootCodes.push_back(std::move(codes[rootIndex]));
+    }
+    signature.canonicalForm = joinSorted(&rootCodes);
+    signature.hash = hash(signature.canonicalForm);
+    return signature;
+}
+
+quint64 SystemArchitecture::hash(const QByteArray& canonicalForm) {
+    quint64 value = 14695981039346656037ULL;
+    for (const char byte : canonicalForm) {
+        value ^= static_cast<quint8>(byte);
+        value *= 1099511628211ULL;
+    }
+    return value;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+
+#include "BodyGraph.h"
+#include "BodyRecords.h"
+
+// Каноническая форма иерархии системы без имён, id и физики: только класс каждого тела,
+// тип связи с родителем и форма дерева. Одинаково устроенные системы дают одну и ту же
+// строку независимо от порядка и нумерации тел, например "B(~S,~S(P(M),P))".
+struct SystemArchitectureSignature {
+    QByteArray canonicalForm;
+    // FNV-1a от canonicalForm: стабилен между запусками, подходит для индекса в корпусе.
+    quint64 hash = 0;
+
+    bool isEmpty() const {
+        return canonicalForm.isEmpty();
+    }
+};
+
+class SystemArchitecture {
+public:
+    // Канонизация AHU: метки детей сортируются и вкладываются в метку родителя снизу вверх,
+    // каждое тело обрабатывается один раз. Несколько корней — лес, корни тоже сортируются.
+    static SystemArchitectureSignature compute(const BodyGraph& graph, const QVector<BodyHot>& hotBodies);
+    static quint64 hash(const QByteArray& canonicalForm);
+};
@@ -0,0 +1,1363 @@
+#include "SystemCorpusDatabase.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QVariant>
+
+#include <iterator>
+#include <limits>
+
+#include "BodyComposition.h"
+#include "CorpusStatistics.h"
+#include "SystemArchitecture.h"
+#include "SystemFingerprint.h"
+#include "SystemId64.h"
+
+namespace {
+
+constexpr auto kSqlDriver = "QSQLITE";
+
+// Версия схемы хранится в PRAGMA user_version. Базовая схема (версия 1) создаётся
+// идемпотентно, последующие версии — миграции поверх неё. Родитель тела хранится в самой
+// строке тела (parent_id + тип связи), поэтому цепочку до корня можно восстановить одним запросом.
+constexpr int kSchemaVersion = 7;
+
+const char* const kBaseSchemaStatements[] = {
+    "CREATE TABLE IF NOT EXISTS systems ("
+    " system_key INTEGER PRIMARY KEY AUTOINCREMENT,"
+    " name TEXT NOT NULL,"
+    " name_key TEXT NOT NULL UNIQUE,"
+    " id64 INTEGER,"
+    " body_count INTEGER NOT NULL DEFAULT 0,"
+    " updated_at TEXT NOT NULL)",
+    "CREATE INDEX IF NOT EXISTS idx_systems_id64 ON systems(id64)",
+    "CREATE TABLE IF NOT EXISTS bodies ("
+    " system_key INTEGER NOT NULL REFERENCES systems(system_key) ON DELETE CASCADE,"
+    " body_id INTEGER NOT NULL,"
+    " parent_id INTEGER,"
+    " parent_relation TEXT,"
+    " name TEXT,"
+    " type TEXT,"
+    " body_class INTEGER NOT NULL,"
+    " star_class INTEGER NOT NULL,"
+    " planet_subtype INTEGER NOT NULL,"
+    " distance_ls REAL,"
+    " semi_major_axis_au REAL,"
+    " radius_km REAL,"
+    " gravity_g REAL,"
+    " temperature_k REAL,"
+    " pressure_atm REAL,"
+    " mass_earth REAL,"
+    " mass_solar REAL,"
+    " rotation_days REAL,"
+    " axial_tilt_deg REAL,"
+    " tidally_locked INTEGER NOT NULL DEFAULT 0,"
+    " atmosphere TEXT,"
+    " volcanism TEXT,"
+    " terraforming_state TEXT,"
+    " terraformable INTEGER NOT NULL DEFAULT 0,"
+    " PRIMARY KEY (system_key, body_id))",
+    "CREATE INDEX IF NOT EXISTS idx_bodies_planet_subtype ON bodies(planet_subtype)",
+    "CREATE INDEX IF NOT EXISTS idx_bodies_star_class ON bodies(star_class)",
+    "CREATE INDEX IF NOT EXISTS idx_bodies_terraforming_state ON bodies(terraforming_state)",
+    "CREATE INDEX IF NOT EXISTS idx_bodies_terraformable ON bodies(terraformable, planet_subtype, gravity_g)",
+    "CREATE INDEX IF NOT EXISTS idx_bodies_gravity ON bodies(gravity_g)",
+    "CREATE INDEX IF NOT EXISTS idx_bodies_temperature ON bodies(temperature_k)",
+};
+
+// Версия 2: галактические координаты системы (coord_x/y/z EDAstro) и расстояние до Sol.
+const char* const kCoordinatesMigrationStatements[] = {
+    "ALTER TABLE systems ADD COLUMN coord_x REAL",
+    "ALTER TABLE systems ADD COLUMN coord_y REAL",
+    "ALTER TABLE systems ADD COLUMN coord_z REAL",
+    "ALTER TABLE systems ADD COLUMN sol_dist REAL",
+    "CREATE INDEX IF NOT EXISTS idx_systems_sol_dist ON systems(sol_dist)",
+};
+
+// Версия 3: составы атмосферы (kind = 0) и материалов (kind = 1). name_key — имя в нижнем
+// регистре без пробелов, чтобы "Carbon dioxide" (Spansh) и "CarbonDioxide" (EDAstro) совпадали.
+const char* const kCompositionsMigrationStatements[] = {
+    "CREATE TABLE IF NOT EXISTS body_compositions ("
+    " system_key INTEGER NOT NULL,"
+    " body_id INTEGER NOT NULL,"
+    " kind INTEGER NOT NULL,"
+    " name TEXT NOT NULL,"
+    " name_key TEXT NOT NULL,"
+    " percent REAL NOT NULL,"
+    " FOREIGN KEY (system_key, body_id) REFERENCES bodies(system_key, body_id) ON DELETE CASCADE)",
+    "CREATE INDEX IF NOT EXISTS idx_body_compositions_body ON body_compositions(system_key, body_id, kind)",
+    "CREATE INDEX IF NOT EXISTS idx_body_compositions_name ON body_compositions(kind, name_key, percent)",
+};
+
+// Версия 4: каноническая форма иерархии (SystemArchitecture) и её хеш. Системы, сохранённые
+// до миграции, получают значения при следующей записи.
+const char* const kArchitectureMigrationStatements[] = {
+    "ALTER TABLE systems ADD COLUMN architecture TEXT",
+    "ALTER TABLE systems ADD COLUMN architecture_hash INTEGER",
+    "CREATE INDEX IF NOT EXISTS idx_systems_architecture_hash ON systems(architecture_hash)",
+};
+
+// Версия 5: отпечаток системы (SystemFingerprint) — kDimensions float для поиска похожих.
+const char* const kFingerprintMigrationStatements[] = {
+    "ALTER TABLE systems ADD COLUMN fingerprint BLOB",
+};
+
+// Версия 6: метки OrbitClassifier битовыми масками (BodyOrbitTypes у тела, SystemOrbitTypes
+// у системы). Запрос по метке — (orbit_types & mask) = mask; меток мало, поэтому без индекса.
+const char* const kOrbitTypesMigrationStatements[] = {
+    "ALTER TABLE bodies ADD COLUMN orbit_types INTEGER NOT NULL DEFAULT 0",
+    "ALTER TABLE systems ADD COLUMN orbit_types INTEGER NOT NULL DEFAULT 0",
+};
+
+// Версия 7: класс звезды-хозяина тела и сводка CorpusStatistics. Строки corpus_stats
+// поддерживает storeSystem; при миграции класс хозяина заполняется у уже сохранённых тел
+// (backfillHostStarClasses), после чего сводка один раз пересчитывается по всем системам.
+const char* const kStatisticsMigrationStatements[] = {
+    "ALTER TABLE bodies ADD COLUMN host_star_class INTEGER NOT NULL DEFAULT 0",
+    "CREATE TABLE IF NOT EXISTS corpus_stats ("
+    " kind INTEGER NOT NULL,"
+    " region INTEGER NOT NULL,"
+    " item_key INTEGER NOT NULL,"
+    " item_count INTEGER NOT NULL,"
+    " PRIMARY KEY (kind, region, item_key)) WITHOUT ROWID",
+};
+
+enum CompositionKind {
+    AtmosphereKind = 0,
+    MaterialKind = 1
+};
+
+// Общий список столбцов для CorpusBodyRecord (см. readBodyRecord).
+constexpr auto kBodyRecordColumns =
+    "s.id64, s.name, b.body_id, b.parent_id, b.name, b.type, b.body_class, b.star_class,"
+    " b.planet_subtype, b.distance_ls, b.gravity_g, b.temperature_k, b.pressure_atm, b.mass_earth,"
+    " b.terraforming_state, b.rowid";
+
+QString systemKeyFor(const QString& systemName) {
+    return systemName.trimmed().toLower();
+}
+
+QVariant nullableDouble(const double value) {
+    return value > 0.0 ? QVariant(value) : QVariant(QVariant::Double);
+}
+
+QVariant nullableText(const QString& value) {
+    return value.isEmpty() ? QVariant(QVariant::String) : QVariant(value);
+}
+
+CorpusBodyRecord readBodyRecord(const QSqlQuery& query) {
+    CorpusBodyRecord record;
+    record.systemId64 = query.value(0).toULongLong();
+    record.systemName = query.value(1).toString();
+    record.bodyId = query.value(2).toInt();
+    record.parentId = query.value(3).isNull() ? -1 : query.value(3).toInt();
+    record.name = query.value(4).toString();
+    record.type = query.value(5).toString();
+    record.bodyClass = static_cast<CelestialBody::BodyClass>(query.value(6).toInt());
+    record.starClass = static_cast<StarClass>(query.value(7).toInt());
+    record.planetSubtype = static_cast<PlanetSubtype>(query.value(8).toInt());
+    record.distanceToArrivalLs = query.value(9).toDouble();
+    record.gravityG = query.value(10).toDouble();
+    record.surfaceTemperatureK = query.value(11).toDouble();
+    record.atmospherePressureAtm = query.value(12).toDouble();
+    record.massEarth = query.value(13).toDouble();
+    record.terraformingState = query.value(14).toString();
+    record.rowId = query.value(15).toLongLong();
+    return record;
+}
+
+// Раскладывает записи body_compositions тел выборки по столбцам слотов; строки без записей
+// остаются нулевыми. bodyCondition — то же условие WHERE по bodies b, что у основной выборки.
+bool loadCompositionColumns(QSqlQuery& query,
+                            const QString& bodyCondition,
+                            const QHash<qint64, int>& rowByRowId,
+                            AtmosphereColumns* atmosphere,
+                            MaterialColumns* materials) {
+    atmosphere->resize(rowByRowId.size());
+    materials->resize(rowByRowId.size());
+    const bool loaded = query.exec(QStringLiteral(
+        "SELECT b.rowid, c.kind, c.name_key, c.percent FROM body_compositions c"
+        " JOIN bodies b ON b.system_key = c.system_key AND b.body_id = c.body_id %1").arg(bodyCondition));
+    if (!loaded) {
+        return false;
+    }
+
+    while (query.next()) {
+        const auto rowIt = rowByRowId.constFind(query.value(0).toLongLong());
+        if (rowIt == rowByRowId.constEnd()) {
+            continue;
+        }
+
+        const QString nameKey = query.value(2).toString();
+        const float percent = query.value(3).toFloat();
+        if (query.value(1).toInt() == AtmosphereKind) {
+            if (const auto gas = BodyComposition::slotFromName<AtmosphereGas>(nameKey)) {
+                atmosphere->setValue(rowIt.value(), *gas, percent);
+            }
+        } else if (const auto material = BodyComposition::slotFromName<RawMaterial>(nameKey)) {
+            materials->setValue(rowIt.value(), *material, percent);
+        }
+    }
+    return true;
+}
+
+// NULL в корпусе — "нет данных" (см. nullableDouble).
+float floatOr(const QVariant& value, const float missing) {
+    return value.isNull() ? missing : value.toFloat();
+}
+
+bool isStarBody(const BodyHot& body) {
+    return body.bodyClass == CelestialBody::BodyClass::Star || body.hasFlag(BodyHot::StarTypeFlag);
+}
+
+bool isBarycenterBody(const BodyHot& body) {
+    return body.bodyClass == CelestialBody::BodyClass::Barycenter || body.hasFlag(BodyHot::BarycenterTypeFlag);
+}
+
+// Класс звезды, вокруг которой в итоге обращается тело, по индексам графа: у звезды — её класс,
+// у барицентра — класс главной звезды его поддерева (с наименьшим id), у остальных — как у родителя.
+QVector<StarClass> hostStarClasses(const BodyGraph& graph, const QVector<BodyHot>& hotBodies) {
+    const int bodyCount = graph.size();
+    QVector<StarClass> hosts(bodyCount, StarClass::Unknown);
+    QVector<int> order;
+    order.reserve(bodyCount);
+    QVector<int> stack(graph.rootIndices);
+    while (!stack.isEmpty()) {
+        const int index = stack.takeLast();
+        order.push_back(index);
+        for (const int* child = graph.childrenBegin(index); child != graph.childrenEnd(index); ++child) {
+            stack.push_back(*child);
+        }
+    }
+
+    // Снизу вверх: главная звезда поддерева. Индексы графа идут по возрастанию id.
+    QVector<int> primaryStar(bodyCount, -1);
+    for (int position = order.size() - 1; position >= 0; --position) {
+        const int index = order.at(position);
+        if (isStarBody(hotBodies.at(index))) {
+            primaryStar[index] = index;
+            continue;
+        }
+        for (const int* child = graph.childrenBegin(index); child != graph.childrenEnd(index); ++child) {
+            const int childStar = primaryStar.at(*child);
+            if (childStar >= 0 && (primaryStar.at(index) < 0 || childStar < primaryStar.at(index))) {
+                primaryStar[index] = childStar;
+            }
+        }
+    }
+
+    // Сверху вниз: родитель обработан раньше детей.
+    for (const int index : order) {
+        const BodyHot& body = hotBodies.at(index);
+        const int parentIndex = graph.parentIndex.at(index);
+        if (isStarBody(body)) {
+            hosts[index] = body.starClass;
+        } else if (isBarycenterBody(body) && primaryStar.at(index) >= 0) {
+            hosts[index] = hotBodies.at(primaryStar.at(index)).starClass;
+        } else if (parentIndex >= 0) {
+            hosts[index] = hosts.at(parentIndex);
+        }
+    }
+    return hosts;
+}
+
+// Заполняет host_star_class тел, записанных до версии 7: иерархия системы собирается заново
+// из сохранённых строк и проходит тот же hostStarClasses, что и при записи. Виртуальный корень
+// в bodies не хранится, поэтому отсутствующий родитель восстанавливается барицентром.
+bool backfillHostStarClasses(QSqlQuery& query) {
+    if (!query.exec(QStringLiteral("SELECT system_key, name FROM systems"))) {
+        return false;
+    }
+    QVector<QPair<qlonglong, QString>> systems;
+    while (query.next()) {
+        systems.push_back({query.value(0).toLongLong(), query.value(1).toString()});
+    }
+    query.finish();
+
+    for (const auto& system : systems) {
+        query.prepare(QStringLiteral("SELECT body_id, parent_id, parent_relation, name, type, body_class, star_class"
+                                     " FROM bodies WHERE system_key = ?"));
+        query.addBindValue(system.first);
+        if (!query.exec()) {
+            return false;
+        }
+
+        QVector<CelestialBody> bodies;
+        QSet<int> bodyIds;
+        while (query.next()) {
+            CelestialBody body;
+            body.id = query.value(0).toInt();
+            body.parentId = query.value(1).isNull() ? -1 : query.value(1).toInt();
+            body.parentRelationType = query.value(2).toString();
+            body.name = query.value(3).toString();
+            body.type = query.value(4).toString();
+            body.bodyClass = static_cast<CelestialBody::BodyClass>(query.value(5).toInt());
+            body.taxon = BodyTaxonomy::resolve(body.type);
+            body.taxon.starClass = static_cast<StarClass>(query.value(6).toInt());
+            bodyIds.insert(body.id);
+            bodies.push_back(body);
+        }
+        query.finish();
+
+        const int storedCount = bodies.size();
+        for (int index = 0; index < storedCount; ++index) {
+            const int parentId = bodies.at(index).parentId;
+            if (parentId < 0 || bodyIds.contains(parentId)) {
+                continue;
+            }
+            CelestialBody barycenter;
+            barycenter.id = parentId;
+            barycenter.type = parentId == kVirtualBarycenterRootId ? kVirtualBarycenterRootType : QStringLiteral("Barycentre");
+            barycenter.bodyClass = CelestialBody::BodyClass::Barycenter;
+            bodyIds.insert(parentId);
+            bodies.push_back(barycenter);
+        }
+
+        const SystemSnapshot snapshot = SystemSnapshot::build(system.second, bodies);
+        const QVector<BodyHot>& hotBodies = snapshot.hotBodies();
+        const QVector<StarClass> hosts = hostStarClasses(snapshot.graph(), hotBodies);
+        query.prepare(QStringLiteral("UPDATE bodies SET host_star_class = ? WHERE system_key = ? AND body_id = ?"));
+        for (int index = 0; index < hotBodies.size(); ++index) {
+            if (hosts.at(index) == StarClass::Unknown) {
+                continue;
+            }
+            query.addBindValue(static_cast<int>(hosts.at(index)));
+            query.addBindValue(system.first);
+            query.addBindValue(hotBodies.at(index).id);
+            if (!query.exec()) {
+                return false;
+            }
+        }
+        query.finish();
+    }
+    return true;
+}
+
+// Приращения corpus_stats по упакованному ключу (вид, регион, ключ).
+using StatisticDeltas = QHash<quint64, qint64>;
+
+quint64 packStatistic(const CorpusStatistics::Kind kind, const int region, const int key) {
+    return (static_cast<quint64>(kind) << 48) | (static_cast<quint64>(static_cast<quint32>(region)) << 16)
+         | static_cast<quint16>(key);
+}
+
+void addStatisticBits(StatisticDeltas* deltas,
+                      const CorpusStatistics::Kind kind,
+                      const int region,
+                      const int mask,
+                      const qint64 count) {
+    for (int bit = 0; bit < 16; ++bit) {
+        if ((mask & (1 << bit)) != 0) {
+            (*deltas)[packStatistic(kind, region, 1 << bit)] += count;
+        }
+    }
+}
+
+// Вклад системы в сводку, умноженный на sign: -1 перед перезаписью системы, +1 после.
+// Считается по строкам базы, поэтому старый и новый вклады заведомо согласованы.
+bool collectSystemStatistics(QSqlQuery& query, const qlonglong systemKey, const qint64 sign, StatisticDeltas* deltas) {
+    query.prepare(QStringLiteral("SELECT id64, coord_x, coord_y, coord_z, orbit_types FROM systems WHERE system_key = ?"));
+    query.addBindValue(systemKey);
+    if (!query.exec()) {
+        return false;
+    }
+    if (!query.next()) {
+        return true;
+    }
+
+    int region = CorpusStatistics::kUnknownRegion;
+    if (!query.value(1).isNull()) {
+        region = CorpusStatistics::regionOf(
+            GalacticCoordinates{query.value(1).toDouble(), query.value(2).toDouble(), query.value(3).toDouble()});
+    } else if (!query.value(0).isNull()) {
+        region = CorpusStatistics::regionOf(SystemId64::approximatePosition(query.value(0).toULongLong()));
+    }
+    (*deltas)[packStatistic(CorpusStatistics::Systems, region, 0)] += sign;
+    addStatisticBits(deltas, CorpusStatistics::SystemOrbitTypes, region, query.value(4).toInt(), sign);
+    query.finish();
+
+    query.prepare(QStringLiteral("SELECT planet_subtype, orbit_types, terraformable, host_star_class, COUNT(*) FROM bodies"
+                                 " WHERE system_key = ? GROUP BY planet_subtype, orbit_types, terraformable, host_star_class"));
+    query.addBindValue(systemKey);
+    if (!query.exec()) {
+        return false;
+    }
+    while (query.next()) {
+        const qint64 count = query.value(4).toLongLong() * sign;
+        const int subtype = query.value(0).toInt();
+        if (subtype != static_cast<int>(PlanetSubtype::Unknown)) {
+            (*deltas)[packStatistic(CorpusStatistics::PlanetSubtypes, region, subtype)] += count;
+        }
+        addStatisticBits(deltas, CorpusStatistics::BodyOrbitTypes, region, query.value(1).toInt(), count);
+        if (query.value(2).toInt() != 0) {
+            (*deltas)[packStatistic(CorpusStatistics::TerraformableByStarClass, region, query.value(3).toInt())] += count;
+        }
+    }
+    query.finish();
+    return true;
+}
+
+bool applyStatisticDeltas(QSqlQuery& query, const StatisticDeltas& deltas) {
+    for (auto it = deltas.constBegin(); it != deltas.constEnd(); ++it) {
+        if (it.value() == 0) {
+            continue;
+        }
+
+        const int kind = static_cast<int>(it.key() >> 48);
+        const int region = static_cast<int>(static_cast<quint32>(it.key() >> 16));
+        const int key = static_cast<int>(it.key() & 0xFFFF);
+        query.prepare(QStringLiteral("INSERT INTO corpus_stats (kind, region, item_key, item_count) VALUES (?, ?, ?, ?)"
+                                     " ON CONFLICT (kind, region, item_key)"
+                                     " DO UPDATE SET item_count = item_count + excluded.item_count"));
+        query.addBindValue(kind);
+        query.addBindValue(region);
+        query.addBindValue(key);
+        query.addBindValue(it.value());
+        if (!query.exec()) {
+            return false;
+        }
+        if (it.value() < 0) {
+            query.prepare(QStringLiteral("DELETE FROM corpus_stats"
+                                         " WHERE kind = ? AND region = ? AND item_key = ? AND item_count <= 0"));
+            query.addBindValue(kind);
+            query.addBindValue(region);
+            query.addBindValue(key);
+            if (!query.exec()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Полный пересчёт сводки по всем системам — при миграции и по запросу.
+bool rebuildStatisticRows(QSqlQuery& query) {
+    if (!query.exec(QStringLiteral("DELETE FROM corpus_stats"))
+        || !query.exec(QStringLiteral("SELECT system_key FROM systems"))) {
+        return false;
+    }
+    QVector<qlonglong> systemKeys;
+    while (query.next()) {
+        systemKeys.push_back(query.value(0).toLongLong());
+    }
+    query.finish();
+
+    StatisticDeltas deltas;
+    for (const qlonglong systemKey : systemKeys) {
+        if (!collectSystemStatistics(query, systemKey, 1, &deltas)) {
+            return false;
+        }
+    }
+    return applyStatisticDeltas(query, deltas);
+}
+
+// Строка «id64, coord_x, coord_y, coord_z» систем; без координат — центр бокселя из id64.
+GalacticPoint galacticPointFromRow(const QSqlQuery& query) {
+    GalacticPoint point;
+    point.systemId64 = query.value(0).toULongLong();
+    if (query.value(1).isNull()) {
+        // Источник не прислал координаты (EDSM/Spansh): центр бокселя из id64 точнее 640 св. лет по оси.
+        point.position = SystemId64::approximatePosition(point.systemId64);
+    } else {
+        point.position.x = query.value(1).toDouble();
+        point.position.y = query.value(2).toDouble();
+        point.position.z = query.value(3).toDouble();
+    }
+    return point;
+}
+
+} // namespace
+
+SystemCorpusDatabase::SystemCorpusDatabase()
+    : m_connectionName(QStringLiteral("SystemCorpus-%1").arg(reinterpret_cast<quintptr>(this), 0, 16)) {
+}
+
+SystemCorpusDatabase::~SystemCorpusDatabase() {
+    close();
+}
+
+QString SystemCorpusDatabase::defaultDatabasePath() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation))
+        .filePath(QStringLiteral("corpus.sqlite"));
+}
+
+bool SystemCorpusDatabase::open(const QString& path) {
+    close();
+
+    if (path != QLatin1String(kInMemoryPath)) {
+        const QFileInfo fileInfo(path);
+        if (!QDir().mkpath(fileInfo.absolutePath())) {
+            return fail(QStringLiteral("Не удалось создать каталог корпуса: %1").arg(fileInfo.absolutePath()));
+        }
+    }
+
+    if (!openConnection(path)) {
+        return false;
+    }
+
+    if (!ensureSchema()) {
+        close();
+        return false;
+    }
+
+    m_spatialIndex.build(systemPositions());
+    m_lastError.clear();
+    return true;
+}
+
+bool SystemCorpusDatabase::openForReading(const QString& path) {
+    close();
+
+    if (path == QLatin1String(kInMemoryPath)) {
+        return fail(QStringLiteral("Временную базу в памяти нельзя открыть вторым соединением."));
+    }
+    if (!openConnection(path)) {
+        return false;
+    }
+
+    m_lastError.clear();
+    return true;
+}
+
+bool SystemCorpusDatabase::openConnection(const QString& path) {
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QLatin1String(kSqlDriver), m_connectionName);
+        db.setDatabaseName(path);
+        if (!db.open()) {
+            const QString error = db.lastError().text();
+            db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(m_connectionName);
+            return fail(QStringLiteral("Не удалось открыть корпус %1: %2").arg(path, error));
+        }
+    }
+
+    m_path = path;
+    return true;
+}
+
+void SystemCorpusDatabase::close() {
+    m_spatialIndex.clear();
+    m_path.clear();
+    if (!QSqlDatabase::contains(m_connectionName)) {
+        return;
+    }
+
+    {
+        QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+QString SystemCorpusDatabase::path() const {
+    return m_path;
+}
+
+bool SystemCorpusDatabase::isInMemory() const {
+    return m_path == QLatin1String(kInMemoryPath);
+}
+
+bool SystemCorpusDatabase::beginRead() const {
+    return isOpen() && QSqlDatabase::database(m_connectionName, false).transaction();
+}
+
+void SystemCorpusDatabase::endRead() const {
+    if (isOpen()) {
+        QSqlDatabase::database(m_connectionName, false).commit();
+    }
+}
+
+bool SystemCorpusDatabase::isOpen() const {
+    return QSqlDatabase::contains(m_connectionName) && QSqlDatabase::database(m_connectionName, false).isOpen();
+}
+
+QString SystemCorpusDatabase::lastError() const {
+    return m_lastError;
+}
+
+bool SystemCorpusDatabase::ensureSchema() {
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+    QSqlQuery query(db);
+
+    // WAL + NORMAL: запись системы — одна транзакция, чтение из другого окна её не блокирует.
+    query.exec(QStringLiteral("PRAGMA journal_mode=WAL"));
+    query.exec(QStringLiteral("PRAGMA synchronous=NORMAL"));
+    query.exec(QStringLiteral("PRAGMA foreign_keys=ON"));
+
+    int version = 0;
+    if (query.exec(QStringLiteral("PRAGMA user_version")) && query.next()) {
+        version = query.value(0).toInt();
+    }
+    query.finish();
+    if (version >= kSchemaVersion) {
+        return true;
+    }
+
+    if (!db.transaction()) {
+        return fail(QStringLiteral("Не удалось начать миграцию корпуса: %1").arg(db.lastError().text()));
+    }
+
+    const auto applyStatements = [&query](const char* const* statements, const int count) {
+        for (int index = 0; index < count; ++index) {
+            if (!query.exec(QString::fromLatin1(statements[index]))) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    bool migrated = true;
+    if (version < 1) {
+        migrated = applyStatements(kBaseSchemaStatements, static_cast<int>(std::size(kBaseSchemaStatements)));
+    }
+    if (migrated && version < 2) {
+        migrated = applyStatements(kCoordinatesMigrationStatements,
+                                   static_cast<int>(std::size(kCoordinatesMigrationStatements)));
+    }
+    if (migrated && version < 3) {
+        migrated = applyStatements(kCompositionsMigrationStatements,
+                                   static_cast<int>(std::size(kCompositionsMigrationStatements)));
+    }
+    if (migrated && version < 4) {
+        migrated = applyStatements(kArchitectureMigrationStatements,
+                                   static_cast<int>(std::size(kArchitectureMigrationStatements)));
+    }
+    if (migrated && version < 5) {
+        migrated = applyStatements(kFingerprintMigrationStatements,
+                                   static_cast<int>(std::size(kFingerprintMigrationStatements)));
+    }
+    if (migrated && version < 6) {
+        migrated = applyStatements(kOrbitTypesMigrationStatements,
+                                   static_cast<int>(std::size(kOrbitTypesMigrationStatements)));
+    }
+    if (migrated && version < 7) {
+        migrated = applyStatements(kStatisticsMigrationStatements,
+                                   static_cast<int>(std::size(kStatisticsMigrationStatements)))
+                   && backfillHostStarClasses(query) && rebuildStatisticRows(query);
+    }
+    if (migrated) {
+        migrated = query.exec(QStringLiteral("PRAGMA user_version = %1").arg(kSchemaVersion));
+    }
+
+    if (!migrated) {
+        const QString error = query.lastError().text();
+        db.rollback();
+        return fail(QStringLiteral("Ошибка создания схемы корпуса: %1").arg(error));
+    }
+
+    if (!db.commit()) {
+        return fail(QStringLiteral("Не удалось зафиксировать схему корпуса: %1").arg(db.lastError().text()));
+    }
+
+    return true;
+}
+
+bool SystemCorpusDatabase::fail(const QString& message) const {
+    m_lastError = message;
+    return false;
+}
+
+bool SystemCorpusDatabase::storeSystem(const SystemSnapshot& snapshot,
+                                       const quint64 systemId64,
+                                       const std::optional<GalacticCoordinates>& coordinates) {
+    if (!isOpen()) {
+        return fail(QStringLiteral("Корпус не открыт."));
+    }
+
+    const QString nameKey = systemKeyFor(snapshot.systemName());
+    if (nameKey.isEmpty()) {
+        return fail(QStringLiteral("У системы нет имени, сохранить её в корпус нельзя."));
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+    if (!db.transaction()) {
+        return fail(QStringLiteral("Не удалось начать транзакцию: %1").arg(db.lastError().text()));
+    }
+
+    const auto rollbackWith = [this, &db](const QSqlQuery& failedQuery) {
+        const QString error = failedQuery.lastError().text();
+        db.rollback();
+        return fail(QStringLiteral("Ошибка записи системы в корпус: %1").arg(error));
+    };
+
+    const QVector<BodyHot>& hotBodies = snapshot.hotBodies();
+    const QVector<BodyCold>& coldBodies = snapshot.coldBodies();
+    const QString updatedAt = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    const SystemArchitectureSignature architecture = SystemArchitecture::compute(snapshot.graph(), hotBodies);
+    const QVariant architectureForm = architecture.isEmpty() ? QVariant(QVariant::String)
+                                                             : QVariant(QString::fromLatin1(architecture.canonicalForm));
+    const QVariant architectureHash = architecture.isEmpty() ? QVariant(QVariant::LongLong)
+                                                             : QVariant(static_cast<qint64>(architecture.hash));
+    const QByteArray fingerprint = SystemFingerprint::compute(snapshot).toBlob();
+    const OrbitClassificationResult& orbitClassification = snapshot.orbitClassification();
+    const int systemOrbitTypes = static_cast<int>(orbitClassification.systemTypes);
+    const QVector<StarClass> hostStars = hostStarClasses(snapshot.graph(), hotBodies);
+    StatisticDeltas statisticDeltas;
+    const QVariant id64Value = systemId64 != 0 ? QVariant(static_cast<qlonglong>(systemId64)) : QVariant(QVariant::LongLong);
+    const QVariant noCoordinate(QVariant::Double);
+    const QVariant coordX = coordinates ? QVariant(coordinates->x) : noCoordinate;
+    const QVariant coordY = coordinates ? QVariant(coordinates->y) : noCoordinate;
+    const QVariant coordZ = coordinates ? QVariant(coordinates->z) : noCoordinate;
+    const QVariant solDistance = coordinates ? QVariant(coordinates->distanceToSol()) : noCoordinate;
+
+    QSqlQuery query(db);
+    query.prepare(QStringLiteral("SELECT system_key FROM systems WHERE name_key = ?"));
+    query.addBindValue(nameKey);
+    if (!query.exec()) {
+        return rollbackWith(query);
+    }
+
+    qlonglong systemKey = -1;
+    if (query.next()) {
+        systemKey = query.value(0).toLongLong();
+        query.finish();
+
+        if (!collectSystemStatistics(query, systemKey, -1, &statisticDeltas)) {
+            return rollbackWith(query);
+        }
+
+        query.prepare(QStringLiteral("UPDATE systems SET name = ?, id64 = COALESCE(?, id64), coord_x = COALESCE(?, coord_x),"
+                                     " coord_y = COALESCE(?, coord_y), coord_z = COALESCE(?, coord_z),"
+                                     " sol_dist = COALESCE(?, sol_dist), body_count = ?, architecture = ?,"
+                                     " architecture_hash = ?, fingerprint = ?, orbit_types = ?, updated_at = ?"
+                                     " WHERE system_key = ?"));
+        query.addBindValue(snapshot.systemName());
+        query.addBindValue(id64Value);
+        query.addBindValue(coordX);
+        query.addBindValue(coordY);
+        query.addBindValue(coordZ);
+        query.addBindValue(solDistance);
+        query.addBindValue(snapshot.realBodyCount());
+        query.addBindValue(architectureForm);
+        query.addBindValue(architectureHash);
+        query.addBindValue(fingerprint);
+        query.addBindValue(systemOrbitTypes);
+        query.addBindValue(updatedAt);
+        query.addBindValue(systemKey);
+        if (!query.exec()) {
+            return rollbackWith(query);
+        }
+
+        for (const auto& statement : {QStringLiteral("DELETE FROM body_compositions WHERE system_key = ?"),
+                                      QStringLiteral("DELETE FROM bodies WHERE system_key = ?")}) {
+            query.prepare(statement);
+            query.addBindValue(systemKey);
+            if (!query.exec()) {
+                return rollbackWith(query);
+            }
+        }
+    } else {
+        query.finish();
+        query.prepare(QStringLiteral("INSERT INTO systems (name, name_key, id64, coord_x, coord_y, coord_z, sol_dist,"
+                                     " body_count, architecture, architecture_hash, fingerprint, orbit_types, updated_at)"
+                                     " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+        query.addBindValue(snapshot.systemName());
+        query.addBindValue(nameKey);
+        query.addBindValue(id64Value);
+        query.addBindValue(coordX);
+        query.addBindValue(coordY);
+        query.addBindValue(coordZ);
+        query.addBindValue(solDistance);
+        query.addBindValue(snapshot.realBodyCount());
+        query.addBindValue(architectureForm);
+        query.addBindValue(architectureHash);
+        query.addBindValue(fingerprint);
+        query.addBindValue(systemOrbitTypes);
+        query.addBindValue(updatedAt);
+        if (!query.exec()) {
+            return rollbackWith(query);
+        }
+        systemKey = query.lastInsertId().toLongLong();
+    }
+
+    // Один подготовленный запрос на все тела: SQLite компилирует его один раз.
+    QSqlQuery insertBody(db);
+    insertBody.prepare(QStringLiteral(
+        "INSERT INTO bodies (system_key, body_id, parent_id, parent_relation, name, type, body_class, star_class,"
+        " planet_subtype, distance_ls, semi_major_axis_au, radius_km, gravity_g, temperature_k, pressure_atm,"
+        " mass_earth, mass_solar, rotation_days, axial_tilt_deg, tidally_locked, atmosphere, volcanism,"
+        " terraforming_state, terraformable, orbit_types, host_star_class)"
+        " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+    QSqlQuery insertComposition(db);
+    insertComposition.prepare(QStringLiteral(
+        "INSERT INTO body_compositions (system_key, body_id, kind, name, name_key, percent) VALUES (?, ?, ?, ?, ?, ?)"));
+    const auto insertParts = [&insertComposition, systemKey](const int bodyId,
+                                                             const CompositionKind kind,
+                                                             const auto& composition) {
+        for (const auto slot : composition.presentSlots()) {
+            const QString name = BodyComposition::displayName(slot);
+            insertComposition.addBindValue(systemKey);
+            insertComposition.addBindValue(bodyId);
+            insertComposition.addBindValue(static_cast<int>(kind));
+            insertComposition.addBindValue(name);
+            insertComposition.addBindValue(BodyComposition::nameKey(name));
+            insertComposition.addBindValue(static_cast<double>(composition.value(slot)));
+            if (!insertComposition.exec()) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (int index = 0; index < hotBodies.size(); ++index) {
+        const BodyHot& hot = hotBodies.at(index);
+        if (hot.hasFlag(BodyHot::VirtualRootFlag)) {
+            continue;
+        }
+
+        const BodyCold& cold = coldBodies.at(index);
+        insertBody.addBindValue(systemKey);
+        insertBody.addBindValue(hot.id);
+        insertBody.addBindValue(hot.parentId >= 0 ? QVariant(hot.parentId) : QVariant(QVariant::Int));
+        insertBody.addBindValue(nullableText(cold.parentRelationType));
+        insertBody.addBindValue(cold.name);
+        insertBody.addBindValue(cold.type);
+        insertBody.addBindValue(static_cast<int>(hot.bodyClass));
+        insertBody.addBindValue(static_cast<int>(hot.starClass));
+        insertBody.addBindValue(static_cast<int>(hot.planetSubtype));
+        insertBody.addBindValue(nullableDouble(hot.distanceToArrivalLs));
+        insertBody.addBindValue(nullableDouble(hot.semiMajorAxisAu));
+        insertBody.addBindValue(nullableDouble(hot.physicalRadiusKm));
+        insertBody.addBindValue(nullableDouble(cold.surfaceGravityMs2 / kStandardGravityMs2));
+        insertBody.addBindValue(nullableDouble(cold.surfaceTemperatureK));
+        insertBody.addBindValue(nullableDouble(cold.atmospherePressureAtm));
+        insertBody.addBindValue(nullableDouble(cold.massEarth));
+        insertBody.addBindValue(nullableDouble(cold.massSolar));
+        insertBody.addBindValue(cold.rotationPeriodDays != 0.0 ? QVariant(cold.rotationPeriodDays) : QVariant(QVariant::Double));
+        insertBody.addBindValue(cold.axialTiltDeg);
+        insertBody.addBindValue(cold.isTidallyLocked ? 1 : 0);
+        insertBody.addBindValue(nullableText(cold.atmosphereSummary));
+        insertBody.addBindValue(nullableText(cold.volcanism));
+        insertBody.addBindValue(nullableText(cold.terraformingState));
+        insertBody.addBindValue(isTerraformableState(cold.terraformingState) ? 1 : 0);
+        insertBody.addBindValue(static_cast<int>(orbitClassification.typesAt(index)));
+        insertBody.addBindValue(static_cast<int>(hostStars.at(index)));
+        if (!insertBody.exec()) {
+            return rollbackWith(insertBody);
+        }
+        if (!insertParts(hot.id, AtmosphereKind, cold.atmoComposition)
+            || !insertParts(hot.id, MaterialKind, cold.materials)) {
+            return rollbackWith(insertComposition);
+        }
+    }
+
+    // Сводка меняется на разницу вкладов: у неизменной системы приращения взаимно гасятся.
+    if (!collectSystemStatistics(query, systemKey, 1, &statisticDeltas)
+        || !applyStatisticDeltas(query, statisticDeltas)) {
+        return rollbackWith(query);
+    }
+
+    if (!db.commit()) {
+        const QString error = db.lastError().text();
+        db.rollback();
+        return fail(QStringLiteral("Не удалось зафиксировать транзакцию: %1").arg(error));
+    }
+
+    updateSpatialIndex(systemKey);
+    return true;
+}
+
+int SystemCorpusDatabase::systemCount() const {
+    if (!isOpen()) {
+        return 0;
+    }
+
+    QSqlQuery query(QStringLiteral("SELECT COUNT(*) FROM systems"), QSqlDatabase::database(m_connectionName, false));
+    return query.next() ? query.value(0).toInt() : 0;
+}
+
+int SystemCorpusDatabase::bodyCount() const {
+    if (!isOpen()) {
+        return 0;
+    }
+
+    QSqlQuery query(QStringLiteral("SELECT COUNT(*) FROM bodies"), QSqlDatabase::database(m_connectionName, false));
+    return query.next() ? query.value(0).toInt() : 0;
+}
+
+QVector<GalacticPoint> SystemCorpusDatabase::systemPositions() const {
+    QVector<GalacticPoint> points;
+    if (!isOpen()) {
+        return points;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("SELECT id64, coord_x, coord_y, coord_z FROM systems WHERE id64 IS NOT NULL"))) {
+        fail(QStringLiteral("Ошибка чтения координат корпуса: %1").arg(query.lastError().text()));
+        return points;
+    }
+
+    while (query.next()) {
+        points.push_back(galacticPointFromRow(query));
+    }
+
+    return points;
+}
+
+const GalacticSpatialIndex& SystemCorpusDatabase::spatialIndex() const {
+    return m_spatialIndex;
+}
+
+void SystemCorpusDatabase::updateSpatialIndex(const qlonglong systemKey) {
+    // Координаты и id64 берутся из записанной строки: пустые аргументы storeSystem их не затирают.
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.prepare(QStringLiteral("SELECT id64, coord_x, coord_y, coord_z FROM systems"
+                                 " WHERE system_key = ? AND id64 IS NOT NULL"));
+    query.addBindValue(systemKey);
+    if (query.exec() && query.next()) {
+        m_spatialIndex.insert(galacticPointFromRow(query));
+    }
+}
+
+QVector<CorpusBodyRecord> SystemCorpusDatabase::findBodies(const CorpusBodyQuery& filter) const {
+    QVector<CorpusBodyRecord> records;
+    if (!isOpen()) {
+        fail(QStringLiteral("Корпус не открыт."));
+        return records;
+    }
+
+    QStringList conditions;
+    QVariantList bindValues;
+    if (filter.planetSubtype) {
+        conditions.push_back(QStringLiteral("b.planet_subtype = ?"));
+        bindValues.push_back(static_cast<int>(*filter.planetSubtype));
+    }
+    if (filter.starClass) {
+        conditions.push_back(QStringLiteral("b.star_class = ?"));
+        bindValues.push_back(static_cast<int>(*filter.starClass));
+    }
+    if (filter.terraformableOnly) {
+        conditions.push_back(QStringLiteral("b.terraformable = 1"));
+    }
+    if (filter.minGravityG) {
+        conditions.push_back(QStringLiteral("b.gravity_g >= ?"));
+        bindValues.push_back(*filter.minGravityG);
+    }
+    if (filter.maxGravityG) {
+        conditions.push_back(QStringLiteral("b.gravity_g <= ?"));
+        bindValues.push_back(*filter.maxGravityG);
+    }
+    if (filter.minTemperatureK) {
+        conditions.push_back(QStringLiteral("b.temperature_k >= ?"));
+        bindValues.push_back(*filter.minTemperatureK);
+    }
+    if (filter.maxTemperatureK) {
+        conditions.push_back(QStringLiteral("b.temperature_k <= ?"));
+        bindValues.push_back(*filter.maxTemperatureK);
+    }
+    if (filter.orbitTypes) {
+        conditions.push_back(QStringLiteral("(b.orbit_types & ?) = ?"));
+        bindValues.push_back(static_cast<int>(filter.orbitTypes));
+        bindValues.push_back(static_cast<int>(filter.orbitTypes));
+    }
+    if (!filter.systemName.trimmed().isEmpty()) {
+        conditions.push_back(QStringLiteral("s.name_key = ?"));
+        bindValues.push_back(systemKeyFor(filter.systemName));
+    }
+
+    QString sql = QStringLiteral("SELECT %1 FROM bodies b JOIN systems s ON s.system_key = b.system_key")
+                      .arg(QLatin1String(kBodyRecordColumns));
+    if (!conditions.isEmpty()) {
+        sql += QStringLiteral(" WHERE ") + conditions.join(QStringLiteral(" AND "));
+    }
+    sql += QStringLiteral(" ORDER BY s.name, b.body_id LIMIT ?");
+    bindValues.push_back(qMax(0, filter.limit));
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    for (const QVariant& value : bindValues) {
+        query.addBindValue(value);
+    }
+
+    if (!query.exec()) {
+        fail(QStringLiteral("Ошибка поиска по корпусу: %1").arg(query.lastError().text()));
+        return records;
+    }
+
+    while (query.next()) {
+        records.push_back(readBodyRecord(query));
+    }
+
+    return records;
+}
+
+std::optional<GalacticCoordinates> SystemCorpusDatabase::systemCoordinates(const QString& systemName) const {
+    if (!isOpen()) {
+        return std::nullopt;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.prepare(QStringLiteral("SELECT id64, coord_x, coord_y, coord_z FROM systems WHERE name_key = ?"));
+    query.addBindValue(systemKeyFor(systemName));
+    if (!query.exec() || !query.next()) {
+        return std::nullopt;
+    }
+
+    if (!query.value(1).isNull()) {
+        return GalacticCoordinates{query.value(1).toDouble(), query.value(2).toDouble(), query.value(3).toDouble()};
+    }
+    if (!query.value(0).isNull()) {
+        return SystemId64::approximatePosition(query.value(0).toULongLong());
+    }
+    return std::nullopt;
+}
+
+TerraformingColumns SystemCorpusDatabase::loadScoringColumns() const {
+    TerraformingColumns columns;
+    if (!isOpen()) {
+        return columns;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    if (query.exec(QStringLiteral("SELECT COUNT(*) FROM bodies WHERE planet_subtype <> 0")) && query.next()) {
+        columns.reserve(query.value(0).toInt());
+    }
+
+    // Только планеты и спутники с известным подтипом: звёзды и барицентры не терраформируются.
+    const bool loaded = query.exec(QStringLiteral(
+        "SELECT b.rowid, s.id64, b.terraformable, b.gravity_g, b.temperature_k, b.pressure_atm, b.mass_earth,"
+        " b.distance_ls"
+        " FROM bodies b JOIN systems s ON s.system_key = b.system_key"
+        " WHERE b.planet_subtype <> 0 ORDER BY b.rowid"));
+    if (!loaded) {
+        fail(QStringLiteral("Ошибка загрузки столбцов корпуса: %1").arg(query.lastError().text()));
+        return columns;
+    }
+
+    QHash<qint64, int> rowByRowId;
+    while (query.next()) {
+        const qint64 rowId = query.value(0).toLongLong();
+        rowByRowId.insert(rowId, columns.size());
+        columns.rowIds.push_back(rowId);
+        columns.systemId64.push_back(query.value(1).toULongLong());
+        columns.terraformable.push_back(query.value(2).toFloat());
+        columns.gravityG.push_back(query.value(3).toFloat());
+        columns.temperatureK.push_back(query.value(4).toFloat());
+        columns.pressureAtm.push_back(query.value(5).toFloat());
+        columns.massEarth.push_back(query.value(6).toFloat());
+        columns.distanceLs.push_back(query.value(7).toFloat());
+    }
+
+    if (!loadCompositionColumns(query,
+                                QStringLiteral("WHERE b.planet_subtype <> 0"),
+                                rowByRowId,
+                                &columns.atmosphere,
+                                &columns.materials)) {
+        fail(QStringLiteral("Ошибка загрузки составов корпуса: %1").arg(query.lastError().text()));
+        return TerraformingColumns();
+    }
+
+    const float* nitrogen = columns.atmosphere.column(AtmosphereGas::Nitrogen);
+    const float* oxygen = columns.atmosphere.column(AtmosphereGas::Oxygen);
+    columns.earthLikeAtmosphere.resize(columns.size());
+    for (int row = 0; row < columns.size(); ++row) {
+        columns.earthLikeAtmosphere[row] = qBound(0.0f, (nitrogen[row] + oxygen[row]) / 100.0f, 1.0f);
+    }
+
+    return columns;
+}
+
+BodyFilterColumns SystemCorpusDatabase::loadFilterColumns() const {
+    BodyFilterColumns columns;
+    if (!isOpen()) {
+        return columns;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    if (query.exec(QStringLiteral("SELECT COUNT(*) FROM bodies")) && query.next()) {
+        columns.reserve(query.value(0).toInt());
+    }
+
+    const bool loaded = query.exec(QStringLiteral(
+        "SELECT b.rowid, b.body_id, b.parent_id, b.distance_ls, b.semi_major_axis_au, b.radius_km, b.gravity_g,"
+        " b.temperature_k, b.pressure_atm, b.mass_earth, b.rotation_days, b.axial_tilt_deg, b.terraformable,"
+        " b.tidally_locked, b.body_class"
+        " FROM bodies b ORDER BY b.rowid"));
+    if (!loaded) {
+        fail(QStringLiteral("Ошибка загрузки столбцов фильтра: %1").arg(query.lastError().text()));
+        return columns;
+    }
+
+    // Те же соглашения, что у BodyFilterColumns::appendBody: неизвестные величины — NaN,
+    // нулевые расстояние и давление — настоящие нули.
+    const float missing = std::numeric_limits<float>::quiet_NaN();
+    const auto set = [&columns](const BodyFilterField field, const float value) {
+        columns.fields[static_cast<size_t>(field)].push_back(value);
+    };
+    const auto isClass = [](const QVariant& value, const CelestialBody::BodyClass bodyClass) {
+        return value.toInt() == static_cast<int>(bodyClass) ? 1.0f : 0.0f;
+    };
+
+    QHash<qint64, int> rowByRowId;
+    while (query.next()) {
+        const qint64 rowId = query.value(0).toLongLong();
+        rowByRowId.insert(rowId, columns.size());
+        columns.rowIds.push_back(rowId);
+        set(BodyFilterField::Id, query.value(1).toFloat());
+        set(BodyFilterField::ParentId, floatOr(query.value(2), -1.0f));
+        set(BodyFilterField::DistanceLs, floatOr(query.value(3), 0.0f));
+        set(BodyFilterField::SemiMajorAxisAu, floatOr(query.value(4), missing));
+        set(BodyFilterField::RadiusKm, floatOr(query.value(5), missing));
+        set(BodyFilterField::GravityG, floatOr(query.value(6), missing));
+        set(BodyFilterField::TemperatureK, floatOr(query.value(7), missing));
+        set(BodyFilterField::PressureAtm, floatOr(query.value(8), 0.0f));
+        set(BodyFilterField::MassEarth, floatOr(query.value(9), missing));
+        set(BodyFilterField::RotationDays, floatOr(query.value(10), missing));
+        set(BodyFilterField::AxialTiltDeg, floatOr(query.value(11), 0.0f));
+        set(BodyFilterField::Terraformable, query.value(12).toInt() != 0 ? 1.0f : 0.0f);
+        set(BodyFilterField::TidallyLocked, query.value(13).toInt() != 0 ? 1.0f : 0.0f);
+        set(BodyFilterField::Star, isClass(query.value(14), CelestialBody::BodyClass::Star));
+        set(BodyFilterField::Planet, isClass(query.value(14), CelestialBody::BodyClass::Planet));
+        set(BodyFilterField::Moon, isClass(query.value(14), CelestialBody::BodyClass::Moon));
+        set(BodyFilterField::Barycenter, isClass(query.value(14), CelestialBody::BodyClass::Barycenter));
+    }
+
+    if (!loadCompositionColumns(query, QString(), rowByRowId, &columns.atmosphere, &columns.materials)) {
+        fail(QStringLiteral("Ошибка загрузки составов корпуса: %1").arg(query.lastError().text()));
+        return BodyFilterColumns();
+    }
+    return columns;
+}
+
+QVector<CorpusBodyRecord> SystemCorpusDatabase::bodiesByRowIds(const QVector<qint64>& rowIds) const {
+    QVector<CorpusBodyRecord> records;
+    if (!isOpen() || rowIds.isEmpty()) {
+        return records;
+    }
+
+    // Один запрос на весь список: rowid — целые числа, поэтому они подставляются в текст IN (...)
+    // напрямую и не упираются в предел числа параметров SQLite.
+    QStringList idList;
+    idList.reserve(rowIds.size());
+    for (const qint64 rowId : rowIds) {
+        idList.push_back(QString::number(rowId));
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("SELECT %1 FROM bodies b JOIN systems s ON s.system_key = b.system_key"
+                                   " WHERE b.rowid IN (%2)")
+                        .arg(QLatin1String(kBodyRecordColumns), idList.join(QLatin1Char(','))))) {
+        fail(QStringLiteral("Ошибка чтения тел корпуса: %1").arg(query.lastError().text()));
+        return records;
+    }
+
+    QHash<qint64, CorpusBodyRecord> recordsByRowId;
+    recordsByRowId.reserve(rowIds.size());
+    while (query.next()) {
+        const CorpusBodyRecord record = readBodyRecord(query);
+        recordsByRowId.insert(record.rowId, record);
+    }
+
+    // Порядок результата совпадает с порядком rowIds (например, с рейтингом оценки);
+    // rowid, которых уже нет в базе, пропускаются.
+    records.reserve(recordsByRowId.size());
+    for (const qint64 rowId : rowIds) {
+        const auto it = recordsByRowId.constFind(rowId);
+        if (it != recordsByRowId.constEnd()) {
+            records.push_back(*it);
+        }
+    }
+
+    return records;
+}
+
+std::optional<SystemArchitectureSignature> SystemCorpusDatabase::systemArchitecture(const QString& systemName) const {
+    if (!isOpen()) {
+        return std::nullopt;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.prepare(QStringLiteral("SELECT architecture, architecture_hash FROM systems"
+                                 " WHERE name_key = ? AND architecture_hash IS NOT NULL"));
+    query.addBindValue(systemKeyFor(systemName));
+    if (!query.exec() || !query.next()) {
+        return std::nullopt;
+    }
+
+    SystemArchitectureSignature signature;
+    signature.canonicalForm = query.value(0).toString().toLatin1();
+    signature.hash = static_cast<quint64>(query.value(1).toLongLong());
+    return signature;
+}
+
+QVector<CorpusSystemRecord> SystemCorpusDatabase::systemsWithArchitecture(const SystemArchitectureSignature& architecture,
+                                                                        const int limit) const {
+    QVector<CorpusSystemRecord> systems;
+    if (!isOpen() || architecture.isEmpty()) {
+        return systems;
+    }
+
+    // Поиск по индексу хеша; сравнение формы отсекает маловероятные коллизии FNV.
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    query.prepare(QStringLiteral("SELECT name, id64, body_count FROM systems"
+                                 " WHERE architecture_hash = ? AND architecture = ? ORDER BY name_key LIMIT ?"));
+    query.addBindValue(static_cast<qint64>(architecture.hash));
+    query.addBindValue(QString::fromLatin1(architecture.canonicalForm));
+    query.addBindValue(limit);
+    if (!query.exec()) {
+        fail(QStringLiteral("Ошибка поиска систем по структуре: %1").arg(query.lastError().text()));
+        return systems;
+    }
+
+    while (query.next()) {
+        CorpusSystemRecord record;
+        record.name = query.value(0).toString();
+        record.systemId64 = query.value(1).toULongLong();
+        record.bodyCount = query.value(2).toInt();
+        systems.push_back(record);
+    }
+    return systems;
+}
+
+QVector<CorpusSystemRecord> SystemCorpusDatabase::systemsWithOrbitTypes(const SystemOrbitTypes types,
+                                                                      const int limit) const {
+    QVector<CorpusSystemRecord> systems;
+    if (!isOpen() || !types) {
+        return systems;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    query.prepare(QStringLiteral("SELECT name, id64, body_count FROM systems"
+                                 " WHERE (orbit_types & ?) = ? ORDER BY name_key LIMIT ?"));
+    query.addBindValue(static_cast<int>(types));
+    query.addBindValue(static_cast<int>(types));
+    query.addBindValue(limit);
+    if (!query.exec()) {
+        fail(QStringLiteral("Ошибка поиска систем по типу орбит: %1").arg(query.lastError().text()));
+        return systems;
+    }
+
+    while (query.next()) {
+        CorpusSystemRecord record;
+        record.name = query.value(0).toString();
+        record.systemId64 = query.value(1).toULongLong();
+        record.bodyCount = query.value(2).toInt();
+        systems.push_back(record);
+    }
+    return systems;
+}
+
+QVector<CorpusArchitectureGroup> SystemCorpusDatabase::architectureGroups(const int limit) const {
+    QVector<CorpusArchitectureGroup> groups;
+    if (!isOpen()) {
+        return groups;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    query.prepare(QStringLiteral("SELECT architecture_hash, architecture, COUNT(*), MIN(name) FROM systems"
+                                 " WHERE architecture_hash IS NOT NULL GROUP BY architecture_hash, architecture"
+                                 " ORDER BY COUNT(*) DESC, architecture LIMIT ?"));
+    query.addBindValue(limit);
+    if (!query.exec()) {
+        fail(QStringLiteral("Ошибка группировки систем по структуре: %1").arg(query.lastError().text()));
+        return groups;
+    }
+
+    while (query.next()) {
+        CorpusArchitectureGroup group;
+        group.architecture.hash = static_cast<quint64>(query.value(0).toLongLong());
+        group.architecture.canonicalForm = query.value(1).toString().toLatin1();
+        group.systemCount = query.value(2).toInt();
+        group.exampleSystem = query.value(3).toString();
+        groups.push_back(group);
+    }
+    return groups;
+}
+
+SystemFingerprintTable SystemCorpusDatabase::loadFingerprints() const {
+    SystemFingerprintTable table;
+    if (!isOpen()) {
+        return table;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("SELECT COUNT(*) FROM systems WHERE fingerprint IS NOT NULL")) || !query.next()) {
+        fail(QStringLiteral("Ошибка чтения отпечатков корпуса: %1").arg(query.lastError().text()));
+        return table;
+    }
+    table.reserve(query.value(0).toInt());
+    query.finish();
+
+    if (!query.exec(QStringLiteral("SELECT name, id64, fingerprint FROM systems WHERE fingerprint IS NOT NULL"
+                                   " ORDER BY system_key"))) {
+        fail(QStringLiteral("Ошибка чтения отпечатков корпуса: %1").arg(query.lastError().text()));
+        return SystemFingerprintTable();
+    }
+
+    while (query.next()) {
+        const auto fingerprint = SystemFingerprint::fromBlob(query.value(2).toByteArray());
+        if (!fingerprint) {
+            continue;
+        }
+        table.append(query.value(0).toString(), query.value(1).toULongLong(), *fingerprint);
+    }
+    return table;
+}
+
+CorpusStatistics SystemCorpusDatabase::statistics() const {
+    CorpusStatistics statistics;
+    if (!isOpen()) {
+        return statistics;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("SELECT kind, region, item_key, item_count FROM corpus_stats WHERE item_count > 0"
+                                   " ORDER BY kind, region, item_key"))) {
+        fail(QStringLiteral("Ошибка чтения сводки корпуса: %1").arg(query.lastError().text()));
+        return statistics;
+    }
+
+    while (query.next()) {
+        CorpusStatistics::Entry entry;
+        entry.kind = static_cast<CorpusStatistics::Kind>(query.value(0).toInt());
+        entry.region = query.value(1).toInt();
+        entry.key = query.value(2).toInt();
+        entry.count = query.value(3).toLongLong();
+        statistics.entries.push_back(entry);
+    }
+    return statistics;
+}
+
+bool SystemCorpusDatabase::rebuildStatistics() {
+    if (!isOpen()) {
+        return fail(QStringLiteral("Корпус не открыт."));
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+    if (!db.transaction()) {
+        return fail(QStringLiteral("Не удалось начать транзакцию: %1").arg(db.lastError().text()));
+    }
+
+    QSqlQuery query(db);
+    if (!rebuildStatisticRows(query)) {
+        const QString error = query.lastError().text();
+        db.rollback();
+        return fail(QStringLiteral("Ошибка пересчёта сводки корпуса: %1").arg(error));
+    }
+
+    if (!db.commit()) {
+        const QString error = db.lastError().text();
+        db.rollback();
+        return fail(QStringLiteral("Не удалось зафиксировать транзакцию: %1").arg(error));
+    }
+    return true;
+}
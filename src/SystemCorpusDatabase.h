@@ -0,0 +1,161 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <optional>
+
+#include "BodyFilter.h"
+#include "BodyTaxonomy.h"
+#include "CelestialBody.h"
+#include "CorpusStatistics.h"
+#include "GalacticCoordinates.h"
+#include "GalacticSpatialIndex.h"
+#include "OrbitClassifier.h"
+#include "SystemArchitecture.h"
+#include "SystemFingerprint.h"
+#include "SystemSnapshot.h"
+#include "TerraformingScorer.h"
+
+// Фильтр локального поиска тел. Незаданные поля не ограничивают выборку.
+struct CorpusBodyQuery {
+    std::optional<PlanetSubtype> planetSubtype;
+    std::optional<StarClass> starClass;
+    // Только тела, которые можно терраформировать (кандидаты, в процессе, уже терраформированы).
+    bool terraformableOnly = false;
+    std::optional<double> minGravityG;
+    std::optional<double> maxGravityG;
+    std::optional<double> minTemperatureK;
+    std::optional<double> maxTemperatureK;
+    // Тела, у которых есть все указанные метки OrbitClassifier (например, циркумбинарные планеты).
+    BodyOrbitTypes orbitTypes;
+    // Точное имя системы без учёта регистра; пусто — по всему корпусу.
+    QString systemName;
+    int limit = 1000;
+};
+
+struct CorpusBodyRecord {
+    // rowid строки bodies: тот же ключ, что TerraformingColumns::rowIds. storeSystem перезаписывает
+    // тела системы под новыми rowid.
+    qint64 rowId = 0;
+    quint64 systemId64 = 0;
+    QString systemName;
+    int bodyId = -1;
+    int parentId = -1;
+    QString name;
+    QString type;
+    CelestialBody::BodyClass bodyClass = CelestialBody::BodyClass::Unknown;
+    StarClass starClass = StarClass::Unknown;
+    PlanetSubtype planetSubtype = PlanetSubtype::Unknown;
+    double distanceToArrivalLs = 0.0;
+    double gravityG = 0.0;
+    double surfaceTemperatureK = 0.0;
+    double atmospherePressureAtm = 0.0;
+    double massEarth = 0.0;
+    QString terraformingState;
+};
+
+struct CorpusSystemRecord {
+    quint64 systemId64 = 0;
+    QString name;
+    int bodyCount = 0;
+};
+
+// Системы корпуса с одинаковой канонической формой иерархии.
+struct CorpusArchitectureGroup {
+    SystemArchitectureSignature architecture;
+    int systemCount = 0;
+    // Первая по алфавиту система группы.
+    QString exampleSystem;
+};
+
+// Локальный корпус всех загруженных и импортированных систем (SQLite через QtSql).
+// Хранит тела с родителями и физическими полями; индексы по имени системы, id64, подтипу,
+// состоянию терраформирования, гравитации, температуре и форме иерархии позволяют отвечать на запросы
+// вроде «терраформируемые миры с высоким содержанием металлов легче 1.5 g» без обращения к API.
+// Каждый экземпляр открывает собственное именованное соединение и работает в одном потоке.
+class SystemCorpusDatabase {
+public:
+    SystemCorpusDatabase();
+    ~SystemCorpusDatabase();
+
+    SystemCorpusDatabase(const SystemCorpusDatabase&) = delete;
+    SystemCorpusDatabase& operator=(const SystemCorpusDatabase&) = delete;
+
+    // <AppDataLocation>/corpus.sqlite
+    static QString defaultDatabasePath();
+
+    // Открывает (или создаёт) базу и схему. Путь ":memory:" — временная база в памяти.
+    bool open(const QString& path = defaultDatabasePath());
+    // Ещё одно соединение с уже открытой другим экземпляром базой — для чтения в фоновом потоке.
+    // Схему не трогает и пространственный индекс не строит; вызывается в том потоке, где соединение
+    // будет работать. Временную базу в памяти так открыть нельзя: её видит только своё соединение.
+    bool openForReading(const QString& path);
+    void close();
+    bool isOpen() const;
+    // Чтение несколькими запросами на один момент: до endRead() все SELECT этого соединения
+    // видят базу, какой она была при первом из них, и записи других соединений не смешиваются.
+    bool beginRead() const;
+    void endRead() const;
+    // Путь открытой базы; пусто, если корпус закрыт.
+    QString path() const;
+    bool isInMemory() const;
+    QString lastError() const;
+
+    // Заменяет сохранённую систему целиком (по имени без учёта регистра). systemId64 == 0 и пустые
+    // координаты означают «неизвестно»: ранее сохранённые значения тогда не затираются.
+    bool storeSystem(const SystemSnapshot& snapshot,
+                     quint64 systemId64 = 0,
+                     const std::optional<GalacticCoordinates>& coordinates = std::nullopt);
+
+    int systemCount() const;
+    int bodyCount() const;
+    QVector<CorpusBodyRecord> findBodies(const CorpusBodyQuery& query) const;
+    // Все системы с известным id64 — для пакетной сборки GalacticSpatialIndex. Без сохранённых
+    // координат позиция берётся из id64 (центр бокселя).
+    QVector<GalacticPoint> systemPositions() const;
+    // k-d дерево по systemPositions(): строится при открытии корпуса и пополняется storeSystem,
+    // так что поиск по радиусу не перечитывает координаты из базы.
+    const GalacticSpatialIndex& spatialIndex() const;
+    // Сохранённые координаты системы, иначе центр бокселя по id64.
+    std::optional<GalacticCoordinates> systemCoordinates(const QString& systemName) const;
+
+    // Планеты и спутники корпуса в столбцовом виде для TerraformingScorer, по возрастанию rowid.
+    TerraformingColumns loadScoringColumns() const;
+    // Все тела корпуса в столбцах для BodyFilter, по возрастанию rowid.
+    BodyFilterColumns loadFilterColumns() const;
+    // Полные записи по TerraformingColumns::rowIds, в том же порядке; пропавшие из базы rowid
+    // пропускаются, поэтому записи сопоставляются с запросом по CorpusBodyRecord::rowId.
+    QVector<CorpusBodyRecord> bodiesByRowIds(const QVector<qint64>& rowIds) const;
+
+    // Сохранённая форма иерархии системы; пусто, если системы нет или она записана до версии 4.
+    std::optional<SystemArchitectureSignature> systemArchitecture(const QString& systemName) const;
+    // Все системы с той же формой иерархии — поиск по индексу architecture_hash.
+    QVector<CorpusSystemRecord> systemsWithArchitecture(const SystemArchitectureSignature& architecture,
+                                                        int limit = 1000) const;
+    // Самые частые формы иерархии корпуса: группировка и поиск дубликатов по структуре.
+    QVector<CorpusArchitectureGroup> architectureGroups(int limit = 100) const;
+    // Системы, у которых есть все указанные метки OrbitClassifier (системы до версии 6 — после перезаписи).
+    QVector<CorpusSystemRecord> systemsWithOrbitTypes(SystemOrbitTypes types, int limit = 1000) const;
+    // Сводка по корпусу; storeSystem поддерживает её сама, чтение не обходит тела.
+    CorpusStatistics statistics() const;
+    // Пересчитывает сводку заново по всем системам (после ручной правки базы).
+    bool rebuildStatistics();
+    // Отпечатки всех систем для SystemFingerprintSearch (системы до версии 5 — после перезаписи).
+    SystemFingerprintTable loadFingerprints() const;
+
+    static constexpr double kStandardGravityMs2 = 9.80665;
+    static constexpr auto kInMemoryPath = ":memory:";
+
+private:
+    bool openConnection(const QString& path);
+    bool ensureSchema();
+    bool fail(const QString& message) const;
+    void updateSpatialIndex(qlonglong systemKey);
+
+    QString m_connectionName;
+    QString m_path;
+    mutable QString m_lastError;
+    GalacticSpatialIndex m_spatialIndex;
+};
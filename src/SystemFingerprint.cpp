@@ -0,0 +1,251 @@
+#include "SystemFingerprint.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "ChunkedTopK.h"
+#include "ColumnKernels.h"
+#include "SystemSnapshot.h"
+
+namespace {
+
+// Блок строк на одну задачу пула: 8K строк × 64 байта — половина типичного L2.
+constexpr int kChunkRows = 8192;
+
+float countFeature(const int count) {
+    return static_cast<float>(std::log1p(static_cast<double>(count)));
+}
+
+bool isBarycenter(const BodyHot& body) {
+    return body.bodyClass == CelestialBody::BodyClass::Barycenter || body.hasFlag(BodyHot::BarycenterTypeFlag);
+}
+
+SystemFingerprint::Feature starGroup(const StarClass starClass) {
+    switch (starClass) {
+    case StarClass::O:
+    case StarClass::B:
+    case StarClass::A:
+        return SystemFingerprint::HotStars;
+    case StarClass::F:
+    case StarClass::G:
+    case StarClass::K:
+        return SystemFingerprint::SolarStars;
+    case StarClass::M:
+        return SystemFingerprint::CoolStars;
+    case StarClass::L:
+    case StarClass::T:
+    case StarClass::Y:
+        return SystemFingerprint::BrownDwarfs;
+    case StarClass::WhiteDwarf:
+    case StarClass::Neutron:
+    case StarClass::BlackHole:
+    case StarClass::SupermassiveBlackHole:
+        return SystemFingerprint::StellarRemnants;
+    default:
+        return SystemFingerprint::ExoticStars;
+    }
+}
+
+// Меньшее расстояние, при равенстве — меньший номер строки.
+bool isCloser(const SystemFingerprintMatch& lhs, const SystemFingerprintMatch& rhs) {
+    return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.row < rhs.row);
+}
+
+} // namespace
+
+SystemFingerprint SystemFingerprint::compute(const SystemSnapshot& snapshot) {
+    SystemFingerprint fingerprint;
+    const BodyGraph& graph = snapshot.graph();
+    const QVector<BodyHot>& hotBodies = snapshot.hotBodies();
+    const QVector<BodyCold>& coldBodies = snapshot.coldBodies();
+    const int bodyCount = graph.size();
+    if (bodyCount == 0) {
+        return fingerprint;
+    }
+
+    std::array<int, kDimensions> counts{};
+    for (int index = 0; index < bodyCount; ++index) {
+        const BodyHot& body = hotBodies.at(index);
+        if (body.hasFlag(BodyHot::VirtualRootFlag)) {
+            continue;
+        }
+
+        switch (body.bodyClass) {
+        case CelestialBody::BodyClass::Star:
+            ++counts[StarCount];
+            ++counts[starGroup(body.starClass)];
+            break;
+        case CelestialBody::BodyClass::Planet:
+            ++counts[PlanetCount];
+            break;
+        case CelestialBody::BodyClass::Moon:
+            ++counts[MoonCount];
+            break;
+        case CelestialBody::BodyClass::Barycenter:
+            ++counts[BarycenterCount];
+            break;
+        case CelestialBody::BodyClass::Unknown:
+            break;
+        }
+        if (isTerraformableState(coldBodies.at(index).terraformingState)) {
+            ++counts[TerraformableCount];
+        }
+    }
+    for (const Feature feature : {StarCount,
+                                  PlanetCount,
+                                  MoonCount,
+                                  BarycenterCount,
+                                  HotStars,
+                                  SolarStars,
+                                  CoolStars,
+                                  BrownDwarfs,
+                                  StellarRemnants,
+                                  ExoticStars,
+                                  TerraformableCount}) {
+        fingerprint.features[feature] = countFeature(counts[feature]);
+    }
+
+    // Глубина барицентров и шаг орбит — за один обход от корней (родитель раньше детей).
+    QVector<int> barycenterDepth(bodyCount, 0);
+    QVector<int> stack(graph.rootIndices);
+    for (const int rootIndex : graph.rootIndices) {
+        barycenterDepth[rootIndex] = isBarycenter(hotBodies.at(rootIndex)) ? 1 : 0;
+    }
+    int maxDepth = 0;
+    std::vector<double> siblingAxes;
+    std::vector<double> spacingRatios;
+    while (!stack.isEmpty()) {
+        const int index = stack.takeLast();
+        maxDepth = std::max(maxDepth, barycenterDepth.at(index));
+
+        siblingAxes.clear();
+        for (const int* child = graph.childrenBegin(index); child != graph.childrenEnd(index); ++child) {
+            const BodyHot& childBody = hotBodies.at(*child);
+            barycenterDepth[*child] = barycenterDepth.at(index) + (isBarycenter(childBody) ? 1 : 0);
+            if (childBody.semiMajorAxisAu > 0.0 && !isBarycenter(childBody)) {
+                siblingAxes.push_back(childBody.semiMajorAxisAu);
+            }
+            stack.push_back(*child);
+        }
+
+        // Отношения соседних больших полуосей у детей одного родителя (закон Тициуса — Боде ≈ 1.7).
+        std::sort(siblingAxes.begin(), siblingAxes.end());
+        for (size_t position = 1; position < siblingAxes.size(); ++position) {
+            spacingRatios.push_back(std::log10(siblingAxes[position] / siblingAxes[position - 1]));
+        }
+    }
+    fingerprint.features[BarycenterDepth] = static_cast<float>(maxDepth);
+    if (!spacingRatios.empty()) {
+        const auto median = spacingRatios.begin() + static_cast<std::ptrdiff_t>(spacingRatios.size() / 2);
+        std::nth_element(spacingRatios.begin(), median, spacingRatios.end());
+        // log10 отношения обычно 0.1..0.5 — растягиваем до порядка единицы.
+        fingerprint.features[OrbitSpacing] = static_cast<float>(*median * 4.0);
+    }
+
+    const SystemOrbitTypes systemTypes = snapshot.orbitClassification().systemTypes;
+    const auto flag = [systemTypes](const SystemOrbitType type) {
+        return systemTypes.testFlag(type) ? 1.0f : 0.0f;
+    };
+    fingerprint.features[BinaryStar] = std::max(flag(SystemOrbitType::BinaryStar), flag(SystemOrbitType::HierarchicalPairOfPairs));
+    fingerprint.features[CircumbinaryPlanets] = flag(SystemOrbitType::CircumbinaryPlanetarySystem);
+    fingerprint.features[BinaryPlanets] = std::max(flag(SystemOrbitType::BinaryPlanetPair), flag(SystemOrbitType::BinaryPlanetNonStarPair));
+    return fingerprint;
+}
+
+QByteArray SystemFingerprint::toBlob() const {
+    return QByteArray(reinterpret_cast<const char*>(features.data()), static_cast<int>(sizeof(features)));
+}
+
+std::optional<SystemFingerprint> SystemFingerprint::fromBlob(const QByteArray& blob) {
+    SystemFingerprint fingerprint;
+    if (blob.size() != static_cast<int>(sizeof(fingerprint.features))) {
+        return std::nullopt;
+    }
+    std::memcpy(fingerprint.features.data(), blob.constData(), sizeof(fingerprint.features));
+    return fingerprint;
+}
+
+QString SystemFingerprint::featureName(const Feature feature) {
+    switch (feature) {
+    case StarCount:
+        return QStringLiteral("Звёзды");
+    case PlanetCount:
+        return QStringLiteral("Планеты");
+    case MoonCount:
+        return QStringLiteral("Спутники");
+    case BarycenterCount:
+        return QStringLiteral("Барицентры");
+    case HotStars:
+        return QStringLiteral("Звёзды O/B/A");
+    case SolarStars:
+        return QStringLiteral("Звёзды F/G/K");
+    case CoolStars:
+        return QStringLiteral("Звёзды M");
+    case BrownDwarfs:
+        return QStringLiteral("Коричневые карлики");
+    case StellarRemnants:
+        return QStringLiteral("Белые карлики, нейтронные звёзды, чёрные дыры");
+    case ExoticStars:
+        return QStringLiteral("Прочие звёзды");
+    case TerraformableCount:
+        return QStringLiteral("Терраформируемые тела");
+    case BarycenterDepth:
+        return QStringLiteral("Глубина барицентров");
+    case OrbitSpacing:
+        return QStringLiteral("Шаг орбит");
+    case BinaryStar:
+        return QStringLiteral("Двойная звезда");
+    case CircumbinaryPlanets:
+        return QStringLiteral("Околодвойные планеты");
+    case BinaryPlanets:
+        return QStringLiteral("Двойные планеты");
+    case FeatureCount:
+        break;
+    }
+    return QString();
+}
+
+void SystemFingerprintTable::reserve(const int count) {
+    names.reserve(count);
+    systemId64.reserve(count);
+    features.reserve(count * SystemFingerprint::kDimensions);
+}
+
+void SystemFingerprintTable::append(const QString& name, const quint64 id64, const SystemFingerprint& fingerprint) {
+    names.push_back(name);
+    systemId64.push_back(id64);
+    for (const float value : fingerprint.features) {
+        features.push_back(value);
+    }
+}
+
+QVector<SystemFingerprintMatch> SystemFingerprintSearch::nearest(const SystemFingerprintTable& table,
+                                                                 const SystemFingerprint& query,
+                                                                 const int k,
+                                                                 const QVector<quint8>* rowMask) {
+    const int rowCount = table.size();
+    if (k <= 0 || rowCount == 0 || table.features.size() != rowCount * SystemFingerprint::kDimensions) {
+        return {};
+    }
+
+    const quint8* mask = rowMask && rowMask->size() == rowCount ? rowMask->constData() : nullptr;
+    QVector<SystemFingerprintMatch> matches = ChunkedTopK::select<SystemFingerprintMatch>(
+        rowCount,
+        kChunkRows,
+        k,
+        mask,
+        [&table, &query](const int begin, const int end, float* out) {
+            ColumnKernels::squaredDistances(table.row(begin),
+                                            end - begin,
+                                            SystemFingerprint::kDimensions,
+                                            query.features.data(),
+                                            out);
+        },
+        isCloser);
+    for (SystemFingerprintMatch& match : matches) {
+        match.distance = std::sqrt(match.distance);
+    }
+    return matches;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <array>
+#include <optional>
+
+class SystemSnapshot;
+
+// Числовой отпечаток системы для поиска похожих: состав по классам тел и звёзд, число
+// терраформируемых тел, глубина вложенности барицентров, типичный шаг орбит и мотивы
+// OrbitClassifier. Счётчики берутся как log(1 + n), чтобы 40 и 45 планет были ближе, чем 1 и 6;
+// все признаки порядка единицы, расстояние — обычное евклидово.
+struct SystemFingerprint {
+    enum Feature : quint8 {
+        StarCount,
+        PlanetCount,
+        MoonCount,
+        BarycenterCount,
+        HotStars,
+        SolarStars,
+        CoolStars,
+        BrownDwarfs,
+        StellarRemnants,
+        ExoticStars,
+        TerraformableCount,
+        BarycenterDepth,
+        OrbitSpacing,
+        BinaryStar,
+        CircumbinaryPlanets,
+        BinaryPlanets,
+        FeatureCount
+    };
+    // 16 float — ровно четыре регистра SSE на строку.
+    static constexpr int kDimensions = FeatureCount;
+
+    std::array<float, kDimensions> features{};
+
+    float value(const Feature feature) const {
+        return features[feature];
+    }
+
+    static SystemFingerprint compute(const SystemSnapshot& snapshot);
+
+    // Сырые float в порядке Feature — для столбца systems.fingerprint корпуса.
+    QByteArray toBlob() const;
+    static std::optional<SystemFingerprint> fromBlob(const QByteArray& blob);
+
+    static QString featureName(Feature feature);
+};
+
+// Отпечатки многих систем подряд (строка = kDimensions float) для полного перебора.
+struct SystemFingerprintTable {
+    QVector<QString> names;
+    // 0 — id64 неизвестен.
+    QVector<quint64> systemId64;
+    QVector<float> features;
+
+    int size() const {
+        return names.size();
+    }
+
+    void reserve(int count);
+    void append(const QString& name, quint64 id64, const SystemFingerprint& fingerprint);
+
+    const float* row(const int index) const {
+        return features.constData() + static_cast<qsizetype>(index) * SystemFingerprint::kDimensions;
+    }
+};
+
+struct SystemFingerprintMatch {
+    int row = -1;
+    float distance = 0.0f;
+};
+
+Q_DECLARE_TYPEINFO(SystemFingerprintMatch, Q_PRIMITIVE_TYPE);
+
+class SystemFingerprintSearch {
+public:
+    // k ближайших строк по возрастанию расстояния. Перебор всех строк: квадраты расстояний
+    // считает SIMD-ядро ColumnKernels, блоки строк обрабатываются на всех ядрах (QtConcurrent),
+    // каждый держит свой top-k. rowMask (необязательный, размер как у таблицы) — 0 пропускает
+    // строку, например вне радиуса поиска.
+    static QVector<SystemFingerprintMatch> nearest(const SystemFingerprintTable& table,
+                                                   const SystemFingerprint& query,
+                                                   int k,
+                                                   const QVector<quint8>* rowMask = nullptr);
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include "GalacticCoordinates.h"
+
+// Поля system id64, разложенные по битам. Сектора — кубы 1280 св. лет,
+// внутри сектора система лежит в боксели размером 10 << massCode св. лет.
+struct DecodedSystemId64 {
+    // 0..7 соответствует буквам 'a'..'h' в процедурных именах ("... b25-1" → 1).
+    int massCode = 0;
+    int sectorX = 0;
+    int sectorY = 0;
+    int sectorZ = 0;
+    int boxelX = 0;
+    int boxelY = 0;
+    int boxelZ = 0;
+    // Номер системы внутри бокселя (N2 в имени "... b25-N2").
+    quint32 systemNumber = 0;
+
+    constexpr char massCodeLetter() const {
+        return static_cast<char>('a' + massCode);
+    }
+
+    constexpr int boxelSizeLy() const {
+        return 10 << massCode;
+    }
+
+    // Центр бокселя: реальная позиция системы отличается не больше чем на половину boxelSizeLy по каждой оси.
+    constexpr GalacticCoordinates approximatePosition() const {
+        const double boxelSize = boxelSizeLy();
+        return GalacticCoordinates{
+            sectorX * kSectorSizeLy + boxelX * boxelSize + boxelSize / 2.0 + kGalaxyOriginX,
+            sectorY * kSectorSizeLy + boxelY * boxelSize + boxelSize / 2.0 + kGalaxyOriginY,
+            sectorZ * kSectorSizeLy + boxelZ * boxelSize + boxelSize / 2.0 + kGalaxyOriginZ};
+    }
+
+    static constexpr double kSectorSizeLy = 1280.0;
+    // Угол сектора (0, 0, 0) в координатах с началом в Sol.
+    static constexpr double kGalaxyOriginX = -49985.0;
+    static constexpr double kGalaxyOriginY = -40985.0;
+    static constexpr double kGalaxyOriginZ = -24105.0;
+};
+
+// Разбор id64 системы и bodyId64 тела без сети и без таблиц: только сдвиги и маски,
+// поэтому годится для каждой записи при импорте дампа галактики.
+//
+// Раскладка id64 от младших битов: massCode (3), boxelZ (7 - massCode), sectorZ (7),
+// boxelY (7 - massCode), sectorY (6), boxelX (7 - massCode), sectorX (7), номер системы
+// (11 + 3 * massCode) — всего 55 бит. bodyId64 = (bodyId << 55) | id64.
+class SystemId64 {
+public:
+    static constexpr int kSystemBits = 55;
+    static constexpr quint64 kSystemMask = (Q_UINT64_C(1) << kSystemBits) - 1;
+
+    static constexpr DecodedSystemId64 decode(const quint64 id64) {
+        DecodedSystemId64 decoded;
+        quint64 rest = id64 & kSystemMask;
+
+        decoded.massCode = static_cast<int>(takeBits(rest, 3));
+        const int boxelBits = 7 - decoded.massCode;
+        decoded.boxelZ = static_cast<int>(takeBits(rest, boxelBits));
+        decoded.sectorZ = static_cast<int>(takeBits(rest, 7));
+        decoded.boxelY = static_cast<int>(takeBits(rest, boxelBits));
+        decoded.sectorY = static_cast<int>(takeBits(rest, 6));
+        decoded.boxelX = static_cast<int>(takeBits(rest, boxelBits));
+        decoded.sectorX = static_cast<int>(takeBits(rest, 7));
+        decoded.systemNumber = static_cast<quint32>(rest);
+        return decoded;
+    }
+
+    static constexpr quint64 encode(const DecodedSystemId64& decoded) {
+        const int boxelBits = 7 - decoded.massCode;
+        quint64 id64 = decoded.systemNumber;
+        id64 = appendBits(id64, static_cast<quint64>(decoded.sectorX), 7);
+        id64 = appendBits(id64, static_cast<quint64>(decoded.boxelX), boxelBits);
+        id64 = appendBits(id64, static_cast<quint64>(decoded.sectorY), 6);
+        id64 = appendBits(id64, static_cast<quint64>(decoded.boxelY), boxelBits);
+        id64 = appendBits(id64, static_cast<quint64>(decoded.sectorZ), 7);
+        id64 = appendBits(id64, static_cast<quint64>(decoded.boxelZ), boxelBits);
+        return appendBits(id64, static_cast<quint64>(decoded.massCode), 3);
+    }
+
+    static constexpr GalacticCoordinates approximatePosition(const quint64 id64) {
+        return decode(id64).approximatePosition();
+    }
+
+    static constexpr quint64 systemOfBody(const quint64 bodyId64) {
+        return bodyId64 & kSystemMask;
+    }
+
+    static constexpr int bodyIdOfBody(const quint64 bodyId64) {
+        return static_cast<int>(bodyId64 >> kSystemBits);
+    }
+
+    static constexpr quint64 makeBodyId64(const quint64 systemId64, const int bodyId) {
+        return (static_cast<quint64>(bodyId) << kSystemBits) | (systemId64 & kSystemMask);
+    }
+
+private:
+    static constexpr quint64 takeBits(quint64& value, const int bitCount) {
+        const quint64 bits = value & ((Q_UINT64_C(1) << bitCount) - 1);
+        value >>= bitCount;
+        return bits;
+    }
+
+    static constexpr quint64 appendBits(const quint64 value, const quint64 bits, const int bitCount) {
+        return (value << bitCount) | (bits & ((Q_UINT64_C(1) << bitCount) - 1));
+    }
+};
+
+// Col 285 Sector XW-G b25-1 (col.json): id64 2869977687537, координаты (2.69, -11.13, 175.06).
+static_assert(SystemId64::decode(Q_UINT64_C(2869977687537)).massCodeLetter() == 'b', "id64 mass code");
+static_assert(SystemId64::decode(Q_UINT64_C(2869977687537)).systemNumber == 1, "id64 system number");
+static_assert(SystemId64::encode(SystemId64::decode(Q_UINT64_C(2869977687537))) == Q_UINT64_C(2869977687537),
+              "id64 round trip");
+static_assert(SystemId64::systemOfBody(Q_UINT64_C(432348434205255153)) == Q_UINT64_C(2869977687537),
+              "bodyId64 system part");
+static_assert(SystemId64::bodyIdOfBody(Q_UINT64_C(432348434205255153)) == 12, "bodyId64 body part");
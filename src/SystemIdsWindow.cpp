@@ -4,18 +4,18 @@
 
 #include <QCloseEvent>
 #include <QLabel>
+#include <QLineEdit>
 #include <QSettings>
 #include <QSplitter>
 #include <QTreeWidget>
 #include <QTreeWidgetItem>
 #include <QVBoxLayout>
 
-#include <algorithm>
-
 namespace {
 
 constexpr auto kSettingsGroup = "SystemIdsWindow";
 constexpr auto kSplitterSizesKey = "splitterSizes";
+constexpr int kGraphIndexRole = Qt::UserRole + 1;
 
 } // namespace
 
@@ -27,6 +27,15 @@ SystemIdsWindow::SystemIdsWindow(QWidget* parent)
     auto* rootLayout = new QVBoxLayout(this);
     auto* title = new QLabel(QStringLiteral("Все ID тел текущей системы"), this);
 
+    m_filterEdit = new QLineEdit(this);
+    m_filterEdit->setPlaceholderText(QStringLiteral("Фильтр: gravity < 1.2 and atmosphere contains CO2"));
+    m_filterEdit->setToolTip(BodyFilter::syntaxHelp());
+    m_filterEdit->setClearButtonEnabled(true);
+
+    m_filterStatusLabel = new QLabel(this);
+    m_filterStatusLabel->setWordWrap(true);
+    m_filterStatusLabel->hide();
+
     m_splitter = new QSplitter(Qt::Horizontal, this);
 
     m_bodiesTree = new QTreeWidget(m_splitter);
@@ -42,10 +51,16 @@ SystemIdsWindow::SystemIdsWindow(QWidget* parent)
     m_splitter->setStretchFactor(1, 1);
 
     rootLayout->addWidget(title);
+    rootLayout->addWidget(m_filterEdit);
+    rootLayout->addWidget(m_filterStatusLabel);
     rootLayout->addWidget(m_splitter, 1);
 
     restoreSplitterState();
 
+    connect(m_filterEdit, &QLineEdit::textChanged, this, [this]() {
+        applyFilter();
+    });
+
     connect(m_bodiesTree, &QTreeWidget::currentItemChanged, this,
             [this](QTreeWidgetItem* current, QTreeWidgetItem*) {
                 if (!current) {
@@ -59,31 +74,33 @@ SystemIdsWindow::SystemIdsWindow(QWidget* parent)
                     return;
                 }
 
-                const int bodyId = idData.toInt();
-                if (!m_bodies.contains(bodyId)) {
+                const auto body = m_snapshot.body(idData.toInt());
+                if (!body) {
                     m_detailsPanel->setPlaceholderText(QStringLiteral("Параметры для выбранного ID не найдены."));
                     return;
                 }
 
-                m_detailsPanel->setBody(m_bodies.value(bodyId), m_bodies);
+                m_detailsPanel->setBody(*body, m_snapshot);
             });
 }
 
-void SystemIdsWindow::setBodies(const QHash<int, CelestialBody>& bodies) {
-    m_bodies = bodies;
+void SystemIdsWindow::setSnapshot(const SystemSnapshot& snapshot) {
+    m_snapshot = snapshot;
+    m_filterColumns = BodyFilterColumns::fromSnapshot(m_snapshot);
     m_bodiesTree->clear();
 
-    QList<int> ids = m_bodies.keys();
-    std::sort(ids.begin(), ids.end());
-
     QHash<QString, QTreeWidgetItem*> classGroups;
 
-    for (const int id : ids) {
-        const CelestialBody body = m_bodies.value(id);
-        if (isVirtualBarycenterRoot(body)) {
+    // Индексы графа уже упорядочены по id.
+    const BodyGraph& graph = m_snapshot.graph();
+    for (int index = 0; index < graph.size(); ++index) {
+        if (m_snapshot.hotBodies().at(index).hasFlag(BodyHot::VirtualRootFlag)) {
             continue;
         }
 
+        const int id = graph.idAt(index);
+        const CelestialBody body = *m_snapshot.body(id);
+
         const QString groupName = bodyClassGroupName(body);
         QTreeWidgetItem* groupItem = classGroups.value(groupName, nullptr);
         if (!groupItem) {
@@ -97,6 +114,7 @@ void SystemIdsWindow::setBodies(const QHash<int, CelestialBody>& bodies) {
         auto* bodyItem = new QTreeWidgetItem(groupItem);
         bodyItem->setText(0, QStringLiteral("ID %1 — %2").arg(QString::number(id), body.name));
         bodyItem->setData(0, Qt::UserRole, id);
+        bodyItem->setData(0, kGraphIndexRole, index);
     }
 
     if (m_bodiesTree->topLevelItemCount() == 0) {
@@ -105,14 +123,56 @@ void SystemIdsWindow::setBodies(const QHash<int, CelestialBody>& bodies) {
     }
 
     m_bodiesTree->expandAll();
+    applyFilter();
+
+    for (int i = 0; i < m_bodiesTree->topLevelItemCount(); ++i) {
+        QTreeWidgetItem* group = m_bodiesTree->topLevelItem(i);
+        if (!group || group->isHidden()) {
+            continue;
+        }
+        for (int j = 0; j < group->childCount(); ++j) {
+            if (!group->child(j)->isHidden()) {
+                m_bodiesTree->setCurrentItem(group->child(j));
+                return;
+            }
+        }
+    }
+}
+
+void SystemIdsWindow::applyFilter() {
+    const BodyFilter filter = BodyFilter::compile(m_filterEdit->text());
+    if (!filter.isValid()) {
+        m_filterStatusLabel->setText(QStringLiteral("Ошибка (позиция %1): %2")
+                                         .arg(filter.errorPosition() + 1)
+                                         .arg(filter.errorMessage()));
+        m_filterStatusLabel->show();
+        return;
+    }
 
+    const QVector<quint8> mask = filter.evaluate(m_filterColumns);
+    int shown = 0;
+    int total = 0;
     for (int i = 0; i < m_bodiesTree->topLevelItemCount(); ++i) {
         QTreeWidgetItem* group = m_bodiesTree->topLevelItem(i);
-        if (group && group->childCount() > 0) {
-            m_bodiesTree->setCurrentItem(group->child(0));
-            break;
+        int shownInGroup = 0;
+        for (int j = 0; j < group->childCount(); ++j) {
+            QTreeWidgetItem* bodyItem = group->child(j);
+            const int index = bodyItem->data(0, kGraphIndexRole).toInt();
+            const bool passed = index >= 0 && index < mask.size() && mask.at(index) != 0;
+            bodyItem->setHidden(!passed);
+            shownInGroup += passed ? 1 : 0;
         }
+        group->setHidden(shownInGroup == 0);
+        shown += shownInGroup;
+        total += group->childCount();
+    }
+
+    if (filter.matchesAll()) {
+        m_filterStatusLabel->hide();
+        return;
     }
+    m_filterStatusLabel->setText(QStringLiteral("Показано тел: %1 из %2").arg(shown).arg(total));
+    m_filterStatusLabel->show();
 }
 
 void SystemIdsWindow::closeEvent(QCloseEvent* event) {
@@ -3,9 +3,14 @@
 #include <QHash>
 #include <QWidget>
 
+#include "BodyFilter.h"
+
 #include "CelestialBody.h"
+#include "SystemSnapshot.h"
 
 class BodyDetailsWidget;
+class QLabel;
+class QLineEdit;
 class QSplitter;
 class QTreeWidget;
 class QTreeWidgetItem;
@@ -15,18 +20,24 @@ class SystemIdsWindow : public QWidget {
 public:
     explicit SystemIdsWindow(QWidget* parent = nullptr);
 
-    void setBodies(const QHash<int, CelestialBody>& bodies);
+    void setSnapshot(const SystemSnapshot& snapshot);
 
 protected:
     void closeEvent(QCloseEvent* event) override;
 
 private:
     QString bodyClassGroupName(const CelestialBody& body) const;
+    // Скрывает тела, не прошедшие выражение из строки фильтра, и опустевшие группы.
+    void applyFilter();
     void restoreSplitterState();
     void saveSplitterState() const;
 
     QSplitter* m_splitter = nullptr;
+    QLineEdit* m_filterEdit = nullptr;
+    QLabel* m_filterStatusLabel = nullptr;
     QTreeWidget* m_bodiesTree = nullptr;
     BodyDetailsWidget* m_detailsPanel = nullptr;
-    QHash<int, CelestialBody> m_bodies;
+    SystemSnapshot m_snapshot;
+    // Столбцы снимка для фильтра: строятся один раз в setSnapshot, строки — индексы graph.
+    BodyFilterColumns m_filterColumns;
 };
@@ -1,13 +1,14 @@
 #include "SystemLayoutEngine.h"
 
-#include "OrbitClassifier.h"
+#include "SystemModelBuilder.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include <QtMath>
 
 namespace {
-double orbitalDistanceAu(const CelestialBody& body) {
+double orbitalDistanceAu(const BodyHot& body) {
     if (body.semiMajorAxisAu > 0.0) {
         return body.semiMajorAxisAu;
     }
@@ -16,240 +17,377 @@ double orbitalDistanceAu(const CelestialBody& body) {
     return qMax(0.0, body.distanceToArrivalLs / 499.0);
 }
 
-bool isStarBody(const CelestialBody& body) {
-    return body.type.contains(QStringLiteral("Star"), Qt::CaseInsensitive);
-}
-
-bool isPlanetBody(const CelestialBody& body) {
-    return body.type.contains(QStringLiteral("Planet"), Qt::CaseInsensitive);
-}
-
-bool isMoonBody(const CelestialBody& body) {
-    return body.type.contains(QStringLiteral("Moon"), Qt::CaseInsensitive);
-}
-
-bool isBarycenterBody(const CelestialBody& body) {
+bool isBarycenterBody(const BodyHot& body) {
     return body.bodyClass == CelestialBody::BodyClass::Barycenter
-        || OrbitClassifier::isBarycenterType(body.type);
+        || body.hasFlag(BodyHot::BarycenterTypeFlag);
 }
 
-int bodyTypePriority(const CelestialBody& body) {
-    if (isStarBody(body)) {
+int bodyTypePriority(const BodyHot& body) {
+    if (body.hasFlag(BodyHot::StarTypeFlag)) {
         return 0;
     }
-    if (isPlanetBody(body)) {
+    if (body.hasFlag(BodyHot::PlanetTypeFlag)) {
         return 1;
     }
-    if (isMoonBody(body)) {
+    if (body.hasFlag(BodyHot::MoonTypeFlag)) {
         return 2;
     }
     return 3;
 }
 
-bool lessForStableLayout(const CelestialBody& lhs, const int lhsId, const CelestialBody& rhs, const int rhsId) {
-    const int lhsPriority = bodyTypePriority(lhs);
-    const int rhsPriority = bodyTypePriority(rhs);
+enum LayoutKindFlag : quint8 {
+    StarKind = 1 << 0,
+    BarycenterKind = 1 << 1,
+    // Workspace::phaseX/phaseY тела заданы эфемеридами.
+    PhaseKind = 1 << 2
+};
+
+// Индексы графа упорядочены по id, поэтому сравнение индексов совпадает со сравнением id.
+bool lessForStableLayout(const SystemLayoutEngine::Workspace& workspace, const int lhs, const int rhs) {
+    const quint8 lhsPriority = workspace.priority.at(lhs);
+    const quint8 rhsPriority = workspace.priority.at(rhs);
     if (lhsPriority != rhsPriority) {
         return lhsPriority < rhsPriority;
     }
 
-    const double lhsOrbitAu = orbitalDistanceAu(lhs);
-    const double rhsOrbitAu = orbitalDistanceAu(rhs);
+    const double lhsOrbitAu = workspace.orbitAu.at(lhs);
+    const double rhsOrbitAu = workspace.orbitAu.at(rhs);
     if (!qFuzzyCompare(lhsOrbitAu + 1.0, rhsOrbitAu + 1.0)) {
         return lhsOrbitAu < rhsOrbitAu;
     }
 
-    return lhsId < rhsId;
+    return lhs < rhs;
 }
 
-QVector<int> sortedByLayoutOrder(const QVector<int>& source, const QHash<int, CelestialBody>& bodyMap) {
-    QVector<int> result = source;
-    std::sort(result.begin(), result.end(), [&](const int lhs, const int rhs) {
-        return lessForStableLayout(bodyMap[lhs], lhs, bodyMap[rhs], rhs);
-    });
-    return result;
+// Порядок выбора ключевой пары барицентра: сначала самые внутренние орбиты.
+bool lessByOrbit(const SystemLayoutEngine::Workspace& workspace, const int lhs, const int rhs) {
+    const double lhsOrbitAu = workspace.orbitAu.at(lhs);
+    const double rhsOrbitAu = workspace.orbitAu.at(rhs);
+    if (!qFuzzyCompare(lhsOrbitAu + 1.0, rhsOrbitAu + 1.0)) {
+        return lhsOrbitAu < rhsOrbitAu;
+    }
+    return lessForStableLayout(workspace, lhs, rhs);
 }
+
+// Смещение от родителя на схеме. При известной фазе — настоящее, в масштабе, где большая
+// полуось равна distanceAu: тело лежит на эллипсе своей орбиты. Иначе — точка окружности
+// радиуса distanceAu под равномерным углом.
+QPointF childOffset(const SystemLayoutEngine::Workspace& workspace,
+                    const int index,
+                    const double evenAngle,
+                    const double distanceAu) {
+    if (workspace.kindFlags.at(index) & PhaseKind) {
+        return QPointF(workspace.phaseX.at(index) * distanceAu, workspace.phaseY.at(index) * distanceAu);
+    }
+    return QPointF(qCos(evenAngle) * distanceAu, qSin(evenAngle) * distanceAu);
 }
 
-QHash<int, BodyLayout> SystemLayoutEngine::buildLayout(const QHash<int, CelestialBody>& bodyMap,
-                                                       const QVector<int>& roots,
-                                                       const QRectF& canvasRect) {
-    QHash<int, BodyLayout> layout;
-    layout.reserve(bodyMap.size());
+void place(QVector<BodyLayout>& layout, const int index, const BodyLayout& bodyLayout) {
+    layout[index] = bodyLayout;
+    layout[index].placed = true;
+}
 
-    if (roots.isEmpty()) {
-        return layout;
+// Ребёнок, уже получивший позицию, повторно не обходится: так обход завершается,
+// даже если корень, переданный вызывающей стороной, лежит внутри другого поддерева.
+void placeAndQueue(SystemLayoutEngine::Workspace& workspace,
+                   QVector<BodyLayout>& layout,
+                   const int index,
+                   const BodyLayout& bodyLayout,
+                   const double fallbackDistanceAu) {
+    if (layout.at(index).placed) {
+        return;
     }
+    place(layout, index, bodyLayout);
+    workspace.pending.push_back({index, fallbackDistanceAu});
+}
+} // namespace
 
-    double maxOrbitAu = 0.0;
-    for (auto it = bodyMap.constBegin(); it != bodyMap.constEnd(); ++it) {
-        maxOrbitAu = qMax(maxOrbitAu, orbitalDistanceAu(*it));
+double SystemLayout::pxPerAu(const QSizeF& canvasSize) const {
+    if (extentAu <= 0.0) {
+        return 0.0;
     }
-
-    const QPointF center = canvasRect.center();
-    const double safeHalfSize = qMax(70.0, qMin(canvasRect.width(), canvasRect.height()) * 0.72);
     // Усиливаем масштаб орбит: система выглядит крупнее и читается на отдалении лучше.
-    const double pxPerAu = maxOrbitAu > 0.0 ? (safeHalfSize / maxOrbitAu) : 85.0;
+    const double safeHalfSize = qMax(70.0, qMin(canvasSize.width(), canvasSize.height()) * 0.72);
+    return safeHalfSize / extentAu;
+}
 
-    if (roots.size() == 1) {
-        layout.insert(roots.first(), BodyLayout{center, 9.0, 0.0, pxPerAu});
-        layoutChildrenRecursive(bodyMap, layout, roots.first(), pxPerAu, 24.0);
-        return layout;
+QHash<int, BodyLayout> SystemLayoutEngine::buildLayout(const QHash<int, CelestialBody>& bodyMap,
+                                                       const QVector<int>& roots) {
+    const BodyGraph graph = SystemModelBuilder::buildBodyGraph(bodyMap);
+    QVector<int> rootIndices;
+    rootIndices.reserve(roots.size());
+    for (const int rootId : roots) {
+        const int rootIndex = graph.indexOf(rootId);
+        if (rootIndex >= 0) {
+            rootIndices.push_back(rootIndex);
+        }
     }
 
-    // Если корней несколько (например, данные неполные), раскладываем их по кругу, чтобы не перекрывались.
-    const double ringRadius = qMin(canvasRect.width(), canvasRect.height()) * 0.15;
-    for (int i = 0; i < roots.size(); ++i) {
-        const int rootId = roots[i];
-        const double angle = (2.0 * M_PI * i) / qMax(1, roots.size());
-        const QPointF position(center.x() + qCos(angle) * ringRadius,
-                               center.y() + qSin(angle) * ringRadius);
+    Workspace workspace;
+    SystemLayout denseLayout;
+    buildDenseLayout(graph, SystemModelBuilder::buildHotRecords(bodyMap, graph), rootIndices, nullptr, 0, workspace,
+                     denseLayout);
 
-        layout.insert(rootId, BodyLayout{position, 8.0, 0.0, pxPerAu});
-        layoutChildrenRecursive(bodyMap, layout, rootId, pxPerAu, 22.0);
+    QHash<int, BodyLayout> layout;
+    layout.reserve(denseLayout.size());
+    for (int index = 0; index < denseLayout.size(); ++index) {
+        if (denseLayout.at(index).placed) {
+            layout.insert(graph.idAt(index), denseLayout.at(index));
+        }
     }
+    return layout;
+}
 
+SystemLayout SystemLayoutEngine::buildLayout(const BodyGraph& graph,
+                                             const QVector<BodyHot>& hotBodies,
+                                             const KeplerEphemeris* ephemeris,
+                                             const qint64 epochMs) {
+    Workspace workspace;
+    SystemLayout layout;
+    buildDenseLayout(graph, hotBodies, graph.rootIndices, ephemeris, epochMs, workspace, layout);
     return layout;
 }
 
-void SystemLayoutEngine::layoutChildrenRecursive(const QHash<int, CelestialBody>& bodyMap,
-                                                 QHash<int, BodyLayout>& layout,
-                                                 int bodyId,
-                                                 double pxPerAu,
-                                                 double fallbackDistancePx) {
-    if (!bodyMap.contains(bodyId) || !layout.contains(bodyId)) {
-        return;
-    }
+void SystemLayoutEngine::buildLayout(const BodyGraph& graph,
+                                     const QVector<BodyHot>& hotBodies,
+                                     Workspace& workspace,
+                                     SystemLayout& layout,
+                                     const KeplerEphemeris* ephemeris,
+                                     const qint64 epochMs) {
+    buildDenseLayout(graph, hotBodies, graph.rootIndices, ephemeris, epochMs, workspace, layout);
+}
 
-    const auto& body = bodyMap[bodyId];
-    if (body.children.isEmpty()) {
+void SystemLayoutEngine::advanceLayout(const BodyGraph& graph,
+                                       const KeplerEphemeris& ephemeris,
+                                       const EphemerisTable& tables,
+                                       const SystemLayout& baseLayout,
+                                       const qint64 epochMs,
+                                       SystemLayout& layout) {
+    const int bodyCount = baseLayout.size();
+    layout.extentAu = baseLayout.extentAu;
+    // Копия в существующий буфер: кадр прокрутки не выделяет память.
+    layout.bodies.resize(bodyCount);
+    std::copy(baseLayout.bodies.constBegin(), baseLayout.bodies.constEnd(), layout.bodies.begin());
+    if (graph.size() != bodyCount || ephemeris.size() != bodyCount || tables.bodyCount() != bodyCount
+        || tables.tableCount() == 0) {
         return;
     }
 
-    const auto parentPosition = layout[bodyId].position;
-
-    QVector<int> sortedChildren;
-    sortedChildren.reserve(body.children.size());
-    for (const int childId : body.children) {
-        const auto childIt = bodyMap.constFind(childId);
-        if (childIt == bodyMap.constEnd()) {
+    for (const int index : ephemeris.parentFirstOrder()) {
+        const int parentIndex = graph.parentIndex.at(index);
+        if (parentIndex < 0 || !baseLayout.at(index).placed || !baseLayout.at(parentIndex).placed) {
             continue;
         }
 
-        sortedChildren.push_back(childId);
+        QPointF offset = baseLayout.at(index).position - baseLayout.at(parentIndex).position;
+        double x = 0.0;
+        double y = 0.0;
+        double z = 0.0;
+        if (tables.evaluate(index, ephemeris.revolutionsSinceEpoch(index, epochMs), x, y, z)) {
+            // Как и при раскладке: проекция на опорную плоскость, большая полуось — orbitRadius схемы.
+            const double scale = baseLayout.at(index).orbitRadius / ephemeris.semiMajorAxisAu(index);
+            offset = QPointF(x * scale, y * scale);
+        }
+        layout.bodies[index].position = layout.bodies.at(parentIndex).position + offset;
+    }
+}
+
+void SystemLayoutEngine::buildDenseLayout(const BodyGraph& graph,
+                                          const QVector<BodyHot>& hotBodies,
+                                          const QVector<int>& rootIndices,
+                                          const KeplerEphemeris* ephemeris,
+                                          const qint64 epochMs,
+                                          Workspace& workspace,
+                                          SystemLayout& layout) {
+    const int bodyCount = graph.size();
+    layout.bodies.fill(BodyLayout(), bodyCount);
+    layout.extentAu = 0.0;
+
+    if (rootIndices.isEmpty()) {
+        return;
     }
 
-    std::sort(sortedChildren.begin(), sortedChildren.end(), [&](const int lhs, const int rhs) {
-        return lessForStableLayout(bodyMap[lhs], lhs, bodyMap[rhs], rhs);
-    });
+    // resize() не уменьшает ёмкость, поэтому на системе не крупнее прошлой память не выделяется.
+    workspace.priority.resize(bodyCount);
+    workspace.orbitAu.resize(bodyCount);
+    workspace.kindFlags.resize(bodyCount);
 
-    QVector<int> keyChildren;
-    keyChildren.reserve(2);
-    QVector<int> outerChildren;
-    outerChildren.reserve(sortedChildren.size());
+    double maxOrbitAu = 0.0;
+    for (int index = 0; index < bodyCount; ++index) {
+        const BodyHot& body = hotBodies.at(index);
+        workspace.priority[index] = static_cast<quint8>(bodyTypePriority(body));
+        workspace.orbitAu[index] = orbitalDistanceAu(body);
+        workspace.kindFlags[index] = (body.hasFlag(BodyHot::StarTypeFlag) ? StarKind : 0)
+                                   | (isBarycenterBody(body) ? BarycenterKind : 0);
+        maxOrbitAu = qMax(maxOrbitAu, workspace.orbitAu.at(index));
+    }
 
-    if (isBarycenterBody(body) && sortedChildren.size() >= 2) {
-        QVector<int> starChildren;
-        for (const int childId : sortedChildren) {
-            if (isStarBody(bodyMap[childId])) {
-                starChildren.push_back(childId);
+    if (ephemeris != nullptr && ephemeris->size() == bodyCount && ephemeris->phasedCount() > 0) {
+        ephemeris->solve(epochMs, workspace.ephemeris);
+        workspace.phaseX.resize(bodyCount);
+        workspace.phaseY.resize(bodyCount);
+        for (int index = 0; index < bodyCount; ++index) {
+            if (ephemeris->hasPhase(index)) {
+                // Проекция смещения на опорную плоскость орбит в долях большой полуоси.
+                const double semiMajorAxisAu = ephemeris->semiMajorAxisAu(index);
+                workspace.phaseX[index] = workspace.ephemeris.relativeX.at(index) / semiMajorAxisAu;
+                workspace.phaseY[index] = workspace.ephemeris.relativeY.at(index) / semiMajorAxisAu;
+                workspace.kindFlags[index] |= PhaseKind;
             }
         }
+    }
+
+    // Единственный проход упорядочивания: дети каждого родителя сортируются на месте
+    // в копии CSR-массива, дальше обход только читает готовые срезы.
+    workspace.orderedChildren.resize(graph.childIndices.size());
+    std::copy(graph.childIndices.constBegin(), graph.childIndices.constEnd(), workspace.orderedChildren.begin());
+    int* const ordered = workspace.orderedChildren.data();
+    for (int index = 0; index < bodyCount; ++index) {
+        if (graph.childCount(index) > 1) {
+            std::sort(ordered + graph.childOffsets.at(index),
+                      ordered + graph.childOffsets.at(index + 1),
+                      [&workspace](const int lhs, const int rhs) {
+                          return lessForStableLayout(workspace, lhs, rhs);
+                      });
+        }
+    }
+
+    // Без полуосей система на опорном холсте получает 85 px на а.е., как и раньше.
+    layout.extentAu = maxOrbitAu > 0.0 ? maxOrbitAu : (kReferenceHalfSizePx / 85.0);
+    // Запасные расстояния заданы в пикселях опорного холста и масштабируются вместе с системой.
+    const double auPerReferencePx = layout.extentAu / kReferenceHalfSizePx;
+
+    workspace.pending.clear();
+    workspace.pending.reserve(bodyCount);
+
+    if (rootIndices.size() == 1) {
+        placeAndQueue(workspace, layout.bodies, rootIndices.first(), BodyLayout{QPointF(), 9.0, 0.0},
+                      24.0 * auPerReferencePx);
+    } else {
+        // Если корней несколько (например, данные неполные), раскладываем их по кругу, чтобы не перекрывались.
+        // 0.15 меньшей стороны холста при полуразмере системы 0.72 стороны.
+        const double ringRadiusAu = layout.extentAu * (0.15 / 0.72);
+        for (int i = 0; i < rootIndices.size(); ++i) {
+            const double angle = (2.0 * M_PI * i) / qMax(1, rootIndices.size());
+            const QPointF position(qCos(angle) * ringRadiusAu, qSin(angle) * ringRadiusAu);
+            placeAndQueue(workspace, layout.bodies, rootIndices[i], BodyLayout{position, 8.0, 0.0},
+                          22.0 * auPerReferencePx);
+        }
+    }
+
+    // Явный стек вместо рекурсии: глубина иерархии ограничена только размером системы.
+    // Позиция ребёнка зависит лишь от родителя, поэтому порядок обхода на результат не влияет.
+    while (!workspace.pending.isEmpty()) {
+        const Workspace::PendingBody parent = workspace.pending.takeLast();
+        layoutChildren(graph, workspace, layout.bodies, parent, auPerReferencePx);
+    }
+}
+
+void SystemLayoutEngine::layoutChildren(const BodyGraph& graph,
+                                        Workspace& workspace,
+                                        QVector<BodyLayout>& layout,
+                                        const Workspace::PendingBody& parent,
+                                        const double auPerReferencePx) {
+    const int childCount = graph.childCount(parent.index);
+    if (childCount == 0) {
+        return;
+    }
 
-        if (starChildren.size() == 2) {
-            // Бинарная звезда: обе звезды всегда ставим в противоположные стороны от барицентра.
-            keyChildren = sortedByLayoutOrder(starChildren, bodyMap);
-            for (const int childId : sortedChildren) {
-                if (childId != keyChildren[0] && childId != keyChildren[1]) {
-                    outerChildren.push_back(childId);
+    const int* const children = workspace.orderedChildren.constData() + graph.childOffsets.at(parent.index);
+    const double fallbackDistanceAu = parent.fallbackDistanceAu;
+    const QPointF parentPosition = layout.at(parent.index).position;
+
+    int keyChildren[2] = {-1, -1};
+    if ((workspace.kindFlags.at(parent.index) & BarycenterKind) && childCount >= 2) {
+        int starCount = 0;
+        for (int i = 0; i < childCount; ++i) {
+            if (workspace.kindFlags.at(children[i]) & StarKind) {
+                if (starCount < 2) {
+                    keyChildren[starCount] = children[i];
                 }
+                ++starCount;
             }
-        } else {
-            // Фолбэк для неполных данных: берём два наиболее внутренних тела как ключевую пару.
-            QVector<int> byOrbit = sortedChildren;
-            std::sort(byOrbit.begin(), byOrbit.end(), [&](const int lhs, const int rhs) {
-                const double lhsOrbitAu = orbitalDistanceAu(bodyMap[lhs]);
-                const double rhsOrbitAu = orbitalDistanceAu(bodyMap[rhs]);
-                if (!qFuzzyCompare(lhsOrbitAu + 1.0, rhsOrbitAu + 1.0)) {
-                    return lhsOrbitAu < rhsOrbitAu;
-                }
-                return lessForStableLayout(bodyMap[lhs], lhs, bodyMap[rhs], rhs);
-            });
+        }
 
-            keyChildren = {byOrbit[0], byOrbit[1]};
-            for (const int childId : sortedChildren) {
-                if (childId != keyChildren[0] && childId != keyChildren[1]) {
-                    outerChildren.push_back(childId);
+        // Ровно две звезды — бинарная звезда: обе всегда ставим в противоположные стороны от барицентра.
+        if (starCount != 2) {
+            // Фолбэк для неполных данных: берём два наиболее внутренних тела как ключевую пару.
+            // Хватает линейного прохода — полная сортировка по орбитам не нужна.
+            keyChildren[0] = children[0];
+            keyChildren[1] = children[1];
+            if (lessByOrbit(workspace, keyChildren[1], keyChildren[0])) {
+                std::swap(keyChildren[0], keyChildren[1]);
+            }
+            for (int i = 2; i < childCount; ++i) {
+                if (lessByOrbit(workspace, children[i], keyChildren[0])) {
+                    keyChildren[1] = keyChildren[0];
+                    keyChildren[0] = children[i];
+                } else if (lessByOrbit(workspace, children[i], keyChildren[1])) {
+                    keyChildren[1] = children[i];
                 }
             }
         }
+        if (lessForStableLayout(workspace, keyChildren[1], keyChildren[0])) {
+            std::swap(keyChildren[0], keyChildren[1]);
+        }
     }
 
-    if (keyChildren.size() == 2) {
+    if (keyChildren[0] >= 0) {
         // Компоненты бинарной пары размещаем симметрично относительно барицентра.
-        std::sort(keyChildren.begin(), keyChildren.end(), [&](const int lhs, const int rhs) {
-            return lessForStableLayout(bodyMap[lhs], lhs, bodyMap[rhs], rhs);
-        });
-
-        const double innerFallbackPx = qMax(8.0, fallbackDistancePx * 0.55);
-        const double firstOrbitAu = orbitalDistanceAu(bodyMap[keyChildren[0]]);
-        const double secondOrbitAu = orbitalDistanceAu(bodyMap[keyChildren[1]]);
+        const double innerFallbackAu = qMax(8.0 * auPerReferencePx, fallbackDistanceAu * 0.55);
+        const double firstOrbitAu = workspace.orbitAu.at(keyChildren[0]);
+        const double secondOrbitAu = workspace.orbitAu.at(keyChildren[1]);
         // Компоненты бинарной пары должны лежать на одном диаметре. Если полуоси отличаются,
         // используем среднюю, чтобы обе звезды располагались строго симметрично.
         const double averagedOrbitAu = (firstOrbitAu > 0.0 && secondOrbitAu > 0.0)
             ? ((firstOrbitAu + secondOrbitAu) * 0.5)
             : 0.0;
-        const double pairDistancePx = averagedOrbitAu > 0.0 ? (averagedOrbitAu * pxPerAu) : innerFallbackPx;
+        const double pairDistanceAu = averagedOrbitAu > 0.0 ? averagedOrbitAu : innerFallbackAu;
 
-        for (int i = 0; i < keyChildren.size(); ++i) {
-            const int childId = keyChildren[i];
-            const double childAngle = M_PI * static_cast<double>(i);
-            const QPointF childPosition(parentPosition.x() + qCos(childAngle) * pairDistancePx,
-                                        parentPosition.y() + qSin(childAngle) * pairDistancePx);
-
-            layout.insert(childId, BodyLayout{childPosition, 6.0, pairDistancePx, pxPerAu});
-            layoutChildrenRecursive(bodyMap, layout, childId, pxPerAu, innerFallbackPx * 0.8);
+        // Пара лежит на одном диаметре; по известной фазе первого компонента он поворачивается.
+        const double pairAngle = (workspace.kindFlags.at(keyChildren[0]) & PhaseKind)
+            ? std::atan2(workspace.phaseY.at(keyChildren[0]), workspace.phaseX.at(keyChildren[0]))
+            : 0.0;
+        for (int i = 0; i < 2; ++i) {
+            const double angle = pairAngle + M_PI * static_cast<double>(i);
+            const QPointF childPosition = parentPosition + childOffset(workspace, keyChildren[i], angle, pairDistanceAu);
+            placeAndQueue(workspace, layout, keyChildren[i], BodyLayout{childPosition, 6.0, pairDistanceAu},
+                          innerFallbackAu * 0.8);
         }
 
-        outerChildren = sortedByLayoutOrder(outerChildren, bodyMap);
-
-        for (int i = 0; i < outerChildren.size(); ++i) {
-            const int childId = outerChildren[i];
-            const auto& child = bodyMap[childId];
-
-            const double orbitAu = orbitalDistanceAu(child);
+        // Внешние тела идут в порядке раскладки, ключевая пара пропускается.
+        const int outerCount = childCount - 2;
+        int outerIndex = 0;
+        for (int i = 0; i < childCount; ++i) {
+            const int childIndex = children[i];
+            if (childIndex == keyChildren[0] || childIndex == keyChildren[1]) {
+                continue;
+            }
+            const double orbitAu = workspace.orbitAu.at(childIndex);
             // Для всех объектов, орбитирующих барицентр (включая планеты),
             // радиус орбиты берём напрямую из полуоси. Это сохраняет физический смысл схемы.
-            const double scaledDistancePx = orbitAu * pxPerAu;
-            const double distancePx = orbitAu > 0.0 ? scaledDistancePx : (fallbackDistancePx * 0.65);
+            const double distanceAu = orbitAu > 0.0 ? orbitAu : (fallbackDistanceAu * 0.65);
 
-            const double childAngle = (2.0 * M_PI * i) / qMax(1, outerChildren.size());
-            const QPointF childPosition(parentPosition.x() + qCos(childAngle) * distancePx,
-                                        parentPosition.y() + qSin(childAngle) * distancePx);
+            const double angle = (2.0 * M_PI * outerIndex) / qMax(1, outerCount);
+            const QPointF childPosition = parentPosition + childOffset(workspace, childIndex, angle, distanceAu);
 
-            layout.insert(childId, BodyLayout{childPosition, 6.0, distancePx, pxPerAu});
-            layoutChildrenRecursive(bodyMap, layout, childId, pxPerAu, fallbackDistancePx * 0.85);
+            placeAndQueue(workspace, layout, childIndex, BodyLayout{childPosition, 6.0, distanceAu},
+                          fallbackDistanceAu * 0.85);
+            ++outerIndex;
         }
 
         return;
     }
 
-    for (int i = 0; i < sortedChildren.size(); ++i) {
-        const int childId = sortedChildren[i];
-        if (!bodyMap.contains(childId)) {
-            continue;
-        }
-
-        const auto& child = bodyMap[childId];
-        const double orbitAu = orbitalDistanceAu(child);
-        const double scaledDistancePx = orbitAu * pxPerAu;
-        const double distancePx = orbitAu > 0.0 ? scaledDistancePx : fallbackDistancePx;
+    for (int i = 0; i < childCount; ++i) {
+        const int childIndex = children[i];
+        const double orbitAu = workspace.orbitAu.at(childIndex);
+        const double distanceAu = orbitAu > 0.0 ? orbitAu : fallbackDistanceAu;
 
-        const double childAngle = (2.0 * M_PI * i) / qMax(1, sortedChildren.size());
-        const QPointF childPosition(parentPosition.x() + qCos(childAngle) * distancePx,
-                                    parentPosition.y() + qSin(childAngle) * distancePx);
+        const double angle = (2.0 * M_PI * i) / qMax(1, childCount);
+        const QPointF childPosition = parentPosition + childOffset(workspace, childIndex, angle, distanceAu);
 
-        layout.insert(childId, BodyLayout{childPosition, 6.0, distancePx, pxPerAu});
-        layoutChildrenRecursive(bodyMap, layout, childId, pxPerAu, fallbackDistancePx * 0.85);
+        placeAndQueue(workspace, layout, childIndex, BodyLayout{childPosition, 6.0, distanceAu},
+                      fallbackDistanceAu * 0.85);
     }
 }
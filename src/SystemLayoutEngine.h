@@ -2,27 +2,118 @@
 
 #include <QHash>
 #include <QPointF>
-#include <QRectF>
+#include <QSizeF>
+#include <QVector>
 
+#include "BodyGraph.h"
+#include "BodyRecords.h"
 #include "CelestialBody.h"
+#include "EphemerisTable.h"
+#include "KeplerEphemeris.h"
 
+// Координаты раскладки — астрономические единицы относительно корня системы
+// (ось Y направлена вниз, как на экране).
 struct BodyLayout {
     QPointF position;
+    // Радиус маркера в пикселях при зуме 1, если физический размер неизвестен.
     double radius = 6.0;
     double orbitRadius = 0.0;
-    double pxPerAu = 0.0;
+    // false — тело не достижимо из корней и не размещено.
+    bool placed = false;
+};
+
+Q_DECLARE_TYPEINFO(BodyLayout, Q_MOVABLE_TYPE);
+
+// Раскладка системы не зависит от размера холста: в пиксели её переводит масштаб pxPerAu()
+// при отрисовке, поэтому изменение размера виджета не требует повторной раскладки.
+struct SystemLayout {
+    // По индексам BodyGraph.
+    QVector<BodyLayout> bodies;
+    // Полуразмер системы в а.е.: самая дальняя орбита, а без полуосей — условная величина.
+    // 0 — ничего не размещено.
+    double extentAu = 0.0;
+
+    int size() const {
+        return bodies.size();
+    }
+
+    const BodyLayout& at(const int index) const {
+        return bodies.at(index);
+    }
+
+    // Пикселей на а.е. для холста: система занимает 0.72 меньшей стороны от центра.
+    double pxPerAu(const QSizeF& canvasSize) const;
 };
 
 class SystemLayoutEngine {
 public:
+    // Рабочие буферы раскладки. Ёмкость сохраняется между вызовами, поэтому повторная раскладка
+    // системы того же или меньшего размера не выделяет память.
+    struct Workspace {
+        struct PendingBody {
+            int index = -1;
+            double fallbackDistanceAu = 0.0;
+        };
+
+        QVector<quint8> priority;
+        QVector<double> orbitAu;
+        QVector<quint8> kindFlags;
+        // Смещение тела от родителя в опорной плоскости в долях большой полуоси; действует при известной фазе.
+        QVector<double> phaseX;
+        QVector<double> phaseY;
+        EphemerisState ephemeris;
+        // Копия BodyGraph::childIndices, где дети каждого родителя отсортированы в порядке раскладки.
+        QVector<int> orderedChildren;
+        // Размещённые тела, чьих детей ещё предстоит разложить (обход без рекурсии).
+        QVector<PendingBody> pending;
+    };
+
+    // Холст, под который подобраны запасные расстояния тел без полуосей, — минимальный
+    // размер SystemSceneWidget. На нём раскладка совпадает с прежней пиксельной.
+    static constexpr double kReferenceHalfSizePx = 432.0;
+
     static QHash<int, BodyLayout> buildLayout(const QHash<int, CelestialBody>& bodyMap,
-                                              const QVector<int>& roots,
-                                              const QRectF& canvasRect);
+                                              const QVector<int>& roots);
+    // Плотная раскладка по индексам графа, корни берутся из graph.rootIndices. С эфемеридами
+    // тела с известной фазой ставятся в своё положение на орбите на момент epochMs (большая
+    // полуось приводится к радиусу орбиты схемы), остальные — равномерно по кругу.
+    static SystemLayout buildLayout(const BodyGraph& graph,
+                                    const QVector<BodyHot>& hotBodies,
+                                    const KeplerEphemeris* ephemeris = nullptr,
+                                    qint64 epochMs = 0);
+    // То же с переиспользованием буферов: layout.bodies получает размер graph.size().
+    static void buildLayout(const BodyGraph& graph,
+                            const QVector<BodyHot>& hotBodies,
+                            Workspace& workspace,
+                            SystemLayout& layout,
+                            const KeplerEphemeris* ephemeris = nullptr,
+                            qint64 epochMs = 0);
+
+    // Раскладка на момент epochMs из готовой baseLayout без повторной раскладки и без решения
+    // уравнения Кеплера: тело с таблицей в tables переходит в своё положение на эллипсе орбиты
+    // (в масштабе baseLayout), остальные сохраняют смещение от родителя из baseLayout и следуют
+    // за ним. Вызывается на каждый кадр прокрутки времени.
+    static void advanceLayout(const BodyGraph& graph,
+                              const KeplerEphemeris& ephemeris,
+                              const EphemerisTable& tables,
+                              const SystemLayout& baseLayout,
+                              qint64 epochMs,
+                              SystemLayout& layout);
 
 private:
-    static void layoutChildrenRecursive(const QHash<int, CelestialBody>& bodyMap,
-                                        QHash<int, BodyLayout>& layout,
-                                        int bodyId,
-                                        double pxPerAu,
-                                        double fallbackDistancePx);
+    static void buildDenseLayout(const BodyGraph& graph,
+                                 const QVector<BodyHot>& hotBodies,
+                                 const QVector<int>& rootIndices,
+                                 const KeplerEphemeris* ephemeris,
+                                 qint64 epochMs,
+                                 Workspace& workspace,
+                                 SystemLayout& layout);
+
+    static void layoutChildren(const BodyGraph& graph,
+                               Workspace& workspace,
+                               QVector<BodyLayout>& layout,
+                               const Workspace::PendingBody& parent,
+                               double auPerReferencePx);
 };
+
+Q_DECLARE_TYPEINFO(SystemLayoutEngine::Workspace::PendingBody, Q_PRIMITIVE_TYPE);
@@ -2,6 +2,8 @@
 
 #include <QDebug>
 
+#include <algorithm>
+
 QHash<int, CelestialBody> SystemModelBuilder::buildBodyMap(const QVector<CelestialBody>& bodies) {
     QHash<int, CelestialBody> map;
     map.reserve(bodies.size());
@@ -11,7 +13,20 @@ QHash<int, CelestialBody> SystemModelBuilder::buildBodyMap(const QVector<Celesti
             continue;
         }
 
-        CelestialBody normalizedBody = body;
+        const auto existing = map.constFind(body.id);
+        if (existing != map.constEnd()) {
+            qWarning().noquote()
+                << QStringLiteral("[SystemModelBuilder][WARN] Duplicate body id=%1. Keeping the latest entry. Existing='%2' (%3), incoming='%4' (%5)")
+                       .arg(QString::number(body.id),
+                            existing->name.isEmpty() ? QStringLiteral("<без имени>") : existing->name,
+                            existing->type.isEmpty() ? QStringLiteral("<без типа>") : existing->type,
+                            body.name.isEmpty() ? QStringLiteral("<без имени>") : body.name,
+                            body.type.isEmpty() ? QStringLiteral("<без типа>") : body.type);
+        }
+
+        // Тело копируется в карту один раз, нормализация выполняется уже на месте.
+        CelestialBody& normalizedBody = map[body.id];
+        normalizedBody = body;
         if (normalizedBody.parentId == normalizedBody.id) {
             qWarning().noquote()
                 << QStringLiteral("[SystemModelBuilder][WARN] Invalid self-parent reference for body id=%1 ('%2'). Normalizing parent to virtual root.")
@@ -27,33 +42,6 @@ QHash<int, CelestialBody> SystemModelBuilder::buildBodyMap(const QVector<Celesti
             }
             normalizedBody.parentRelationType = QStringLiteral("Null");
         }
-
-        if (map.contains(normalizedBody.id)) {
-            const CelestialBody existing = map.value(body.id);
-            qWarning().noquote()
-                << QStringLiteral("[SystemModelBuilder][WARN] Duplicate body id=%1. Keeping the latest entry. Existing='%2' (%3), incoming='%4' (%5)")
-                       .arg(QString::number(normalizedBody.id),
-                            existing.name.isEmpty() ? QStringLiteral("<без имени>") : existing.name,
-                            existing.type.isEmpty() ? QStringLiteral("<без типа>") : existing.type,
-                            normalizedBody.name.isEmpty() ? QStringLiteral("<без имени>") : normalizedBody.name,
-                            normalizedBody.type.isEmpty() ? QStringLiteral("<без типа>") : normalizedBody.type);
-        }
-
-        map.insert(normalizedBody.id, normalizedBody);
-    }
-
-    for (auto it = map.begin(); it != map.end(); ++it) {
-        const int parentId = it->parentId;
-        if (parentId == it->id) {
-            qWarning().noquote()
-                << QStringLiteral("[SystemModelBuilder][WARN] Skipping self-parent link for body id=%1 while building children map.")
-                       .arg(QString::number(it->id));
-            continue;
-        }
-
-        if (parentId >= 0 && map.contains(parentId)) {
-            map[parentId].children.push_back(it->id);
-        }
     }
 
     return map;
@@ -83,3 +71,157 @@ QVector<int> SystemModelBuilder::findRootBodies(const QHash<int, CelestialBody>&
 
     return roots;
 }
+
+BodyGraph SystemModelBuilder::buildBodyGraph(const QHash<int, CelestialBody>& bodyMap) {
+    BodyGraph graph;
+    graph.bodyIds = bodyMap.keys().toVector();
+    std::sort(graph.bodyIds.begin(), graph.bodyIds.end());
+
+    const int bodyCount = graph.bodyIds.size();
+    graph.indexById.reserve(bodyCount);
+    for (int index = 0; index < bodyCount; ++index) {
+        graph.indexById.insert(graph.bodyIds.at(index), index);
+    }
+
+    graph.parentIndex.fill(-1, bodyCount);
+    graph.childOffsets.fill(0, bodyCount + 1);
+    for (int index = 0; index < bodyCount; ++index) {
+        const int bodyId = graph.bodyIds.at(index);
+        const int parentId = bodyMap.constFind(bodyId)->parentId;
+        if (parentId == bodyId) {
+            qWarning().noquote()
+                << QStringLiteral("[SystemModelBuilder][WARN] Skipping self-parent link for body id=%1 while building children map.")
+                       .arg(QString::number(bodyId));
+            continue;
+        }
+
+        const int parentIndex = parentId >= 0 ? graph.indexById.value(parentId, -1) : -1;
+        if (parentIndex < 0) {
+            continue;
+        }
+
+        graph.parentIndex[index] = parentIndex;
+        ++graph.childOffsets[parentIndex + 1];
+    }
+
+    for (int index = 0; index < bodyCount; ++index) {
+        graph.childOffsets[index + 1] += graph.childOffsets.at(index);
+    }
+
+    // Дети укладываются в порядке индексов, то есть по возрастанию id.
+    graph.childIndices.resize(graph.childOffsets.at(bodyCount));
+    QVector<int> cursor = graph.childOffsets;
+    for (int index = 0; index < bodyCount; ++index) {
+        const int parentIndex = graph.parentIndex.at(index);
+        if (parentIndex >= 0) {
+            graph.childIndices[cursor[parentIndex]++] = index;
+        }
+    }
+
+    const QVector<int> rootIds = findRootBodies(bodyMap);
+    graph.rootIndices.reserve(rootIds.size());
+    for (const int rootId : rootIds) {
+        graph.rootIndices.push_back(graph.indexById.value(rootId));
+    }
+
+    return graph;
+}
+
+QVector<BodyHot> SystemModelBuilder::buildHotRecords(const QHash<int, CelestialBody>& bodyMap, const BodyGraph& graph) {
+    QVector<BodyHot> records;
+    records.reserve(graph.size());
+    for (int index = 0; index < graph.size(); ++index) {
+        records.push_back(makeHotRecord(bodyMap.constFind(graph.idAt(index)).value()));
+    }
+    return records;
+}
+
+QVector<BodyCold> SystemModelBuilder::buildColdRecords(const QHash<int, CelestialBody>& bodyMap, const BodyGraph& graph) {
+    QVector<BodyCold> records;
+    records.reserve(graph.size());
+    for (int index = 0; index < graph.size(); ++index) {
+        records.push_back(makeColdRecord(bodyMap.constFind(graph.idAt(index)).value()));
+    }
+    return records;
+}
+
+BodyHot SystemModelBuilder::makeHotRecord(const CelestialBody& body) {
+    BodyHot hot;
+    hot.id = body.id;
+    hot.parentId = body.parentId;
+    hot.bodyClass = body.bodyClass;
+    hot.distanceToArrivalLs = body.distanceToArrivalLs;
+    hot.semiMajorAxisAu = body.semiMajorAxisAu;
+    hot.physicalRadiusKm = body.physicalRadiusKm;
+
+    // Парсеры заполняют таксономию сами; разбор строки здесь — только для тел,
+    // собранных в обход парсеров (синтетические записи, тесты).
+    const BodyTaxon taxon = body.taxon.resolved ? body.taxon : BodyTaxonomy::resolve(body.type);
+    hot.flags = static_cast<quint8>(taxon.typeFlags & BodyHot::kTypeFlagMask);
+    hot.starClass = taxon.starClass;
+    hot.luminosity = taxon.luminosity;
+    hot.planetSubtype = taxon.planetSubtype;
+    if (isVirtualBarycenterRoot(body)) {
+        hot.flags |= BodyHot::VirtualRootFlag;
+    }
+    if (body.orbitsBarycenter) {
+        hot.flags |= BodyHot::OrbitsBarycenterFlag;
+    }
+    return hot;
+}
+
+BodyCold SystemModelBuilder::makeColdRecord(const CelestialBody& body) {
+    BodyCold cold;
+    cold.parentRelationType = body.parentRelationType;
+    cold.name = body.name;
+    cold.type = body.type;
+    cold.orbit = body.orbit;
+    cold.surfaceGravityMs2 = body.surfaceGravityMs2;
+    cold.surfaceTemperatureK = body.surfaceTemperatureK;
+    cold.rotationPeriodDays = body.rotationPeriodDays;
+    cold.isTidallyLocked = body.isTidallyLocked;
+    cold.atmosphereSummary = body.atmosphereSummary;
+    cold.atmospherePressureAtm = body.atmospherePressureAtm;
+    cold.massEarth = body.massEarth;
+    cold.massSolar = body.massSolar;
+    cold.axialTiltDeg = body.axialTiltDeg;
+    cold.volcanism = body.volcanism;
+    cold.terraformingState = body.terraformingState;
+    cold.atmoComposition = body.atmoComposition;
+    cold.materials = body.materials;
+    return cold;
+}
+
+CelestialBody SystemModelBuilder::assembleBody(const BodyHot& hot, const BodyCold& cold) {
+    CelestialBody body;
+    body.id = hot.id;
+    body.parentId = hot.parentId;
+    body.parentRelationType = cold.parentRelationType;
+    body.name = cold.name;
+    body.type = cold.type;
+    body.distanceToArrivalLs = hot.distanceToArrivalLs;
+    body.semiMajorAxisAu = hot.semiMajorAxisAu;
+    body.orbit = cold.orbit;
+    body.physicalRadiusKm = hot.physicalRadiusKm;
+    body.surfaceGravityMs2 = cold.surfaceGravityMs2;
+    body.surfaceTemperatureK = cold.surfaceTemperatureK;
+    body.rotationPeriodDays = cold.rotationPeriodDays;
+    body.isTidallyLocked = cold.isTidallyLocked;
+    body.atmosphereSummary = cold.atmosphereSummary;
+    body.atmospherePressureAtm = cold.atmospherePressureAtm;
+    body.massEarth = cold.massEarth;
+    body.massSolar = cold.massSolar;
+    body.axialTiltDeg = cold.axialTiltDeg;
+    body.volcanism = cold.volcanism;
+    body.terraformingState = cold.terraformingState;
+    body.atmoComposition = cold.atmoComposition;
+    body.materials = cold.materials;
+    body.orbitsBarycenter = hot.hasFlag(BodyHot::OrbitsBarycenterFlag);
+    body.bodyClass = hot.bodyClass;
+    body.taxon.starClass = hot.starClass;
+    body.taxon.luminosity = hot.luminosity;
+    body.taxon.planetSubtype = hot.planetSubtype;
+    body.taxon.typeFlags = static_cast<quint8>(hot.flags & BodyHot::kTypeFlagMask);
+    body.taxon.resolved = true;
+    return body;
+}
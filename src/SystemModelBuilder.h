@@ -3,10 +3,20 @@
 #include <QHash>
 #include <QVector>
 
+#include "BodyGraph.h"
+#include "BodyRecords.h"
 #include "CelestialBody.h"
 
 class SystemModelBuilder {
 public:
     static QHash<int, CelestialBody> buildBodyMap(const QVector<CelestialBody>& bodies);
     static QVector<int> findRootBodies(const QHash<int, CelestialBody>& bodyMap);
+    static BodyGraph buildBodyGraph(const QHash<int, CelestialBody>& bodyMap);
+
+    // Горячие и холодные записи раскладываются по индексам графа.
+    static QVector<BodyHot> buildHotRecords(const QHash<int, CelestialBody>& bodyMap, const BodyGraph& graph);
+    static QVector<BodyCold> buildColdRecords(const QHash<int, CelestialBody>& bodyMap, const BodyGraph& graph);
+    static BodyHot makeHotRecord(const CelestialBody& body);
+    static BodyCold makeColdRecord(const CelestialBody& body);
+    static CelestialBody assembleBody(const BodyHot& hot, const BodyCold& cold);
 };
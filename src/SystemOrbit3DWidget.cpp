@@ -0,0 +1,326 @@
+#include "SystemOrbit3DWidget.h"
+
+#include <QDateTime>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QShowEvent>
+#include <QWheelEvent>
+#include <QtMath>
+
+#include <cmath>
+
+namespace {
+
+// Начальный вид наклонён на 60° от вида сверху: видно и форму орбит, и их наклон.
+constexpr double kDefaultPitchRad = M_PI / 3.0;
+constexpr double kRadiansPerDragPx = 0.01;
+// Сцена при зуме 1 занимает 90% меньшей стороны виджета.
+constexpr double kFitFraction = 0.45;
+constexpr int kReferenceSegments = 96;
+constexpr double kHitSlopPx = 3.0;
+// Полное решение Кеплера по всем телам при прокрутке времени — не чаще 10 раз в секунду.
+constexpr int kEpochSolveIntervalMs = 100;
+
+QColor bodyColorForClass(const CelestialBody::BodyClass bodyClass) {
+    switch (bodyClass) {
+    case CelestialBody::BodyClass::Star:
+        return QColor(255, 206, 92);
+    case CelestialBody::BodyClass::Planet:
+        return QColor(98, 176, 255);
+    case CelestialBody::BodyClass::Moon:
+        return QColor(166, 166, 176);
+    case CelestialBody::BodyClass::Barycenter:
+    case CelestialBody::BodyClass::Unknown:
+        break;
+    }
+
+    return QColor(190, 210, 240);
+}
+
+// Размер тел в настоящем масштабе меньше пикселя, поэтому тела рисуются метками по классу.
+double bodyMarkerRadiusPx(const CelestialBody::BodyClass bodyClass) {
+    switch (bodyClass) {
+    case CelestialBody::BodyClass::Star:
+        return 6.0;
+    case CelestialBody::BodyClass::Planet:
+        return 4.0;
+    case CelestialBody::BodyClass::Moon:
+        return 2.5;
+    case CelestialBody::BodyClass::Barycenter:
+    case CelestialBody::BodyClass::Unknown:
+        return 2.0;
+    }
+
+    return 2.0;
+}
+
+bool isDrawnBody(const BodyHot& hot) {
+    return hot.bodyClass != CelestialBody::BodyClass::Barycenter && !hot.hasFlag(BodyHot::VirtualRootFlag);
+}
+
+} // namespace
+
+SystemOrbit3DWidget::SystemOrbit3DWidget(QWidget* parent)
+    : QWidget(parent),
+      m_pitchRad(kDefaultPitchRad) {
+    setMinimumSize(320, 240);
+
+    m_epochTimer.setSingleShot(true);
+    m_epochTimer.setInterval(kEpochSolveIntervalMs);
+    connect(&m_epochTimer, &QTimer::timeout, this, [this]() {
+        applyPendingEpoch();
+    });
+}
+
+void SystemOrbit3DWidget::setSnapshot(const SystemSnapshot& snapshot) {
+    m_snapshot = snapshot;
+    m_yawRad = 0.0;
+    m_pitchRad = kDefaultPitchRad;
+    m_zoom = 1.0;
+    m_isDragging = false;
+    m_movedSincePress = false;
+    m_selectedBodyId = -1;
+    m_epochPending = false;
+    m_epochTimer.stop();
+
+    const KeplerEphemeris& ephemeris = m_snapshot.ephemeris();
+    m_scene.build(ephemeris);
+    ephemeris.solve(QDateTime::currentMSecsSinceEpoch(), m_state);
+    m_scene.place(m_state);
+    m_fitExtentAu = m_scene.extentAu() > 0.0 ? m_scene.extentAu() : 1.0;
+
+    m_referenceX.resize(kReferenceSegments + 1);
+    m_referenceY.resize(kReferenceSegments + 1);
+    m_referenceZ.fill(0.0, kReferenceSegments + 1);
+    for (int point = 0; point <= kReferenceSegments; ++point) {
+        const double angle = point == kReferenceSegments ? 0.0 : (2.0 * M_PI * point) / kReferenceSegments;
+        m_referenceX[point] = m_fitExtentAu * std::cos(angle);
+        m_referenceY[point] = m_fitExtentAu * std::sin(angle);
+    }
+    m_referenceScreenX.resize(kReferenceSegments + 1);
+    m_referenceScreenY.resize(kReferenceSegments + 1);
+    m_referenceDepth.resize(kReferenceSegments + 1);
+
+    update();
+}
+
+void SystemOrbit3DWidget::setSceneEpoch(const qint64 epochMs) {
+    if (m_snapshot.isEmpty()) {
+        return;
+    }
+
+    m_pendingEpochMs = epochMs;
+    m_epochPending = m_state.epochMs != epochMs;
+    // Скрытый вид (по умолчанию) решает момент только в showEvent; видимый копит моменты
+    // прокрутки и решает последний по таймеру, а не на каждый шаг воспроизведения.
+    if (m_epochPending && isVisible() && !m_epochTimer.isActive()) {
+        m_epochTimer.start();
+    }
+}
+
+void SystemOrbit3DWidget::applyPendingEpoch() {
+    if (!m_epochPending || m_snapshot.isEmpty()) {
+        return;
+    }
+
+    m_snapshot.ephemeris().solve(m_pendingEpochMs, m_state);
+    m_epochPending = false;
+    m_scene.place(m_state);
+    update();
+}
+
+void SystemOrbit3DWidget::showEvent(QShowEvent* event) {
+    QWidget::showEvent(event);
+    applyPendingEpoch();
+}
+
+ViewProjection3D SystemOrbit3DWidget::currentProjection() const {
+    ViewProjection3D view;
+    view.yawRad = m_yawRad;
+    view.pitchRad = m_pitchRad;
+    view.pxPerAu = kFitFraction * qMin(width(), height()) / m_fitExtentAu * m_zoom;
+    view.originX = width() / 2.0;
+    view.originY = height() / 2.0;
+    // Выбранное тело стоит в центре вида: зум колесом приближает его окрестности, и луны
+    // в настоящем масштабе можно рассмотреть рядом с планетой.
+    const int focusIndex = m_selectedBodyId >= 0 ? m_snapshot.graph().indexById.value(m_selectedBodyId, -1) : -1;
+    if (focusIndex >= 0 && focusIndex < m_state.x.size()) {
+        double focusX = 0.0;
+        double focusY = 0.0;
+        double focusDepth = 0.0;
+        view.project(&m_state.x.at(focusIndex), &m_state.y.at(focusIndex), &m_state.z.at(focusIndex), 1,
+                     &focusX, &focusY, &focusDepth);
+        view.originX -= focusX - view.originX;
+        view.originY -= focusY - view.originY;
+    }
+    return view;
+}
+
+void SystemOrbit3DWidget::paintEvent(QPaintEvent* event) {
+    QWidget::paintEvent(event);
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.fillRect(rect(), QColor(10, 15, 24));
+
+    painter.setPen(QColor(180, 200, 255));
+    const QString& systemName = m_snapshot.systemName();
+    painter.drawText(20, 30, QStringLiteral("3D: %1").arg(systemName.isEmpty() ? QStringLiteral("—") : systemName));
+    painter.setPen(QColor(120, 140, 180));
+    painter.drawText(20, 50, QStringLiteral("Перетаскивание — поворот, колесо — масштаб, клик по телу — центр вида"));
+
+    const QVector<BodyHot>& hotBodies = m_snapshot.hotBodies();
+    if (hotBodies.isEmpty() || m_state.x.size() != hotBodies.size()) {
+        return;
+    }
+
+    const ViewProjection3D view = currentProjection();
+    m_scene.project(view, m_state);
+    view.project(m_referenceX.constData(), m_referenceY.constData(), m_referenceZ.constData(), m_referenceX.size(),
+                 m_referenceScreenX.data(), m_referenceScreenY.data(), m_referenceDepth.data());
+
+    m_polyline.resize(kReferenceSegments + 1);
+    for (int point = 0; point <= kReferenceSegments; ++point) {
+        m_polyline[point] = QPointF(m_referenceScreenX.at(point), m_referenceScreenY.at(point));
+    }
+    painter.setPen(QPen(QColor(60, 72, 96, 160), 1.0, Qt::DashLine));
+    painter.drawPolyline(m_polyline.constData(), m_polyline.size());
+
+    painter.setPen(QPen(QColor(84, 111, 168, 150), 1.0));
+    m_polyline.resize(OrbitScene3D::kPointsPerOrbit);
+    for (int orbit = 0; orbit < m_scene.orbitCount(); ++orbit) {
+        const double* const screenX = m_scene.orbitScreenX(orbit);
+        const double* const screenY = m_scene.orbitScreenY(orbit);
+        for (int point = 0; point < OrbitScene3D::kPointsPerOrbit; ++point) {
+            m_polyline[point] = QPointF(screenX[point], screenY[point]);
+        }
+        painter.drawPolyline(m_polyline.constData(), m_polyline.size());
+    }
+
+    // Тела от дальних к ближним: ближнее тело перекрывает то, что за ним.
+    const QVector<double>& bodyScreenX = m_scene.bodyScreenX();
+    const QVector<double>& bodyScreenY = m_scene.bodyScreenY();
+    int selectedIndex = -1;
+    for (const int index : m_scene.bodyDepthOrder()) {
+        const BodyHot& hot = hotBodies.at(index);
+        if (!isDrawnBody(hot)) {
+            continue;
+        }
+
+        const double radius = bodyMarkerRadiusPx(hot.bodyClass);
+        const QPointF center(bodyScreenX.at(index), bodyScreenY.at(index));
+        painter.setPen(hot.id == m_selectedBodyId ? QPen(QColor(255, 255, 255), 1.5) : QPen(QColor(10, 15, 24), 1.0));
+        painter.setBrush(bodyColorForClass(hot.bodyClass));
+        painter.drawEllipse(center, radius, radius);
+        if (hot.id == m_selectedBodyId) {
+            selectedIndex = index;
+        }
+    }
+
+    if (selectedIndex >= 0) {
+        const double radius = bodyMarkerRadiusPx(hotBodies.at(selectedIndex).bodyClass);
+        painter.setPen(QColor(220, 230, 245));
+        painter.drawText(QPointF(bodyScreenX.at(selectedIndex) + radius + 6.0, bodyScreenY.at(selectedIndex) - radius - 4.0),
+                         m_snapshot.coldBodies().at(selectedIndex).name);
+    }
+}
+
+int SystemOrbit3DWidget::findBodyAt(const QPointF& widgetPos) const {
+    const QVector<BodyHot>& hotBodies = m_snapshot.hotBodies();
+    const QVector<double>& bodyScreenX = m_scene.bodyScreenX();
+    const QVector<double>& bodyScreenY = m_scene.bodyScreenY();
+    if (bodyScreenX.size() != hotBodies.size()) {
+        return -1;
+    }
+
+    // С конца порядка глубины: из перекрывающихся меток выбирается ближняя к зрителю.
+    const QVector<int>& depthOrder = m_scene.bodyDepthOrder();
+    for (int position = depthOrder.size() - 1; position >= 0; --position) {
+        const int index = depthOrder.at(position);
+        const BodyHot& hot = hotBodies.at(index);
+        if (!isDrawnBody(hot)) {
+            continue;
+        }
+
+        const double deltaX = widgetPos.x() - bodyScreenX.at(index);
+        const double deltaY = widgetPos.y() - bodyScreenY.at(index);
+        const double hitRadius = bodyMarkerRadiusPx(hot.bodyClass) + kHitSlopPx;
+        if (deltaX * deltaX + deltaY * deltaY <= hitRadius * hitRadius) {
+            return hot.id;
+        }
+    }
+
+    return -1;
+}
+
+void SystemOrbit3DWidget::mousePressEvent(QMouseEvent* event) {
+    if (event->button() == Qt::LeftButton) {
+        m_isDragging = true;
+        m_movedSincePress = false;
+        m_pressPos = event->pos();
+        m_lastMousePos = event->pos();
+        setCursor(Qt::ClosedHandCursor);
+        event->accept();
+        return;
+    }
+
+    QWidget::mousePressEvent(event);
+}
+
+void SystemOrbit3DWidget::mouseMoveEvent(QMouseEvent* event) {
+    if (m_isDragging) {
+        const QPoint delta = event->pos() - m_lastMousePos;
+        m_lastMousePos = event->pos();
+        if (!m_movedSincePress && (event->pos() - m_pressPos).manhattanLength() > 3) {
+            m_movedSincePress = true;
+        }
+        // Поворот меняет только матрицу проекции: точки сцены не пересчитываются.
+        m_yawRad = std::remainder(m_yawRad + delta.x() * kRadiansPerDragPx, 2.0 * M_PI);
+        m_pitchRad = qBound(-M_PI / 2.0, m_pitchRad - delta.y() * kRadiansPerDragPx, M_PI / 2.0);
+        update();
+        event->accept();
+        return;
+    }
+
+    QWidget::mouseMoveEvent(event);
+}
+
+void SystemOrbit3DWidget::mouseReleaseEvent(QMouseEvent* event) {
+    if (event->button() == Qt::LeftButton && m_isDragging) {
+        const bool treatAsClick = !m_movedSincePress;
+        m_isDragging = false;
+        unsetCursor();
+
+        if (treatAsClick) {
+            const int bodyId = findBodyAt(event->pos());
+            m_selectedBodyId = bodyId;
+            if (bodyId >= 0) {
+                emit bodyClicked(bodyId);
+            }
+            update();
+        }
+
+        event->accept();
+        return;
+    }
+
+    QWidget::mouseReleaseEvent(event);
+}
+
+void SystemOrbit3DWidget::wheelEvent(QWheelEvent* event) {
+    const QPoint numDegrees = event->angleDelta() / 8;
+    if (numDegrees.isNull()) {
+        QWidget::wheelEvent(event);
+        return;
+    }
+
+    const double step = numDegrees.y() / 15.0;
+    const double newZoom = qBound(0.05, m_zoom * std::pow(1.15, step), 100000.0);
+    if (qFuzzyCompare(newZoom, m_zoom)) {
+        return;
+    }
+
+    m_zoom = newZoom;
+    update();
+    event->accept();
+}
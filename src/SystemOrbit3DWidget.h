@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QPoint>
+#include <QPointF>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+
+#include "KeplerEphemeris.h"
+#include "OrbitScene3D.h"
+#include "SystemSnapshot.h"
+
+// Трёхмерный вид орбит системы в настоящем масштабе а.е. с учётом наклонения и долготы
+// восходящего узла. Проекция программная, рисование — обычным QPainter, поэтому вид
+// работает и без GPU. Перетаскивание мышью поворачивает вид, колесо меняет масштаб вокруг
+// выбранного тела.
+class SystemOrbit3DWidget : public QWidget {
+    Q_OBJECT
+public:
+    explicit SystemOrbit3DWidget(QWidget* parent = nullptr);
+
+    void setSnapshot(const SystemSnapshot& snapshot);
+    // Момент, на который стоят тела: обычно момент шкалы времени плоской схемы. Скрытый вид
+    // только запоминает момент и решает его при показе; видимый решает не чаще раза за
+    // интервал таймера, беря последний из пришедших моментов.
+    void setSceneEpoch(qint64 epochMs);
+
+signals:
+    void bodyClicked(int bodyId);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+
+private:
+    ViewProjection3D currentProjection() const;
+    int findBodyAt(const QPointF& widgetPos) const;
+    void applyPendingEpoch();
+
+    SystemSnapshot m_snapshot;
+    EphemerisState m_state;
+    // Момент, ещё не решённый для m_state (m_epochPending == false — тела уже на нём).
+    qint64 m_pendingEpochMs = 0;
+    bool m_epochPending = false;
+    QTimer m_epochTimer;
+    OrbitScene3D m_scene;
+    // Окружность в опорной плоскости на краю сцены: по её наклону видно, откуда смотрим.
+    QVector<double> m_referenceX;
+    QVector<double> m_referenceY;
+    QVector<double> m_referenceZ;
+    QVector<double> m_referenceScreenX;
+    QVector<double> m_referenceScreenY;
+    QVector<double> m_referenceDepth;
+    // Буфер ломаной кадра.
+    QVector<QPointF> m_polyline;
+    // Размер сцены на момент загрузки системы: масштаб не дёргается при прокрутке времени.
+    double m_fitExtentAu = 1.0;
+
+    double m_yawRad = 0.0;
+    double m_pitchRad = 0.0;
+    double m_zoom = 1.0;
+    bool m_isDragging = false;
+    bool m_movedSincePress = false;
+    QPoint m_lastMousePos;
+    QPoint m_pressPos;
+    int m_selectedBodyId = -1;
+};
@@ -5,13 +5,22 @@
 
 #include <QtGlobal>
 
+#include <QComboBox>
+#include <QDateTime>
 #include <QFontMetrics>
+#include <QHBoxLayout>
+#include <QLabel>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QSignalBlocker>
+#include <QSlider>
+#include <QToolButton>
+#include <QVBoxLayout>
 #include <QWheelEvent>
+#include <QtConcurrent>
 
 namespace {
-QColor bodyColorForClass(const CelestialBody::BodyClass bodyClass, const QSet<BodyOrbitType>& bodyTypes) {
+QColor bodyColorForClass(const CelestialBody::BodyClass bodyClass, const BodyOrbitTypes bodyTypes) {
     QColor bodyColor(190, 210, 240);
     switch (bodyClass) {
     case CelestialBody::BodyClass::Star:
@@ -28,9 +37,9 @@ QColor bodyColorForClass(const CelestialBody::BodyClass bodyClass, const QSet<Bo
         break;
     }
 
-    if (bodyTypes.contains(BodyOrbitType::BinaryPlanetComponent)) {
+    if (bodyTypes.testFlag(BodyOrbitType::BinaryPlanetComponent)) {
         bodyColor = QColor(140, 255, 168);
-    } else if (bodyTypes.contains(BodyOrbitType::CircumbinaryPlanet)) {
+    } else if (bodyTypes.testFlag(BodyOrbitType::CircumbinaryPlanet)) {
         bodyColor = QColor(126, 255, 200);
     }
 
@@ -74,6 +83,44 @@ constexpr double visualMaxWidgetRadiusPx = 170.0;
 constexpr double bodyLabelMaxWidthPx = 220.0;
 constexpr int bodyLabelMaxLines = 2;
 
+// Шкала времени: ±10 лет от момента загрузки системы с шагом в час.
+constexpr int kTimelineRangeHours = 10 * 8766;
+constexpr qint64 kMsPerHour = 3600000;
+constexpr double kMsPerDay = 86400000.0;
+constexpr int kPlaybackIntervalMs = 16;
+// Зум колесом не имеет явного конца: таблицы эфемерид запрашиваются, когда колесо замерло на столько.
+constexpr int kViewSettleDelayMs = 150;
+
+// Разведение перекрытий: значок уходит от своей точки орбиты не дальше чем подпись,
+// и на расталкивание кадр тратит не больше бюджета — недоделанное продолжится в следующем.
+constexpr double kDeclutterGlyphMaxOffsetPx = 10.0;
+constexpr double kDeclutterLabelMaxOffsetPx = 60.0;
+constexpr qint64 kDeclutterBudgetNs = 2000000;
+// Подпись, отодвинутая дальше этого, соединяется со своим телом линией.
+constexpr double kLeaderLineMinOffsetPx = 4.0;
+
+// Подписи ставятся по убыванию важности: выбранное тело, звёзды, планеты, спутники, прочее.
+int labelPriority(const BodyHot& body, const bool selected) {
+    if (selected) {
+        return 4;
+    }
+    if (body.bodyClass == CelestialBody::BodyClass::Star) {
+        return 3;
+    }
+    if (body.bodyClass == CelestialBody::BodyClass::Planet || body.hasFlag(BodyHot::PlanetTypeFlag)) {
+        return 2;
+    }
+    return body.bodyClass == CelestialBody::BodyClass::Moon ? 1 : 0;
+}
+
+int glyphDeclutterKey(const int index) {
+    return 2 * index;
+}
+
+int labelDeclutterKey(const int index) {
+    return 2 * index + 1;
+}
+
 #ifndef SIMPLE_EDT_LABEL_DEBUG
 #define SIMPLE_EDT_LABEL_DEBUG 0
 #endif
@@ -84,51 +131,50 @@ bool isDebugLabelModeEnabled() {
     return enabled;
 }
 
-QString scientificTypeLabel(const CelestialBody& body) {
-    const QString type = body.type.trimmed();
-    const QString lowerType = type.toLower();
-
-    if (lowerType.contains(QStringLiteral("water world"))) {
+QString scientificTypeLabel(const BodyHot& body) {
+    switch (body.planetSubtype) {
+    case PlanetSubtype::WaterWorld:
         return QStringLiteral("водный мир");
-    }
-    if (lowerType.contains(QStringLiteral("ice giant"))) {
+    case PlanetSubtype::IceGiant:
         return QStringLiteral("ледяной гигант");
-    }
-    if (lowerType.contains(QStringLiteral("gas giant"))) {
-        return QStringLiteral("газовый гигант");
-    }
-    if (lowerType.contains(QStringLiteral("earth-like"))) {
+    case PlanetSubtype::EarthLike:
         return QStringLiteral("землеподобный мир");
-    }
-    if (lowerType.contains(QStringLiteral("high metal")) || lowerType.contains(QStringLiteral("metal-rich"))) {
+    case PlanetSubtype::HighMetalContent:
+    case PlanetSubtype::MetalRich:
         return QStringLiteral("металлический мир");
-    }
-    if (lowerType.contains(QStringLiteral("rocky"))) {
+    case PlanetSubtype::Rocky:
+    case PlanetSubtype::RockyIce:
         return QStringLiteral("каменистый мир");
-    }
-    if (lowerType.contains(QStringLiteral("icy")) || lowerType.contains(QStringLiteral("ice world"))) {
+    case PlanetSubtype::Icy:
         return QStringLiteral("ледяной мир");
-    }
-    if (lowerType.contains(QStringLiteral("ammonia world"))) {
+    case PlanetSubtype::AmmoniaWorld:
         return QStringLiteral("аммиачный мир");
+    default:
+        if (BodyTaxonomy::isGasGiant(body.planetSubtype)) {
+            return QStringLiteral("газовый гигант");
+        }
+        break;
     }
-    if (lowerType.contains(QStringLiteral("helium-rich"))) {
-        return QStringLiteral("гелиевый гигант");
-    }
-    if (lowerType.contains(QStringLiteral("red dwarf"))) {
-        return QStringLiteral("красный карлик");
-    }
-    if (lowerType.contains(QStringLiteral("white dwarf"))) {
+
+    switch (body.starClass) {
+    case StarClass::M:
+        if (body.luminosity == StarLuminosity::MainSequence) {
+            return QStringLiteral("красный карлик");
+        }
+        break;
+    case StarClass::WhiteDwarf:
         return QStringLiteral("белый карлик");
-    }
-    if (lowerType.contains(QStringLiteral("brown dwarf"))) {
+    case StarClass::L:
+    case StarClass::T:
+    case StarClass::Y:
         return QStringLiteral("коричневый карлик");
-    }
-    if (lowerType.contains(QStringLiteral("neutron"))) {
+    case StarClass::Neutron:
         return QStringLiteral("нейтронная звезда");
-    }
-    if (lowerType.contains(QStringLiteral("black hole"))) {
+    case StarClass::BlackHole:
+    case StarClass::SupermassiveBlackHole:
         return QStringLiteral("чёрная дыра");
+    default:
+        break;
     }
 
     switch (body.bodyClass) {
@@ -163,7 +209,7 @@ QString compactWrappedLabel(const QString& text, const QFontMetrics& metrics, co
 
     for (int i = 0; i < words.size(); ++i) {
         const QString& word = words[i];
-        const QString candidate = currentLine.isEmpty() ? word : QStringLiteral("%1 %2").arg(currentLine, word);
+        const QString candidate = currentLine.isEmpty() ? word : currentLine + QLatin1Char(' ') + word;
         if (metrics.horizontalAdvance(candidate) <= maxWidthPx) {
             currentLine = candidate;
             continue;
@@ -202,19 +248,95 @@ SystemSceneWidget::SystemSceneWidget(QWidget* parent)
     setMinimumSize(900, 600);
     setAutoFillBackground(true);
     setMouseTracking(true);
+    setupTimeline();
+
+    m_viewSettleTimer.setSingleShot(true);
+    m_viewSettleTimer.setInterval(kViewSettleDelayMs);
+    connect(&m_viewSettleTimer, &QTimer::timeout, this, [this]() {
+        // Во время перетаскивания ждём отпускания кнопки: конец сдвига запросит таблицы сам.
+        if (!m_isDragging) {
+            requestVisibleEphemerisTables();
+        }
+    });
 }
 
-void SystemSceneWidget::setSystemData(const QString& systemName,
-                                      const QHash<int, CelestialBody>& bodyMap,
-                                      const QVector<int>& roots) {
-    m_systemName = systemName;
-    m_bodyMap = bodyMap;
-    m_roots = roots;
+SystemSceneWidget::~SystemSceneWidget() {
+    m_viewSettleTimer.stop();
+    m_playbackTimer.stop();
+    m_ephemerisTableWatcher.waitForFinished();
+}
+
+void SystemSceneWidget::setupTimeline() {
+    m_timelineBar = new QWidget(this);
+    m_timelineBar->setAutoFillBackground(true);
+    auto* timelineLayout = new QHBoxLayout(m_timelineBar);
+    timelineLayout->setContentsMargins(8, 4, 8, 4);
+
+    m_playButton = new QToolButton(m_timelineBar);
+    m_playButton->setCheckable(true);
+    m_playButton->setText(QStringLiteral("▶"));
+    m_playButton->setToolTip(QStringLiteral("Воспроизвести движение тел по орбитам"));
+
+    m_nowButton = new QToolButton(m_timelineBar);
+    m_nowButton->setText(QStringLiteral("Сейчас"));
+    m_nowButton->setToolTip(QStringLiteral("Вернуться к моменту загрузки системы"));
+
+    m_timelineSlider = new QSlider(Qt::Horizontal, m_timelineBar);
+    m_timelineSlider->setRange(-kTimelineRangeHours, kTimelineRangeHours);
+    m_timelineSlider->setValue(0);
+    m_timelineSlider->setToolTip(QStringLiteral("Сдвиг времени: ±10 лет от момента загрузки системы"));
+
+    m_playbackSpeedCombo = new QComboBox(m_timelineBar);
+    m_playbackSpeedCombo->addItem(QStringLiteral("1 сут/с"), 1.0);
+    m_playbackSpeedCombo->addItem(QStringLiteral("1 мес/с"), 30.0);
+    m_playbackSpeedCombo->addItem(QStringLiteral("1 год/с"), 365.25);
+    m_playbackSpeedCombo->setToolTip(QStringLiteral("Скорость воспроизведения"));
+
+    m_timelineLabel = new QLabel(m_timelineBar);
+
+    timelineLayout->addWidget(m_playButton);
+    timelineLayout->addWidget(m_nowButton);
+    timelineLayout->addWidget(m_timelineSlider, 1);
+    timelineLayout->addWidget(m_playbackSpeedCombo);
+    timelineLayout->addWidget(m_timelineLabel);
+
+    auto* sceneLayout = new QVBoxLayout(this);
+    sceneLayout->setContentsMargins(0, 0, 0, 0);
+    sceneLayout->addStretch(1);
+    sceneLayout->addWidget(m_timelineBar);
+
+    m_playbackTimer.setInterval(kPlaybackIntervalMs);
+    connect(&m_playbackTimer, &QTimer::timeout, this, [this]() {
+        advancePlayback();
+    });
+    connect(m_playButton, &QToolButton::toggled, this, [this](const bool checked) {
+        setPlaybackActive(checked);
+    });
+    connect(m_nowButton, &QToolButton::clicked, this, [this]() {
+        setSceneEpoch(m_baseEpochMs);
+    });
+    connect(m_timelineSlider, &QSlider::valueChanged, this, [this](const int hours) {
+        setSceneEpoch(m_baseEpochMs + hours * kMsPerHour);
+    });
+    connect(&m_ephemerisTableWatcher, &QFutureWatcher<EphemerisTable>::finished, this, [this]() {
+        if (m_ephemerisTableGeneration == m_snapshotGeneration) {
+            m_ephemerisTable.merge(m_ephemerisTableWatcher.result());
+        }
+        applySceneEpoch();
+    });
+
+    // До загрузки системы с известными фазами двигать нечего.
+    m_timelineBar->setEnabled(false);
+}
+
+void SystemSceneWidget::setSnapshot(const SystemSnapshot& snapshot) {
+    m_playButton->setChecked(false);
+    ++m_snapshotGeneration;
+    m_snapshot = snapshot;
     m_zoom = 1.0;
     m_panOffset = QPointF(0.0, 0.0);
     m_isDragging = false;
     m_movedSincePress = false;
-    m_orbitClassification = OrbitClassifier::classify(m_bodyMap);
     m_selectedBodyId = -1;
     rebuildLayout();
 }
@@ -228,6 +350,16 @@ void SystemSceneWidget::setBodySizeMode(const BodySizeMode mode) {
     update();
 }
 
+void SystemSceneWidget::setDeclutterEnabled(const bool enabled) {
+    if (m_declutterEnabled == enabled) {
+        return;
+    }
+
+    m_declutterEnabled = enabled;
+    m_declutter.clear();
+    update();
+}
+
 void SystemSceneWidget::paintEvent(QPaintEvent* event) {
     QWidget::paintEvent(event);
 
@@ -236,9 +368,13 @@ void SystemSceneWidget::paintEvent(QPaintEvent* event) {
     painter.fillRect(rect(), QColor(10, 15, 24));
 
     painter.setPen(QColor(180, 200, 255));
-    painter.drawText(20, 30, QStringLiteral("Система: %1").arg(m_systemName.isEmpty() ? QStringLiteral("—") : m_systemName));
+    const QString& systemName = m_snapshot.systemName();
+    painter.drawText(20, 30, QStringLiteral("Система: %1").arg(systemName.isEmpty() ? QStringLiteral("—") : systemName));
 
-    const QStringList systemLabels = OrbitClassifier::systemTypeLabels(m_orbitClassification.systemTypes);
+    const BodyGraph& graph = m_snapshot.graph();
+    const QVector<BodyHot>& hotBodies = m_snapshot.hotBodies();
+    const OrbitClassificationResult& orbitClassification = m_snapshot.orbitClassification();
+    const QStringList systemLabels = OrbitClassifier::systemTypeLabels(orbitClassification.systemTypes);
     const QString systemTypesLine = systemLabels.isEmpty()
         ? QStringLiteral("Типы системы: не обнаружены")
         : QStringLiteral("Типы системы: %1").arg(systemLabels.join(QStringLiteral(", ")));
@@ -258,15 +394,14 @@ void SystemSceneWidget::paintEvent(QPaintEvent* event) {
         painter.drawText(20, 90, QStringLiteral("Размеры тел: физические"));
     } else {
         QString clampDetails = QStringLiteral("min=4 px, max=%1 px").arg(visualMaxWidgetRadiusPx * 2.0, 0, 'f', 0);
-        if (m_selectedBodyId >= 0) {
-            const auto selectedIt = m_bodyMap.constFind(m_selectedBodyId);
-            if (selectedIt != m_bodyMap.constEnd()) {
-                const double minDiameterPx = minimumBodyDiameterPx(selectedIt->bodyClass);
-                clampDetails = QStringLiteral("для класса «%1»: min=%2 px, max=%3 px")
-                    .arg(bodyClassLabel(selectedIt->bodyClass))
-                    .arg(minDiameterPx, 0, 'f', 0)
-                    .arg(visualMaxWidgetRadiusPx * 2.0, 0, 'f', 0);
-            }
+        const int selectedIndex = graph.indexOf(m_selectedBodyId);
+        if (selectedIndex >= 0) {
+            const CelestialBody::BodyClass selectedClass = hotBodies.at(selectedIndex).bodyClass;
+            const double minDiameterPx = minimumBodyDiameterPx(selectedClass);
+            clampDetails = QStringLiteral("для класса «%1»: min=%2 px, max=%3 px")
+                .arg(bodyClassLabel(selectedClass))
+                .arg(minDiameterPx, 0, 'f', 0)
+                .arg(visualMaxWidgetRadiusPx * 2.0, 0, 'f', 0);
         }
 
         painter.drawText(
@@ -275,7 +410,7 @@ void SystemSceneWidget::paintEvent(QPaintEvent* event) {
             QStringLiteral("Размеры тел: с визуальными ограничениями (min/max px) — %1").arg(clampDetails));
     }
 
-    if (m_bodyMap.isEmpty() || m_layout.isEmpty()) {
+    if (hotBodies.isEmpty() || m_layout.size() != hotBodies.size()) {
         painter.drawText(20, 110, QStringLiteral("Нет данных для отображения."));
         return;
     }
@@ -285,84 +420,175 @@ void SystemSceneWidget::paintEvent(QPaintEvent* event) {
     painter.scale(m_zoom, m_zoom);
 
     painter.setBrush(Qt::NoBrush);
-    painter.setPen(QPen(QColor(84, 111, 168, 150), 1.0 / m_zoom));
-    for (auto it = m_layout.constBegin(); it != m_layout.constEnd(); ++it) {
-        const auto bodyIt = m_bodyMap.constFind(it.key());
-        if (bodyIt == m_bodyMap.constEnd() || bodyIt->parentId < 0 || !m_layout.contains(bodyIt->parentId)) {
-            continue;
+    // Раскладка в а.е. переводится в координаты сцены здесь, поэтому resize её не пересчитывает.
+    const double pxPerAu = viewPxPerAu();
+    const QPointF origin = sceneOrigin();
+    // Окно в а.е.: по нему отбираются раздвигаемые подсистемы и видимые куски орбит.
+    const QRectF widgetRect = QRectF(rect()).adjusted(-2.0, -2.0, 2.0, 2.0);
+    const QRectF viewAu = pxPerAu > 0.0
+        ? QRectF(((widgetRect.topLeft() - m_panOffset) / m_zoom - origin) / pxPerAu,
+                 ((widgetRect.bottomRight() - m_panOffset) / m_zoom - origin) / pxPerAu)
+        : QRectF();
+    if (m_semanticZoom.apply(m_layout, pxPerAu * m_zoom, viewAu, m_displayLayout) > 0) {
+        // Впервые раздвинутым спутникам нужны таблицы эфемерид, чтобы они двигались по шкале времени;
+        // запрос откладывается за пределы кадра.
+        m_viewSettleTimer.start();
+    }
+
+    if (pxPerAu > 0.0) {
+        // Орбиты — эллипсы с родителем в фокусе (для тел без фазы — окружности): из кэша берутся
+        // только куски, задевающие окно.
+        const KeplerEphemeris& ephemeris = m_snapshot.ephemeris();
+        const bool hasEphemeris = ephemeris.size() == m_displayLayout.size();
+        m_orbitRuns.clear();
+        for (int index = 0; index < m_displayLayout.size(); ++index) {
+            const BodyLayout& bodyLayout = m_displayLayout.at(index);
+            const int parentIndex = graph.parentIndex.at(index);
+            if (!bodyLayout.placed || parentIndex < 0 || !m_displayLayout.at(parentIndex).placed) {
+                continue;
+            }
+
+            const OrbitEllipse ellipse = hasEphemeris && ephemeris.hasPhase(index) ? ephemeris.orbitEllipse(index)
+                                                                                   : OrbitEllipse();
+            m_orbitPathCache.appendVisibleRuns(index, ellipse, bodyLayout.orbitRadius, m_displayLayout.at(parentIndex).position,
+                                               pxPerAu * m_zoom, viewAu, m_orbitRuns);
         }
 
-        const QPointF parentPos = m_layout.value(bodyIt->parentId).position;
-        painter.drawEllipse(parentPos, it->orbitRadius, it->orbitRadius);
+        painter.save();
+        painter.translate(origin);
+        painter.scale(pxPerAu, pxPerAu);
+        // Косметическое перо: толщина 1 px при любом масштабе.
+        QPen orbitPen(QColor(84, 111, 168, 150), 1.0);
+        orbitPen.setCosmetic(true);
+        painter.setPen(orbitPen);
+        for (int run = 0; run < m_orbitRuns.runCount(); ++run) {
+            painter.drawPolyline(m_orbitRuns.points.constData() + m_orbitRuns.runStarts.at(run), m_orbitRuns.runLength(run));
+        }
+        painter.restore();
     }
 
+    struct BodyGlyph {
+        int index = -1;
+        QPointF point;
+        double radius = 0.0;
+        QColor color;
+    };
     struct BodyLabel {
         QRectF rect;
-        QString text;
+        // Порядковый номер тела подписи в bodyGlyphs.
+        int glyph = -1;
     };
+    QVector<BodyGlyph> bodyGlyphs;
     QVector<BodyLabel> bodyLabels;
-    bodyLabels.reserve(m_bodyMap.size());
-
-    for (auto it = m_bodyMap.constBegin(); it != m_bodyMap.constEnd(); ++it) {
+    bodyGlyphs.reserve(hotBodies.size());
+    bodyLabels.reserve(hotBodies.size());
+    m_labelRequests.clear();
+    const QString fontKey = font().key();
+    if (fontKey != m_labelCacheFontKey || m_labelCache.size() != hotBodies.size()) {
+        // Вёрстка подписей зависит от шрифта: при его смене кэш собирается заново.
+        m_labelCache.clear();
+        m_labelCache.resize(hotBodies.size());
+        m_labelCacheFontKey = fontKey;
+    }
+    const QFontMetrics metrics(font());
+
+    for (int index = 0; index < hotBodies.size(); ++index) {
+        const BodyHot& hot = hotBodies.at(index);
+        const BodyLayout& bodyLayout = m_displayLayout.at(index);
         // Орбиту барицентра показываем для структуры системы, сам барицентр не рисуем как объект.
-        if (!m_layout.contains(it.key()) || it->bodyClass == CelestialBody::BodyClass::Barycenter
-            || isVirtualBarycenterRoot(it.value())) {
+        if (!bodyLayout.placed || hot.bodyClass == CelestialBody::BodyClass::Barycenter
+            || hot.hasFlag(BodyHot::VirtualRootFlag)) {
             continue;
         }
 
-        const BodyLayout bodyLayout = m_layout.value(it.key());
-        const QPointF point = bodyLayout.position;
-        const double radius = bodyDrawRadiusPx(*it, bodyLayout, nullptr);
+        const QPointF point = origin + bodyLayout.position * pxPerAu;
+        const double radius = bodyDrawRadiusPx(hot, bodyLayout, nullptr);
 
-        const QSet<BodyOrbitType> bodyTypes = m_orbitClassification.bodyTypes.value(it.key());
+        const BodyOrbitTypes bodyTypes = orbitClassification.typesAt(index);
 
-        const QColor bodyColor = bodyColorForClass(it->bodyClass, bodyTypes);
+        const QColor bodyColor = bodyColorForClass(hot.bodyClass, bodyTypes);
 
-        painter.setBrush(bodyColor);
-        painter.setPen(Qt::NoPen);
-        painter.drawEllipse(point, radius, radius);
-
-        const QString mainLabel = QStringLiteral("%1 — %2").arg(it->name, scientificTypeLabel(*it));
-        QString labelText = mainLabel;
-
-        if (isDebugLabelModeEnabled() && it.key() == m_selectedBodyId) {
-            SizeSource source = SizeSource::Physical;
-            bodyDrawRadiusPx(*it, bodyLayout, &source);
-            const QStringList typeLabels = OrbitClassifier::bodyTypeLabels(bodyTypes);
-            const QString debugSuffix = QStringLiteral("SIZE_SRC=%1%2")
-                .arg(sizeSourceLabel(source),
-                     typeLabels.isEmpty() ? QString() : QStringLiteral(", ORBIT=%1").arg(typeLabels.join(QStringLiteral(", "))));
-            labelText = QStringLiteral("%1 [%2]").arg(mainLabel, debugSuffix);
+        bodyGlyphs.push_back({index, point, radius, bodyColor});
+
+        const CachedBodyLabel& label = cachedBodyLabel(index, metrics);
+        m_labelRequests.push_back({point * m_zoom + m_panOffset, radius * m_zoom, label.size,
+                                   labelPriority(hot, hot.id == m_selectedBodyId)});
+    }
+
+    // Подписи расставляются по приоритету без наложений; не поместившиеся и невидимые не рисуются.
+    m_labelPlacement.place(m_labelRequests, QRectF(rect()), m_placedLabelRects);
+    for (int ordinal = 0; ordinal < m_placedLabelRects.size(); ++ordinal) {
+        if (!m_placedLabelRects.at(ordinal).isNull()) {
+            bodyLabels.push_back({m_placedLabelRects.at(ordinal), ordinal});
+        }
+    }
+
+    // Разведение перекрытий работает в пикселях окна: значок — кругом своего радиуса,
+    // подпись — кругом той же площади, что и её текст.
+    QVector<QPointF> glyphOffsets(bodyGlyphs.size());
+    QVector<QPointF> labelOffsets(bodyLabels.size());
+    if (m_declutterEnabled) {
+        m_declutterItems.clear();
+        for (int ordinal = 0; ordinal < bodyGlyphs.size(); ++ordinal) {
+            const BodyGlyph& glyph = bodyGlyphs.at(ordinal);
+            m_declutterItems.push_back({glyphDeclutterKey(glyph.index), glyph.point * m_zoom + m_panOffset,
+                                        glyph.radius * m_zoom, kDeclutterGlyphMaxOffsetPx});
         }
+        for (const BodyLabel& bodyLabel : bodyLabels) {
+            m_declutterItems.push_back({labelDeclutterKey(bodyGlyphs.at(bodyLabel.glyph).index), bodyLabel.rect.center(),
+                                        0.5 * std::sqrt(bodyLabel.rect.width() * bodyLabel.rect.height()),
+                                        kDeclutterLabelMaxOffsetPx});
+        }
+        m_declutter.setItems(m_declutterItems);
+        if (!m_declutter.relax(kDeclutterBudgetNs)) {
+            // Раскладка не успокоилась за бюджет кадра: досчитывается в следующих кадрах.
+            update();
+        }
+        for (int ordinal = 0; ordinal < bodyGlyphs.size(); ++ordinal) {
+            glyphOffsets[ordinal] = m_declutter.offset(ordinal);
+        }
+        for (int ordinal = 0; ordinal < bodyLabels.size(); ++ordinal) {
+            labelOffsets[ordinal] = m_declutter.offset(bodyGlyphs.size() + ordinal);
+        }
+    }
 
-        const QPointF labelScenePos = point + QPointF(radius + 8.0 / m_zoom, -radius - 6.0 / m_zoom);
-        const QPointF labelWidgetPos = labelScenePos * m_zoom + m_panOffset;
-        const QFontMetrics metrics(font());
-        const QString compactLabel = compactWrappedLabel(labelText, metrics, static_cast<int>(bodyLabelMaxWidthPx), bodyLabelMaxLines);
-        const int lineCount = qMax(1, compactLabel.count('\n') + 1);
-        const QRectF labelRect(
-            labelWidgetPos,
-            QSizeF(bodyLabelMaxWidthPx, metrics.lineSpacing() * lineCount));
-        bodyLabels.push_back({labelRect, compactLabel});
+    painter.setPen(Qt::NoPen);
+    for (int ordinal = 0; ordinal < bodyGlyphs.size(); ++ordinal) {
+        const BodyGlyph& glyph = bodyGlyphs.at(ordinal);
+        painter.setBrush(glyph.color);
+        painter.drawEllipse(glyph.point + glyphOffsets.at(ordinal) / m_zoom, glyph.radius, glyph.radius);
     }
 
     painter.restore();
 
+    for (int ordinal = 0; ordinal < bodyLabels.size(); ++ordinal) {
+        const QPointF labelOffset = labelOffsets.at(ordinal);
+        if (std::hypot(labelOffset.x(), labelOffset.y()) < kLeaderLineMinOffsetPx) {
+            continue;
+        }
+        // Линия от тела к ближайшей точке отодвинутой подписи.
+        const int glyphOrdinal = bodyLabels.at(ordinal).glyph;
+        const BodyGlyph& glyph = bodyGlyphs.at(glyphOrdinal);
+        const QPointF glyphWidgetPos = (glyph.point * m_zoom + m_panOffset) + glyphOffsets.at(glyphOrdinal);
+        const QRectF labelRect = bodyLabels.at(ordinal).rect.translated(labelOffset);
+        const QPointF nearest(qBound(labelRect.left(), glyphWidgetPos.x(), labelRect.right()),
+                              qBound(labelRect.top(), glyphWidgetPos.y(), labelRect.bottom()));
+        painter.setPen(QPen(QColor(150, 170, 210, 140), 1.0));
+        painter.drawLine(glyphWidgetPos, nearest);
+    }
+
     painter.setPen(QColor(220, 230, 245));
     painter.setBrush(QColor(8, 12, 20, 190));
-    for (const BodyLabel& bodyLabel : bodyLabels) {
+    for (int ordinal = 0; ordinal < bodyLabels.size(); ++ordinal) {
+        const BodyLabel& bodyLabel = bodyLabels.at(ordinal);
+        const QRectF labelRect = bodyLabel.rect.translated(labelOffsets.at(ordinal));
         painter.setPen(Qt::NoPen);
-        painter.drawRoundedRect(bodyLabel.rect.adjusted(-4.0, -2.0, 4.0, 2.0), 4.0, 4.0);
+        painter.drawRoundedRect(labelRect.adjusted(-4.0, -2.0, 4.0, 2.0), 4.0, 4.0);
         painter.setPen(QColor(220, 230, 245));
-        painter.drawText(bodyLabel.rect, Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, bodyLabel.text);
+        painter.drawStaticText(labelRect.topLeft(), m_labelCache.at(bodyGlyphs.at(bodyLabel.glyph).index).text);
     }
 }
 
-void SystemSceneWidget::resizeEvent(QResizeEvent* event) {
-    QWidget::resizeEvent(event);
-    rebuildLayout();
-}
-
 void SystemSceneWidget::mousePressEvent(QMouseEvent* event) {
     if (event->button() == Qt::LeftButton) {
         m_isDragging = true;
@@ -398,6 +624,10 @@ void SystemSceneWidget::mouseReleaseEvent(QMouseEvent* event) {
         const bool treatAsClick = !m_movedSincePress;
         m_isDragging = false;
         unsetCursor();
+        if (!treatAsClick) {
+            // Сдвиг закончен: в окно могли войти тела без таблиц.
+            requestVisibleEphemerisTables();
+        }
 
         if (treatAsClick) {
             const int bodyId = findBodyAt(event->pos());
@@ -438,6 +668,7 @@ void SystemSceneWidget::wheelEvent(QWheelEvent* event) {
     const QPointF scenePosAfter = scenePosBefore * m_zoom;
     m_panOffset = mousePos - scenePosAfter;
 
+    m_viewSettleTimer.start();
     update();
     event->accept();
 }
@@ -457,14 +688,15 @@ QString SystemSceneWidget::sizeSourceLabel(const SizeSource source) {
     return QStringLiteral("PHYSICAL");
 }
 
-double SystemSceneWidget::computePhysicalWidgetRadiusPx(const CelestialBody& body, const BodyLayout& bodyLayout) const {
-    if (body.physicalRadiusKm <= 0.0 || bodyLayout.pxPerAu <= 0.0 || m_zoom <= 0.0) {
+double SystemSceneWidget::computePhysicalWidgetRadiusPx(const BodyHot& body) const {
+    const double pxPerAu = viewPxPerAu();
+    if (body.physicalRadiusKm <= 0.0 || pxPerAu <= 0.0 || m_zoom <= 0.0) {
         return 0.0;
     }
 
     constexpr double kmPerAu = 149597870.7;
     // Физический размер тела в экранных пикселях при текущем зуме.
-    return body.physicalRadiusKm * (bodyLayout.pxPerAu * m_zoom / kmPerAu);
+    return body.physicalRadiusKm * (pxPerAu * m_zoom / kmPerAu);
 }
 
 double SystemSceneWidget::applyVisualClamp(const double widgetRadiusPx,
@@ -492,13 +724,13 @@ double SystemSceneWidget::applyVisualClamp(const double widgetRadiusPx,
     return result;
 }
 
-double SystemSceneWidget::bodyDrawRadiusPx(const CelestialBody& body,
+double SystemSceneWidget::bodyDrawRadiusPx(const BodyHot& body,
                                            const BodyLayout& bodyLayout,
                                            SizeSource* outSource) const {
     // Масштаб размеров тел (физический/ограниченный) независим от орбитального
     // масштаба в currentKmPerPixel(): первый отвечает за читаемость дисков,
     // второй — за отображение орбитальных расстояний.
-    const double physicalWidgetRadiusPx = computePhysicalWidgetRadiusPx(body, bodyLayout);
+    const double physicalWidgetRadiusPx = computePhysicalWidgetRadiusPx(body);
 
     if (physicalWidgetRadiusPx > 0.0) {
         if (m_bodySizeMode == BodySizeMode::Physical) {
@@ -526,46 +758,229 @@ double SystemSceneWidget::currentKmPerPixel() const {
     // Это именно орбитальный масштаб сцены (км на 1 px) для расстояний.
     // Он не описывает масштаб радиусов тел: их рендер регулируется отдельно
     // режимом BodySizeMode в bodyDrawRadiusPx().
-    if (m_layout.isEmpty() || m_zoom <= 0.0) {
+    if (m_zoom <= 0.0) {
         return 0.0;
     }
 
-    const auto firstLayout = m_layout.constBegin().value();
-    if (firstLayout.pxPerAu <= 0.0) {
+    const double pxPerAu = viewPxPerAu();
+    if (pxPerAu <= 0.0) {
         return 0.0;
     }
 
     constexpr double kmPerAu = 149597870.7;
-    return kmPerAu / (firstLayout.pxPerAu * m_zoom);
+    return kmPerAu / (pxPerAu * m_zoom);
+}
+
+double SystemSceneWidget::viewPxPerAu() const {
+    return m_layout.pxPerAu(size());
 }
+
+QPointF SystemSceneWidget::sceneOrigin() const {
+    return QRectF(rect()).center();
+}
+
 void SystemSceneWidget::rebuildLayout() {
-    m_layout = SystemLayoutEngine::buildLayout(m_bodyMap, m_roots, rect());
+    // Направления на тела с известной фазой — на момент загрузки системы, от него же
+    // отсчитывается шкала времени.
+    m_baseEpochMs = QDateTime::currentMSecsSinceEpoch();
+    m_sceneEpochMs = m_baseEpochMs;
+    const KeplerEphemeris& ephemeris = m_snapshot.ephemeris();
+    SystemLayoutEngine::buildLayout(m_snapshot.graph(),
+                                    m_snapshot.hotBodies(),
+                                    m_layoutWorkspace,
+                                    m_baseLayout,
+                                    &ephemeris,
+                                    m_baseEpochMs);
+    m_ephemerisTable.reset(m_snapshot.graph().size());
+    m_orbitPathCache.clear();
+    m_semanticZoom.reset(m_snapshot.graph(), m_snapshot.hotBodies(), m_baseLayout);
+    m_declutter.clear();
+    m_labelCache.clear();
+
+    m_timelineBar->setEnabled(ephemeris.phasedCount() > 0);
+    {
+        const QSignalBlocker blocker(m_timelineSlider);
+        m_timelineSlider->setValue(0);
+    }
+    applySceneEpoch();
+}
+
+void SystemSceneWidget::setSceneEpoch(const qint64 epochMs) {
+    const qint64 rangeMs = kTimelineRangeHours * kMsPerHour;
+    m_sceneEpochMs = qBound(m_baseEpochMs - rangeMs, epochMs, m_baseEpochMs + rangeMs);
+    {
+        const QSignalBlocker blocker(m_timelineSlider);
+        m_timelineSlider->setValue(static_cast<int>((m_sceneEpochMs - m_baseEpochMs) / kMsPerHour));
+    }
+    applySceneEpoch();
+}
+
+void SystemSceneWidget::applySceneEpoch() {
+    // Кадр прокрутки только читает таблицы; тела, чьих таблиц ещё нет, остаются на месте
+    // относительно родителя до прихода фонового результата.
+    SystemLayoutEngine::advanceLayout(m_snapshot.graph(),
+                                      m_snapshot.ephemeris(),
+                                      m_ephemerisTable,
+                                      m_baseLayout,
+                                      m_sceneEpochMs,
+                                      m_layout);
+    updateTimelineLabel();
+    requestVisibleEphemerisTables();
     update();
+    emit sceneEpochChanged(m_sceneEpochMs);
+}
+
+void SystemSceneWidget::advancePlayback() {
+    const double daysPerSecond = m_playbackSpeedCombo->currentData().toDouble();
+    const qint64 elapsedMs = m_playbackClock.restart();
+    setSceneEpoch(m_sceneEpochMs + qRound64(elapsedMs * daysPerSecond * kMsPerDay / 1000.0));
+    if (m_sceneEpochMs >= m_baseEpochMs + kTimelineRangeHours * kMsPerHour) {
+        m_playButton->setChecked(false);
+    }
+}
+
+void SystemSceneWidget::setPlaybackActive(const bool active) {
+    if (!active) {
+        m_playbackTimer.stop();
+        m_playButton->setText(QStringLiteral("▶"));
+        return;
+    }
+
+    if (m_sceneEpochMs >= m_baseEpochMs + kTimelineRangeHours * kMsPerHour) {
+        setSceneEpoch(m_baseEpochMs);
+    }
+    m_playButton->setText(QStringLiteral("❚❚"));
+    m_playbackClock.start();
+    m_playbackTimer.start();
+}
+
+void SystemSceneWidget::updateTimelineLabel() {
+    m_timelineLabel->setText(QDateTime::fromMSecsSinceEpoch(m_sceneEpochMs, Qt::UTC)
+                                 .toString(QStringLiteral("yyyy-MM-dd HH:mm 'UTC'")));
+}
+
+void SystemSceneWidget::requestVisibleEphemerisTables() {
+    const KeplerEphemeris& ephemeris = m_snapshot.ephemeris();
+    if (ephemeris.phasedCount() == 0 || m_ephemerisTableWatcher.isRunning()
+        || m_ephemerisTable.bodyCount() != ephemeris.size() || m_layout.size() != ephemeris.size()) {
+        return;
+    }
+
+    // Видимое поддерево: тела, чей круг вокруг родителя на схеме заметен (не меньше пикселя)
+    // и задевает окно. Остальные до приближения или сдвига сцены остаются без таблиц.
+    const BodyGraph& graph = m_snapshot.graph();
+    const double pxPerAu = viewPxPerAu();
+    const QPointF origin = sceneOrigin();
+    const QRectF viewRect(rect());
+    QVector<int> missingIndices;
+    for (int index = 0; index < ephemeris.size(); ++index) {
+        const int parentIndex = graph.parentIndex.at(index);
+        if (!ephemeris.hasPhase(index) || m_ephemerisTable.contains(index) || parentIndex < 0
+            || !m_baseLayout.at(index).placed || !m_baseLayout.at(parentIndex).placed) {
+            continue;
+        }
+
+        // Спутники раздвинутой подсистемы видны в масштабе последнего кадра.
+        const QPointF baseOffset = m_baseLayout.at(index).position - m_baseLayout.at(parentIndex).position;
+        const double orbitWidgetPx = std::hypot(baseOffset.x(), baseOffset.y()) * m_semanticZoom.displayScale(index)
+                                   * pxPerAu * m_zoom;
+        if (orbitWidgetPx < 1.0) {
+            continue;
+        }
+        const SystemLayout& shownLayout = m_displayLayout.size() == m_layout.size() ? m_displayLayout : m_layout;
+        const QPointF parentWidgetPos = (origin + shownLayout.at(parentIndex).position * pxPerAu) * m_zoom + m_panOffset;
+        if (viewRect.adjusted(-orbitWidgetPx, -orbitWidgetPx, orbitWidgetPx, orbitWidgetPx).contains(parentWidgetPos)) {
+            missingIndices.push_back(index);
+        }
+    }
+    if (missingIndices.isEmpty()) {
+        return;
+    }
+
+    // Снимок копируется за O(1), поэтому фоновая задача не зависит от последующей смены системы.
+    const SystemSnapshot snapshot = m_snapshot;
+    m_ephemerisTableGeneration = m_snapshotGeneration;
+    m_ephemerisTableWatcher.setFuture(QtConcurrent::run([snapshot, missingIndices]() {
+        return EphemerisTable::build(snapshot.ephemeris(), missingIndices);
+    }));
+}
+
+const SystemSceneWidget::CachedBodyLabel& SystemSceneWidget::cachedBodyLabel(const int index, const QFontMetrics& metrics) {
+    const BodyHot& hot = m_snapshot.hotBodies().at(index);
+    CachedBodyLabel& label = m_labelCache[index];
+    // Обычная подпись зависит только от тела и шрифта. Отладочная — ещё от выбора и размера,
+    // поэтому её текст сверяется в каждом кадре.
+    const bool debugLabel = isDebugLabelModeEnabled() && hot.id == m_selectedBodyId;
+    if (!label.sourceText.isEmpty() && !debugLabel && !label.debug) {
+        return label;
+    }
+
+    // Строки берутся из холодной таблицы только для подписи.
+    const BodyCold& cold = m_snapshot.coldBodies().at(index);
+    const QString mainLabel = QStringLiteral("%1 — %2").arg(cold.name, scientificTypeLabel(hot));
+    QString labelText = mainLabel;
+
+    if (debugLabel) {
+        SizeSource source = SizeSource::Physical;
+        bodyDrawRadiusPx(hot, m_displayLayout.at(index), &source);
+        const QStringList typeLabels = OrbitClassifier::bodyTypeLabels(m_snapshot.orbitClassification().typesAt(index));
+        const QString debugSuffix = QStringLiteral("SIZE_SRC=%1%2")
+            .arg(sizeSourceLabel(source),
+                 typeLabels.isEmpty() ? QString() : QStringLiteral(", ORBIT=%1").arg(typeLabels.join(QStringLiteral(", "))));
+        labelText = QStringLiteral("%1 [%2]").arg(mainLabel, debugSuffix);
+    }
+    if (labelText == label.sourceText) {
+        return label;
+    }
+
+    label.sourceText = labelText;
+    label.debug = debugLabel;
+    const QString compactLabel = compactWrappedLabel(labelText, metrics, static_cast<int>(bodyLabelMaxWidthPx), bodyLabelMaxLines);
+    const QStringList lines = compactLabel.split('\n');
+    double textWidth = 0.0;
+    for (const QString& line : lines) {
+        textWidth = qMax(textWidth, static_cast<double>(metrics.horizontalAdvance(line)));
+    }
+    label.size = QSizeF(textWidth, metrics.lineSpacing() * qMax(1, lines.size()));
+    // Строки уже перенесены: разделитель строк QStaticText понимает как жёсткий перенос.
+    label.text.setTextFormat(Qt::PlainText);
+    label.text.setPerformanceHint(QStaticText::AggressiveCaching);
+    label.text.setTextWidth(bodyLabelMaxWidthPx);
+    label.text.setText(lines.join(QChar::LineSeparator));
+    label.text.prepare(QTransform(), font());
+    return label;
 }
 
 int SystemSceneWidget::findBodyAt(const QPointF& widgetPos) const {
-    if (m_layout.isEmpty()) {
+    const QVector<BodyHot>& hotBodies = m_snapshot.hotBodies();
+    if (m_displayLayout.size() != hotBodies.size()) {
         return -1;
     }
 
     const QPointF scenePos = (widgetPos - m_panOffset) / m_zoom;
+    const double pxPerAu = viewPxPerAu();
+    const QPointF origin = sceneOrigin();
     int foundBodyId = -1;
     double smallestDistance = std::numeric_limits<double>::max();
 
-    for (auto it = m_layout.constBegin(); it != m_layout.constEnd(); ++it) {
-        const auto bodyIt = m_bodyMap.constFind(it.key());
-        if (bodyIt == m_bodyMap.constEnd()
-            || bodyIt->bodyClass == CelestialBody::BodyClass::Barycenter
-            || isVirtualBarycenterRoot(bodyIt.value())) {
+    for (int index = 0; index < hotBodies.size(); ++index) {
+        const BodyHot& hot = hotBodies.at(index);
+        const BodyLayout& bodyLayout = m_displayLayout.at(index);
+        if (!bodyLayout.placed
+            || hot.bodyClass == CelestialBody::BodyClass::Barycenter
+            || hot.hasFlag(BodyHot::VirtualRootFlag)) {
             continue;
         }
 
-        const QPointF delta = scenePos - it->position;
+        // Значок, отодвинутый разведением перекрытий, ловится там, где нарисован.
+        const QPointF declutterOffset = m_declutterEnabled ? m_declutter.offsetForKey(glyphDeclutterKey(index)) / m_zoom
+                                                           : QPointF();
+        const QPointF delta = scenePos - (origin + bodyLayout.position * pxPerAu + declutterOffset);
         const double distanceSquared = delta.x() * delta.x() + delta.y() * delta.y();
-        const double drawRadius = bodyDrawRadiusPx(*bodyIt, *it, nullptr);
+        const double drawRadius = bodyDrawRadiusPx(hot, bodyLayout, nullptr);
         const double radiusSquared = drawRadius * drawRadius;
         if (distanceSquared <= radiusSquared && distanceSquared < smallestDistance) {
-            foundBodyId = it.key();
+            foundBodyId = hot.id;
             smallestDistance = distanceSquared;
         }
     }
@@ -1,12 +1,29 @@
 #pragma once
 
-#include <QHash>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <QPoint>
+#include <QStaticText>
+#include <QTimer>
+#include <QVector>
 #include <QWidget>
 
+#include "BodyRecords.h"
 #include "CelestialBody.h"
+#include "EphemerisTable.h"
+#include "LabelPlacement.h"
+#include "LayoutDeclutter.h"
+#include "OrbitPathCache.h"
 #include "OrbitClassifier.h"
+#include "SemanticZoomLayout.h"
 #include "SystemLayoutEngine.h"
+#include "SystemSnapshot.h"
+
+class QComboBox;
+class QFontMetrics;
+class QLabel;
+class QSlider;
+class QToolButton;
 
 class SystemSceneWidget : public QWidget {
     Q_OBJECT
@@ -17,19 +34,21 @@ public:
     };
 
     explicit SystemSceneWidget(QWidget* parent = nullptr);
+    ~SystemSceneWidget() override;
 
-    void setSystemData(const QString& systemName,
-                       const QHash<int, CelestialBody>& bodyMap,
-                       const QVector<int>& roots);
+    void setSnapshot(const SystemSnapshot& snapshot);
     void setBodySizeMode(BodySizeMode mode);
+    // Расталкивать налезающие друг на друга значки тел и подписи.
+    void setDeclutterEnabled(bool enabled);
 
 signals:
     void bodyClicked(int bodyId);
     void emptyAreaClicked();
+    // Момент шкалы времени сменился: при загрузке системы, прокрутке и воспроизведении.
+    void sceneEpochChanged(qint64 epochMs);
 
 protected:
     void paintEvent(QPaintEvent* event) override;
-    void resizeEvent(QResizeEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
     void mouseReleaseEvent(QMouseEvent* event) override;
@@ -42,25 +61,88 @@ private:
         MaxClamp
     };
 
-    double computePhysicalWidgetRadiusPx(const CelestialBody& body, const BodyLayout& bodyLayout) const;
+    double computePhysicalWidgetRadiusPx(const BodyHot& body) const;
     double applyVisualClamp(double widgetRadiusPx,
                             CelestialBody::BodyClass bodyClass,
                             SizeSource* outSource = nullptr) const;
     static QString sizeSourceLabel(SizeSource source);
 
     void rebuildLayout();
+    // Шкала времени: положение тел на m_sceneEpochMs по готовым таблицам эфемерид.
+    void setupTimeline();
+    void setSceneEpoch(qint64 epochMs);
+    void applySceneEpoch();
+    void advancePlayback();
+    void setPlaybackActive(bool active);
+    void updateTimelineLabel();
+    // Запускает в фоне построение таблиц для видимых движущихся тел, которых ещё нет. Вызывается
+    // при загрузке системы, смене момента и в конце зума или сдвига — не из кадра.
+    void requestVisibleEphemerisTables();
+    struct CachedBodyLabel {
+        // Текст подписи до переноса строк; пустой — подпись ещё не свёрстана.
+        QString sourceText;
+        QStaticText text;
+        QSizeF size;
+        bool debug = false;
+    };
+    // Свёрстанная подпись тела index; пересобирается только при смене её текста.
+    const CachedBodyLabel& cachedBodyLabel(int index, const QFontMetrics& metrics);
     int findBodyAt(const QPointF& widgetPos) const;
-    double bodyDrawRadiusPx(const CelestialBody& body,
+    double bodyDrawRadiusPx(const BodyHot& body,
                             const BodyLayout& bodyLayout,
                             SizeSource* outSource = nullptr) const;
     double currentKmPerPixel() const;
+    // Перевод раскладки из а.е. в координаты сцены (пиксели при зуме 1) для текущего размера
+    // виджета: начало координат в центре, масштаб по SystemLayout::pxPerAu().
+    double viewPxPerAu() const;
+    QPointF sceneOrigin() const;
 
-    QString m_systemName;
-    QHash<int, CelestialBody> m_bodyMap;
-    QVector<int> m_roots;
-    QHash<int, BodyLayout> m_layout;
-    OrbitClassificationResult m_orbitClassification;
+    SystemSnapshot m_snapshot;
+    // Плотная раскладка по индексам m_snapshot.graph() в а.е. на момент загрузки системы;
+    // строится только при смене системы.
+    SystemLayout m_baseLayout;
+    // m_baseLayout, сдвинутая на момент шкалы времени.
+    SystemLayout m_layout;
+    // m_layout с подсистемами спутников в локальном масштабе под текущий зум; строится в каждом
+    // кадре, по ней рисуется сцена и ищется тело под курсором.
+    SystemLayout m_displayLayout;
+    SemanticZoomLayout m_semanticZoom;
+    // Буферы раскладки живут вместе с виджетом: смена системы не выделяет память заново.
+    SystemLayoutEngine::Workspace m_layoutWorkspace;
     BodySizeMode m_bodySizeMode = BodySizeMode::VisualClamped;
+    // Разбиения орбит по корзинам зума живут до смены системы; m_orbitRuns — буфер кадра.
+    OrbitPathCache m_orbitPathCache;
+    OrbitPathRuns m_orbitRuns;
+    // Подписи по индексам графа свёрстаны под шрифт m_labelCacheFontKey и живут до смены
+    // системы или шрифта; запросы и места подписей — буферы кадра.
+    QVector<CachedBodyLabel> m_labelCache;
+    QString m_labelCacheFontKey;
+    LabelPlacement m_labelPlacement;
+    QVector<LabelPlacement::Request> m_labelRequests;
+    QVector<QRectF> m_placedLabelRects;
+    // Смещения разведённых значков и подписей переживают кадр; m_declutterItems — буфер кадра.
+    bool m_declutterEnabled = false;
+    LayoutDeclutter m_declutter;
+    QVector<LayoutDeclutter::Item> m_declutterItems;
+
+    // Таблицы не зависят от зума и момента, поэтому копятся до смены системы.
+    EphemerisTable m_ephemerisTable;
+    QFutureWatcher<EphemerisTable> m_ephemerisTableWatcher;
+    // Номер системы, для которой строятся таблицы: результат для прежней системы отбрасывается.
+    int m_snapshotGeneration = 0;
+    int m_ephemerisTableGeneration = -1;
+    qint64 m_baseEpochMs = 0;
+    qint64 m_sceneEpochMs = 0;
+    QTimer m_playbackTimer;
+    // Однократный таймер конца зума колесом; он же выносит запрос таблиц из paintEvent.
+    QTimer m_viewSettleTimer;
+    QElapsedTimer m_playbackClock;
+    QWidget* m_timelineBar = nullptr;
+    QToolButton* m_playButton = nullptr;
+    QToolButton* m_nowButton = nullptr;
+    QSlider* m_timelineSlider = nullptr;
+    QComboBox* m_playbackSpeedCombo = nullptr;
+    QLabel* m_timelineLabel = nullptr;
 
     double m_zoom = 1.0;
     QPointF m_panOffset;
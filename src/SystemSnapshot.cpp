@@ -0,0 +1,153 @@
+#include "SystemSnapshot.h"
+
+#include "SystemModelBuilder.h"
+
+SystemSnapshot::SystemSnapshot()
+    : d(new SystemSnapshotData) {
+}
+
+SystemSnapshot SystemSnapshot::build(const QString& systemName, const QVector<CelestialBody>& bodies) {
+    SystemSnapshot snapshot;
+    snapshot.d->systemName = systemName;
+    snapshot.rebuildFromBodyMap(SystemModelBuilder::buildBodyMap(bodies));
+    return snapshot;
+}
+
+void SystemSnapshot::rebuildFromBodyMap(const QHash<int, CelestialBody>& bodyMap) {
+    d->graph = SystemModelBuilder::buildBodyGraph(bodyMap);
+    d->hotBodies = SystemModelBuilder::buildHotRecords(bodyMap, d->graph);
+    d->coldBodies = SystemModelBuilder::buildColdRecords(bodyMap, d->graph);
+    d->roots.clear();
+    d->roots.reserve(d->graph.rootIndices.size());
+    for (const int rootIndex : d->graph.rootIndices) {
+        d->roots.push_back(d->graph.idAt(rootIndex));
+    }
+    d->orbitClassification = OrbitClassifier::classify(d->graph, d->hotBodies);
+    d->ephemeris = KeplerEphemeris::build(d->graph, d->hotBodies, d->coldBodies);
+}
+
+bool SystemSnapshot::isEmpty() const {
+    return d->hotBodies.isEmpty();
+}
+
+const QString& SystemSnapshot::systemName() const {
+    return d->systemName;
+}
+
+const QVector<int>& SystemSnapshot::roots() const {
+    return d->roots;
+}
+
+const BodyGraph& SystemSnapshot::graph() const {
+    return d->graph;
+}
+
+const QVector<BodyHot>& SystemSnapshot::hotBodies() const {
+    return d->hotBodies;
+}
+
+const QVector<BodyCold>& SystemSnapshot::coldBodies() const {
+    return d->coldBodies;
+}
+
+const OrbitClassificationResult& SystemSnapshot::orbitClassification() const {
+    return d->orbitClassification;
+}
+
+const KeplerEphemeris& SystemSnapshot::ephemeris() const {
+    return d->ephemeris;
+}
+
+bool SystemSnapshot::contains(const int bodyId) const {
+    return d->graph.indexOf(bodyId) >= 0;
+}
+
+std::optional<CelestialBody> SystemSnapshot::body(const int bodyId) const {
+    const int index = d->graph.indexOf(bodyId);
+    if (index < 0) {
+        return std::nullopt;
+    }
+    return SystemModelBuilder::assembleBody(d->hotBodies.at(index), d->coldBodies.at(index));
+}
+
+int SystemSnapshot::realBodyCount() const {
+    int count = 0;
+    for (const BodyHot& hot : d->hotBodies) {
+        if (!hot.hasFlag(BodyHot::VirtualRootFlag)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+qint64 SystemSnapshot::estimatedMemoryBytes() const {
+    auto stringBytes = [](const QString& value) {
+        return static_cast<qint64>(value.capacity()) * static_cast<qint64>(sizeof(QChar));
+    };
+    qint64 bytes = static_cast<qint64>(sizeof(SystemSnapshotData)) + stringBytes(d->systemName);
+    bytes += static_cast<qint64>(d->hotBodies.capacity()) * static_cast<qint64>(sizeof(BodyHot));
+    bytes += static_cast<qint64>(d->coldBodies.capacity()) * static_cast<qint64>(sizeof(BodyCold));
+    for (const BodyCold& cold : d->coldBodies) {
+        bytes += stringBytes(cold.parentRelationType) + stringBytes(cold.name) + stringBytes(cold.type)
+                 + stringBytes(cold.atmosphereSummary) + stringBytes(cold.volcanism) + stringBytes(cold.terraformingState);
+    }
+
+    const BodyGraph& graph = d->graph;
+    bytes += static_cast<qint64>(graph.bodyIds.capacity() + graph.parentIndex.capacity() + graph.childOffsets.capacity()
+                                 + graph.childIndices.capacity() + graph.rootIndices.capacity() + d->roots.capacity())
+             * static_cast<qint64>(sizeof(int));
+    // QHash: узел с ключом и значением плюс ячейка корзины на элемент.
+    bytes += static_cast<qint64>(graph.indexById.size()) * static_cast<qint64>(4 * sizeof(void*));
+    bytes += static_cast<qint64>(d->orbitClassification.bodyTypes.capacity()) * static_cast<qint64>(sizeof(BodyOrbitTypes));
+    // Сам объект эфемерид уже учтён в sizeof(SystemSnapshotData).
+    bytes += d->ephemeris.estimatedMemoryBytes() - static_cast<qint64>(sizeof(KeplerEphemeris));
+    return bytes;
+}
+
+SystemSnapshot SystemSnapshot::withBody(const CelestialBody& body) const {
+    if (body.id < 0) {
+        return *this;
+    }
+
+    CelestialBody replacement = body;
+    if (replacement.parentId == replacement.id) {
+        // Та же нормализация самоссылки, что и в SystemModelBuilder::buildBodyMap.
+        replacement.parentId = replacement.id == kExternalVirtualBarycenterMarkerId ? -1 : kExternalVirtualBarycenterMarkerId;
+        replacement.orbitsBarycenter = replacement.parentId == kExternalVirtualBarycenterMarkerId;
+        replacement.parentRelationType = QStringLiteral("Null");
+    }
+
+    const int index = d->graph.indexOf(replacement.id);
+    const BodyHot hot = SystemModelBuilder::makeHotRecord(replacement);
+    const bool sameHierarchy = index >= 0 && hot.parentId == d->hotBodies.at(index).parentId
+        && hot.hasFlag(BodyHot::VirtualRootFlag) == d->hotBodies.at(index).hasFlag(BodyHot::VirtualRootFlag);
+    if (!sameHierarchy) {
+        // Новое тело или смена родителя меняют граф: снимок собирается заново целиком.
+        QHash<int, CelestialBody> bodyMap;
+        bodyMap.reserve(d->hotBodies.size() + 1);
+        for (int bodyIndex = 0; bodyIndex < d->hotBodies.size(); ++bodyIndex) {
+            bodyMap.insert(d->graph.idAt(bodyIndex),
+                           SystemModelBuilder::assembleBody(d->hotBodies.at(bodyIndex), d->coldBodies.at(bodyIndex)));
+        }
+        bodyMap.insert(replacement.id, replacement);
+
+        SystemSnapshot updated = *this;
+        updated.rebuildFromBodyMap(bodyMap);
+        return updated;
+    }
+
+    // Иерархия прежняя: данные снимка отделяются, и переписывается одна ячейка тела. Граф
+    // остаётся общим с исходным снимком, строки остальных тел тоже — QString копируется лениво.
+    SystemSnapshot updated = *this;
+    SystemSnapshotData& data = *updated.d;
+    const bool classInputsChanged = hot.bodyClass != data.hotBodies.at(index).bodyClass
+        || hot.flags != data.hotBodies.at(index).flags;
+    data.hotBodies[index] = hot;
+    data.coldBodies[index] = SystemModelBuilder::makeColdRecord(replacement);
+    data.ephemeris.updateBody(index, data.hotBodies.at(index), data.coldBodies.at(index));
+    // Классификатор читает только класс и флаги тел.
+    if (classInputsChanged) {
+        data.orbitClassification = OrbitClassifier::classify(data.graph, data.hotBodies);
+    }
+    return updated;
+}
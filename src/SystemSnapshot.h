@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QHash>
+#include <QMetaType>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QString>
+#include <QVector>
+
+#include <optional>
+
+#include "BodyGraph.h"
+#include "BodyRecords.h"
+#include "CelestialBody.h"
+#include "KeplerEphemeris.h"
+#include "OrbitClassifier.h"
+
+class SystemSnapshotData : public QSharedData {
+public:
+    QString systemName;
+    QVector<int> roots;
+    BodyGraph graph;
+    // Горячие и холодные части тел лежат по индексам graph.
+    QVector<BodyHot> hotBodies;
+    QVector<BodyCold> coldBodies;
+    OrbitClassificationResult orbitClassification;
+    KeplerEphemeris ephemeris;
+};
+
+// Неизменяемый снимок загруженной системы: тела, восстановленная иерархия, орбитальная
+// классификация и эфемериды. Копирование — O(1) (общий счётчик ссылок), поэтому один снимок
+// раздаётся сцене, дереву ID, панелям деталей и фоновым задачам без глубоких копий.
+class SystemSnapshot {
+public:
+    SystemSnapshot();
+
+    static SystemSnapshot build(const QString& systemName, const QVector<CelestialBody>& bodies);
+
+    bool isEmpty() const;
+    const QString& systemName() const;
+    const QVector<int>& roots() const;
+    const BodyGraph& graph() const;
+    const QVector<BodyHot>& hotBodies() const;
+    const QVector<BodyCold>& coldBodies() const;
+    const OrbitClassificationResult& orbitClassification() const;
+    const KeplerEphemeris& ephemeris() const;
+
+    bool contains(int bodyId) const;
+    // Собирает полную запись тела из горячей и холодной частей; пусто, если тела нет в снимке.
+    std::optional<CelestialBody> body(int bodyId) const;
+    int realBodyCount() const;
+    // Приблизительный объём памяти снимка: плотные массивы (составы лежат в них же), строки тел, граф.
+    qint64 estimatedMemoryBytes() const;
+
+    // Copy-on-write: исходный снимок не меняется, новый разделяет с ним неизменённые данные.
+    // Правка тела с прежним родителем переписывает только его записи и эфемериду; новое тело
+    // или смена родителя пересобирают снимок целиком.
+    SystemSnapshot withBody(const CelestialBody& body) const;
+
+private:
+    void rebuildFromBodyMap(const QHash<int, CelestialBody>& bodyMap);
+
+    QSharedDataPointer<SystemSnapshotData> d;
+};
+
+Q_DECLARE_METATYPE(SystemSnapshot);
@@ -0,0 +1,134 @@
+#include "SystemSnapshotStore.h"
+
+SystemSnapshotStore::SystemSnapshotStore(const qint64 memoryBudgetBytes)
+    : m_memoryBudgetBytes(qMax<qint64>(0, memoryBudgetBytes)) {
+}
+
+qint64 SystemSnapshotStore::memoryBudgetBytes() const {
+    return m_memoryBudgetBytes;
+}
+
+int SystemSnapshotStore::setMemoryBudgetBytes(const qint64 memoryBudgetBytes) {
+    m_memoryBudgetBytes = qMax<qint64>(0, memoryBudgetBytes);
+    return evictOverBudget();
+}
+
+qint64 SystemSnapshotStore::memoryUsageBytes() const {
+    return m_memoryUsageBytes;
+}
+
+int SystemSnapshotStore::size() const {
+    return m_entries.size();
+}
+
+bool SystemSnapshotStore::contains(const QString& systemName) const {
+    return m_entries.contains(keyFor(systemName));
+}
+
+QStringList SystemSnapshotStore::systemNames() const {
+    QStringList names;
+    names.reserve(m_lruKeys.size());
+    for (const QString& key : m_lruKeys) {
+        names.push_back(m_entries.value(key).snapshot.systemName());
+    }
+    return names;
+}
+
+int SystemSnapshotStore::insert(const SystemSnapshot& snapshot) {
+    const QString key = keyFor(snapshot.systemName());
+    if (key.isEmpty()) {
+        return 0;
+    }
+
+    const auto existing = m_entries.constFind(key);
+    if (existing != m_entries.constEnd()) {
+        m_memoryUsageBytes -= existing->bytes;
+    }
+
+    Entry entry;
+    entry.snapshot = snapshot;
+    entry.bytes = snapshot.estimatedMemoryBytes();
+    m_entries.insert(key, entry);
+    m_memoryUsageBytes += entry.bytes;
+    touch(key);
+    return evictOverBudget();
+}
+
+std::optional<SystemSnapshot> SystemSnapshotStore::find(const QString& systemName) {
+    const QString key = keyFor(systemName);
+    const auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd()) {
+        return std::nullopt;
+    }
+
+    const SystemSnapshot snapshot = it->snapshot;
+    touch(key);
+    return snapshot;
+}
+
+void SystemSnapshotStore::visit(const QString& systemName) {
+    const QString trimmedName = systemName.trimmed();
+    if (trimmedName.isEmpty()) {
+        return;
+    }
+
+    if (m_historyIndex >= 0 && keyFor(m_history.at(m_historyIndex)) == keyFor(trimmedName)) {
+        return;
+    }
+
+    while (m_history.size() > m_historyIndex + 1) {
+        m_history.removeLast();
+    }
+    m_history.push_back(trimmedName);
+    m_historyIndex = m_history.size() - 1;
+}
+
+bool SystemSnapshotStore::canGoBack() const {
+    return m_historyIndex > 0;
+}
+
+bool SystemSnapshotStore::canGoForward() const {
+    return m_historyIndex >= 0 && m_historyIndex + 1 < m_history.size();
+}
+
+QString SystemSnapshotStore::goBack() {
+    if (!canGoBack()) {
+        return QString();
+    }
+
+    --m_historyIndex;
+    return m_history.at(m_historyIndex);
+}
+
+QString SystemSnapshotStore::goForward() {
+    if (!canGoForward()) {
+        return QString();
+    }
+
+    ++m_historyIndex;
+    return m_history.at(m_historyIndex);
+}
+
+QString SystemSnapshotStore::currentHistoryEntry() const {
+    return m_historyIndex >= 0 ? m_history.at(m_historyIndex) : QString();
+}
+
+QString SystemSnapshotStore::keyFor(const QString& systemName) {
+    return systemName.trimmed().toLower();
+}
+
+void SystemSnapshotStore::touch(const QString& key) {
+    m_lruKeys.removeOne(key);
+    m_lruKeys.push_front(key);
+}
+
+int SystemSnapshotStore::evictOverBudget() {
+    // Самую свежую систему не трогаем: она сейчас на экране.
+    int evictedCount = 0;
+    while (m_memoryUsageBytes > m_memoryBudgetBytes && m_lruKeys.size() > 1) {
+        const QString evictedKey = m_lruKeys.takeLast();
+        m_memoryUsageBytes -= m_entries.take(evictedKey).bytes;
+        ++evictedCount;
+    }
+    return evictedCount;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include <optional>
+
+#include "SystemSnapshot.h"
+
+// Хранилище недавно открытых систем в памяти процесса. Снимки вытесняются по LRU,
+// как только суммарная оценка их памяти превышает бюджет. Отдельно ведётся история
+// переходов (назад/вперёд): её записи переживают вытеснение, и тогда систему
+// нужно загрузить заново.
+class SystemSnapshotStore {
+public:
+    static constexpr qint64 kDefaultMemoryBudgetBytes = 256LL * 1024 * 1024;
+
+    explicit SystemSnapshotStore(qint64 memoryBudgetBytes = kDefaultMemoryBudgetBytes);
+
+    qint64 memoryBudgetBytes() const;
+    // Возвращает число вытесненных снимков, как и insert().
+    int setMemoryBudgetBytes(qint64 memoryBudgetBytes);
+    qint64 memoryUsageBytes() const;
+
+    int size() const;
+    bool contains(const QString& systemName) const;
+    // Самая свежая система — первая.
+    QStringList systemNames() const;
+
+    // Последний вставленный снимок не вытесняется, даже если сам превышает бюджет.
+    // Возвращает число снимков, вытесненных ради него.
+    int insert(const SystemSnapshot& snapshot);
+    // Находит снимок и отмечает его как последний использованный.
+    std::optional<SystemSnapshot> find(const QString& systemName);
+
+    // Добавляет систему в историю, отбрасывая записи «вперёд». Повторный переход
+    // на текущую систему историю не меняет.
+    void visit(const QString& systemName);
+    bool canGoBack() const;
+    bool canGoForward() const;
+    QString goBack();
+    QString goForward();
+    QString currentHistoryEntry() const;
+
+private:
+    struct Entry {
+        SystemSnapshot snapshot;
+        qint64 bytes = 0;
+    };
+
+    static QString keyFor(const QString& systemName);
+    void touch(const QString& key);
+    int evictOverBudget();
+
+    qint64 m_memoryBudgetBytes = kDefaultMemoryBudgetBytes;
+    qint64 m_memoryUsageBytes = 0;
+    QHash<QString, Entry> m_entries;
+    QStringList m_lruKeys;
+    QStringList m_history;
+    int m_historyIndex = -1;
+};
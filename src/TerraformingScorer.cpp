@@ -0,0 +1,112 @@
+#include "TerraformingScorer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ChunkedTopK.h"
+
+namespace {
+
+// Блок строк на одну задачу пула: ~16K строк × 7 столбцов float помещаются в L2.
+constexpr int kChunkRows = 16384;
+
+inline float closeness(const float value, const float target, const float inverseTolerance) {
+    return std::max(0.0f, 1.0f - std::fabs(value - target) * inverseTolerance);
+}
+
+float inverseOf(const double tolerance) {
+    return tolerance > 0.0 ? static_cast<float>(1.0 / tolerance) : 0.0f;
+}
+
+// Порядок выдачи: выше оценка, при равенстве — меньший номер строки (детерминированно
+// при любом разбиении на блоки).
+bool ranksHigher(const TerraformingCandidate& lhs, const TerraformingCandidate& rhs) {
+    return lhs.score > rhs.score || (lhs.score == rhs.score && lhs.row < rhs.row);
+}
+
+} // namespace
+
+void TerraformingColumns::reserve(const int count) {
+    rowIds.reserve(count);
+    systemId64.reserve(count);
+    terraformable.reserve(count);
+    gravityG.reserve(count);
+    temperatureK.reserve(count);
+    pressureAtm.reserve(count);
+    massEarth.reserve(count);
+    distanceLs.reserve(count);
+    earthLikeAtmosphere.reserve(count);
+    atmosphere.reserve(count);
+    materials.reserve(count);
+}
+
+void TerraformingScorer::scoreRange(const TerraformingColumns& columns,
+                                    const TerraformingWeights& weights,
+                                    const int begin,
+                                    const int end,
+                                    float* out) {
+    const double weightSum = qMax(0.0, weights.terraformingState) + qMax(0.0, weights.gravity)
+                             + qMax(0.0, weights.temperature) + qMax(0.0, weights.pressure)
+                             + qMax(0.0, weights.atmosphere) + qMax(0.0, weights.mass) + qMax(0.0, weights.distance);
+    const double normalizer = weightSum > 0.0 ? 1.0 / weightSum : 0.0;
+    const auto normalized = [normalizer](const double weight) {
+        return static_cast<float>(qMax(0.0, weight) * normalizer);
+    };
+
+    const float terraformingWeight = normalized(weights.terraformingState);
+    const float gravityWeight = normalized(weights.gravity);
+    const float temperatureWeight = normalized(weights.temperature);
+    const float pressureWeight = normalized(weights.pressure);
+    const float atmosphereWeight = normalized(weights.atmosphere);
+    const float massWeight = normalized(weights.mass);
+    const float distanceWeight = normalized(weights.distance);
+
+    const float targetGravity = static_cast<float>(weights.targetGravityG);
+    const float targetTemperature = static_cast<float>(weights.targetTemperatureK);
+    const float targetPressure = static_cast<float>(weights.targetPressureAtm);
+    const float targetMass = static_cast<float>(weights.targetMassEarth);
+    const float inverseGravityTolerance = inverseOf(weights.gravityToleranceG);
+    const float inverseTemperatureTolerance = inverseOf(weights.temperatureToleranceK);
+    const float inversePressureTolerance = inverseOf(weights.pressureToleranceAtm);
+    const float inverseMassTolerance = inverseOf(weights.massToleranceEarth);
+    const float distanceHalfScore = static_cast<float>(qMax(1.0, weights.distanceHalfScoreLs));
+
+    // Сырые указатели: компилятор видит независимые последовательные потоки float
+    // и разворачивает цикл в SIMD без проверок границ QVector.
+    const float* terraformable = columns.terraformable.constData();
+    const float* gravity = columns.gravityG.constData();
+    const float* temperature = columns.temperatureK.constData();
+    const float* pressure = columns.pressureAtm.constData();
+    const float* mass = columns.massEarth.constData();
+    const float* distance = columns.distanceLs.constData();
+    const float* atmosphere = columns.earthLikeAtmosphere.constData();
+
+    for (int row = begin; row < end; ++row) {
+        out[row - begin] = terraformingWeight * terraformable[row]
+                           + gravityWeight * closeness(gravity[row], targetGravity, inverseGravityTolerance)
+                           + temperatureWeight * closeness(temperature[row], targetTemperature, inverseTemperatureTolerance)
+                           + pressureWeight * closeness(pressure[row], targetPressure, inversePressureTolerance)
+                           + atmosphereWeight * atmosphere[row]
+                           + massWeight * closeness(mass[row], targetMass, inverseMassTolerance)
+                           + distanceWeight * (distanceHalfScore / (distanceHalfScore + distance[row]));
+    }
+}
+
+QVector<TerraformingCandidate> TerraformingScorer::topK(const TerraformingColumns& columns,
+                                                        const TerraformingWeights& weights,
+                                                        const int k,
+                                                        const QVector<quint8>* rowMask) {
+    const int rowCount = columns.size();
+    if (k <= 0 || rowCount == 0) {
+        return {};
+    }
+
+    const quint8* mask = rowMask && rowMask->size() == rowCount ? rowMask->constData() : nullptr;
+    return ChunkedTopK::select<TerraformingCandidate>(
+        rowCount,
+        kChunkRows,
+        k,
+        mask,
+        [&columns, &weights](const int begin, const int end, float* out) { scoreRange(columns, weights, begin, end, out); },
+        ranksHigher);
+}
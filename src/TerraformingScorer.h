@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QVector>
+#include <QtGlobal>
+
+#include "BodyComposition.h"
+
+// Столбцовое представление тел корпуса для оценки: каждое поле — отдельный плотный
+// массив float, поэтому ядро оценки читает память последовательно и векторизуется.
+// Отсутствующие значения хранятся как 0 и дают нулевой вклад соответствующего критерия.
+struct TerraformingColumns {
+    QVector<qint64> rowIds;
+    QVector<quint64> systemId64;
+    QVector<float> terraformable;
+    QVector<float> gravityG;
+    QVector<float> temperatureK;
+    QVector<float> pressureAtm;
+    QVector<float> massEarth;
+    QVector<float> distanceLs;
+    // Доля азота и кислорода в атмосфере, 0..1.
+    QVector<float> earthLikeAtmosphere;
+    // Полные составы по слотам — для пороговых фильтров ("азот ≥ 70%") перед оценкой.
+    AtmosphereColumns atmosphere;
+    MaterialColumns materials;
+
+    int size() const {
+        return rowIds.size();
+    }
+
+    void reserve(int count);
+};
+
+// Веса критериев и целевые значения. Оценка тела — взвешенное среднее вкладов 0..1,
+// поэтому сама оценка тоже лежит в 0..1 при любых неотрицательных весах.
+struct TerraformingWeights {
+    double terraformingState = 4.0;
+    double gravity = 2.0;
+    double temperature = 2.0;
+    double pressure = 1.0;
+    double atmosphere = 1.0;
+    double mass = 1.0;
+    double distance = 0.5;
+
+    double targetGravityG = 1.0;
+    double gravityToleranceG = 0.6;
+    double targetTemperatureK = 288.0;
+    double temperatureToleranceK = 80.0;
+    double targetPressureAtm = 1.0;
+    double pressureToleranceAtm = 1.0;
+    double targetMassEarth = 1.0;
+    double massToleranceEarth = 1.0;
+    // Расстояние, на котором вклад удалённости падает вдвое.
+    double distanceHalfScoreLs = 5000.0;
+};
+
+struct TerraformingCandidate {
+    int row = -1;
+    float score = 0.0f;
+};
+
+Q_DECLARE_TYPEINFO(TerraformingCandidate, Q_PRIMITIVE_TYPE);
+
+class TerraformingScorer {
+public:
+    // Оценивает строки [begin, end) в out[0 .. end - begin). Без ветвлений по данным.
+    static void scoreRange(const TerraformingColumns& columns,
+                           const TerraformingWeights& weights,
+                           int begin,
+                           int end,
+                           float* out);
+
+    // Лучшие k строк по убыванию оценки. Столбцы режутся на блоки, блоки оцениваются
+    // на всех ядрах (QtConcurrent), каждый блок держит свой top-k, затем они сливаются.
+    // rowMask (необязательный, размер как у столбцов): строки с 0 пропускаются.
+    static QVector<TerraformingCandidate> topK(const TerraformingColumns& columns,
+                                               const TerraformingWeights& weights,
+                                               int k,
+                                               const QVector<quint8>* rowMask = nullptr);
+};
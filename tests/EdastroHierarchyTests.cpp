@@ -1,18 +1,40 @@
 #include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QFile>
 #include <QHash>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonParseError>
+#include <QRandomGenerator>
 #include <QStringList>
+#include <QTextStream>
 #include <QtTest>
 
+#include "BodyFilter.h"
+#include "BodyTaxonomy.h"
 #include "CelestialBody.h"
+#include "ColumnKernels.h"
+#include "CorpusStatistics.h"
 #include "EdsmApiClient.h"
+#include "GalacticSpatialIndex.h"
+#include "LabelPlacement.h"
+#include "LayoutDeclutter.h"
+#include "OrbitPathCache.h"
+#include "OrbitScene3D.h"
+#include "SemanticZoomLayout.h"
+#include "SystemArchitecture.h"
+#include "SystemCorpusDatabase.h"
+#include "SystemFingerprint.h"
+#include "SystemId64.h"
 #include "SystemLayoutEngine.h"
 #include "SystemModelBuilder.h"
+#include "SystemSnapshot.h"
+#include "SystemSnapshotStore.h"
+#include "TerraformingScorer.h"
 
 namespace {
 
@@ -39,6 +61,19 @@ QHash<int, CelestialBody> toMap(const QVector<CelestialBody>& bodies) {
     return map;
 }
 
+QVector<int> childIdsOf(const BodyGraph& graph, const int bodyId) {
+    QVector<int> childIds;
+    const int index = graph.indexOf(bodyId);
+    if (index < 0) {
+        return childIds;
+    }
+
+    for (const int* child = graph.childrenBegin(index); child != graph.childrenEnd(index); ++child) {
+        childIds.push_back(graph.idAt(*child));
+    }
+    return childIds;
+}
+
 } // namespace
 
 class EdastroHierarchyTests : public QObject {
@@ -53,7 +88,31 @@ private slots:
     void colLayoutPlacesBinaryStarsSymmetricallyForBodyClassBarycenter();
     void buildBodyMapSkipsSelfParentInChildren();
     void findRootBodiesReturnsRootAfterSelfParentNormalization();
+    void snapshotUpdateLeavesSharedCopiesUntouched();
+    void snapshotSplitsBodiesIntoHotAndColdRecords();
+    void taxonomyResolvesStarClassAndPlanetSubtype();
+    void snapshotStoreEvictsLeastRecentlyUsedOverBudget();
+    void snapshotStoreHistoryNavigatesBackAndForward();
+    void corpusDatabaseFindsTerraformableWorldsByGravity();
+    void spatialIndexMatchesBruteForceNeighbours();
+    void id64DecoderLocatesSystemWithinBoxel();
+    void terraformingScorerRanksCorpusCandidates();
+    void compositionSlotsSupportColumnThresholdScans();
+    void bodyFilterCompilesAndEvaluatesExpressions();
+    void systemArchitectureHashIgnoresBodyOrder();
+    void systemFingerprintFindsNearestSystems();
+    void orbitClassifierPacksLabelsIntoBitmasks();
+    void corpusStatisticsFollowSystemUpdates();
+    void layoutWorkspaceHandlesDeepChainsWithoutReallocation();
+    void layoutIsIndependentOfCanvasSize();
     void parsesExtendedPhysicalFieldsFromEdastroJson();
+    void keplerEphemerisSolvesPositionsFromElements();
+    void ephemerisTablesFollowKeplerSolutionAndAdvanceLayout();
+    void orbitPathsFollowEllipseAndCullToViewport();
+    void orbitScene3DProjectsInclinedOrbits();
+    void semanticZoomExpandsVisibleMoonSubsystems();
+    void layoutDeclutterSeparatesOverlapsNearAnchors();
+    void labelPlacementAvoidsCollisionsByPriority();
 };
 
 void EdastroHierarchyTests::eadstroBarycenterResolvesToStar() {
@@ -231,7 +290,7 @@ void EdastroHierarchyTests::colLayoutPlacesBinaryStarsSymmetricallyForBodyClassB
     QCOMPARE(barycenter.bodyClass, CelestialBody::BodyClass::Barycenter);
     QVERIFY2(barycenter.type.isEmpty(), "Expected empty type for barycenter id=4 in col.json");
 
-    const auto layout = SystemLayoutEngine::buildLayout(map, QVector<int>{0}, QRectF(0.0, 0.0, 1200.0, 1200.0));
+    const auto layout = SystemLayoutEngine::buildLayout(map, QVector<int>{0});
     QVERIFY2(layout.contains(4), "Expected layout for barycenter id=4");
     QVERIFY2(layout.contains(5), "Expected layout for star C id=5");
     QVERIFY2(layout.contains(6), "Expected layout for star D id=6");
@@ -295,13 +354,13 @@ void EdastroHierarchyTests::parsesExtendedPhysicalFieldsFromEdastroJson() {
     QCOMPARE(body.volcanism, QStringLiteral("Major"));
     QCOMPARE(body.terraformingState, QStringLiteral("Candidate"));
 
-    QCOMPARE(body.atmoComposition.size(), 2);
-    QCOMPARE(body.atmoComposition.at(0).name, QStringLiteral("Nitrogen"));
-    QCOMPARE(body.atmoComposition.at(0).percent, 78.0);
+    QCOMPARE(body.atmoComposition.partCount(), 2);
+    QCOMPARE(body.atmoComposition.presentSlots().first(), AtmosphereGas::Nitrogen);
+    QCOMPARE(body.atmoComposition.value(AtmosphereGas::Nitrogen), 78.0f);
 
-    QCOMPARE(body.materials.size(), 2);
-    QCOMPARE(body.materials.at(0).name, QStringLiteral("Iron"));
-    QCOMPARE(body.materials.at(0).percent, 18.5);
+    QCOMPARE(body.materials.partCount(), 2);
+    QCOMPARE(body.materials.presentSlots().first(), RawMaterial::Iron);
+    QCOMPARE(body.materials.value(RawMaterial::Iron), 18.5f);
 }
 
 void EdastroHierarchyTests::buildBodyMapSkipsSelfParentInChildren() {
@@ -322,11 +381,12 @@ void EdastroHierarchyTests::buildBodyMapSkipsSelfParentInChildren() {
     QCOMPARE(bodyMap.value(10).parentRelationType, QStringLiteral("Null"));
 
     QVERIFY2(bodyMap.contains(0), "Expected root id=0");
-    const auto& rootBody = bodyMap.value(0);
-    QVERIFY2(rootBody.children.contains(10), "Expected root to include normalized child id=10");
+    const auto graph = SystemModelBuilder::buildBodyGraph(bodyMap);
+    QVERIFY2(childIdsOf(graph, 0).contains(10), "Expected root to include normalized child id=10");
+    QCOMPARE(graph.parentIndex.at(graph.indexOf(10)), graph.indexOf(0));
 
     int selfLinks = 0;
-    for (const int childId : bodyMap.value(10).children) {
+    for (const int childId : childIdsOf(graph, 10)) {
         if (childId == 10) {
             ++selfLinks;
         }
@@ -352,5 +412,1483 @@ void EdastroHierarchyTests::findRootBodiesReturnsRootAfterSelfParentNormalizatio
     QVERIFY2(roots.contains(1), "Expected normalized body id=1 to be detected as root");
 }
 
+void EdastroHierarchyTests::snapshotUpdateLeavesSharedCopiesUntouched() {
+    CelestialBody root;
+    root.id = 0;
+    root.name = QStringLiteral("Root");
+    root.type = QStringLiteral("Null");
+
+    CelestialBody planet;
+    planet.id = 10;
+    planet.name = QStringLiteral("Planet");
+    planet.type = QStringLiteral("Planet");
+    planet.parentId = 0;
+
+    const auto original = SystemSnapshot::build(QStringLiteral("Snapshot test"), {root, planet});
+    const SystemSnapshot sharedCopy = original;
+    QVERIFY2(&sharedCopy.hotBodies() == &original.hotBodies(), "Snapshot copies must share body storage");
+
+    CelestialBody moon;
+    moon.id = 11;
+    moon.name = QStringLiteral("Moon");
+    moon.type = QStringLiteral("Moon");
+    moon.parentId = 10;
+
+    const auto updated = original.withBody(moon);
+    QVERIFY2(updated.contains(11), "Expected updated snapshot to contain the new body");
+    QVERIFY2(childIdsOf(updated.graph(), 10).contains(11), "Expected new body to be linked to its parent");
+    QVERIFY2(!original.contains(11), "Original snapshot must stay unchanged");
+    QVERIFY2(!childIdsOf(sharedCopy.graph(), 10).contains(11), "Shared copies must not observe the update");
+    QCOMPARE(updated.systemName(), original.systemName());
+
+    // Правка тела с прежним родителем переписывает только его записи: граф остаётся общим.
+    CelestialBody renamedMoon = moon;
+    renamedMoon.name = QStringLiteral("Moon II");
+    renamedMoon.semiMajorAxisAu = 0.002;
+    const auto patched = updated.withBody(renamedMoon);
+    QVERIFY2(patched.graph().childIndices.constData() == updated.graph().childIndices.constData(),
+             "Same-parent update must not rebuild the graph");
+    QCOMPARE(patched.body(11)->name, QStringLiteral("Moon II"));
+    QVERIFY(patched.ephemeris().hasOrbit(patched.graph().indexOf(11)));
+    QCOMPARE(updated.body(11)->name, QStringLiteral("Moon"));
+    QVERIFY(!updated.ephemeris().hasOrbit(updated.graph().indexOf(11)));
+}
+
+void EdastroHierarchyTests::snapshotSplitsBodiesIntoHotAndColdRecords() {
+    CelestialBody star;
+    star.id = 0;
+    star.name = QStringLiteral("Star A");
+    star.type = QStringLiteral("K (Yellow-Orange) Star");
+    star.bodyClass = CelestialBody::BodyClass::Star;
+
+    CelestialBody planet;
+    planet.id = 3;
+    planet.parentId = 0;
+    planet.name = QStringLiteral("Planet 1");
+    planet.type = QStringLiteral("High metal content world Planet");
+    planet.bodyClass = CelestialBody::BodyClass::Planet;
+    planet.semiMajorAxisAu = 1.25;
+    planet.physicalRadiusKm = 4200.0;
+    planet.surfaceGravityMs2 = 7.1;
+    planet.terraformingState = QStringLiteral("Candidate for terraforming");
+    planet.materials.setValue(RawMaterial::Iron, 21.5f);
+
+    const auto snapshot = SystemSnapshot::build(QStringLiteral("Hot/cold test"), {star, planet});
+    const int planetIndex = snapshot.graph().indexOf(3);
+    QVERIFY2(planetIndex >= 0, "Expected planet id=3 in the graph");
+
+    const BodyHot& hot = snapshot.hotBodies().at(planetIndex);
+    QCOMPARE(hot.parentId, 0);
+    QCOMPARE(hot.semiMajorAxisAu, 1.25);
+    QVERIFY2(hot.hasFlag(BodyHot::PlanetTypeFlag), "Expected planet type flag");
+    QVERIFY2(!hot.hasFlag(BodyHot::StarTypeFlag), "Planet must not carry star type flag");
+    QVERIFY2(snapshot.hotBodies().at(snapshot.graph().indexOf(0)).hasFlag(BodyHot::StarTypeFlag), "Expected star type flag");
+
+    const auto assembled = snapshot.body(3);
+    QVERIFY2(assembled.has_value(), "Expected assembled planet");
+    QCOMPARE(assembled->name, planet.name);
+    QCOMPARE(assembled->physicalRadiusKm, 4200.0);
+    QCOMPARE(assembled->surfaceGravityMs2, 7.1);
+    QCOMPARE(assembled->terraformingState, planet.terraformingState);
+    QCOMPARE(assembled->materials, planet.materials);
+    QVERIFY2(!snapshot.body(42).has_value(), "Unknown id must not resolve to a body");
+}
+
+void EdastroHierarchyTests::taxonomyResolvesStarClassAndPlanetSubtype() {
+    const BodyTaxon redDwarf = BodyTaxonomy::resolve(QStringLiteral("M (Red dwarf) Star"));
+    QVERIFY2(redDwarf.resolved, "Expected resolved taxon");
+    QVERIFY2(redDwarf.starClass == StarClass::M, "Expected M spectral class");
+    QVERIFY2(redDwarf.luminosity == StarLuminosity::MainSequence, "Red dwarf must stay on the main sequence");
+    QVERIFY2(redDwarf.hasFlag(BodyTaxon::StarTypeFlag), "Expected star type flag");
+
+    const BodyTaxon superGiant = BodyTaxonomy::resolve(QStringLiteral("B (Blue-White super giant) Star"));
+    QVERIFY2(superGiant.starClass == StarClass::B, "Expected B spectral class");
+    QVERIFY2(superGiant.luminosity == StarLuminosity::SuperGiant, "Expected super giant luminosity");
+
+    const BodyTaxon gasGiant = BodyTaxonomy::resolve(QStringLiteral("Class II gas giant"));
+    QVERIFY2(gasGiant.planetSubtype == PlanetSubtype::GasGiantClassII, "Class II must not match Class I");
+    QVERIFY2(gasGiant.hasFlag(BodyTaxon::WorldTypeFlag), "Gas giant type must be flagged as planetary");
+
+    // EDSM/Spansh: общий тип в type, подробный — в subType.
+    const BodyTaxon spanshPlanet = BodyTaxonomy::resolve(QStringLiteral("Planet"),
+                                                         QStringLiteral("High metal content world"));
+    QVERIFY2(spanshPlanet.hasFlag(BodyTaxon::PlanetTypeFlag), "Flags come from the primary type field");
+    QVERIFY2(spanshPlanet.planetSubtype == PlanetSubtype::HighMetalContent, "Subtype comes from subType");
+
+    const BodyTaxon barycenter = BodyTaxonomy::resolve(QStringLiteral("Barycentre"));
+    QVERIFY2(barycenter.hasFlag(BodyTaxon::BarycenterTypeFlag), "Expected barycenter flag");
+    QVERIFY2(barycenter.starClass == StarClass::Unknown, "Barycenter has no spectral class");
+
+    // EDSM/Spansh пишут «water-based life» через дефис — так же, как planetSubtypeName.
+    const BodyTaxon waterLife = BodyTaxonomy::resolve(QStringLiteral("Planet"),
+                                                      QStringLiteral("Gas giant with water-based life"));
+    QVERIFY2(waterLife.planetSubtype == PlanetSubtype::GasGiantWaterLife, "Hyphenated life subtype must resolve");
+
+    // Имя каждого подтипа разбирается обратно в тот же подтип.
+    for (int value = static_cast<int>(PlanetSubtype::MetalRich); value <= static_cast<int>(PlanetSubtype::GasGiant); ++value) {
+        const auto subtype = static_cast<PlanetSubtype>(value);
+        const QString name = BodyTaxonomy::planetSubtypeName(subtype);
+        QVERIFY2(BodyTaxonomy::resolve(QStringLiteral("Planet"), name).planetSubtype == subtype, qPrintable(name));
+    }
+}
+
+void EdastroHierarchyTests::snapshotStoreEvictsLeastRecentlyUsedOverBudget() {
+    auto makeSnapshot = [](const QString& systemName) {
+        CelestialBody star;
+        star.id = 0;
+        star.name = systemName + QStringLiteral(" A");
+        star.type = QStringLiteral("G (White-Yellow) Star");
+        return SystemSnapshot::build(systemName, {star});
+    };
+
+    const auto first = makeSnapshot(QStringLiteral("Sys-1"));
+    const auto second = makeSnapshot(QStringLiteral("Sys-2"));
+    const auto third = makeSnapshot(QStringLiteral("Sys-3"));
+    QVERIFY2(first.estimatedMemoryBytes() > 0, "Expected a positive memory estimate");
+
+    // Имена одной длины дают одинаковую оценку памяти, бюджет вмещает ровно два снимка.
+    SystemSnapshotStore store(first.estimatedMemoryBytes() + second.estimatedMemoryBytes());
+    QCOMPARE(store.insert(first), 0);
+    QCOMPARE(store.insert(second), 0);
+    QCOMPARE(store.size(), 2);
+
+    QVERIFY2(store.find(QStringLiteral("sys-1")).has_value(), "Lookup must be case-insensitive");
+    QCOMPARE(store.insert(third), 1);
+
+    QCOMPARE(store.size(), 2);
+    QVERIFY2(store.contains(QStringLiteral("Sys-1")), "Recently used system must survive eviction");
+    QVERIFY2(!store.contains(QStringLiteral("Sys-2")), "Least recently used system must be evicted");
+    QCOMPARE(store.systemNames(), (QStringList{QStringLiteral("Sys-3"), QStringLiteral("Sys-1")}));
+    QVERIFY2(store.memoryUsageBytes() <= store.memoryBudgetBytes(), "Usage must fit the budget");
+
+    QCOMPARE(store.setMemoryBudgetBytes(0), 1);
+    QCOMPARE(store.size(), 1);
+    QVERIFY2(store.contains(QStringLiteral("Sys-3")), "The most recent system is never evicted");
+}
+
+void EdastroHierarchyTests::snapshotStoreHistoryNavigatesBackAndForward() {
+    SystemSnapshotStore store;
+    QVERIFY2(!store.canGoBack() && !store.canGoForward(), "Empty history has no navigation");
+
+    store.visit(QStringLiteral("Sol"));
+    store.visit(QStringLiteral("Col 285 Sector XW-G b25-1"));
+    store.visit(QStringLiteral("col 285 sector xw-g b25-1"));
+    store.visit(QStringLiteral("Achenar"));
+
+    QVERIFY2(store.canGoBack(), "Expected back navigation");
+    QCOMPARE(store.goBack(), QStringLiteral("Col 285 Sector XW-G b25-1"));
+    QCOMPARE(store.goBack(), QStringLiteral("Sol"));
+    QVERIFY2(!store.canGoBack(), "Sol is the first history entry");
+    QCOMPARE(store.goForward(), QStringLiteral("Col 285 Sector XW-G b25-1"));
+
+    // Новый переход из середины истории отбрасывает записи «вперёд».
+    store.visit(QStringLiteral("Shinrarta Dezhra"));
+    QVERIFY2(!store.canGoForward(), "Forward entries must be dropped after a new visit");
+    QCOMPARE(store.currentHistoryEntry(), QStringLiteral("Shinrarta Dezhra"));
+}
+
+void EdastroHierarchyTests::corpusDatabaseFindsTerraformableWorldsByGravity() {
+    QFile file(QStringLiteral("col.json"));
+    QVERIFY2(file.open(QIODevice::ReadOnly), "Failed to open col.json");
+    const auto imported = parseEdastroSystemPayload(file.readAll(), QString(), [](const QString&) {});
+    QVERIFY2(!imported.bodies.isEmpty(), "Expected bodies from col.json");
+    QCOMPARE(imported.systemName, QStringLiteral("Col 285 Sector XW-G b25-1"));
+    QCOMPARE(imported.systemId64, Q_UINT64_C(2869977687537));
+
+    auto makePlanet = [](const int id, const QString& type, const double gravityG, const QString& terraformingState) {
+        CelestialBody planet;
+        planet.id = id;
+        planet.parentId = 0;
+        planet.name = QStringLiteral("Corpus Test %1").arg(id);
+        planet.type = type;
+        planet.surfaceGravityMs2 = gravityG * SystemCorpusDatabase::kStandardGravityMs2;
+        planet.surfaceTemperatureK = 250.0;
+        planet.terraformingState = terraformingState;
+        return planet;
+    };
+
+    CelestialBody star;
+    star.id = 0;
+    star.name = QStringLiteral("Corpus Test A");
+    star.type = QStringLiteral("K (Yellow-Orange) Star");
+
+    const QString highMetal = QStringLiteral("High metal content world");
+    const auto synthetic = SystemSnapshot::build(QStringLiteral("Corpus Test"),
+                                                 {star,
+                                                  makePlanet(1, highMetal, 1.2, QStringLiteral("Candidate for terraforming")),
+                                                  makePlanet(2, highMetal, 2.0, QStringLiteral("Candidate for terraforming")),
+                                                  makePlanet(3, highMetal, 1.0, QStringLiteral("Not terraformable")),
+                                                  makePlanet(4, QStringLiteral("Rocky body"), 0.8, QStringLiteral("Terraformable"))});
+
+    SystemCorpusDatabase corpus;
+    QVERIFY2(corpus.open(QStringLiteral(":memory:")), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(SystemSnapshot::build(imported.systemName, imported.bodies),
+                                imported.systemId64,
+                                imported.coordinates),
+             qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(synthetic), qPrintable(corpus.lastError()));
+    // Повторное сохранение заменяет систему, а не дублирует её тела.
+    QVERIFY2(corpus.storeSystem(synthetic), qPrintable(corpus.lastError()));
+    QCOMPARE(corpus.systemCount(), 2);
+    // Система без id64 и координат в пространственный индекс не попадает.
+    QCOMPARE(corpus.systemPositions().size(), 1);
+    // Индекс корпуса пополняется при сохранении, а не пересобирается из базы на каждый запрос.
+    QCOMPARE(corpus.spatialIndex().size(), 1);
+    QCOMPARE(corpus.spatialIndex().kNearest(*imported.coordinates, 1).first().point.systemId64, imported.systemId64);
+
+    CorpusBodyQuery query;
+    query.planetSubtype = PlanetSubtype::HighMetalContent;
+    query.terraformableOnly = true;
+    query.maxGravityG = 1.5;
+    const auto found = corpus.findBodies(query);
+    QCOMPARE(found.size(), 1);
+    QCOMPARE(found.first().systemName, QStringLiteral("Corpus Test"));
+    QCOMPARE(found.first().bodyId, 1);
+    QCOMPARE(found.first().parentId, 0);
+    QVERIFY(qAbs(found.first().gravityG - 1.2) < 1e-9);
+
+    CorpusBodyQuery bySystem;
+    bySystem.systemName = QStringLiteral("col 285 sector xw-g b25-1");
+    const auto colBodies = corpus.findBodies(bySystem);
+    QVERIFY2(!colBodies.isEmpty(), "Expected stored col.json bodies");
+    QCOMPARE(colBodies.first().systemId64, Q_UINT64_C(2869977687537));
+}
+
+void EdastroHierarchyTests::spatialIndexMatchesBruteForceNeighbours() {
+    QFile file(QStringLiteral("col.json"));
+    QVERIFY2(file.open(QIODevice::ReadOnly), "Failed to open col.json");
+    const auto imported = parseEdastroSystemPayload(file.readAll(), QString(), [](const QString&) {});
+    QVERIFY2(imported.coordinates.has_value(), "Expected coord_x/coord_y/coord_z from col.json");
+
+    QRandomGenerator generator(285);
+    QVector<GalacticPoint> points;
+    for (int index = 0; index < 2000; ++index) {
+        GalacticPoint point;
+        point.systemId64 = static_cast<quint64>(index + 1);
+        point.position.x = generator.bounded(2000.0) - 1000.0;
+        point.position.y = generator.bounded(400.0) - 200.0;
+        point.position.z = generator.bounded(2000.0) - 1000.0;
+        points.push_back(point);
+    }
+
+    GalacticSpatialIndex index;
+    index.build(points);
+    QCOMPARE(index.size(), points.size());
+
+    const GalacticCoordinates origin = *imported.coordinates;
+    auto bruteForce = [&points, &origin](const std::function<bool(const GalacticPoint&)>& accept) {
+        QVector<QPair<double, quint64>> sorted;
+        for (const auto& point : points) {
+            if (!accept || accept(point)) {
+                sorted.push_back({origin.distanceTo(point.position), point.systemId64});
+            }
+        }
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    };
+
+    // Фильтр имитирует «только системы с терраформируемой планетой».
+    const GalacticSpatialIndex::PointFilter evenOnly = [](const GalacticPoint& point) {
+        return point.systemId64 % 2 == 0;
+    };
+    const auto expectedNearest = bruteForce(evenOnly);
+    const auto nearest = index.kNearest(origin, 50, evenOnly);
+    QCOMPARE(nearest.size(), 50);
+    for (int rank = 0; rank < nearest.size(); ++rank) {
+        QCOMPARE(nearest.at(rank).point.systemId64, expectedNearest.at(rank).second);
+    }
+
+    const auto expectedAll = bruteForce({});
+    const double radiusLy = 250.0;
+    const auto inRadius = index.withinRadius(origin, radiusLy);
+    const int expectedInRadius = static_cast<int>(std::count_if(expectedAll.cbegin(),
+                                                                expectedAll.cend(),
+                                                                [radiusLy](const QPair<double, quint64>& entry) {
+                                                                    return entry.first <= radiusLy;
+                                                                }));
+    QCOMPARE(inRadius.size(), expectedInRadius);
+    for (int rank = 1; rank < inRadius.size(); ++rank) {
+        QVERIFY(inRadius.at(rank - 1).distanceLy <= inRadius.at(rank).distanceLy);
+    }
+
+    // Добавленные и перенесённые insert() точки отвечают так же, как после полной пересборки;
+    // 300 вставок переполняют буфер и проверяют его слияние с деревом.
+    for (int step = 0; step < 300; ++step) {
+        GalacticPoint point;
+        point.systemId64 = step % 3 == 0 ? static_cast<quint64>(step + 1) : static_cast<quint64>(points.size() + 1);
+        point.position.x = origin.x + generator.bounded(600.0) - 300.0;
+        point.position.y = origin.y + generator.bounded(100.0) - 50.0;
+        point.position.z = origin.z + generator.bounded(600.0) - 300.0;
+        index.insert(point);
+        if (point.systemId64 <= static_cast<quint64>(points.size())) {
+            points[static_cast<int>(point.systemId64 - 1)] = point;
+        } else {
+            points.push_back(point);
+        }
+
+        if (step != 99 && step != 299) {
+            continue;
+        }
+        QCOMPARE(index.size(), points.size());
+        const auto expectedUpdated = bruteForce(evenOnly);
+        const auto updatedNearest = index.kNearest(origin, 50, evenOnly);
+        QCOMPARE(updatedNearest.size(), 50);
+        for (int rank = 0; rank < updatedNearest.size(); ++rank) {
+            QVERIFY(qAbs(updatedNearest.at(rank).distanceLy - expectedUpdated.at(rank).first) < 1e-9);
+        }
+        const auto updatedAll = bruteForce({});
+        const int updatedInRadius = static_cast<int>(std::count_if(updatedAll.cbegin(),
+                                                                   updatedAll.cend(),
+                                                                   [radiusLy](const QPair<double, quint64>& entry) {
+                                                                       return entry.first <= radiusLy;
+                                                                   }));
+        QCOMPARE(index.withinRadius(origin, radiusLy).size(), updatedInRadius);
+    }
+}
+
+void EdastroHierarchyTests::id64DecoderLocatesSystemWithinBoxel() {
+    for (const auto& fileName : {QStringLiteral("col.json"), QStringLiteral("eadstro_example.json")}) {
+        QFile file(fileName);
+        QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable(fileName));
+        const auto payload = file.readAll();
+        const auto imported = parseEdastroSystemPayload(payload, QString(), [](const QString&) {});
+        QVERIFY2(imported.systemId64 != 0 && imported.coordinates.has_value(), qPrintable(fileName));
+
+        const auto systemObject = QJsonDocument::fromJson(payload).array().first().toObject();
+        const DecodedSystemId64 decoded = SystemId64::decode(imported.systemId64);
+        QCOMPARE(QString(QLatin1Char(decoded.massCodeLetter())), systemObject.value(QStringLiteral("masscode")).toString());
+        QCOMPARE(SystemId64::encode(decoded), imported.systemId64);
+
+        const GalacticCoordinates approximate = decoded.approximatePosition();
+        const double halfBoxel = decoded.boxelSizeLy() / 2.0;
+        QVERIFY2(qAbs(approximate.x - imported.coordinates->x) <= halfBoxel, qPrintable(fileName));
+        QVERIFY2(qAbs(approximate.y - imported.coordinates->y) <= halfBoxel, qPrintable(fileName));
+        QVERIFY2(qAbs(approximate.z - imported.coordinates->z) <= halfBoxel, qPrintable(fileName));
+
+        const quint64 bodyId64 = SystemId64::makeBodyId64(imported.systemId64, 42);
+        QCOMPARE(SystemId64::systemOfBody(bodyId64), imported.systemId64);
+        QCOMPARE(SystemId64::bodyIdOfBody(bodyId64), 42);
+    }
+}
+
+void EdastroHierarchyTests::terraformingScorerRanksCorpusCandidates() {
+    auto makePlanet = [](const int id, const QString& terraformingState, const double gravityG, const double temperatureK) {
+        CelestialBody planet;
+        planet.id = id;
+        planet.parentId = 0;
+        planet.name = QStringLiteral("Score Test %1").arg(id);
+        planet.type = QStringLiteral("High metal content world");
+        planet.terraformingState = terraformingState;
+        planet.surfaceGravityMs2 = gravityG * SystemCorpusDatabase::kStandardGravityMs2;
+        planet.surfaceTemperatureK = temperatureK;
+        planet.atmospherePressureAtm = 0.8;
+        planet.massEarth = 0.9;
+        planet.distanceToArrivalLs = 800.0;
+        return planet;
+    };
+
+    CelestialBody star;
+    star.id = 0;
+    star.name = QStringLiteral("Score Test A");
+    star.type = QStringLiteral("G (White-Yellow) Star");
+
+    auto bestCandidate = makePlanet(1, QStringLiteral("Candidate for terraforming"), 1.0, 290.0);
+    bestCandidate.atmoComposition.setValue(AtmosphereGas::Nitrogen, 80.0f);
+    bestCandidate.atmoComposition.setValue(AtmosphereGas::Oxygen, 15.0f);
+    const auto snapshot = SystemSnapshot::build(QStringLiteral("Score Test"),
+                                                {star,
+                                                 bestCandidate,
+                                                 makePlanet(2, QStringLiteral("Candidate for terraforming"), 1.0, 290.0),
+                                                 makePlanet(3, QString(), 1.0, 290.0),
+                                                 makePlanet(4, QString(), 3.5, 900.0)});
+
+    SystemCorpusDatabase corpus;
+    QVERIFY2(corpus.open(QStringLiteral(":memory:")), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(snapshot), qPrintable(corpus.lastError()));
+
+    const TerraformingColumns columns = corpus.loadScoringColumns();
+    QCOMPARE(columns.size(), 4);
+
+    const TerraformingWeights weights;
+    const auto ranked = TerraformingScorer::topK(columns, weights, 3);
+    QCOMPARE(ranked.size(), 3);
+    QVector<qint64> rowIds;
+    for (const auto& candidate : ranked) {
+        rowIds.push_back(columns.rowIds.at(candidate.row));
+    }
+    const auto records = corpus.bodiesByRowIds(rowIds);
+    QCOMPARE(records.size(), 3);
+    // Атмосфера N2 + O2 поднимает первое тело над таким же кандидатом без неё, нетерраформируемые — ниже обоих.
+    QCOMPARE(records.at(0).bodyId, 1);
+    QCOMPARE(records.at(1).bodyId, 2);
+    QCOMPARE(records.at(2).bodyId, 3);
+    // Пакетный запрос отдаёт тела в порядке rowIds, а не в порядке строк таблицы.
+    std::reverse(rowIds.begin(), rowIds.end());
+    const auto reversed = corpus.bodiesByRowIds(rowIds);
+    QCOMPARE(reversed.size(), 3);
+    QCOMPARE(reversed.at(0).bodyId, 3);
+    QCOMPARE(reversed.at(2).bodyId, 1);
+    QCOMPARE(reversed.at(0).rowId, rowIds.at(0));
+    // Исчезнувший rowid пропускается, поэтому записи сопоставляются с запросом по rowId, а не по позиции.
+    const auto withMissing = corpus.bodiesByRowIds({rowIds.at(0), -1, rowIds.at(2)});
+    QCOMPARE(withMissing.size(), 2);
+    QCOMPARE(withMissing.at(1).rowId, rowIds.at(2));
+
+    // Параллельный top-K по нескольким блокам совпадает с полной сортировкой.
+    QRandomGenerator generator(35);
+    TerraformingColumns random;
+    const int rowCount = 50000;
+    random.reserve(rowCount);
+    for (int row = 0; row < rowCount; ++row) {
+        random.rowIds.push_back(row);
+        random.systemId64.push_back(static_cast<quint64>(row % 97));
+        random.terraformable.push_back(generator.bounded(2) == 0 ? 0.0f : 1.0f);
+        random.gravityG.push_back(static_cast<float>(generator.bounded(3.0)));
+        random.temperatureK.push_back(static_cast<float>(generator.bounded(600.0)));
+        random.pressureAtm.push_back(static_cast<float>(generator.bounded(5.0)));
+        random.massEarth.push_back(static_cast<float>(generator.bounded(4.0)));
+        random.distanceLs.push_back(static_cast<float>(generator.bounded(100000.0)));
+        random.earthLikeAtmosphere.push_back(static_cast<float>(generator.bounded(1.0)));
+    }
+
+    QVector<float> scores(rowCount);
+    TerraformingScorer::scoreRange(random, weights, 0, rowCount, scores.data());
+    QVector<int> expectedOrder(rowCount);
+    std::iota(expectedOrder.begin(), expectedOrder.end(), 0);
+    std::sort(expectedOrder.begin(), expectedOrder.end(), [&scores](const int lhs, const int rhs) {
+        return scores.at(lhs) > scores.at(rhs) || (scores.at(lhs) == scores.at(rhs) && lhs < rhs);
+    });
+
+    const auto parallelTop = TerraformingScorer::topK(random, weights, 20);
+    QCOMPARE(parallelTop.size(), 20);
+    for (int rank = 0; rank < parallelTop.size(); ++rank) {
+        QCOMPARE(parallelTop.at(rank).row, expectedOrder.at(rank));
+    }
+
+    QVector<quint8> mask(rowCount, 0);
+    mask[rowCount - 1] = 1;
+    const auto maskedTop = TerraformingScorer::topK(random, weights, 20, &mask);
+    QCOMPARE(maskedTop.size(), 1);
+    QCOMPARE(maskedTop.first().row, rowCount - 1);
+}
+
+void EdastroHierarchyTests::compositionSlotsSupportColumnThresholdScans() {
+    const auto gasSlot = [](const QString& name) {
+        return BodyComposition::slotFromName<AtmosphereGas>(name).value_or(AtmosphereGas::Count);
+    };
+    QCOMPARE(gasSlot(QStringLiteral("Carbon dioxide")), AtmosphereGas::CarbonDioxide);
+    QCOMPARE(gasSlot(QStringLiteral("CarbonDioxide")), AtmosphereGas::CarbonDioxide);
+    QCOMPARE(gasSlot(QStringLiteral("sulfur_dioxide")), AtmosphereGas::SulphurDioxide);
+    QCOMPARE(BodyComposition::slotFromName<RawMaterial>(QStringLiteral("polonium")).value_or(RawMaterial::Count), RawMaterial::Polonium);
+    QVERIFY2(!BodyComposition::slotFromName<RawMaterial>(QStringLiteral("Unobtainium")).has_value(), "Unknown material must not map to a slot");
+
+    // 37 строк: два полных SIMD-блока по 16 и скалярный хвост.
+    QRandomGenerator generator(36);
+    AtmosphereColumns atmosphere;
+    MaterialColumns materials;
+    const int rowCount = 37;
+    for (int row = 0; row < rowCount; ++row) {
+        AtmosphereComposition gases;
+        gases.setValue(AtmosphereGas::Nitrogen, static_cast<float>(generator.bounded(100)));
+        atmosphere.append(gases);
+        MaterialComposition surface;
+        surface.setValue(RawMaterial::Polonium, static_cast<float>(generator.bounded(3.0)));
+        materials.append(surface);
+    }
+    QCOMPARE(atmosphere.size(), rowCount);
+
+    QVector<quint8> mask(rowCount, 1);
+    ColumnKernels::narrowMask(atmosphere.column(AtmosphereGas::Nitrogen), rowCount, ColumnComparison::GreaterOrEqual, 70.0f, mask.data());
+    ColumnKernels::narrowMask(materials.column(RawMaterial::Polonium), rowCount, ColumnComparison::Greater, 1.0f, mask.data());
+
+    int expectedCount = 0;
+    for (int row = 0; row < rowCount; ++row) {
+        const bool expected = atmosphere.columns[static_cast<size_t>(AtmosphereGas::Nitrogen)].at(row) >= 70.0f
+                              && materials.columns[static_cast<size_t>(RawMaterial::Polonium)].at(row) > 1.0f;
+        QCOMPARE(mask.at(row), static_cast<quint8>(expected ? 1 : 0));
+        expectedCount += expected ? 1 : 0;
+    }
+    QCOMPARE(ColumnKernels::countSelected(mask.constData(), rowCount), expectedCount);
+}
+
+void EdastroHierarchyTests::bodyFilterCompilesAndEvaluatesExpressions() {
+    auto makePlanet = [](const int id, const double gravityG, const double temperatureK) {
+        CelestialBody planet;
+        planet.id = id;
+        planet.parentId = 0;
+        planet.name = QStringLiteral("Filter Test %1").arg(id);
+        planet.type = QStringLiteral("Rocky body");
+        planet.bodyClass = CelestialBody::BodyClass::Planet;
+        planet.surfaceGravityMs2 = gravityG * SystemCorpusDatabase::kStandardGravityMs2;
+        planet.surfaceTemperatureK = temperatureK;
+        return planet;
+    };
+
+    CelestialBody star;
+    star.id = 0;
+    star.name = QStringLiteral("Filter Test A");
+    star.type = QStringLiteral("M (Red dwarf) Star");
+    star.bodyClass = CelestialBody::BodyClass::Star;
+
+    auto warmCo2 = makePlanet(1, 0.9, 250.0);
+    warmCo2.atmoComposition.setValue(AtmosphereGas::CarbonDioxide, 96.0f);
+    warmCo2.terraformingState = QStringLiteral("Candidate for terraforming");
+    auto heavy = makePlanet(2, 2.4, 250.0);
+    heavy.atmoComposition.setValue(AtmosphereGas::CarbonDioxide, 90.0f);
+    auto polonium = makePlanet(3, 0.3, 120.0);
+    polonium.materials.setValue(RawMaterial::Polonium, 1.4f);
+    // Температура неизвестна: сравнения по ней не проходят.
+    const auto unknown = makePlanet(4, 0.5, 0.0);
+
+    const auto snapshot = SystemSnapshot::build(QStringLiteral("Filter Test"), {star, warmCo2, heavy, polonium, unknown});
+    const BodyFilterColumns columns = BodyFilterColumns::fromSnapshot(snapshot);
+    QCOMPARE(columns.size(), snapshot.graph().size());
+
+    const auto matchingIds = [&](const QString& expression) {
+        const BodyFilter filter = BodyFilter::compile(expression);
+        if (!filter.isValid()) {
+            qWarning("%s", qPrintable(filter.errorMessage()));
+            return QList<int>{-1};
+        }
+        const QVector<quint8> mask = filter.evaluate(columns);
+        QList<int> ids;
+        for (int index = 0; index < mask.size(); ++index) {
+            if (mask.at(index) != 0) {
+                ids.push_back(snapshot.graph().idAt(index));
+            }
+        }
+        return ids;
+    };
+
+    QCOMPARE(matchingIds(QStringLiteral("gravity < 1.2 and temperature between 200 and 320 K and atmosphere contains CO2")),
+             QList<int>({1}));
+    QCOMPARE(matchingIds(QStringLiteral("terraformable or mat.polonium > 1")), QList<int>({1, 3}));
+    QCOMPARE(matchingIds(QStringLiteral("planet and not (temperature >= 200 or gravity > 0.4)")), QList<int>({3}));
+    QCOMPARE(matchingIds(QStringLiteral("1.0 > gravity && !star")), QList<int>({1, 3, 4}));
+    QCOMPARE(matchingIds(QString()), QList<int>({0, 1, 2, 3, 4}));
+
+    const BodyFilter broken = BodyFilter::compile(QStringLiteral("gravity < 1.2 and atmo.unobtainium > 5"));
+    QVERIFY(!broken.isValid());
+    QCOMPARE(broken.errorPosition(), 18);
+    QVERIFY(broken.evaluate(columns).size() == columns.size());
+    QVERIFY(!BodyFilter::compile(QStringLiteral("gravity and 5")).isValid());
+
+    // Корпус отдаёт те же столбцы по rowid: фильтр видит одни и те же тела.
+    SystemCorpusDatabase corpus;
+    QVERIFY2(corpus.open(QStringLiteral(":memory:")), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(snapshot), qPrintable(corpus.lastError()));
+    const BodyFilterColumns corpusColumns = corpus.loadFilterColumns();
+    QCOMPARE(corpusColumns.size(), 5);
+    QCOMPARE(corpusColumns.rowIds.size(), 5);
+    const QVector<quint8> corpusMask =
+        BodyFilter::compile(QStringLiteral("terraformable or mat.polonium > 1")).evaluate(corpusColumns);
+    QCOMPARE(ColumnKernels::countSelected(corpusMask.constData(), corpusMask.size()), 2);
+}
+
+void EdastroHierarchyTests::systemArchitectureHashIgnoresBodyOrder() {
+    auto makeBody = [](const int id, const int parentId, const CelestialBody::BodyClass bodyClass, const bool orbitsBarycenter) {
+        CelestialBody body;
+        body.id = id;
+        body.parentId = parentId;
+        body.bodyClass = bodyClass;
+        body.orbitsBarycenter = orbitsBarycenter;
+        body.name = QStringLiteral("Body %1").arg(id);
+        switch (bodyClass) {
+        case CelestialBody::BodyClass::Barycenter:
+            body.type = QStringLiteral("Barycentre");
+            break;
+        case CelestialBody::BodyClass::Star:
+            body.type = QStringLiteral("K (Yellow-Orange) Star");
+            break;
+        default:
+            body.type = QStringLiteral("Rocky body");
+            break;
+        }
+        return body;
+    };
+    using BodyClass = CelestialBody::BodyClass;
+
+    // Двойная звезда, у первой компоненты две планеты, у одной из них спутник.
+    const auto first = SystemSnapshot::build(QStringLiteral("Shape A"),
+                                             {makeBody(0, -1, BodyClass::Barycenter, false),
+                                              makeBody(1, 0, BodyClass::Star, true),
+                                              makeBody(2, 0, BodyClass::Star, true),
+                                              makeBody(3, 1, BodyClass::Planet, false),
+                                              makeBody(4, 1, BodyClass::Planet, false),
+                                              makeBody(5, 4, BodyClass::Moon, false)});
+    // То же дерево с другой нумерацией: планеты у второй по id звезды, спутник у первой планеты.
+    const auto renumbered = SystemSnapshot::build(QStringLiteral("Shape B"),
+                                                  {makeBody(10, -1, BodyClass::Barycenter, false),
+                                                   makeBody(3, 10, BodyClass::Star, true),
+                                                   makeBody(7, 10, BodyClass::Star, true),
+                                                   makeBody(20, 7, BodyClass::Planet, false),
+                                                   makeBody(21, 20, BodyClass::Moon, false),
+                                                   makeBody(30, 7, BodyClass::Planet, false)});
+    // Спутник перенесён на вторую звезду как планета — другая структура.
+    const auto different = SystemSnapshot::build(QStringLiteral("Shape C"),
+                                                 {makeBody(0, -1, BodyClass::Barycenter, false),
+                                                  makeBody(1, 0, BodyClass::Star, true),
+                                                  makeBody(2, 0, BodyClass::Star, true),
+                                                  makeBody(3, 1, BodyClass::Planet, false),
+                                                  makeBody(4, 1, BodyClass::Planet, false),
+                                                  makeBody(5, 2, BodyClass::Planet, false)});
+
+    const auto signatureOf = [](const SystemSnapshot& snapshot) {
+        return SystemArchitecture::compute(snapshot.graph(), snapshot.hotBodies());
+    };
+    const SystemArchitectureSignature firstSignature = signatureOf(first);
+    QCOMPARE(firstSignature.canonicalForm, QByteArray("B(~S,~S(P,P(M)))"));
+    QCOMPARE(firstSignature.hash, SystemArchitecture::hash(firstSignature.canonicalForm));
+    QCOMPARE(signatureOf(renumbered).canonicalForm, firstSignature.canonicalForm);
+    QCOMPARE(signatureOf(renumbered).hash, firstSignature.hash);
+    QVERIFY(signatureOf(different).hash != firstSignature.hash);
+
+    SystemCorpusDatabase corpus;
+    QVERIFY2(corpus.open(QStringLiteral(":memory:")), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(first), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(renumbered), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(different), qPrintable(corpus.lastError()));
+
+    const auto stored = corpus.systemArchitecture(QStringLiteral("shape b"));
+    QVERIFY(stored.has_value());
+    QCOMPARE(stored->hash, firstSignature.hash);
+
+    const QVector<CorpusSystemRecord> similar = corpus.systemsWithArchitecture(firstSignature);
+    QCOMPARE(similar.size(), 2);
+    QCOMPARE(similar.at(0).name, QStringLiteral("Shape A"));
+    QCOMPARE(similar.at(1).name, QStringLiteral("Shape B"));
+
+    const QVector<CorpusArchitectureGroup> groups = corpus.architectureGroups();
+    QCOMPARE(groups.size(), 2);
+    QCOMPARE(groups.at(0).systemCount, 2);
+    QCOMPARE(groups.at(0).exampleSystem, QStringLiteral("Shape A"));
+    QCOMPARE(groups.at(1).systemCount, 1);
+}
+
+void EdastroHierarchyTests::systemFingerprintFindsNearestSystems() {
+    auto makeBody = [](const int id, const int parentId, const CelestialBody::BodyClass bodyClass, const QString& type) {
+        CelestialBody body;
+        body.id = id;
+        body.parentId = parentId;
+        body.bodyClass = bodyClass;
+        body.orbitsBarycenter = bodyClass == CelestialBody::BodyClass::Star && parentId >= 0;
+        body.name = QStringLiteral("Body %1").arg(id);
+        body.type = type;
+        return body;
+    };
+    using BodyClass = CelestialBody::BodyClass;
+    const QString yellowStar = QStringLiteral("G (White-Yellow) Star");
+    const QString rockyBody = QStringLiteral("Rocky body");
+
+    // Одиночная G-звезда с тремя планетами в шаге 2:1 и терраформируемой второй планетой.
+    QVector<CelestialBody> solLike{makeBody(0, -1, BodyClass::Star, yellowStar)};
+    for (int planet = 1; planet <= 3; ++planet) {
+        CelestialBody body = makeBody(planet, 0, BodyClass::Planet, rockyBody);
+        body.semiMajorAxisAu = 0.5 * (1 << planet);
+        if (planet == 2) {
+            body.terraformingState = QStringLiteral("Candidate for terraforming");
+        }
+        solLike.push_back(body);
+    }
+    const auto single = SystemSnapshot::build(QStringLiteral("Fingerprint Single"), solLike);
+    const auto binary = SystemSnapshot::build(QStringLiteral("Fingerprint Binary"),
+                                              {makeBody(0, -1, BodyClass::Barycenter, QStringLiteral("Barycentre")),
+                                               makeBody(1, 0, BodyClass::Star, yellowStar),
+                                               makeBody(2, 0, BodyClass::Star, QStringLiteral("M (Red dwarf) Star")),
+                                               makeBody(3, 1, BodyClass::Planet, rockyBody)});
+
+    const SystemFingerprint singlePrint = SystemFingerprint::compute(single);
+    QCOMPARE(singlePrint.value(SystemFingerprint::StarCount), static_cast<float>(std::log1p(1.0)));
+    QCOMPARE(singlePrint.value(SystemFingerprint::PlanetCount), static_cast<float>(std::log1p(3.0)));
+    QCOMPARE(singlePrint.value(SystemFingerprint::SolarStars), static_cast<float>(std::log1p(1.0)));
+    QCOMPARE(singlePrint.value(SystemFingerprint::TerraformableCount), static_cast<float>(std::log1p(1.0)));
+    QCOMPARE(singlePrint.value(SystemFingerprint::OrbitSpacing), static_cast<float>(std::log10(2.0) * 4.0));
+    QCOMPARE(singlePrint.value(SystemFingerprint::BinaryStar), 0.0f);
+
+    const SystemFingerprint binaryPrint = SystemFingerprint::compute(binary);
+    QCOMPARE(binaryPrint.value(SystemFingerprint::BarycenterDepth), 1.0f);
+    QCOMPARE(binaryPrint.value(SystemFingerprint::BinaryStar), 1.0f);
+    QCOMPARE(binaryPrint.value(SystemFingerprint::CoolStars), static_cast<float>(std::log1p(1.0)));
+    QVERIFY(SystemFingerprint::fromBlob(binaryPrint.toBlob())->features == binaryPrint.features);
+
+    // Перебор по блокам совпадает с полной сортировкой, маска исключает строки.
+    QRandomGenerator generator(39);
+    SystemFingerprintTable table;
+    const int rowCount = 20000;
+    table.reserve(rowCount);
+    for (int row = 0; row < rowCount; ++row) {
+        SystemFingerprint fingerprint;
+        for (float& feature : fingerprint.features) {
+            feature = static_cast<float>(generator.bounded(4.0));
+        }
+        table.append(QStringLiteral("Random %1").arg(row), static_cast<quint64>(row + 1), fingerprint);
+    }
+    QVector<quint8> mask(rowCount, 1);
+    for (int row = 0; row < rowCount; row += 3) {
+        mask[row] = 0;
+    }
+
+    const auto matches = SystemFingerprintSearch::nearest(table, singlePrint, 10, &mask);
+    QCOMPARE(matches.size(), 10);
+    QVector<QPair<float, int>> expected;
+    for (int row = 0; row < rowCount; ++row) {
+        if (mask.at(row) == 0) {
+            continue;
+        }
+        float sum = 0.0f;
+        for (int feature = 0; feature < SystemFingerprint::kDimensions; ++feature) {
+            const float delta = table.row(row)[feature] - singlePrint.features[static_cast<size_t>(feature)];
+            sum += delta * delta;
+        }
+        expected.push_back({sum, row});
+    }
+    std::sort(expected.begin(), expected.end());
+    for (int index = 0; index < matches.size(); ++index) {
+        QCOMPARE(matches.at(index).row, expected.at(index).second);
+        QVERIFY(qAbs(matches.at(index).distance - std::sqrt(expected.at(index).first)) < 1e-4f);
+    }
+
+    SystemCorpusDatabase corpus;
+    QVERIFY2(corpus.open(QStringLiteral(":memory:")), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(single), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(binary, 42), qPrintable(corpus.lastError()));
+    const SystemFingerprintTable stored = corpus.loadFingerprints();
+    QCOMPARE(stored.size(), 2);
+    QCOMPARE(stored.systemId64.at(1), quint64(42));
+    const auto nearestStored = SystemFingerprintSearch::nearest(stored, binaryPrint, 1);
+    QCOMPARE(stored.names.at(nearestStored.at(0).row), QStringLiteral("Fingerprint Binary"));
+    QCOMPARE(nearestStored.at(0).distance, 0.0f);
+}
+
+void EdastroHierarchyTests::orbitClassifierPacksLabelsIntoBitmasks() {
+    auto makeBody = [](const int id, const int parentId, const CelestialBody::BodyClass bodyClass, const QString& type) {
+        CelestialBody body;
+        body.id = id;
+        body.parentId = parentId;
+        body.bodyClass = bodyClass;
+        body.name = QStringLiteral("Body %1").arg(id);
+        body.type = type;
+        return body;
+    };
+    using BodyClass = CelestialBody::BodyClass;
+    const QString barycentre = QStringLiteral("Barycentre");
+    const QString star = QStringLiteral("K (Yellow-Orange) Star");
+    const QString rockyBody = QStringLiteral("Rocky body");
+
+    // Пара пар звёзд (0 → 1, 2), у пары 1 — циркумбинарная планета, у корня — двойная планета (3).
+    const auto snapshot = SystemSnapshot::build(QStringLiteral("Orbit Types"),
+                                                {makeBody(0, -1, BodyClass::Barycenter, barycentre),
+                                                 makeBody(1, 0, BodyClass::Barycenter, barycentre),
+                                                 makeBody(2, 0, BodyClass::Barycenter, barycentre),
+                                                 makeBody(3, 0, BodyClass::Barycenter, barycentre),
+                                                 makeBody(10, 1, BodyClass::Star, star),
+                                                 makeBody(11, 1, BodyClass::Star, star),
+                                                 makeBody(12, 1, BodyClass::Planet, rockyBody),
+                                                 makeBody(20, 2, BodyClass::Star, star),
+                                                 makeBody(21, 2, BodyClass::Star, star),
+                                                 makeBody(30, 3, BodyClass::Planet, rockyBody),
+                                                 makeBody(31, 3, BodyClass::Planet, rockyBody)});
+    const BodyGraph& graph = snapshot.graph();
+    const OrbitClassificationResult& result = snapshot.orbitClassification();
+    QCOMPARE(result.bodyTypes.size(), graph.size());
+    const auto typesOf = [&](const int bodyId) {
+        return result.typesAt(graph.indexOf(bodyId));
+    };
+
+    QCOMPARE(typesOf(0), BodyOrbitTypes(BodyOrbitType::HierarchicalPairOfPairsBarycenter));
+    QCOMPARE(typesOf(1), BodyOrbitType::BinaryStarBarycenter | BodyOrbitType::HierarchicalPairMemberBarycenter);
+    QCOMPARE(typesOf(2), typesOf(1));
+    QCOMPARE(typesOf(3), BodyOrbitType::BinaryNonStarBarycenter | BodyOrbitType::BinaryPlanetPairBarycenter);
+    QCOMPARE(typesOf(10), BodyOrbitTypes(BodyOrbitType::BinaryStarComponent));
+    QCOMPARE(typesOf(12), BodyOrbitTypes(BodyOrbitType::CircumbinaryPlanet));
+    QCOMPARE(typesOf(31), BodyOrbitTypes(BodyOrbitType::BinaryPlanetComponent));
+    QCOMPARE(result.typesAt(-1), BodyOrbitTypes());
+    QCOMPARE(result.systemTypes,
+             SystemOrbitType::BinaryStar | SystemOrbitType::BinaryNonStarPair | SystemOrbitType::BinaryPlanetPair
+                 | SystemOrbitType::HierarchicalPairOfPairs | SystemOrbitType::CircumbinaryPlanetarySystem);
+    QCOMPARE(OrbitClassifier::systemTypeLabels(result.systemTypes).size(), 5);
+
+    // Метки сохраняются в корпус и ищутся маской.
+    const auto single = SystemSnapshot::build(QStringLiteral("Orbit Single"), {makeBody(100, -1, BodyClass::Star, star)});
+    SystemCorpusDatabase corpus;
+    QVERIFY2(corpus.open(QStringLiteral(":memory:")), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(snapshot), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(single), qPrintable(corpus.lastError()));
+
+    const auto circumbinary = corpus.systemsWithOrbitTypes(SystemOrbitType::CircumbinaryPlanetarySystem);
+    QCOMPARE(circumbinary.size(), 1);
+    QCOMPARE(circumbinary.first().name, QStringLiteral("Orbit Types"));
+
+    CorpusBodyQuery query;
+    query.orbitTypes = BodyOrbitType::BinaryPlanetComponent;
+    const auto binaryPlanets = corpus.findBodies(query);
+    QCOMPARE(binaryPlanets.size(), 2);
+    QCOMPARE(binaryPlanets.at(0).bodyId, 30);
+    QCOMPARE(binaryPlanets.at(1).bodyId, 31);
+}
+
+void EdastroHierarchyTests::corpusStatisticsFollowSystemUpdates() {
+    auto makeBody = [](const int id, const int parentId, const CelestialBody::BodyClass bodyClass, const QString& type) {
+        CelestialBody body;
+        body.id = id;
+        body.parentId = parentId;
+        body.bodyClass = bodyClass;
+        body.name = QStringLiteral("Body %1").arg(id);
+        body.type = type;
+        return body;
+    };
+    using BodyClass = CelestialBody::BodyClass;
+    using Stats = CorpusStatistics;
+
+    // Двойная G + M: терраформируемая каменистая планета вокруг барицентра (звезда-хозяин — G,
+    // у неё меньший id) и землеподобная планета у M.
+    CelestialBody circumbinary = makeBody(3, 0, BodyClass::Planet, QStringLiteral("Rocky body"));
+    circumbinary.terraformingState = QStringLiteral("Candidate for terraforming");
+    QVector<CelestialBody> binaryBodies{makeBody(0, -1, BodyClass::Barycenter, QStringLiteral("Barycentre")),
+                                        makeBody(1, 0, BodyClass::Star, QStringLiteral("G (White-Yellow) Star")),
+                                        makeBody(2, 0, BodyClass::Star, QStringLiteral("M (Red dwarf) Star")),
+                                        circumbinary,
+                                        makeBody(4, 2, BodyClass::Planet, QStringLiteral("Earth-like world"))};
+    CelestialBody metalWorld = makeBody(1, 0, BodyClass::Planet, QStringLiteral("High metal content world"));
+    metalWorld.terraformingState = QStringLiteral("Terraformable");
+    const auto single = SystemSnapshot::build(QStringLiteral("Stats Single"),
+                                              {makeBody(0, -1, BodyClass::Star, QStringLiteral("K (Yellow-Orange) Star")),
+                                               metalWorld});
+
+    const GalacticCoordinates solPosition{0.0, 0.0, 0.0};
+    const GalacticCoordinates farPosition{20000.0, 0.0, 20000.0};
+    const int solRegion = Stats::regionOf(solPosition);
+    const int farRegion = Stats::regionOf(farPosition);
+    QVERIFY(solRegion != farRegion);
+
+    SystemCorpusDatabase corpus;
+    QVERIFY2(corpus.open(QStringLiteral(":memory:")), qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(SystemSnapshot::build(QStringLiteral("Stats Binary"), binaryBodies), 0, solPosition),
+             qPrintable(corpus.lastError()));
+    QVERIFY2(corpus.storeSystem(single, 0, farPosition), qPrintable(corpus.lastError()));
+
+    Stats statistics = corpus.statistics();
+    QCOMPARE(statistics.count(Stats::Systems, 0), qint64(2));
+    QCOMPARE(statistics.count(Stats::Systems, 0, farRegion), qint64(1));
+    QCOMPARE(statistics.regions().size(), 2);
+    const int binaryStar = static_cast<int>(SystemOrbitType::BinaryStar);
+    QCOMPARE(statistics.count(Stats::SystemOrbitTypes, binaryStar, solRegion), qint64(1));
+    QCOMPARE(statistics.count(Stats::SystemOrbitTypes, binaryStar, farRegion), qint64(0));
+    QCOMPARE(statistics.count(Stats::BodyOrbitTypes, static_cast<int>(BodyOrbitType::BinaryStarComponent)), qint64(2));
+    QCOMPARE(statistics.count(Stats::BodyOrbitTypes, static_cast<int>(BodyOrbitType::CircumbinaryPlanet)), qint64(1));
+    QCOMPARE(statistics.count(Stats::PlanetSubtypes, static_cast<int>(PlanetSubtype::EarthLike)), qint64(1));
+    QCOMPARE(statistics.count(Stats::TerraformableByStarClass, static_cast<int>(StarClass::G)), qint64(1));
+    QCOMPARE(statistics.count(Stats::TerraformableByStarClass, static_cast<int>(StarClass::K), farRegion), qint64(1));
+
+    // Перезапись без землеподобной планеты и без координат: вклад старой версии вычитается,
+    // регион берётся из сохранённых координат.
+    binaryBodies.removeLast();
+    QVERIFY2(corpus.storeSystem(SystemSnapshot::build(QStringLiteral("Stats Binary"), binaryBodies)),
+             qPrintable(corpus.lastError()));
+    statistics = corpus.statistics();
+    QCOMPARE(statistics.count(Stats::Systems, 0, solRegion), qint64(1));
+    QCOMPARE(statistics.count(Stats::PlanetSubtypes, static_cast<int>(PlanetSubtype::EarthLike)), qint64(0));
+    QVERIFY(!statistics.keys(Stats::PlanetSubtypes).contains(static_cast<int>(PlanetSubtype::EarthLike)));
+    QCOMPARE(statistics.count(Stats::SystemOrbitTypes, binaryStar), qint64(1));
+
+    // Инкрементальная сводка совпадает с полным пересчётом.
+    QVERIFY2(corpus.rebuildStatistics(), qPrintable(corpus.lastError()));
+    const Stats rebuilt = corpus.statistics();
+    QCOMPARE(rebuilt.entries.size(), statistics.entries.size());
+    for (int index = 0; index < rebuilt.entries.size(); ++index) {
+        QCOMPARE(rebuilt.entries.at(index).kind, statistics.entries.at(index).kind);
+        QCOMPARE(rebuilt.entries.at(index).region, statistics.entries.at(index).region);
+        QCOMPARE(rebuilt.entries.at(index).key, statistics.entries.at(index).key);
+        QCOMPARE(rebuilt.entries.at(index).count, statistics.entries.at(index).count);
+    }
+
+    QString csv;
+    QTextStream stream(&csv);
+    statistics.writeCsv(stream);
+    stream.flush();
+    QVERIFY(csv.startsWith(QStringLiteral("kind,region,key,count\n")));
+    QCOMPARE(csv.count(QLatin1Char('\n')), statistics.entries.size() + 1);
+    QVERIFY(csv.contains(QStringLiteral("High metal content world")));
+}
+
+void EdastroHierarchyTests::layoutWorkspaceHandlesDeepChainsWithoutReallocation() {
+    const auto document = loadJson(QStringLiteral("col.json"));
+    QVERIFY2(!document.isNull(), "Failed to parse col.json");
+    const auto snapshot = SystemSnapshot::build(QStringLiteral("Col 285 Sector XW-G b25-1"),
+                                                parseEdastroBodiesForTests(document,
+                                                                           QStringLiteral("Col 285 Sector XW-G b25-1"),
+                                                                           [](const QString&) {}));
+
+    // Цепочка в 200 тыс. уровней: рекурсивная раскладка переполнила бы стек.
+    constexpr int kChainLength = 200000;
+    BodyGraph chain;
+    QVector<BodyHot> chainHot(kChainLength);
+    chain.bodyIds.resize(kChainLength);
+    chain.parentIndex.resize(kChainLength);
+    chain.childOffsets.resize(kChainLength + 1);
+    chain.childIndices.resize(kChainLength - 1);
+    for (int index = 0; index < kChainLength; ++index) {
+        chain.bodyIds[index] = index;
+        chain.indexById.insert(index, index);
+        chain.parentIndex[index] = index - 1;
+        chain.childOffsets[index] = index;
+        if (index > 0) {
+            chain.childIndices[index - 1] = index;
+        }
+        chainHot[index].id = index;
+        chainHot[index].parentId = index - 1;
+        chainHot[index].flags = BodyHot::PlanetTypeFlag;
+        chainHot[index].semiMajorAxisAu = 0.001;
+    }
+    chain.childOffsets[kChainLength] = kChainLength - 1;
+    chain.rootIndices = {0};
+
+    SystemLayoutEngine::Workspace workspace;
+    SystemLayout layout;
+    SystemLayoutEngine::buildLayout(chain, chainHot, workspace, layout);
+    QCOMPARE(layout.size(), kChainLength);
+    QVERIFY(std::all_of(layout.bodies.cbegin(), layout.bodies.cend(), [](const BodyLayout& bodyLayout) {
+        return bodyLayout.placed;
+    }));
+    QVERIFY(layout.bodies.last().position.x() > layout.bodies.first().position.x());
+
+    // Меньшая система укладывается в уже выделенные буферы и совпадает с раскладкой без них.
+    const int orderedCapacity = workspace.orderedChildren.capacity();
+    const int pendingCapacity = workspace.pending.capacity();
+    SystemLayoutEngine::buildLayout(snapshot.graph(), snapshot.hotBodies(), workspace, layout);
+    QCOMPARE(workspace.orderedChildren.capacity(), orderedCapacity);
+    QCOMPARE(workspace.pending.capacity(), pendingCapacity);
+
+    const SystemLayout expected = SystemLayoutEngine::buildLayout(snapshot.graph(), snapshot.hotBodies());
+    QCOMPARE(layout.size(), expected.size());
+    QCOMPARE(layout.extentAu, expected.extentAu);
+    for (int index = 0; index < expected.size(); ++index) {
+        QCOMPARE(layout.at(index).placed, expected.at(index).placed);
+        QCOMPARE(layout.at(index).position, expected.at(index).position);
+        QCOMPARE(layout.at(index).orbitRadius, expected.at(index).orbitRadius);
+    }
+}
+
+void EdastroHierarchyTests::layoutIsIndependentOfCanvasSize() {
+    auto makeBody = [](const int id, const int parentId, const CelestialBody::BodyClass bodyClass, const double semiMajorAxisAu) {
+        CelestialBody body;
+        body.id = id;
+        body.parentId = parentId;
+        body.bodyClass = bodyClass;
+        body.name = QStringLiteral("Body %1").arg(id);
+        body.type = bodyClass == CelestialBody::BodyClass::Star ? QStringLiteral("G (White-Yellow) Star")
+                                                                 : QStringLiteral("Rocky body");
+        body.semiMajorAxisAu = semiMajorAxisAu;
+        return body;
+    };
+    using BodyClass = CelestialBody::BodyClass;
+    const auto snapshot = SystemSnapshot::build(QStringLiteral("Scale"),
+                                                {makeBody(1, -1, BodyClass::Star, 0.0),
+                                                 makeBody(2, 1, BodyClass::Planet, 2.0),
+                                                 makeBody(3, 1, BodyClass::Planet, 5.0)});
+    const SystemLayout layout = SystemLayoutEngine::buildLayout(snapshot.graph(), snapshot.hotBodies());
+    const BodyGraph& graph = snapshot.graph();
+
+    // Координаты — а.е. от корня, масштаб в пиксели зависит только от размера холста.
+    QCOMPARE(layout.extentAu, 5.0);
+    const BodyLayout& root = layout.at(graph.indexOf(1));
+    const BodyLayout& inner = layout.at(graph.indexOf(2));
+    QCOMPARE(root.position, QPointF(0.0, 0.0));
+    QCOMPARE(inner.orbitRadius, 2.0);
+    QVERIFY(qAbs(std::hypot(inner.position.x(), inner.position.y()) - 2.0) < 1e-9);
+
+    QCOMPARE(layout.pxPerAu(QSizeF(900.0, 600.0)), SystemLayoutEngine::kReferenceHalfSizePx / 5.0);
+    QCOMPARE(layout.pxPerAu(QSizeF(1800.0, 1200.0)), 2.0 * layout.pxPerAu(QSizeF(900.0, 600.0)));
+    QCOMPARE(layout.pxPerAu(QSizeF(4000.0, 600.0)), layout.pxPerAu(QSizeF(900.0, 600.0)));
+    QCOMPARE(SystemLayout().pxPerAu(QSizeF(900.0, 600.0)), 0.0);
+}
+
+void EdastroHierarchyTests::keplerEphemerisSolvesPositionsFromElements() {
+    QJsonObject root;
+    root.insert(QStringLiteral("stars"),
+                QJsonArray{QJsonObject{{QStringLiteral("id"), 0},
+                                       {QStringLiteral("name"), QStringLiteral("Primary")},
+                                       {QStringLiteral("type"), QStringLiteral("Star")}}});
+    root.insert(QStringLiteral("planets"),
+                QJsonArray{QJsonObject{{QStringLiteral("id"), 100},
+                                       {QStringLiteral("name"), QStringLiteral("Eccentric")},
+                                       {QStringLiteral("type"), QStringLiteral("Planet")},
+                                       {QStringLiteral("parents"), QStringLiteral("Star:0")},
+                                       {QStringLiteral("semiMajorAxis"), 2.0},
+                                       {QStringLiteral("orbitalEccentricity"), 0.5},
+                                       {QStringLiteral("orbitalInclination"), 0.0},
+                                       {QStringLiteral("argOfPeriapsis"), 0.0},
+                                       {QStringLiteral("ascendingNode"), 0.0},
+                                       {QStringLiteral("meanAnomaly"), 0.0},
+                                       {QStringLiteral("meanAnomalyDate"), QStringLiteral("2026-01-01 00:00:00")},
+                                       {QStringLiteral("orbitalPeriod"), -365.25}}});
+
+    const auto bodies = parseEdastroBodiesForTests(QJsonDocument(root), QStringLiteral("Kepler test"), [](const QString&) {});
+    const auto map = toMap(bodies);
+    QVERIFY2(map.contains(100), "Expected parsed planet id=100");
+
+    const qint64 epochMs = QDateTime(QDate(2026, 1, 1), QTime(0, 0), Qt::UTC).toMSecsSinceEpoch();
+    const OrbitalElements orbit = map.value(100).orbit;
+    QCOMPARE(orbit.eccentricity, 0.5);
+    QCOMPARE(orbit.orbitalPeriodDays, 365.25);
+    QCOMPARE(orbit.meanAnomalyEpochMs, epochMs);
+    QVERIFY(orbit.hasPhase());
+
+    const SystemSnapshot snapshot = SystemSnapshot::build(QStringLiteral("Kepler test"), bodies);
+    const KeplerEphemeris& ephemeris = snapshot.ephemeris();
+    QCOMPARE(ephemeris.phasedCount(), 1);
+    const int planetIndex = snapshot.graph().indexById.value(100);
+
+    // В момент эпохи тело в перицентре a(1 − e), через полпериода — в апоцентре a(1 + e) по другую сторону.
+    const qint64 halfPeriodMs = static_cast<qint64>(365.25 / 2.0 * 86400000.0);
+    EphemerisState state;
+    ephemeris.solve(epochMs, state);
+    QVERIFY(qAbs(state.x.at(planetIndex) - 1.0) < 1e-9);
+    QVERIFY(qAbs(state.y.at(planetIndex)) < 1e-9);
+    ephemeris.solve(epochMs + halfPeriodMs, state);
+    QVERIFY(qAbs(state.x.at(planetIndex) + 3.0) < 1e-9);
+    QVERIFY(qAbs(state.y.at(planetIndex)) < 1e-6);
+
+    // Схема кладёт тело с известной фазой в его настоящем направлении от родителя.
+    const SystemLayout atPeriapsis = SystemLayoutEngine::buildLayout(snapshot.graph(), snapshot.hotBodies(), &ephemeris, epochMs);
+    const SystemLayout atApoapsis =
+        SystemLayoutEngine::buildLayout(snapshot.graph(), snapshot.hotBodies(), &ephemeris, epochMs + halfPeriodMs);
+    QVERIFY(atPeriapsis.at(planetIndex).position.x() > 0.0);
+    QVERIFY(atApoapsis.at(planetIndex).position.x() < 0.0);
+    QVERIFY(qAbs(atApoapsis.at(planetIndex).position.y()) < 1e-6);
+
+    // Решатель сходится и на почти параболических орбитах.
+    const double meanAnomalies[] = {-3.0, -0.5, 0.0, 1e-6, 0.5, 3.1};
+    for (const double eccentricity : {0.0, 0.3, 0.9, 0.999999}) {
+        const double eccentricities[] = {eccentricity, eccentricity, eccentricity, eccentricity, eccentricity, eccentricity};
+        double eccentricAnomalies[6] = {};
+        KeplerEphemeris::solveEccentricAnomalies(meanAnomalies, eccentricities, eccentricAnomalies, 6);
+        for (int index = 0; index < 6; ++index) {
+            const double residual = eccentricAnomalies[index] - eccentricity * std::sin(eccentricAnomalies[index]) - meanAnomalies[index];
+            QVERIFY2(qAbs(residual) < 1e-12, qPrintable(QStringLiteral("e=%1 M=%2").arg(eccentricity).arg(meanAnomalies[index])));
+        }
+    }
+}
+
+void EdastroHierarchyTests::ephemerisTablesFollowKeplerSolutionAndAdvanceLayout() {
+    QJsonObject root;
+    root.insert(QStringLiteral("stars"),
+                QJsonArray{QJsonObject{{QStringLiteral("id"), 0},
+                                       {QStringLiteral("name"), QStringLiteral("Primary")},
+                                       {QStringLiteral("type"), QStringLiteral("Star")}}});
+    root.insert(QStringLiteral("planets"),
+                QJsonArray{QJsonObject{{QStringLiteral("id"), 100},
+                                       {QStringLiteral("name"), QStringLiteral("Moving")},
+                                       {QStringLiteral("type"), QStringLiteral("Planet")},
+                                       {QStringLiteral("parents"), QStringLiteral("Star:0")},
+                                       {QStringLiteral("semiMajorAxis"), 2.0},
+                                       {QStringLiteral("orbitalEccentricity"), 0.5},
+                                       {QStringLiteral("orbitalInclination"), 12.0},
+                                       {QStringLiteral("argOfPeriapsis"), 40.0},
+                                       {QStringLiteral("ascendingNode"), 75.0},
+                                       {QStringLiteral("meanAnomaly"), 10.0},
+                                       {QStringLiteral("meanAnomalyDate"), QStringLiteral("2026-01-01 00:00:00")},
+                                       {QStringLiteral("orbitalPeriod"), 0.73}},
+                           QJsonObject{{QStringLiteral("id"), 101},
+                                       {QStringLiteral("name"), QStringLiteral("Without phase")},
+                                       {QStringLiteral("type"), QStringLiteral("Planet")},
+                                       {QStringLiteral("parents"), QStringLiteral("Star:0")},
+                                       {QStringLiteral("semiMajorAxis"), 5.0}}});
+
+    const auto bodies = parseEdastroBodiesForTests(QJsonDocument(root), QStringLiteral("Table test"), [](const QString&) {});
+    const SystemSnapshot snapshot = SystemSnapshot::build(QStringLiteral("Table test"), bodies);
+    const KeplerEphemeris& ephemeris = snapshot.ephemeris();
+    const int movingIndex = snapshot.graph().indexById.value(100);
+    const int staticIndex = snapshot.graph().indexById.value(101);
+    const int starIndex = snapshot.graph().indexById.value(0);
+
+    // Таблицы строятся только для запрошенных тел с известной фазой.
+    const EphemerisTable built = EphemerisTable::build(ephemeris, {movingIndex, staticIndex});
+    QCOMPARE(built.tableCount(), 1);
+    EphemerisTable tables;
+    tables.reset(ephemeris.size());
+    QVERIFY(!tables.contains(movingIndex));
+    tables.merge(built);
+    QVERIFY(tables.contains(movingIndex));
+    QVERIFY(!tables.contains(staticIndex));
+
+    // Таблица одного оборота годится и через годы от момента средней аномалии.
+    const qint64 epochMs = QDateTime(QDate(2026, 1, 1), QTime(0, 0), Qt::UTC).toMSecsSinceEpoch();
+    EphemerisState state;
+    for (const qint64 offsetMs : {0LL, 1234567LL, -86400000LL * 3650, 86400000LL * 3650 + 7777LL}) {
+        ephemeris.solve(epochMs + offsetMs, state);
+        double x = 0.0;
+        double y = 0.0;
+        double z = 0.0;
+        QVERIFY(tables.evaluate(movingIndex, ephemeris.revolutionsSinceEpoch(movingIndex, epochMs + offsetMs), x, y, z));
+        const double error = std::hypot(std::hypot(x - state.relativeX.at(movingIndex), y - state.relativeY.at(movingIndex)),
+                                         z - state.relativeZ.at(movingIndex));
+        QVERIFY2(error < 1e-6, qPrintable(QStringLiteral("offset=%1 error=%2").arg(offsetMs).arg(error)));
+    }
+
+    // Кадр прокрутки ставит тело туда же, куда его поставила бы полная раскладка на этот момент;
+    // тела без таблиц сохраняют смещение от родителя.
+    const SystemLayout baseLayout =
+        SystemLayoutEngine::buildLayout(snapshot.graph(), snapshot.hotBodies(), &ephemeris, epochMs);
+    const qint64 laterMs = epochMs + 86400000LL * 100 + 4321;
+    SystemLayout advanced;
+    SystemLayoutEngine::advanceLayout(snapshot.graph(), ephemeris, tables, baseLayout, laterMs, advanced);
+    QCOMPARE(advanced.size(), baseLayout.size());
+    QCOMPARE(advanced.at(staticIndex).position, baseLayout.at(staticIndex).position);
+
+    const SystemLayout rebuilt = SystemLayoutEngine::buildLayout(snapshot.graph(), snapshot.hotBodies(), &ephemeris, laterMs);
+    const QPointF advancedOffset = advanced.at(movingIndex).position - advanced.at(starIndex).position;
+    const QPointF rebuiltOffset = rebuilt.at(movingIndex).position - rebuilt.at(starIndex).position;
+    QVERIFY(std::hypot(advancedOffset.x() - rebuiltOffset.x(), advancedOffset.y() - rebuiltOffset.y()) < 1e-6);
+}
+
+void EdastroHierarchyTests::orbitPathsFollowEllipseAndCullToViewport() {
+    // Орбита e = 0.5 в плоскости схемы: перицентр справа от родителя, апоцентр слева.
+    OrbitEllipse ellipse;
+    ellipse.eccentricity = 0.5;
+    ellipse.minorX = 0.0;
+    ellipse.minorY = std::sqrt(1.0 - 0.25);
+    const QPointF parentAu(3.0, -2.0);
+    const double orbitRadiusAu = 2.0;
+
+    OrbitPathCache cache;
+    OrbitPathRuns runs;
+    const double overviewPxPerAu = 200.0;
+    cache.appendVisibleRuns(7, ellipse, orbitRadiusAu, parentAu, overviewPxPerAu, QRectF(-100.0, -100.0, 200.0, 200.0), runs);
+    QCOMPARE(runs.runCount(), 1);
+    const int fullLength = runs.runLength(0);
+    QCOMPARE(fullLength, OrbitPathCache::segmentCountForRadius(orbitRadiusAu * overviewPxPerAu) + 1);
+    QCOMPARE(runs.points.first(), runs.points.last());
+    QCOMPARE(runs.points.first(), parentAu + QPointF(orbitRadiusAu * 0.5, 0.0));
+
+    // Хорды отходят от эллипса не больше чем на четверть пикселя.
+    double maxDeviationPx = 0.0;
+    for (int point = 0; point + 1 < fullLength; ++point) {
+        const QPointF a = (runs.points.at(point) - parentAu) / orbitRadiusAu;
+        const QPointF b = (runs.points.at(point + 1) - parentAu) / orbitRadiusAu;
+        const double startAnomaly = 2.0 * M_PI * point / (fullLength - 1);
+        const double middleAnomaly = startAnomaly + M_PI / (fullLength - 1);
+        const QPointF onEllipse(std::cos(middleAnomaly) - 0.5, ellipse.minorY * std::sin(middleAnomaly));
+        const QPointF chordMiddle = (a + b) / 2.0;
+        maxDeviationPx = qMax(maxDeviationPx,
+                              std::hypot(onEllipse.x() - chordMiddle.x(), onEllipse.y() - chordMiddle.y())
+                                  * orbitRadiusAu * overviewPxPerAu);
+    }
+    QVERIFY2(maxDeviationPx <= 0.25, qPrintable(QStringLiteral("deviation=%1 px").arg(maxDeviationPx)));
+
+    // Тот же зум в пределах корзины берёт готовое разбиение.
+    runs.clear();
+    cache.appendVisibleRuns(7, ellipse, orbitRadiusAu, parentAu, overviewPxPerAu * 1.05, QRectF(-100.0, -100.0, 200.0, 200.0), runs);
+    QCOMPARE(cache.cachedPathCount(), 1);
+    QCOMPARE(runs.runLength(0), fullLength);
+
+    // Глубокий зум на перицентр: окно в тысячу пикселей получает только ближние куски дуги.
+    const double deepPxPerAu = overviewPxPerAu * 400.0;
+    const QPointF periapsisAu = parentAu + QPointF(orbitRadiusAu * 0.5, 0.0);
+    const QRectF deepViewAu(periapsisAu - QPointF(500.0, 500.0) / deepPxPerAu, QSizeF(1000.0, 1000.0) / deepPxPerAu);
+    runs.clear();
+    cache.appendVisibleRuns(7, ellipse, orbitRadiusAu, parentAu, deepPxPerAu, deepViewAu, runs);
+    QCOMPARE(cache.cachedPathCount(), 2);
+    const int deepSegments = OrbitPathCache::segmentCountForRadius(orbitRadiusAu * deepPxPerAu);
+    QVERIFY(deepSegments > 10 * fullLength);
+    QVERIFY(runs.runCount() >= 1);
+    QVERIFY2(runs.points.size() < deepSegments / 10, qPrintable(QStringLiteral("emitted %1 of %2").arg(runs.points.size()).arg(deepSegments)));
+    const bool touchesPeriapsis = std::any_of(runs.points.cbegin(), runs.points.cend(), [&periapsisAu](const QPointF& point) {
+        return point == periapsisAu;
+    });
+    QVERIFY(touchesPeriapsis);
+
+    // Орбита целиком вне окна ничего не добавляет.
+    runs.clear();
+    cache.appendVisibleRuns(7, ellipse, orbitRadiusAu, parentAu + QPointF(100.0, 0.0), deepPxPerAu, deepViewAu, runs);
+    QCOMPARE(runs.runCount(), 0);
+}
+
+void EdastroHierarchyTests::orbitScene3DProjectsInclinedOrbits() {
+    // Полярная орбита: наклонение 90°, узел и перицентр на оси X — орбита лежит в плоскости XZ.
+    QJsonObject root;
+    root.insert(QStringLiteral("stars"),
+                QJsonArray{QJsonObject{{QStringLiteral("id"), 0},
+                                       {QStringLiteral("name"), QStringLiteral("Primary")},
+                                       {QStringLiteral("type"), QStringLiteral("Star")}}});
+    root.insert(QStringLiteral("planets"),
+                QJsonArray{QJsonObject{{QStringLiteral("id"), 100},
+                                       {QStringLiteral("name"), QStringLiteral("Polar")},
+                                       {QStringLiteral("type"), QStringLiteral("Planet")},
+                                       {QStringLiteral("parents"), QStringLiteral("Star:0")},
+                                       {QStringLiteral("semiMajorAxis"), 2.0},
+                                       {QStringLiteral("orbitalEccentricity"), 0.0},
+                                       {QStringLiteral("orbitalInclination"), 90.0},
+                                       {QStringLiteral("argOfPeriapsis"), 0.0},
+                                       {QStringLiteral("ascendingNode"), 0.0},
+                                       {QStringLiteral("meanAnomaly"), 0.0},
+                                       {QStringLiteral("meanAnomalyDate"), QStringLiteral("2026-01-01 00:00:00")},
+                                       {QStringLiteral("orbitalPeriod"), 365.25}}});
+
+    const auto bodies = parseEdastroBodiesForTests(QJsonDocument(root), QStringLiteral("Orbit 3D test"), [](const QString&) {});
+    const SystemSnapshot snapshot = SystemSnapshot::build(QStringLiteral("Orbit 3D test"), bodies);
+    const KeplerEphemeris& ephemeris = snapshot.ephemeris();
+    const int planetIndex = snapshot.graph().indexById.value(100);
+    const qint64 epochMs = QDateTime(QDate(2026, 1, 1), QTime(0, 0), Qt::UTC).toMSecsSinceEpoch();
+
+    EphemerisState state;
+    ephemeris.solve(epochMs, state);
+    OrbitScene3D scene;
+    scene.build(ephemeris);
+    scene.place(state);
+    QCOMPARE(scene.orbitCount(), 1);
+    QCOMPARE(scene.orbitBodyIndex(0), planetIndex);
+    QVERIFY(qAbs(scene.extentAu() - 2.0) < 1e-9);
+
+    // Сверху полярная орбита видна с ребра: отрезок вдоль X, тело в перицентре на его конце.
+    ViewProjection3D view;
+    view.pxPerAu = 10.0;
+    view.originX = 100.0;
+    view.originY = 100.0;
+    scene.project(view, state);
+    for (int point = 0; point < OrbitScene3D::kPointsPerOrbit; ++point) {
+        QVERIFY(qAbs(scene.orbitScreenY(0)[point] - 100.0) < 1e-9);
+        QVERIFY(scene.orbitScreenX(0)[point] >= 80.0 - 1e-9 && scene.orbitScreenX(0)[point] <= 120.0 + 1e-9);
+    }
+    QVERIFY(qAbs(scene.bodyScreenX().at(planetIndex) - 120.0) < 1e-9);
+
+    // С ребра опорной плоскости та же орбита — окружность радиусом 20 px.
+    view.pitchRad = M_PI / 2.0;
+    scene.project(view, state);
+    for (int point = 0; point < OrbitScene3D::kPointsPerOrbit; ++point) {
+        const double radiusPx = std::hypot(scene.orbitScreenX(0)[point] - 100.0, scene.orbitScreenY(0)[point] - 100.0);
+        QVERIFY2(qAbs(radiusPx - 20.0) < 1e-9, qPrintable(QStringLiteral("point %1: r=%2").arg(point).arg(radiusPx)));
+    }
+
+    // Поворот не меняет длин: экранное смещение и глубина вместе дают расстояние до начала координат.
+    view.yawRad = 0.7;
+    view.pitchRad = -0.4;
+    scene.project(view, state);
+    for (int index = 0; index < state.x.size(); ++index) {
+        const double deltaX = scene.bodyScreenX().at(index) - view.originX;
+        const double deltaY = scene.bodyScreenY().at(index) - view.originY;
+        const double depthPx = scene.bodyDepth().at(index) * view.pxPerAu;
+        const double distancePx = std::sqrt(state.x.at(index) * state.x.at(index) + state.y.at(index) * state.y.at(index)
+                                            + state.z.at(index) * state.z.at(index))
+                                * view.pxPerAu;
+        QVERIFY(qAbs(std::sqrt(deltaX * deltaX + deltaY * deltaY + depthPx * depthPx) - distancePx) < 1e-9);
+    }
+    const QVector<int>& depthOrder = scene.bodyDepthOrder();
+    QCOMPARE(depthOrder.size(), state.x.size());
+    for (int position = 1; position < depthOrder.size(); ++position) {
+        QVERIFY(scene.bodyDepth().at(depthOrder.at(position - 1)) <= scene.bodyDepth().at(depthOrder.at(position)));
+    }
+}
+
+void EdastroHierarchyTests::semanticZoomExpandsVisibleMoonSubsystems() {
+    QJsonObject root;
+    root.insert(QStringLiteral("stars"),
+                QJsonArray{QJsonObject{{QStringLiteral("id"), 0},
+                                       {QStringLiteral("name"), QStringLiteral("Primary")},
+                                       {QStringLiteral("type"), QStringLiteral("Star")}}});
+    root.insert(QStringLiteral("planets"),
+                QJsonArray{QJsonObject{{QStringLiteral("id"), 100},
+                                       {QStringLiteral("name"), QStringLiteral("Inner")},
+                                       {QStringLiteral("type"), QStringLiteral("Planet")},
+                                       {QStringLiteral("parents"), QStringLiteral("Star:0")},
+                                       {QStringLiteral("semiMajorAxis"), 1.0}},
+                           QJsonObject{{QStringLiteral("id"), 200},
+                                       {QStringLiteral("name"), QStringLiteral("Outer")},
+                                       {QStringLiteral("type"), QStringLiteral("Planet")},
+                                       {QStringLiteral("parents"), QStringLiteral("Star:0")},
+                                       {QStringLiteral("semiMajorAxis"), 1.5}}});
+    root.insert(QStringLiteral("moons"),
+                QJsonArray{QJsonObject{{QStringLiteral("id"), 101},
+                                       {QStringLiteral("name"), QStringLiteral("Inner a")},
+                                       {QStringLiteral("type"), QStringLiteral("Moon")},
+                                       {QStringLiteral("parents"), QStringLiteral("Planet:100;Star:0")},
+                                       {QStringLiteral("semiMajorAxis"), 0.002}}});
+
+    const auto bodies = parseEdastroBodiesForTests(QJsonDocument(root), QStringLiteral("Zoom test"), [](const QString&) {});
+    const SystemSnapshot snapshot = SystemSnapshot::build(QStringLiteral("Zoom test"), bodies);
+    const BodyGraph& graph = snapshot.graph();
+    const int planetIndex = graph.indexById.value(100);
+    const int moonIndex = graph.indexById.value(101);
+    const SystemLayout layout = SystemLayoutEngine::buildLayout(graph, snapshot.hotBodies());
+
+    SemanticZoomLayout semanticZoom;
+    semanticZoom.reset(graph, snapshot.hotBodies(), layout);
+    QCOMPARE(semanticZoom.subsystemCount(), 1);
+
+    // Зазор планеты — половина расстояния до соседней орбиты, 0.25 а.е. При 50 px/а.е. это меньше
+    // порога: луна остаётся в настоящем масштабе, масштаб подсистемы не считается.
+    const QRectF viewAu(-5.0, -5.0, 10.0, 10.0);
+    SystemLayout displayLayout;
+    QCOMPARE(semanticZoom.apply(layout, 50.0, viewAu, displayLayout), 0);
+    QCOMPARE(semanticZoom.displayScale(moonIndex), 1.0);
+    QCOMPARE(displayLayout.at(moonIndex).position, layout.at(moonIndex).position);
+
+    // При 200 px/а.е. подсистема раздвигается до своего зазора; планета остаётся на месте.
+    QCOMPARE(semanticZoom.apply(layout, 200.0, viewAu, displayLayout), 1);
+    const QPointF moonOffset = displayLayout.at(moonIndex).position - displayLayout.at(planetIndex).position;
+    QVERIFY(qAbs(std::hypot(moonOffset.x(), moonOffset.y()) - 0.25) < 1e-9);
+    QVERIFY(qAbs(displayLayout.at(moonIndex).orbitRadius - 0.25) < 1e-9);
+    QCOMPARE(displayLayout.at(planetIndex).position, layout.at(planetIndex).position);
+
+    // Та же корзина зума берёт готовый масштаб.
+    QCOMPARE(semanticZoom.apply(layout, 210.0, viewAu, displayLayout), 0);
+    QVERIFY(semanticZoom.displayScale(moonIndex) > 1.0);
+
+    // Подсистема вне окна не раздвигается.
+    semanticZoom.apply(layout, 200.0, QRectF(50.0, 50.0, 1.0, 1.0), displayLayout);
+    QCOMPARE(semanticZoom.displayScale(moonIndex), 1.0);
+
+    // На глубоком зуме настоящая орбита луны и так крупнее цели — масштаб снова настоящий.
+    semanticZoom.apply(layout, 1e6, viewAu, displayLayout);
+    QCOMPARE(semanticZoom.displayScale(moonIndex), 1.0);
+    QCOMPARE(displayLayout.at(moonIndex).position, layout.at(moonIndex).position);
+
+    // Между ними подсистема на экране не меньше цели в 80 px и не больше зазора.
+    semanticZoom.apply(layout, 2000.0, viewAu, displayLayout);
+    const double expandedRadiusPx = displayLayout.at(moonIndex).orbitRadius * 2000.0;
+    QVERIFY2(expandedRadiusPx >= 80.0 && expandedRadiusPx <= 0.25 * 2000.0,
+             qPrintable(QStringLiteral("radius=%1 px").arg(expandedRadiusPx)));
+}
+
+void EdastroHierarchyTests::layoutDeclutterSeparatesOverlapsNearAnchors() {
+    // Три значка в одной точке и один в стороне.
+    QVector<LayoutDeclutter::Item> items;
+    for (int key = 0; key < 3; ++key) {
+        items.push_back({key, QPointF(100.0, 100.0), 5.0, 20.0});
+    }
+    items.push_back({10, QPointF(400.0, 100.0), 5.0, 20.0});
+
+    LayoutDeclutter declutter;
+    declutter.setItems(items);
+    // Нулевой бюджет — ровно одна итерация за кадр: остальное досчитывается в следующих.
+    QVERIFY(!declutter.relax(0));
+    QCOMPARE(declutter.lastIterationCount(), 1);
+    QVERIFY(declutter.relax(50000000));
+
+    for (int first = 0; first < 3; ++first) {
+        for (int second = first + 1; second < 3; ++second) {
+            const QPointF delta = declutter.position(first) - declutter.position(second);
+            QVERIFY2(std::hypot(delta.x(), delta.y()) > 10.0,
+                     qPrintable(QStringLiteral("distance=%1").arg(std::hypot(delta.x(), delta.y()))));
+        }
+        const QPointF offset = declutter.offset(first);
+        QVERIFY(std::hypot(offset.x(), offset.y()) <= 20.0 + 1e-9);
+    }
+    // Одинокий значок остаётся на своём месте.
+    QCOMPARE(declutter.position(3), QPointF(400.0, 100.0));
+
+    // Те же якоря в следующем кадре ничего не считают.
+    declutter.setItems(items);
+    QVERIFY(declutter.relax(0));
+    QCOMPARE(declutter.lastIterationCount(), 0);
+
+    // Сдвинутые якоря: смещения переносятся по ключам, раскладка уже разведена.
+    const QPointF settledOffset = declutter.offsetForKey(1);
+    for (LayoutDeclutter::Item& item : items) {
+        item.anchor += QPointF(30.0, -15.0);
+    }
+    declutter.setItems(items);
+    QCOMPARE(declutter.offset(1), settledOffset);
+    QVERIFY(declutter.relax(50000000));
+    QVERIFY(declutter.lastIterationCount() <= 2);
+
+    // Россыпь с перекрытиями: после расчёта по кадрам их не остаётся, никто не ушёл дальше предела.
+    QRandomGenerator random(49);
+    items.clear();
+    for (int key = 0; key < 2000; ++key) {
+        items.push_back({key, QPointF(random.bounded(1200.0), random.bounded(1200.0)), 6.0, 12.0});
+    }
+    declutter.setItems(items);
+    int frames = 0;
+    while (!declutter.relax(2000000) && frames < 1000) {
+        ++frames;
+    }
+    QVERIFY(declutter.isConverged());
+    int overlaps = 0;
+    for (int first = 0; first < items.size(); ++first) {
+        const QPointF offset = declutter.offset(first);
+        QVERIFY(std::hypot(offset.x(), offset.y()) <= 12.0 + 1e-9);
+        for (int second = first + 1; second < items.size(); ++second) {
+            const QPointF delta = declutter.position(first) - declutter.position(second);
+            overlaps += std::hypot(delta.x(), delta.y()) < 10.0 ? 1 : 0;
+        }
+    }
+    QCOMPARE(overlaps, 0);
+}
+
+void EdastroHierarchyTests::labelPlacementAvoidsCollisionsByPriority() {
+    const QRectF viewport(0.0, 0.0, 800.0, 600.0);
+    const QSizeF labelSize(100.0, 16.0);
+    // Пять тел в одной точке: у подписи четыре места, пятой места не остаётся.
+    QVector<LabelPlacement::Request> requests;
+    for (const int priority : {0, 3, 1, 2, 0}) {
+        requests.push_back({QPointF(400.0, 300.0), 4.0, labelSize, priority});
+    }
+    // Тело далеко за краем окна: подпись не ставится, но и выброшенной не считается.
+    requests.push_back({QPointF(-500.0, -500.0), 4.0, labelSize, 3});
+
+    LabelPlacement placement;
+    QVector<QRectF> placed;
+    placement.place(requests, viewport, placed);
+    QCOMPARE(placed.size(), requests.size());
+    QCOMPARE(placement.placedCount(), 4);
+    QCOMPARE(placement.droppedCount(), 1);
+    // Самая важная подпись стоит на основном месте — справа сверху от значка.
+    QCOMPARE(placed.at(1), QRectF(QPointF(412.0, 290.0), labelSize));
+    QVERIFY(placed.at(2).right() <= 400.0 || placed.at(2).top() > 290.0);
+    // При равном приоритете раньше ставится подпись, запрошенная раньше.
+    QVERIFY(!placed.at(0).isNull());
+    QVERIFY(placed.at(4).isNull());
+    QVERIFY(placed.at(5).isNull());
+
+    // Россыпь подписей: поставленные не пересекаются, а у каждой выброшенной любое видимое
+    // место занято — хэш не пропускает соседей.
+    QRandomGenerator random(50);
+    requests.clear();
+    for (int index = 0; index < 600; ++index) {
+        requests.push_back({QPointF(random.bounded(800.0), random.bounded(600.0)), random.bounded(8.0),
+                            QSizeF(40.0 + random.bounded(180.0), 16.0 * (1 + random.bounded(2))),
+                            static_cast<int>(random.bounded(4))});
+    }
+    placement.place(requests, viewport, placed);
+    QVector<QRectF> placedRects;
+    for (const QRectF& rect : placed) {
+        if (!rect.isNull()) {
+            placedRects.push_back(rect);
+        }
+    }
+    QCOMPARE(placedRects.size(), placement.placedCount());
+    QVERIFY(placement.placedCount() > 0 && placement.droppedCount() > 0);
+    for (int first = 0; first < placedRects.size(); ++first) {
+        for (int second = first + 1; second < placedRects.size(); ++second) {
+            QVERIFY(!placedRects.at(first).intersects(placedRects.at(second)));
+        }
+    }
+    for (int index = 0; index < requests.size(); ++index) {
+        if (!placed.at(index).isNull()) {
+            continue;
+        }
+        const LabelPlacement::Request& request = requests.at(index);
+        const double clearance = request.clearancePx;
+        const double width = request.size.width();
+        const double height = request.size.height();
+        const QVector<QRectF> candidates = {
+            QRectF(QPointF(request.anchor.x() + clearance + 8.0, request.anchor.y() - clearance - 6.0), request.size),
+            QRectF(QPointF(request.anchor.x() + clearance + 8.0, request.anchor.y() - clearance - 6.0 + height), request.size),
+            QRectF(QPointF(request.anchor.x() - clearance - 8.0 - width, request.anchor.y() - clearance - 6.0), request.size),
+            QRectF(QPointF(request.anchor.x() - clearance - 8.0 - width, request.anchor.y() - clearance - 6.0 + height),
+                   request.size),
+        };
+        for (const QRectF& candidate : candidates) {
+            if (!candidate.intersects(viewport)) {
+                continue;
+            }
+            QVERIFY(std::any_of(placedRects.cbegin(), placedRects.cend(), [&candidate](const QRectF& rect) {
+                return rect.intersects(candidate);
+            }));
+        }
+    }
+}
+
 QTEST_MAIN(EdastroHierarchyTests)
 #include "EdastroHierarchyTests.moc"